@@ -33,6 +33,7 @@
 #include "user.h"
 #include "space.h"
 #include "memtx_index.h"
+#include "memtx_read_view.h"
 #include "func.h"
 #include "txn.h"
 #include "tuple.h"
@@ -223,6 +224,22 @@ opt_set(void *opts, const struct opt_def *def, const char **val)
 			unreachable();
 		}
 		break;
+	case MP_DOUBLE:
+		switch (mp_typeof(**val)) {
+		case MP_UINT:
+			store_double(opt, mp_decode_uint(val));
+			break;
+		case MP_INT:
+			store_double(opt, mp_decode_int(val));
+			break;
+		case MP_FLOAT:
+			store_double(opt, mp_decode_float(val));
+			break;
+		default:
+			store_double(opt, mp_decode_double(val));
+			break;
+		}
+		break;
 	case MP_STR:
 		str = mp_decode_str(val, &str_len);
 		str_len = MIN(str_len, def->len - 1);
@@ -264,7 +281,13 @@ opts_create_from_field(void *opts, const struct opt_def *reg, const char *map,
 			    memcmp(key, def->name, key_len) != 0)
 				continue;
 
-			if (mp_typeof(*map) != def->type) {
+			enum mp_type type = mp_typeof(*map);
+			/* Double options accept any number. */
+			if (def->type == MP_DOUBLE &&
+			    (type == MP_UINT || type == MP_INT ||
+			     type == MP_FLOAT))
+				type = MP_DOUBLE;
+			if (type != def->type) {
 				snprintf(errmsg, sizeof(errmsg),
 					"'%.*s' must be %s", key_len, key,
 					mp_type_strs[def->type]);
@@ -325,6 +348,23 @@ key_opts_create_from_field(struct key_opts *opts, const char *map)
 			       ER_WRONG_INDEX_OPTIONS, INDEX_OPTS);
 	if (opts->distancebuf[0] != '\0')
 		opts->distance = key_opts_decode_distance(opts->distancebuf);
+	if (opts->compressionbuf[0] != '\0') {
+		opts->compression = STR2ENUM(index_compression_type,
+					     opts->compressionbuf);
+		if (opts->compression == index_compression_type_MAX) {
+			tnt_raise(ClientError, ER_WRONG_INDEX_OPTIONS,
+				  INDEX_OPTS, "compression must be one of "
+				  "'none', 'lz4' or 'zstd'");
+		}
+	}
+	if (opts->layoutbuf[0] != '\0') {
+		opts->layout = STR2ENUM(hash_index_layout, opts->layoutbuf);
+		if (opts->layout == hash_index_layout_MAX) {
+			tnt_raise(ClientError, ER_WRONG_INDEX_OPTIONS,
+				  INDEX_OPTS, "layout must be either "
+				  "'chain' or 'swiss'");
+		}
+	}
 }
 
 /**
@@ -1001,6 +1041,11 @@ key_def_change_require_index_rebuid(struct key_def *old_key_def,
 		    || old_key_def->opts.distance != new_key_def->opts.distance)
 			return true;
 	}
+	/* TREE elements store hints only if the option is set. */
+	if (old_key_def->opts.hint != new_key_def->opts.hint)
+		return true;
+	if (old_key_def->opts.layout != new_key_def->opts.layout)
+		return true;
 	return false;
 }
 
@@ -1816,6 +1861,8 @@ grant_or_revoke(struct priv_def *priv)
 	struct user *grantee = user_by_id(priv->grantee_id);
 	if (grantee == NULL)
 		return;
+	/* Read views cache access to spaces. */
+	memtx_read_view_invalidate();
 	if (priv->object_type == SC_ROLE) {
 		struct user *role = user_by_id(priv->object_id);
 		if (role == NULL || role->def.type != SC_ROLE)
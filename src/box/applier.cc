@@ -47,10 +47,16 @@
 #include "trigger.h"
 #include "xrow_io.h"
 #include "error.h"
+#include "session.h"
 
 /* TODO: add configuration options */
 static const int RECONNECT_DELAY = 1;
 static const int CONNECT_TIMEOUT = 30;
+/**
+ * Max number of rows applied at the same time. Rows are
+ * executed one by one, but wait for WAL together.
+ */
+static const int APPLIER_ROWS_IN_FLIGHT_MAX = 256;
 
 STRS(applier_state, applier_STATE);
 
@@ -243,6 +249,99 @@ finish:
 	applier_set_state(applier, APPLIER_CONNECTED);
 }
 
+/**
+ * Apply a row in a separate fiber, so that the applier can
+ * go on with the next rows while this one is written to WAL.
+ */
+static int
+applier_apply_f(va_list ap)
+{
+	struct applier *applier = va_arg(ap, struct applier *);
+	struct xrow_header *row = va_arg(ap, struct xrow_header *);
+	uint64_t seq = va_arg(ap, uint64_t);
+	try {
+		xstream_write(applier->subscribe_stream, row);
+	} catch (Exception *e) {
+		/* The applier stops at the first error. */
+		if (diag_is_empty(&applier->diag))
+			diag_move(&fiber()->diag, &applier->diag);
+	}
+	if (seq == applier->last_row_seq)
+		applier->last_row_done = true;
+	applier->rows_in_flight--;
+	ipc_cond_broadcast(&applier->row_cond);
+	return 0;
+}
+
+/** Raise the error of a row fiber, if any. */
+static inline void
+applier_check_error(struct applier *applier)
+{
+	if (!diag_is_empty(&applier->diag)) {
+		diag_move(&applier->diag, &fiber()->diag);
+		diag_raise();
+	}
+}
+
+/**
+ * Pass a row to a new row fiber. Rows coming in one go from
+ * the network are executed one after another and the WAL
+ * writer gets them in a single batch, while the applier
+ * doesn't wait for WAL before reading the next row.
+ */
+static void
+applier_apply_row(struct applier *applier, struct xrow_header *row)
+{
+	while (applier->rows_in_flight >= APPLIER_ROWS_IN_FLIGHT_MAX &&
+	       diag_is_empty(&applier->diag)) {
+		ipc_cond_wait(&applier->row_cond);
+		fiber_testcancel();
+	}
+	applier_check_error(applier);
+
+	struct fiber *f = fiber_new_xc(fiber_name(fiber()), applier_apply_f);
+	/* The row must outlive the input buffer. */
+	struct xrow_header *copy =
+		region_alloc_object_xc(&f->gc, struct xrow_header);
+	*copy = *row;
+	for (int i = 0; i < row->bodycnt; i++) {
+		void *body = region_alloc_xc(&f->gc, row->body[i].iov_len);
+		memcpy(body, row->body[i].iov_base, row->body[i].iov_len);
+		copy->body[i].iov_base = body;
+	}
+	uint32_t server_id = row->server_id;
+	int64_t lsn = row->lsn;
+
+	/*
+	 * Share the applier session with the row fiber rather
+	 * than let it create a session on demand for every row.
+	 * Row fibers never outlive the applier fiber, see
+	 * applier_subscribe().
+	 */
+	struct session *session = current_session();
+	fiber_set_session(f, session);
+	fiber_set_user(f, &session->credentials);
+
+	applier->rows_in_flight++;
+	applier->last_row_done = false;
+	fiber_start(f, applier, copy, ++applier->last_row_seq);
+	/*
+	 * Rows must be written to WAL in the order they come from
+	 * the master. A row fiber usually yields only in WAL,
+	 * when the row has already been queued and the vclock has
+	 * been advanced, so the next row can be started at once.
+	 * Otherwise, e.g. if the engine yields, wait until the
+	 * row is done.
+	 */
+	while (!applier->last_row_done &&
+	       vclock_get(&::recovery->vclock, server_id) < lsn &&
+	       diag_is_empty(&applier->diag)) {
+		ipc_cond_wait(&applier->row_cond);
+		fiber_testcancel();
+	}
+	applier_check_error(applier);
+}
+
 /**
  * Execute and process SUBSCRIBE request (follow updates from a master).
  */
@@ -250,6 +349,8 @@ static void
 applier_subscribe(struct applier *applier)
 {
 	assert(applier->subscribe_stream != NULL);
+	/* Forget a row error of the previous subscription. */
+	diag_clear(&applier->diag);
 
 	/* Send SUBSCRIBE request */
 	struct ev_io *coio = &applier->io;
@@ -312,18 +413,30 @@ applier_subscribe(struct applier *applier)
 	/*
 	 * Process a stream of rows from the binary log.
 	 */
-	while (true) {
-		coio_read_xrow(coio, &iobuf->in, &row);
-		applier->lag = ev_now(loop()) - row.tm;
-		applier->last_row_time = ev_now(loop());
-
-		if (iproto_type_is_error(row.type))
-			xrow_decode_error(&row);  /* error */
-		xstream_write(applier->subscribe_stream, &row);
-
-		iobuf_reset(iobuf);
-		fiber_gc();
+	try {
+		while (true) {
+			coio_read_xrow(coio, &iobuf->in, &row);
+			applier->lag = ev_now(loop()) - row.tm;
+			applier->last_row_time = ev_now(loop());
+
+			if (iproto_type_is_error(row.type))
+				xrow_decode_error(&row);  /* error */
+			applier_apply_row(applier, &row);
+
+			iobuf_reset(iobuf);
+			fiber_gc();
+		}
+	} catch (Exception *e) {
+		/* The error stays in the fiber diagnostics area. */
 	}
+	/*
+	 * Row fibers refer to the applier, wait for them.
+	 * Do it outside of the catch block, see the comment
+	 * about fiber_sleep() in applier_f().
+	 */
+	while (applier->rows_in_flight > 0)
+		ipc_cond_wait(&applier->row_cond);
+	diag_raise();
 }
 
 /**
@@ -499,6 +612,8 @@ applier_new(const char *uri, struct xstream *initial_join_stream,
 	applier->last_row_time = ev_now(loop());
 	rlist_create(&applier->on_state);
 	ipc_channel_create(&applier->pause, 0);
+	ipc_cond_create(&applier->row_cond);
+	diag_create(&applier->diag);
 
 	return applier;
 }
@@ -510,6 +625,9 @@ applier_delete(struct applier *applier)
 	iobuf_delete(applier->iobuf);
 	assert(applier->io.fd == -1);
 	ipc_channel_destroy(&applier->pause);
+	assert(applier->rows_in_flight == 0);
+	ipc_cond_destroy(&applier->row_cond);
+	diag_destroy(&applier->diag);
 	trigger_destroy(&applier->on_state);
 	free(applier);
 }
@@ -41,6 +41,7 @@
 #include "third_party/tarantool_ev.h"
 #include "vclock.h"
 #include "ipc.h"
+#include "diag.h"
 
 struct xstream;
 
@@ -91,6 +92,16 @@ struct applier {
 	struct xstream *initial_join_stream;
 	struct xstream *final_join_stream;
 	struct xstream *subscribe_stream;
+	/** Number of rows being applied by row fibers. */
+	int rows_in_flight;
+	/** Sequence number of the last row passed to a row fiber. */
+	uint64_t last_row_seq;
+	/** Set when the last row passed to a row fiber is done. */
+	bool last_row_done;
+	/** Signalled when a row fiber is done. */
+	struct ipc_cond row_cond;
+	/** The first error of a row fiber, stops the applier. */
+	struct diag diag;
 };
 
 /**
@@ -47,6 +47,7 @@
 #include "engine.h"
 #include "memtx_engine.h"
 #include "memtx_index.h"
+#include "memtx_read_view.h"
 #include "sysview_engine.h"
 #include "vinyl_engine.h"
 #include "space.h"
@@ -325,6 +326,41 @@ box_check_readahead(int readahead)
 	}
 }
 
+static int
+box_check_memtx_build_threads(int memtx_build_threads)
+{
+	enum { MEMTX_BUILD_THREADS_MAX = 1000 };
+	if (memtx_build_threads < 1 ||
+	    memtx_build_threads > (int) MEMTX_BUILD_THREADS_MAX) {
+		tnt_raise(ClientError, ER_CFG, "memtx_build_threads",
+			  "specified value is out of bounds");
+	}
+	return memtx_build_threads;
+}
+
+static int
+box_check_snap_threads(int snap_threads)
+{
+	enum { SNAP_THREADS_MAX = 1000 };
+	if (snap_threads < 1 || snap_threads > (int) SNAP_THREADS_MAX) {
+		tnt_raise(ClientError, ER_CFG, "snap_threads",
+			  "specified value is out of bounds");
+	}
+	return snap_threads;
+}
+
+static enum xlog_compression
+box_check_snap_compression(const char *snap_compression)
+{
+	enum xlog_compression compression =
+		STR2ENUM(xlog_compression, snap_compression);
+	if (compression == xlog_compression_MAX) {
+		tnt_raise(ClientError, ER_CFG, "snap_compression",
+			  "must be one of 'none', 'zstd'");
+	}
+	return compression;
+}
+
 static int64_t
 box_check_rows_per_wal(int64_t rows_per_wal)
 {
@@ -336,6 +372,67 @@ box_check_rows_per_wal(int64_t rows_per_wal)
 	return rows_per_wal;
 }
 
+static int
+box_check_iproto_threads(int threads)
+{
+	if (threads <= 0 || threads > IPROTO_THREADS_MAX) {
+		tnt_raise(ClientError, ER_CFG, "iproto_threads",
+			  "specified value is out of bounds");
+	}
+	return threads;
+}
+
+static int64_t
+box_check_wal_group_commit_bytes(int64_t bytes)
+{
+	if (bytes < 0) {
+		tnt_raise(ClientError, ER_CFG, "wal_group_commit_bytes",
+			  "the value must not be negative");
+	}
+	return bytes;
+}
+
+static int64_t
+box_check_wal_group_commit_usec(int64_t usec)
+{
+	enum { WAL_GROUP_COMMIT_USEC_MAX = 1000000 };
+	if (usec < 0 || usec > WAL_GROUP_COMMIT_USEC_MAX) {
+		tnt_raise(ClientError, ER_CFG, "wal_group_commit_usec",
+			  "specified value is out of bounds");
+	}
+	return usec;
+}
+
+static int64_t
+box_check_wal_prealloc_size(int64_t size)
+{
+	if (size < 0) {
+		tnt_raise(ClientError, ER_CFG, "wal_prealloc_size",
+			  "the value must not be negative");
+	}
+	return size;
+}
+
+static int64_t
+box_check_wal_tail_size(int64_t wal_tail_size)
+{
+	if (wal_tail_size < 0) {
+		tnt_raise(ClientError, ER_CFG, "wal_tail_size",
+			  "the value must not be negative");
+	}
+	return wal_tail_size;
+}
+
+static double
+box_check_read_view_period(double period)
+{
+	if (period < 0) {
+		tnt_raise(ClientError, ER_CFG, "read_view_period",
+			  "the value must not be negative");
+	}
+	return period;
+}
+
 void
 box_check_config()
 {
@@ -343,9 +440,18 @@ box_check_config()
 	box_check_uri(cfg_gets("listen"), "listen");
 	box_check_replication_source();
 	box_check_readahead(cfg_geti("readahead"));
+	box_check_iproto_threads(cfg_geti("iproto_threads"));
 	box_check_rows_per_wal(cfg_geti64("rows_per_wal"));
 	box_check_wal_mode(cfg_gets("wal_mode"));
+	box_check_wal_tail_size(cfg_geti64("wal_tail_size"));
+	box_check_wal_group_commit_bytes(cfg_geti64("wal_group_commit_bytes"));
+	box_check_wal_group_commit_usec(cfg_geti64("wal_group_commit_usec"));
+	box_check_wal_prealloc_size(cfg_geti64("wal_prealloc_size"));
 	box_check_slab_alloc_minimal(cfg_geti64("slab_alloc_minimal"));
+	box_check_memtx_build_threads(cfg_geti("memtx_build_threads"));
+	box_check_snap_threads(cfg_geti("snap_threads"));
+	box_check_snap_compression(cfg_gets("snap_compression"));
+	box_check_read_view_period(cfg_getd("read_view_period"));
 }
 
 /*
@@ -468,6 +574,13 @@ box_set_readahead(void)
 	iobuf_set_readahead(readahead);
 }
 
+extern "C" void
+box_set_read_view_period(void)
+{
+	memtx_read_view_set_period(box_check_read_view_period(
+		cfg_getd("read_view_period")));
+}
+
 /* }}} configuration bindings */
 
 /**
@@ -869,12 +982,9 @@ func_call(struct func *func, struct request *request, struct obuf *out)
 
 	if (request->type == IPROTO_CALL_16) {
 		/* Tarantool < 1.7.1 compatibility */
-		for (struct port_entry *entry = port.first;
-		     entry != NULL; entry = entry->next) {
-			if (tuple_to_obuf(entry->tuple, out) != 0) {
-				obuf_rollback_to_svp(out, &svp);
-				goto error;
-			}
+		if (port_to_obuf(&port, out) != 0) {
+			obuf_rollback_to_svp(out, &svp);
+			goto error;
 		}
 		iproto_reply_select(out, &svp, request->header->sync, port.size);
 	} else {
@@ -884,12 +994,9 @@ func_call(struct func *func, struct request *request, struct obuf *out)
 		if (size_buf == NULL)
 			goto error;
 		mp_encode_array(size_buf, port.size);
-		for (struct port_entry *entry = port.first;
-		     entry != NULL; entry = entry->next) {
-			if (tuple_to_obuf(entry->tuple, out) != 0) {
-				obuf_rollback_to_svp(out, &svp);
-				goto error;
-			}
+		if (port_to_obuf(&port, out) != 0) {
+			obuf_rollback_to_svp(out, &svp);
+			goto error;
 		}
 		iproto_reply_select(out, &svp, request->header->sync, 1);
 	}
@@ -1218,6 +1325,7 @@ box_free(void)
 		tuple_free();
 		port_free();
 #endif
+		memtx_read_view_free();
 		engine_shutdown();
 	}
 }
@@ -1234,6 +1342,10 @@ engine_init()
 	MemtxEngine *memtx = new MemtxEngine(cfg_gets("snap_dir"),
 					     cfg_geti("panic_on_snap_error"),
 					     cfg_geti("panic_on_wal_error"));
+	memtx->setBuildThreads(cfg_geti("memtx_build_threads"));
+	memtx->setSnapThreads(cfg_geti("snap_threads"));
+	memtx->setSnapCompression(box_check_snap_compression(
+		cfg_gets("snap_compression")));
 	engine_register(memtx);
 
 	SysviewEngine *sysview = new SysviewEngine();
@@ -1407,7 +1519,8 @@ box_init(void)
 		/* Start network */
 		assert(!tt_uuid_is_nil(&SERVER_UUID));
 		port_init();
-		iproto_init();
+		iproto_init(box_check_iproto_threads(
+			cfg_geti("iproto_threads")));
 		box_set_listen();
 		recovery_finalize(recovery, &wal_stream.base);
 
@@ -1424,7 +1537,8 @@ box_init(void)
 		/* Start network */
 		tt_uuid_create(&SERVER_UUID);
 		port_init();
-		iproto_init();
+		iproto_init(box_check_iproto_threads(
+			cfg_geti("iproto_threads")));
 		box_set_listen();
 		box_sync_replication_source();
 
@@ -1435,13 +1549,25 @@ box_init(void)
 
 	int64_t rows_per_wal = box_check_rows_per_wal(cfg_geti64("rows_per_wal"));
 	enum wal_mode wal_mode = box_check_wal_mode(cfg_gets("wal_mode"));
+	int64_t wal_tail_size =
+		box_check_wal_tail_size(cfg_geti64("wal_tail_size"));
+	int64_t group_commit_bytes = box_check_wal_group_commit_bytes(
+		cfg_geti64("wal_group_commit_bytes"));
+	int64_t group_commit_usec = box_check_wal_group_commit_usec(
+		cfg_geti64("wal_group_commit_usec"));
+	int64_t prealloc_size =
+		box_check_wal_prealloc_size(cfg_geti64("wal_prealloc_size"));
 	if (wal_mode != WAL_NONE) {
 		wal_writer_start(wal_mode, cfg_gets("wal_dir"), &SERVER_UUID,
-				 &recovery->vclock, rows_per_wal);
+				 &recovery->vclock, rows_per_wal,
+				 wal_tail_size, group_commit_bytes,
+				 group_commit_usec, prealloc_size);
 	}
 
 	rmean_cleanup(rmean_box);
 
+	memtx_read_view_init();
+
 	/* Follow replica */
 	server_foreach(server) {
 		if (server->applier != NULL)
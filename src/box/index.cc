@@ -38,6 +38,7 @@
 #include "request.h"
 #include "txn.h"
 #include "rmean.h"
+#include "fiber.h"
 
 const char *iterator_type_strs[] = {
 	/* [ITER_EQ]  = */ "EQ",
@@ -231,6 +232,35 @@ Index::findByKey(const char *key, uint32_t part_count) const
 	return NULL;
 }
 
+/**
+ * Free found tuples which are not referenced by anyone, e.g.
+ * vinyl ones, when they won't be passed to the caller.
+ */
+static void
+index_free_unused_tuples(struct tuple **tuples, uint32_t n)
+{
+	for (uint32_t i = 0; i < n; i++) {
+		if (tuples[i] != NULL && tuples[i]->refs == 0) {
+			tuple_ref(tuples[i]);
+			tuple_unref(tuples[i]);
+		}
+	}
+}
+
+void
+Index::findByKeys(const char **keys, uint32_t part_count, uint32_t n,
+		  struct tuple **result) const
+{
+	uint32_t i = 0;
+	try {
+		for (; i < n; i++)
+			result[i] = findByKey(keys[i], part_count);
+	} catch (Exception *) {
+		index_free_unused_tuples(result, i);
+		throw;
+	}
+}
+
 struct tuple *
 Index::findByTuple(struct tuple *tuple) const
 {
@@ -374,6 +404,61 @@ box_index_get(uint32_t space_id, uint32_t index_id, const char *key,
 	}
 }
 
+int
+box_index_get_many(uint32_t space_id, uint32_t index_id, const char **keys,
+		   uint32_t n, box_tuple_t **results)
+{
+	assert(keys != NULL || n == 0);
+	assert(results != NULL || n == 0);
+	struct region *region = &fiber()->gc;
+	size_t region_svp = region_used(region);
+	try {
+		struct space *space;
+		Index *index = check_index(space_id, index_id, &space);
+		if (!index->key_def->opts.is_unique)
+			tnt_raise(ClientError, ER_MORE_THAN_ONE_TUPLE);
+		uint32_t part_count = index->key_def->part_count;
+		/* Keys without the MsgPack array header. */
+		const char **parts = (const char **)
+			region_alloc_xc(region, sizeof(*parts) * n);
+		for (uint32_t i = 0; i < n; i++) {
+			const char *key = keys[i];
+			assert(mp_typeof(*key) == MP_ARRAY);
+			uint32_t key_part_count = mp_decode_array(&key);
+			primary_key_validate(index->key_def, key,
+					     key_part_count);
+			parts[i] = key;
+		}
+		/* Start transaction in the engine. */
+		struct txn *txn = txn_begin_ro_stmt(space);
+		index->findByKeys(parts, part_count, n, results);
+		/* Count statistics */
+		rmean_collect(rmean_box, IPROTO_SELECT, n);
+
+		txn_commit_ro_stmt(txn);
+		region_truncate(region, region_svp);
+	}  catch (Exception *) {
+		txn_rollback_stmt();
+		region_truncate(region, region_svp);
+		return -1;
+	}
+	for (uint32_t i = 0; i < n; i++) {
+		if (results[i] == NULL)
+			continue;
+		try {
+			tuple_ref(results[i]);
+		} catch (Exception *) {
+			for (uint32_t j = 0; j < i; j++) {
+				if (results[j] != NULL)
+					tuple_unref(results[j]);
+			}
+			index_free_unused_tuples(results + i, n - i);
+			return -1;
+		}
+	}
+	return 0;
+}
+
 int
 box_index_min(uint32_t space_id, uint32_t index_id, const char *key,
 	      const char *key_end, box_tuple_t **result)
@@ -454,6 +539,23 @@ box_index_count(uint32_t space_id, uint32_t index_id, int type,
 
 /* {{{ Iterators ************************************************/
 
+uint32_t
+iterator_next_batch(struct iterator *it, struct tuple **buf, uint32_t n)
+{
+	if (it->next_batch != NULL)
+		return it->next_batch(it, buf, n);
+	uint32_t count = 0;
+	struct tuple *tuple;
+	try {
+		while (count < n && (tuple = it->next(it)) != NULL)
+			buf[count++] = tuple;
+	} catch (Exception *) {
+		index_free_unused_tuples(buf, count);
+		throw;
+	}
+	return count;
+}
+
 box_iterator_t *
 box_index_iterator(uint32_t space_id, uint32_t index_id, int type,
                    const char *key, const char *key_end)
@@ -470,6 +572,8 @@ box_index_iterator(uint32_t space_id, uint32_t index_id, int type,
 		it = index->allocIterator();
 		index->initIterator(it, itype, key, part_count);
 		it->sc_version = sc_version;
+		it->batch_size = 0;
+		it->write_count = txn_write_count;
 		it->space_id = space_id;
 		it->index_id = index_id;
 		it->index = index;
@@ -488,29 +592,45 @@ box_index_iterator(uint32_t space_id, uint32_t index_id, int type,
 	}
 }
 
+bool
+box_iterator_is_valid(box_iterator_t *itr)
+{
+	if (itr->sc_version == sc_version)
+		return true;
+	try {
+		struct space *space;
+		/* no tx management */
+		Index *index = check_index(itr->space_id, itr->index_id,
+					   &space);
+		if (index != itr->index)
+			return false;
+		if (index->sc_version > itr->sc_version)
+			return false;
+		itr->sc_version = sc_version;
+		return true;
+	} catch (Exception *) {
+		return false;
+	}
+}
+
+uint32_t
+box_iterator_batch_size(box_iterator_t *itr, uint32_t n)
+{
+	if (itr->write_count != txn_write_count || itr->batch_size == 0)
+		itr->batch_size = 1;
+	else
+		itr->batch_size = MIN(itr->batch_size * 2, n);
+	itr->write_count = txn_write_count;
+	return MIN(itr->batch_size, n);
+}
+
 int
 box_iterator_next(box_iterator_t *itr, box_tuple_t **result)
 {
 	assert(result != NULL);
-	try {
-		if (itr->sc_version != sc_version) {
-			struct space *space;
-			/* no tx management */
-			Index *index = check_index(itr->space_id, itr->index_id,
-						   &space);
-			if (index != itr->index) {
-				*result = NULL;
-				return 0;
-			}
-			if (index->sc_version > itr->sc_version) {
-				*result = NULL; /* invalidate iterator */
-				return 0;
-			}
-			itr->sc_version = sc_version;
-		}
-	} catch (Exception *) {
-		*result = NULL;
-		return 0; /* invalidate iterator */
+	if (!box_iterator_is_valid(itr)) {
+		*result = NULL; /* invalidate iterator */
+		return 0;
 	}
 	try {
 		struct tuple *tuple = itr->next(itr);
@@ -521,6 +641,29 @@ box_iterator_next(box_iterator_t *itr, box_tuple_t **result)
 	}
 }
 
+ssize_t
+box_iterator_next_batch(box_iterator_t *itr, box_tuple_t **buf, uint32_t n)
+{
+	if (!box_iterator_is_valid(itr))
+		return 0; /* invalidate iterator */
+	uint32_t count;
+	try {
+		count = iterator_next_batch(itr, buf, n);
+	} catch (Exception *) {
+		return -1;
+	}
+	for (uint32_t i = 0; i < count; i++) {
+		try {
+			tuple_ref(buf[i]);
+		} catch (Exception *) {
+			for (uint32_t j = 0; j < i; j++)
+				tuple_unref(buf[j]);
+			return -1;
+		}
+	}
+	return count;
+}
+
 void
 box_iterator_free(box_iterator_t *it)
 {
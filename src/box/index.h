@@ -110,6 +110,22 @@ box_index_iterator(uint32_t space_id, uint32_t index_id, int type,
 int
 box_iterator_next(box_iterator_t *iterator, box_tuple_t **result);
 
+/**
+ * Retrieve up to \a n next items from the \a iterator.
+ * A batched form of box_iterator_next(): every returned tuple
+ * is referenced and must be released with box_tuple_unref().
+ *
+ * \param iterator an iterator returned by box_index_iterator().
+ * \param[out] buf an array of at least \a n tuple pointers.
+ * \param n the maximal number of tuples to fetch.
+ * \retval -1 on error (check box_error_last() for details)
+ * \retval >= 0 the number of tuples stored in \a buf. It is less
+ * than \a n only at the end of data.
+ */
+ssize_t
+box_iterator_next_batch(box_iterator_t *iterator, box_tuple_t **buf,
+			uint32_t n);
+
 /**
  * Destroy and deallocate iterator.
  *
@@ -180,6 +196,30 @@ int
 box_index_get(uint32_t space_id, uint32_t index_id, const char *key,
 	      const char *key_end, box_tuple_t **result);
 
+/**
+ * Get tuples from index by \a n keys at once.
+ *
+ * A batched form of box_index_get(): lookups of different keys
+ * are interleaved to hide memory latency, so it is faster than
+ * calling box_index_get() in a loop. Every found tuple is
+ * referenced and must be released with box_tuple_unref().
+ *
+ * \param space_id space identifier
+ * \param index_id index identifier
+ * \param keys an array of \a n keys, each encoded in MsgPack
+ * Array format ([part1, part2, ...]).
+ * \param n the number of keys
+ * \param[out] results an array of at least \a n tuple pointers,
+ * results[i] is the tuple matching keys[i] or NULL if there
+ * is none.
+ * \retval -1 on error (check box_error_last())
+ * \retval 0 on success
+ * \sa \code box.space[space_id].index[index_id]:get_many(keys) \endcode
+ */
+int
+box_index_get_many(uint32_t space_id, uint32_t index_id, const char **keys,
+		   uint32_t n, box_tuple_t **results);
+
 /**
  * Return a first (minimal) tuple matched the provided key.
  *
@@ -237,6 +277,25 @@ box_index_count(uint32_t space_id, uint32_t index_id, int type,
 
 /** \endcond public */
 
+/**
+ * Check that the index of the iterator was not dropped or
+ * altered since the iterator was created.
+ * FFI-friendly, used by index:pairs() to serve prefetched
+ * tuples.
+ */
+bool
+box_iterator_is_valid(box_iterator_t *iterator);
+
+/**
+ * Return how many tuples index:pairs() may prefetch, up to
+ * @a n. Prefetched tuples don't see changes made after they
+ * were fetched, so the batch is one tuple after a write and
+ * grows twice with every batch fetched without writes.
+ * FFI-friendly.
+ */
+uint32_t
+box_iterator_batch_size(box_iterator_t *iterator, uint32_t n);
+
 extern const char *iterator_type_strs[];
 
 #if defined(__cplusplus)
@@ -245,14 +304,35 @@ extern const char *iterator_type_strs[];
 
 struct iterator {
 	struct tuple *(*next)(struct iterator *);
+	/**
+	 * Optional: fetch up to n tuples at once, see
+	 * iterator_next_batch(). NULL if the index has
+	 * no faster way than calling next() in a loop.
+	 */
+	uint32_t (*next_batch)(struct iterator *, struct tuple **, uint32_t);
 	void (*free)(struct iterator *);
 	/* optional parameters used in lua */
 	uint32_t sc_version;
+	/** See box_iterator_batch_size(). */
+	uint32_t batch_size;
+	/** txn_write_count when the last batch was fetched. */
+	uint64_t write_count;
 	uint32_t space_id;
 	uint32_t index_id;
 	class Index *index;
 };
 
+/**
+ * Fetch up to @a n tuples from the iterator into @a buf.
+ * The tuples are not referenced, the same as ones returned
+ * by iterator->next().
+ *
+ * @return the number of tuples stored in @a buf. It is less
+ * than @a n only if the iterator is exhausted.
+ */
+uint32_t
+iterator_next_batch(struct iterator *it, struct tuple **buf, uint32_t n);
+
 static inline bool
 iterator_type_is_reverse(enum iterator_type type)
 {
@@ -331,6 +411,13 @@ public:
 	virtual size_t count(enum iterator_type type, const char *key,
 			     uint32_t part_count) const;
 	virtual struct tuple *findByKey(const char *key, uint32_t part_count) const;
+	/**
+	 * Look up @a n full keys of @a part_count parts each and
+	 * store the found tuples, or NULL, in @a result. The
+	 * default implementation calls findByKey() in a loop.
+	 */
+	virtual void findByKeys(const char **keys, uint32_t part_count,
+				uint32_t n, struct tuple **result) const;
 	virtual struct tuple *findByTuple(struct tuple *tuple) const;
 	virtual struct tuple *replace(struct tuple *old_tuple,
 				      struct tuple *new_tuple,
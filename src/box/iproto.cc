@@ -33,6 +33,8 @@
 #include <stdint.h>
 #include <stdarg.h>
 #include <stdio.h>
+#include <unistd.h>
+#include <fcntl.h>
 
 #include <msgpuck.h>
 #include "third_party/base64.h"
@@ -53,15 +55,80 @@
 #include "request.h"
 #include "box.h"
 #include "tuple.h"
+#include "index.h" /* box_index_get_many() */
 #include "session.h"
+#include "txn.h"
 #include "xrow.h"
 #include "schema.h" /* sc_version */
+#include "memtx_read_view.h"
 #include "cluster.h" /* server_uuid */
 #include "iproto_constants.h"
 #include "rmean.h"
 
-/* The number of iproto messages in flight */
+/* The number of iproto messages in flight, per network thread */
 enum { IPROTO_MSG_MAX = 768 };
+/**
+ * The max number of DML requests of a connection coalesced into
+ * one transaction, see tx_process_dml_batch().
+ */
+enum { IPROTO_DML_BATCH_MAX = 64 };
+/** Initial size of the read view output buffer. */
+enum { IPROTO_RV_OUT_SIZE = 16384 };
+
+enum rmean_net_name {
+	IPROTO_SENT,
+	IPROTO_RECEIVED,
+	IPROTO_LAST,
+};
+
+const char *rmean_net_strings[IPROTO_LAST] = { "SENT", "RECEIVED" };
+
+/**
+ * A network io thread. Client connections are spread among
+ * the threads, and each thread has its own bus to the tx
+ * thread, so the threads don't contend with each other.
+ * Connections are accepted by the first thread and handed
+ * over to the thread which serves the fewest connections.
+ */
+struct iproto_thread
+{
+	/** Thread number, the first thread accepts connections. */
+	int id;
+	struct cord cord;
+	/** Requests from this thread to the tx thread. */
+	struct cpipe tx_pipe;
+	/** Responses from the tx thread to this thread. */
+	struct cpipe net_pipe;
+	struct cbus net_tx_bus;
+	struct mempool iproto_msg_pool;
+	struct mempool iproto_connection_pool;
+	/** SENT and RECEIVED statistics of the thread. */
+	struct rmean *rmean_net;
+	/**
+	 * The number of connections of this thread, including
+	 * ones handed over but not picked up yet.
+	 */
+	int connection_count;
+	/** Connections handed over by the first thread. */
+	int accept_pipe[2];
+	struct ev_io accept_input;
+	/* Message routes, leading back to this thread. */
+	struct cmsg_hop disconnect_route[2];
+	struct cmsg_hop misc_route[2];
+	struct cmsg_hop select_route[2];
+	struct cmsg_hop get_many_route[2];
+	struct cmsg_hop process1_route[2];
+	struct cmsg_hop dml_batch_route[2];
+	struct cmsg_hop sync_route[2];
+	struct cmsg_hop connect_route[2];
+	struct cmsg_hop chunk_route[2];
+	const struct cmsg_hop *dml_route[IPROTO_TYPE_STAT_MAX];
+};
+
+static struct iproto_thread *iproto_threads;
+static int iproto_threads_count;
+/** The network thread of the current cord. */
+static __thread struct iproto_thread *iproto_thread;
 
 /* {{{ iproto_msg - declaration */
 
@@ -99,15 +166,21 @@ struct iproto_msg: public cmsg
 	 * and the connection must be closed.
 	 */
 	bool close_connection;
+	/**
+	 * DML requests routed to tx together, including this
+	 * one, which goes first. Only used in the message which
+	 * is routed, see struct IprotoDmlBatch.
+	 */
+	struct stailq batch;
+	/** Link in the batch. */
+	struct stailq_entry in_batch;
 };
 
-static struct mempool iproto_msg_pool;
-
 static struct iproto_msg *
 iproto_msg_new(struct iproto_connection *con)
 {
-	struct iproto_msg *msg =
-		(struct iproto_msg *) mempool_alloc_xc(&iproto_msg_pool);
+	struct iproto_msg *msg = (struct iproto_msg *)
+		mempool_alloc_xc(&iproto_thread->iproto_msg_pool);
 	msg->connection = con;
 	return msg;
 }
@@ -115,9 +188,62 @@ iproto_msg_new(struct iproto_connection *con)
 static inline void
 iproto_msg_delete(struct cmsg *msg)
 {
-	mempool_free(&iproto_msg_pool, msg);
+	mempool_free(&iproto_thread->iproto_msg_pool, msg);
 }
 
+/**
+ * Tuples of at least this size are written to the socket right
+ * from the tuple arena instead of being copied to an output
+ * buffer, see struct iproto_splice.
+ */
+enum { IPROTO_SPLICE_MIN = 4096 };
+
+/** The max number of iovecs in one writev() of a chunk. */
+enum { IPROTO_CHUNK_IOV_MAX = 128 };
+
+/**
+ * A tuple sent by reference. The tuple is referenced in tx
+ * until the network thread has written it to the socket, the
+ * network thread only reads the tuple data.
+ */
+struct iproto_splice {
+	/** Offset in the chunk buffer the tuple goes at. */
+	size_t offset;
+	struct tuple *tuple;
+	const char *data;
+	uint32_t size;
+};
+
+/**
+ * A chunk of a SELECT response, see tx_process_select_chunked()
+ * and tx_reply_select_spliced(). Travels from tx to the network
+ * thread of the connection, which writes the chunk to the
+ * socket and sends the message back to let tx reuse the chunk
+ * buffer and release the spliced tuples. This way a response
+ * of any size takes at most two chunks of memory, and is
+ * produced no faster than the client reads it.
+ */
+struct iproto_chunk_msg: public cmsg
+{
+	struct iproto_connection *connection;
+	/** The packet, allocated in tx. */
+	struct obuf buf;
+	/** Tuples inserted into the packet, ordered by offset. */
+	struct iproto_splice *splices;
+	uint32_t splice_count;
+	uint32_t splice_capacity;
+	/** The total size of the spliced tuples. */
+	size_t splice_size;
+	/** Link in iproto_connection::chunks. */
+	struct stailq_entry in_chunks;
+	/** The tx fiber producing the response. */
+	struct fiber *fiber;
+	/** Set when the message is back in tx. */
+	bool is_done;
+	/** Set if the chunk wasn't sent, the client is gone. */
+	bool is_closed;
+};
+
 struct IprotoMsgGuard {
 	struct iproto_msg *msg;
 	IprotoMsgGuard(struct iproto_msg *msg_arg):msg(msg_arg) {}
@@ -132,8 +258,9 @@ struct IprotoMsgGuard {
 /* {{{ iproto connection and requests */
 
 /**
- * A single global queue for all requests in all connections. All
- * requests from all connections are processed concurrently.
+ * A queue of each network thread for all requests in all its
+ * connections (iproto_thread::tx_pipe). All requests from all
+ * connections are processed concurrently.
  * Is also used as a queue for just established connections and to
  * execute disconnect triggers. A few notes about these triggers:
  * - they need to be run in a fiber
@@ -142,23 +269,9 @@ struct IprotoMsgGuard {
  * - on_connect trigger must be processed before any other
  *   request on this connection.
  */
-static struct cpipe tx_pipe;
-static struct cpipe net_pipe;
-static struct cbus net_tx_bus;
 /* A pointer to the transaction processor cord. */
 struct cord *tx_cord;
 
-struct rmean *rmean_net;
-struct rmean *rmean_net_tx_bus;
-
-enum rmean_net_name {
-	IPROTO_SENT,
-	IPROTO_RECEIVED,
-	IPROTO_LAST,
-};
-
-const char *rmean_net_strings[IPROTO_LAST] = { "SENT", "RECEIVED" };
-
 /** Context of a single client connection. */
 struct iproto_connection
 {
@@ -187,11 +300,71 @@ struct iproto_connection
 	/** Logical session. */
 	struct session *session;
 	ev_loop *loop;
+	/** The network thread serving the connection. */
+	struct iproto_thread *thread;
+	/**
+	 * Replies to requests executed in the network thread
+	 * against a memtx read view. Unlike iobuf output,
+	 * allocated in the network thread.
+	 */
+	struct obuf rv_out;
+	/** How much of rv_out has been sent. */
+	size_t rv_sent;
+	/**
+	 * Chunks of streamed responses waiting to be sent,
+	 * struct iproto_chunk_msg. A chunk is only started
+	 * between packets of other output, and once started,
+	 * it goes before any other output.
+	 */
+	struct stailq chunks;
+	/** How much of the first of the chunks has been sent. */
+	size_t chunk_sent;
 	/* Pre-allocated disconnect msg. */
 	struct iproto_msg *disconnect;
 };
 
-static struct mempool iproto_connection_pool;
+/**
+ * Consecutive DML requests of a connection, collected while
+ * the input is parsed to be routed to tx in one message, see
+ * tx_process_dml_batch(). The requests are routed as soon as
+ * another kind of request comes up, the batch is full or goes
+ * out of scope.
+ */
+struct IprotoDmlBatch {
+	struct iproto_connection *con;
+	struct iproto_msg *first;
+	int size;
+	IprotoDmlBatch(struct iproto_connection *con_arg)
+		:con(con_arg), first(NULL), size(0) {}
+	~IprotoDmlBatch() { push(); }
+
+	void add(struct iproto_msg *msg)
+	{
+		if (first == NULL) {
+			first = msg;
+			stailq_create(&first->batch);
+		}
+		stailq_add_tail_entry(&first->batch, msg, in_batch);
+		if (++size == IPROTO_DML_BATCH_MAX)
+			push();
+	}
+
+	void push()
+	{
+		if (first == NULL)
+			return;
+		/* A lone request takes the usual route. */
+		if (size == 1) {
+			cmsg_init(first,
+				  con->thread->dml_route[first->header.type]);
+		} else {
+			cmsg_init(first, con->thread->dml_batch_route);
+		}
+		cpipe_push_input(&con->thread->tx_pipe, first);
+		first = NULL;
+		size = 0;
+	}
+};
 
 /**
  * A connection is idle when the client is gone
@@ -236,9 +409,12 @@ iproto_connection_delete(struct iproto_connection *con)
 	 */
 	iobuf_delete_mt(con->iobuf[0]);
 	iobuf_delete_mt(con->iobuf[1]);
+	obuf_destroy(&con->rv_out);
 	if (con->disconnect)
 		iproto_msg_delete(con->disconnect);
-	mempool_free(&iproto_connection_pool, con);
+	__atomic_sub_fetch(&con->thread->connection_count, 1,
+			   __ATOMIC_RELAXED);
+	mempool_free(&con->thread->iproto_connection_pool, con);
 }
 
 static void
@@ -248,7 +424,13 @@ tx_process1(struct cmsg *msg);
 static void
 tx_process_select(struct cmsg *msg);
 static void
+tx_process_get_many(struct cmsg *msg);
+static void
 net_send_msg(struct cmsg *msg);
+static void
+tx_process_dml_batch(struct cmsg *msg);
+static void
+net_send_dml_batch(struct cmsg *msg);
 
 static void
 tx_process_join_subscribe(struct cmsg *msg);
@@ -292,65 +474,103 @@ net_finish_disconnect(struct cmsg *m)
 	iproto_msg_delete(msg);
 }
 
-static const struct cmsg_hop disconnect_route[] = {
-	{ tx_process_disconnect, &net_pipe },
-	{ net_finish_disconnect, NULL },
-};
-
-static const struct cmsg_hop misc_route[] = {
-	{ tx_process_misc, &net_pipe },
-	{ net_send_msg, NULL },
-};
-
-static const struct cmsg_hop select_route[] = {
-	{ tx_process_select, &net_pipe },
-	{ net_send_msg, NULL },
-};
-
-static const struct cmsg_hop process1_route[] = {
-	{ tx_process1, &net_pipe },
-	{ net_send_msg, NULL },
-};
+static void
+tx_process_connect(struct cmsg *msg);
+static void
+net_send_greeting(struct cmsg *msg);
+static void
+net_send_chunk(struct cmsg *msg);
+static void
+tx_end_chunk(struct cmsg *msg);
 
-static const struct cmsg_hop *dml_route[IPROTO_TYPE_STAT_MAX] = {
-	NULL,                                   /* IPROTO_OK */
-	select_route,                           /* IPROTO_SELECT */
-	process1_route,                         /* IPROTO_INSERT */
-	process1_route,                         /* IPROTO_REPLACE */
-	process1_route,                         /* IPROTO_UPDATE */
-	process1_route,                         /* IPROTO_DELETE */
-	misc_route,                             /* IPROTO_CALL_16 */
-	misc_route,                             /* IPROTO_AUTH */
-	misc_route,                             /* IPROTO_EVAL */
-	process1_route,                         /* IPROTO_UPSERT */
-	misc_route                              /* IPROTO_CALL */
-};
+/** Set a route of two hops: to tx and back to the thread. */
+static inline void
+iproto_route_init(struct cmsg_hop *route, cmsg_f tx_f, cmsg_f net_f,
+		  struct iproto_thread *thread)
+{
+	route[0].f = tx_f;
+	route[0].pipe = &thread->net_pipe;
+	route[1].f = net_f;
+	route[1].pipe = NULL;
+}
 
-static const struct cmsg_hop sync_route[] = {
-	{ tx_process_join_subscribe, &net_pipe },
-	{ net_end_join_subscribe, NULL },
-};
+/** Initialize message routes of a network thread. */
+static void
+iproto_thread_init_routes(struct iproto_thread *thread)
+{
+	iproto_route_init(thread->disconnect_route, tx_process_disconnect,
+			  net_finish_disconnect, thread);
+	iproto_route_init(thread->misc_route, tx_process_misc,
+			  net_send_msg, thread);
+	iproto_route_init(thread->select_route, tx_process_select,
+			  net_send_msg, thread);
+	iproto_route_init(thread->get_many_route, tx_process_get_many,
+			  net_send_msg, thread);
+	iproto_route_init(thread->process1_route, tx_process1,
+			  net_send_msg, thread);
+	iproto_route_init(thread->dml_batch_route, tx_process_dml_batch,
+			  net_send_dml_batch, thread);
+	iproto_route_init(thread->sync_route, tx_process_join_subscribe,
+			  net_end_join_subscribe, thread);
+	iproto_route_init(thread->connect_route, tx_process_connect,
+			  net_send_greeting, thread);
+	/*
+	 * A chunk goes in the opposite direction and is sent
+	 * back to tx explicitly, see iproto_chunk_return().
+	 */
+	thread->chunk_route[0].f = net_send_chunk;
+	thread->chunk_route[0].pipe = NULL;
+	thread->chunk_route[1].f = tx_end_chunk;
+	thread->chunk_route[1].pipe = NULL;
+
+	const struct cmsg_hop **dml_route = thread->dml_route;
+	dml_route[IPROTO_OK] = NULL;
+	dml_route[IPROTO_SELECT] = thread->select_route;
+	dml_route[IPROTO_INSERT] = thread->process1_route;
+	dml_route[IPROTO_REPLACE] = thread->process1_route;
+	dml_route[IPROTO_UPDATE] = thread->process1_route;
+	dml_route[IPROTO_DELETE] = thread->process1_route;
+	dml_route[IPROTO_CALL_16] = thread->misc_route;
+	dml_route[IPROTO_AUTH] = thread->misc_route;
+	dml_route[IPROTO_EVAL] = thread->misc_route;
+	dml_route[IPROTO_UPSERT] = thread->process1_route;
+	dml_route[IPROTO_CALL] = thread->misc_route;
+}
 
 static struct iproto_connection *
-iproto_connection_new(const char *name, int fd)
+iproto_connection_new(int fd)
 {
-	(void) name;
+	struct iproto_thread *thread = iproto_thread;
 	struct iproto_connection *con = (struct iproto_connection *)
-		mempool_alloc_xc(&iproto_connection_pool);
+		mempool_alloc_xc(&thread->iproto_connection_pool);
 	con->input.data = con->output.data = con;
 	con->loop = loop();
+	con->thread = thread;
 	ev_io_init(&con->input, iproto_connection_on_input, fd, EV_READ);
 	ev_io_init(&con->output, iproto_connection_on_output, fd, EV_WRITE);
 	con->iobuf[0] = iobuf_new_mt(&tx_cord->slabc);
 	con->iobuf[1] = iobuf_new_mt(&tx_cord->slabc);
+	obuf_create(&con->rv_out, &cord()->slabc, IPROTO_RV_OUT_SIZE);
+	con->rv_sent = 0;
+	stailq_create(&con->chunks);
+	con->chunk_sent = 0;
 	con->parse_size = 0;
 	con->session = NULL;
 	/* It may be very awkward to allocate at close. */
 	con->disconnect = iproto_msg_new(con);
-	cmsg_init(con->disconnect, disconnect_route);
+	cmsg_init(con->disconnect, thread->disconnect_route);
 	return con;
 }
 
+/** Send a chunk message back to tx. */
+static inline void
+iproto_chunk_return(struct iproto_chunk_msg *chunk)
+{
+	/* See chunk_route in iproto_thread_init_routes(). */
+	chunk->hop++;
+	cpipe_push(&chunk->connection->thread->tx_pipe, chunk);
+}
+
 /**
  * Initiate a connection shutdown. This method may
  * be invoked many times, and does the internal
@@ -375,6 +595,16 @@ iproto_connection_close(struct iproto_connection *con)
 		 * is done only once.
 		 */
 		con->iobuf[0]->in.wpos -= con->parse_size;
+		/* Stop streamed responses. */
+		while (! stailq_empty(&con->chunks)) {
+			struct iproto_chunk_msg *chunk =
+				stailq_shift_entry(&con->chunks,
+						   struct iproto_chunk_msg,
+						   in_chunks);
+			chunk->is_closed = true;
+			iproto_chunk_return(chunk);
+		}
+		con->chunk_sent = 0;
 	}
 	/*
 	 * If the connection has no outstanding requests in the
@@ -392,7 +622,7 @@ iproto_connection_close(struct iproto_connection *con)
 		assert(con->disconnect != NULL);
 		struct iproto_msg *msg = con->disconnect;
 		con->disconnect = NULL;
-		cpipe_push(&tx_pipe, msg);
+		cpipe_push(&con->thread->tx_pipe, msg);
 	}
 }
 
@@ -489,11 +719,68 @@ iproto_connection_input_iobuf(struct iproto_connection *con)
 	return newbuf;
 }
 
+/**
+ * Check if a request may be coalesced with the neighbouring
+ * ones into one transaction, see tx_process_dml_batch().
+ */
+static inline bool
+iproto_type_is_batched(uint32_t type)
+{
+	switch (type) {
+	case IPROTO_INSERT:
+	case IPROTO_REPLACE:
+	case IPROTO_UPDATE:
+	case IPROTO_DELETE:
+	case IPROTO_UPSERT:
+		return true;
+	default:
+		return false;
+	}
+}
+
+/**
+ * Try to execute a SELECT in the network thread against a memtx
+ * read view, see memtx_read_view.h. Only possible if all previous
+ * requests of the connection have been answered and the answers
+ * have been sent, otherwise the answers could be reordered.
+ * @retval true the request has been answered, the answer is in
+ * con->rv_out.
+ */
+static bool
+iproto_select_from_read_view(struct iproto_connection *con,
+			     struct iproto_msg *msg, const char *reqstart)
+{
+	if (con->session == NULL ||
+	    con->iobuf[0]->in.rpos != reqstart ||
+	    ibuf_used(&con->iobuf[1]->in) != 0 ||
+	    con->iobuf[0]->out.wpos.used != con->iobuf[0]->out.wend.used ||
+	    con->iobuf[1]->out.wpos.used != con->iobuf[1]->out.wend.used)
+		return false;
+	if (msg->header.schema_id && msg->header.schema_id != sc_version)
+		return false;
+	struct request *req = &msg->request;
+	struct obuf *out = &con->rv_out;
+	struct obuf_svp svp;
+	uint32_t count;
+	if (iproto_prepare_select(out, &svp) != 0)
+		return false;
+	if (memtx_read_view_select(&con->session->credentials,
+				   req->space_id, req->index_id,
+				   req->iterator, req->offset, req->limit,
+				   req->key, out, &count) != 0) {
+		obuf_rollback_to_svp(out, &svp);
+		return false;
+	}
+	iproto_reply_select(out, &svp, msg->header.sync, count);
+	return true;
+}
+
 /** Enqueue all requests which were read up. */
 static inline void
 iproto_enqueue_batch(struct iproto_connection *con, struct ibuf *in)
 {
 	bool stop_input = false;
+	IprotoDmlBatch batch(con);
 	while (con->parse_size && stop_input == false) {
 		const char *reqstart = in->wpos - con->parse_size;
 		const char *pos = reqstart;
@@ -544,15 +831,35 @@ iproto_enqueue_batch(struct iproto_connection *con, struct ibuf *in)
 			request_decode(&msg->request,
 				       (const char *) msg->header.body[0].iov_base,
 				       msg->header.body[0].iov_len);
-			assert(msg->header.type < sizeof(dml_route)/sizeof(*dml_route));
-			cmsg_init(msg, dml_route[msg->header.type]);
+			if (msg->header.type == IPROTO_SELECT &&
+			    iproto_select_from_read_view(con, msg, reqstart)) {
+				/* Discard the request, it's answered. */
+				in->rpos += msg->len;
+				con->parse_size -= msg->len;
+				if (! ev_is_active(&con->output))
+					ev_feed_event(con->loop, &con->output,
+						      EV_WRITE);
+				continue;
+			}
+			assert(msg->header.type < IPROTO_TYPE_STAT_MAX);
+			cmsg_init(msg, con->thread->dml_route[msg->header.type]);
+			break;
+		case IPROTO_GET_MANY:
+			if (msg->header.bodycnt == 0) {
+				tnt_raise(ClientError, ER_INVALID_MSGPACK,
+					  "missing request body");
+			}
+			request_decode(&msg->request,
+				       (const char *) msg->header.body[0].iov_base,
+				       msg->header.body[0].iov_len);
+			cmsg_init(msg, con->thread->get_many_route);
 			break;
 		case IPROTO_PING:
-			cmsg_init(msg, misc_route);
+			cmsg_init(msg, con->thread->misc_route);
 			break;
 		case IPROTO_JOIN:
 		case IPROTO_SUBSCRIBE:
-			cmsg_init(msg, sync_route);
+			cmsg_init(msg, con->thread->sync_route);
 			stop_input = true;
 			break;
 		default:
@@ -560,7 +867,13 @@ iproto_enqueue_batch(struct iproto_connection *con, struct ibuf *in)
 				  (uint32_t) msg->header.type);
 			break;
 		}
-		cpipe_push_input(&tx_pipe, guard.release());
+		if (iproto_type_is_batched(msg->header.type)) {
+			batch.add(guard.release());
+		} else {
+			batch.push();
+			cpipe_push_input(&con->thread->tx_pipe,
+					 guard.release());
+		}
 		/* Request is parsed */
 		assert(reqend > reqstart);
 		assert(con->parse_size >= (size_t) (reqend - reqstart));
@@ -571,6 +884,7 @@ iproto_enqueue_batch(struct iproto_connection *con, struct ibuf *in)
 		 */
 		con->parse_size -= reqend - reqstart;
 	}
+	batch.push();
 	if (stop_input) {
 		/**
 		 * Don't mess with the file descriptor
@@ -589,7 +903,7 @@ iproto_enqueue_batch(struct iproto_connection *con, struct ibuf *in)
 		 */
 		ev_feed_event(con->loop, &con->input, EV_READ);
 	}
-	cpipe_flush_input(&tx_pipe);
+	cpipe_flush_input(&con->thread->tx_pipe);
 }
 
 static void
@@ -604,7 +918,8 @@ iproto_connection_on_input(ev_loop *loop, struct ev_io *watcher,
 	try {
 		/* Ensure we have sufficient space for the next round.  */
 		struct iobuf *iobuf;
-		if ((mempool_count(&iproto_msg_pool) > IPROTO_MSG_MAX &&
+		if ((mempool_count(&con->thread->iproto_msg_pool) >
+		     IPROTO_MSG_MAX &&
 			/* Don't stop connection if there is no pending requests */
 			(ibuf_used(&con->iobuf[0]->in) > con->parse_size ||
 			 ibuf_used(&con->iobuf[1]->in))) ||
@@ -626,7 +941,7 @@ iproto_connection_on_input(ev_loop *loop, struct ev_io *watcher,
 			return;
 		}
 		/* Count statistics */
-		rmean_collect(rmean_net, IPROTO_RECEIVED, nrd);
+		rmean_collect(con->thread->rmean_net, IPROTO_RECEIVED, nrd);
 
 		/* Update the read position and connection state. */
 		in->wpos += nrd;
@@ -683,7 +998,7 @@ iproto_flush(struct iobuf *iobuf, struct iproto_connection *con)
 	ssize_t nwr = sio_writev(fd, iov, iovcnt);
 
 	/* Count statistics */
-	rmean_collect(rmean_net, IPROTO_SENT, nwr);
+	rmean_collect(con->thread->rmean_net, IPROTO_SENT, nwr);
 	if (nwr > 0) {
 		if (begin->used + nwr == end->used) {
 			if (ibuf_used(&iobuf->in) == 0) {
@@ -708,6 +1023,134 @@ iproto_flush(struct iobuf *iobuf, struct iproto_connection *con)
 	return -1;
 }
 
+/**
+ * writev() the contents of @a out to the socket, skipping
+ * @a sent bytes which have been sent already.
+ * @retval 0 all of @a out has been sent.
+ * @retval -1 the socket is not ready for more output.
+ */
+static int
+iproto_flush_obuf(struct iproto_connection *con, struct obuf *out,
+		  size_t *sent)
+{
+	int fd = con->output.fd;
+	struct iovec iov[SMALL_OBUF_IOV_MAX+1];
+	int iovcnt = obuf_iovcnt(out);
+	memcpy(iov, out->iov, iovcnt * sizeof(struct iovec));
+	/* Skip the part which has been sent already. */
+	size_t offset = 0;
+	int advance = sio_move_iov(iov, *sent, &offset);
+	sio_add_to_iov(iov + advance, -offset);
+
+	ssize_t nwr = sio_writev(fd, iov + advance, iovcnt - advance);
+
+	/* Count statistics */
+	rmean_collect(con->thread->rmean_net, IPROTO_SENT, nwr);
+	if (nwr > 0)
+		*sent += nwr;
+	return *sent < obuf_size(out) ? -1 : 0;
+}
+
+/** Send replies to requests executed in a read view. */
+static int
+iproto_flush_read_view(struct iproto_connection *con)
+{
+	if (iproto_flush_obuf(con, &con->rv_out, &con->rv_sent) < 0)
+		return -1;
+	obuf_reset(&con->rv_out);
+	con->rv_sent = 0;
+	return 0;
+}
+
+/** A vector of data for writev(), skipping what's been sent. */
+struct iproto_iov {
+	struct iovec iov[IPROTO_CHUNK_IOV_MAX];
+	int iovcnt;
+	/** How much is left to skip. */
+	size_t skip;
+};
+
+/**
+ * Append data to the vector.
+ * @retval false the vector is full.
+ */
+static inline bool
+iproto_iov_add(struct iproto_iov *v, const char *data, size_t size)
+{
+	if (size <= v->skip) {
+		v->skip -= size;
+		return true;
+	}
+	if (v->iovcnt == IPROTO_CHUNK_IOV_MAX)
+		return false;
+	v->iov[v->iovcnt].iov_base = (void *) (data + v->skip);
+	v->iov[v->iovcnt].iov_len = size - v->skip;
+	v->iovcnt++;
+	v->skip = 0;
+	return true;
+}
+
+/**
+ * Fill the vector with the unsent part of a chunk: the pieces
+ * of the chunk buffer with the spliced tuples in between.
+ */
+static void
+iproto_iov_add_chunk(struct iproto_iov *v, struct iproto_chunk_msg *chunk)
+{
+	struct obuf *out = &chunk->buf;
+	struct iproto_splice *splice = chunk->splices;
+	struct iproto_splice *splice_end = splice + chunk->splice_count;
+	size_t offset = 0;
+	int iovcnt = obuf_iovcnt(out);
+	for (int i = 0; i < iovcnt; i++) {
+		const char *data = (const char *) out->iov[i].iov_base;
+		size_t size = out->iov[i].iov_len;
+		for (; splice < splice_end &&
+		       splice->offset < offset + size; splice++) {
+			size_t n = splice->offset - offset;
+			if (! iproto_iov_add(v, data, n) ||
+			    ! iproto_iov_add(v, splice->data, splice->size))
+				return;
+			data += n;
+			size -= n;
+			offset += n;
+		}
+		if (! iproto_iov_add(v, data, size))
+			return;
+		offset += size;
+	}
+	/* Tuples at the very end of the buffer. */
+	for (; splice < splice_end; splice++) {
+		if (! iproto_iov_add(v, splice->data, splice->size))
+			return;
+	}
+}
+
+/** Send the first chunk of a streamed response. */
+static int
+iproto_flush_chunk(struct iproto_connection *con)
+{
+	struct iproto_chunk_msg *chunk =
+		stailq_first_entry(&con->chunks, struct iproto_chunk_msg,
+				   in_chunks);
+	struct iproto_iov v;
+	v.iovcnt = 0;
+	v.skip = con->chunk_sent;
+	iproto_iov_add_chunk(&v, chunk);
+	ssize_t nwr = sio_writev(con->output.fd, v.iov, v.iovcnt);
+
+	/* Count statistics */
+	rmean_collect(con->thread->rmean_net, IPROTO_SENT, nwr);
+	if (nwr > 0)
+		con->chunk_sent += nwr;
+	if (con->chunk_sent < obuf_size(&chunk->buf) + chunk->splice_size)
+		return -1;
+	stailq_shift(&con->chunks);
+	con->chunk_sent = 0;
+	iproto_chunk_return(chunk);
+	return 0;
+}
+
 static void
 iproto_connection_on_output(ev_loop *loop, struct ev_io *watcher,
 			    int /* revents */)
@@ -715,6 +1158,20 @@ iproto_connection_on_output(ev_loop *loop, struct ev_io *watcher,
 	struct iproto_connection *con = (struct iproto_connection *) watcher->data;
 
 	try {
+		/* Finish a chunk before sending anything else. */
+		if (con->chunk_sent > 0 && iproto_flush_chunk(con) < 0) {
+			ev_io_start(loop, &con->output);
+			return;
+		}
+		/* Read view replies precede any replies from tx. */
+		if (obuf_size(&con->rv_out) > 0) {
+			if (iproto_flush_read_view(con) < 0) {
+				ev_io_start(loop, &con->output);
+				return;
+			}
+			if (! ev_is_active(&con->input))
+				ev_feed_event(loop, &con->input, EV_READ);
+		}
 		struct iobuf *iobuf;
 		while ((iobuf = iproto_connection_output_iobuf(con))) {
 			if (iproto_flush(iobuf, con) < 0) {
@@ -724,6 +1181,13 @@ iproto_connection_on_output(ev_loop *loop, struct ev_io *watcher,
 			if (! ev_is_active(&con->input))
 				ev_feed_event(loop, &con->input, EV_READ);
 		}
+		/* All other output is sent, start the chunks. */
+		while (! stailq_empty(&con->chunks)) {
+			if (iproto_flush_chunk(con) < 0) {
+				ev_io_start(loop, &con->output);
+				return;
+			}
+		}
 		if (ev_is_active(&con->output))
 			ev_io_stop(con->loop, &con->output);
 	} catch (Exception *e) {
@@ -778,6 +1242,387 @@ error:
 	msg->write_end = obuf_create_svp(out);
 }
 
+/**
+ * Check if a DML request can be a part of a coalesced
+ * transaction. Such a transaction must not yield before commit
+ * and must stay in one engine, which rules out spaces with
+ * triggers, system spaces and engines other than memtx.
+ */
+static bool
+tx_dml_is_batched(struct request *req)
+{
+	struct space *space = space_by_id(req->space_id);
+	return space != NULL && ! space_is_system(space) &&
+	       rlist_empty(&space->on_replace) &&
+	       strcmp(space->handler->engine->name, "memtx") == 0;
+}
+
+/**
+ * Commit the coalesced transaction, if any, and reply to the
+ * requests which made it. The results are referenced.
+ */
+static void
+tx_commit_dml_batch(struct obuf *out, struct iproto_msg **msgs,
+		    struct tuple **results, int count)
+{
+	int rc = box_txn_commit();
+	for (int i = 0; i < count; i++) {
+		uint64_t sync = msgs[i]->header.sync;
+		struct tuple *tuple = results[i];
+		struct obuf_svp svp;
+		if (rc != 0 || iproto_prepare_select(out, &svp) != 0 ||
+		    (tuple && tuple_to_obuf(tuple, out))) {
+			iproto_reply_error(out,
+					   diag_last_error(&fiber()->diag),
+					   sync);
+		} else {
+			iproto_reply_select(out, &svp, sync, tuple != 0);
+		}
+		if (tuple != NULL)
+			tuple_unref(tuple);
+	}
+}
+
+/**
+ * Execute consecutive DML requests of a connection in one
+ * transaction, so that they are written to WAL at once and
+ * don't take a fiber each. Every request still gets its own
+ * reply: a failed request is rolled back alone, the replies to
+ * the rest are written when the transaction is committed.
+ * Requests which can't be coalesced are executed on their own,
+ * in the original order.
+ */
+static void
+tx_process_dml_batch(struct cmsg *m)
+{
+	struct iproto_msg *batch = (struct iproto_msg *) m;
+	struct obuf *out = &batch->iobuf->out;
+	/* Requests in the current transaction and their results. */
+	struct iproto_msg *msgs[IPROTO_DML_BATCH_MAX];
+	struct tuple *results[IPROTO_DML_BATCH_MAX];
+	int count = 0;
+	struct iproto_msg *msg;
+	stailq_foreach_entry(msg, &batch->batch, in_batch) {
+		tx_fiber_init(msg->connection->session, msg->header.sync);
+		if (tx_check_schema(msg->header.schema_id))
+			goto error;
+		if (! tx_dml_is_batched(&msg->request)) {
+			tx_commit_dml_batch(out, msgs, results, count);
+			count = 0;
+			tx_process1(msg);
+			continue;
+		}
+		struct tuple *tuple;
+		if ((! box_txn() && box_txn_begin() != 0) ||
+		    box_process1(&msg->request, &tuple) != 0)
+			goto error;
+		/* Can't fail, box_process1() has blessed the tuple. */
+		if (tuple != NULL)
+			tuple_ref(tuple);
+		msgs[count] = msg;
+		results[count] = tuple;
+		count++;
+		continue;
+error:
+		iproto_reply_error(out, diag_last_error(&fiber()->diag),
+				   msg->header.sync);
+	}
+	tx_commit_dml_batch(out, msgs, results, count);
+	batch->write_end = obuf_create_svp(out);
+}
+
+/**
+ * Check if a SELECT can be streamed in chunks. Each chunk is
+ * selected anew, starting right after the last tuple of the
+ * previous chunk, which requires a unique ordered index and a
+ * range iterator. The tuples are not pinned between chunks,
+ * so the client sees changes made while the response is
+ * streamed, but every key is sent at most once.
+ */
+static bool
+tx_select_is_chunked(struct request *req)
+{
+	if (req->chunk_size == 0)
+		return false;
+	switch (req->iterator) {
+	case ITER_ALL:
+	case ITER_GE:
+	case ITER_GT:
+	case ITER_LE:
+	case ITER_LT:
+		break;
+	default:
+		return false;
+	}
+	struct space *space = space_by_id(req->space_id);
+	if (space == NULL)
+		return false;
+	Index *index = space_index(space, req->index_id);
+	return index != NULL && index->key_def->type == TREE &&
+	       index->key_def->opts.is_unique;
+}
+
+static void
+iproto_chunk_create(struct iproto_chunk_msg *chunk,
+		    struct iproto_connection *con)
+{
+	cmsg_init(chunk, con->thread->chunk_route);
+	chunk->connection = con;
+	obuf_create(&chunk->buf, &cord()->slabc, IPROTO_RV_OUT_SIZE);
+	chunk->splices = NULL;
+	chunk->splice_count = 0;
+	chunk->splice_capacity = 0;
+	chunk->splice_size = 0;
+	chunk->fiber = fiber();
+	chunk->is_done = true;
+	chunk->is_closed = false;
+}
+
+/** Release the spliced tuples and empty the chunk. */
+static void
+iproto_chunk_reset(struct iproto_chunk_msg *chunk)
+{
+	assert(chunk->is_done);
+	for (uint32_t i = 0; i < chunk->splice_count; i++)
+		tuple_unref(chunk->splices[i].tuple);
+	chunk->splice_count = 0;
+	chunk->splice_size = 0;
+	obuf_reset(&chunk->buf);
+}
+
+static void
+iproto_chunk_destroy(struct iproto_chunk_msg *chunk)
+{
+	iproto_chunk_reset(chunk);
+	obuf_destroy(&chunk->buf);
+	free(chunk->splices);
+}
+
+/**
+ * Append a tuple to the chunk. Large tuples are referenced
+ * rather than copied.
+ */
+static int
+iproto_chunk_add_tuple(struct iproto_chunk_msg *chunk,
+		       struct tuple *tuple)
+{
+	if (tuple->bsize < IPROTO_SPLICE_MIN)
+		return tuple_to_obuf(tuple, &chunk->buf);
+	if (chunk->splice_count == chunk->splice_capacity) {
+		uint32_t capacity = MAX(chunk->splice_capacity * 2, 16);
+		size_t size = capacity * sizeof(*chunk->splices);
+		struct iproto_splice *splices = (struct iproto_splice *)
+			realloc(chunk->splices, size);
+		if (splices == NULL) {
+			diag_set(OutOfMemory, size, "realloc", "splices");
+			return -1;
+		}
+		chunk->splices = splices;
+		chunk->splice_capacity = capacity;
+	}
+	if (box_tuple_ref(tuple) != 0)
+		return tuple_to_obuf(tuple, &chunk->buf);
+	struct iproto_splice *splice = &chunk->splices[chunk->splice_count++];
+	splice->offset = obuf_size(&chunk->buf);
+	splice->tuple = tuple;
+	splice->data = tuple->data;
+	splice->size = tuple->bsize;
+	chunk->splice_size += tuple->bsize;
+	return 0;
+}
+
+/**
+ * Encode a packet with the tuples of a port into the chunk.
+ * The port is destroyed.
+ */
+static int
+iproto_chunk_encode(struct iproto_chunk_msg *chunk, struct port *port,
+		    uint32_t code, uint64_t sync)
+{
+	struct obuf_svp svp;
+	if (iproto_prepare_select(&chunk->buf, &svp) != 0) {
+		port_destroy(port);
+		return -1;
+	}
+	for (struct port_chunk *c = port->first; c != NULL; c = c->next) {
+		for (uint32_t i = 0; i < c->size; i++) {
+			if (iproto_chunk_add_tuple(chunk, c->tuples[i]) != 0) {
+				port_destroy(port);
+				return -1;
+			}
+		}
+	}
+	iproto_reply_data(&chunk->buf, &svp, code, sync, port->size,
+			  chunk->splice_size);
+	port_destroy(port);
+	return 0;
+}
+
+/** Check if a port has tuples worth sending by reference. */
+static bool
+iproto_port_has_large_tuples(struct port *port)
+{
+	for (struct port_chunk *c = port->first; c != NULL; c = c->next) {
+		for (uint32_t i = 0; i < c->size; i++) {
+			if (c->tuples[i]->bsize >= IPROTO_SPLICE_MIN)
+				return true;
+		}
+	}
+	return false;
+}
+
+/** Wait until the network thread is done with a chunk. */
+static void
+tx_wait_chunk(struct iproto_chunk_msg *chunk)
+{
+	while (! chunk->is_done)
+		fiber_yield();
+}
+
+/** Hand a chunk over to the network thread. */
+static void
+tx_send_chunk(struct iproto_chunk_msg *chunk)
+{
+	chunk->is_done = false;
+	cpipe_push(&chunk->connection->thread->net_pipe, chunk);
+}
+
+/**
+ * Send a SELECT reply with large tuples through a chunk
+ * message, so that the tuples are not copied. The reply
+ * doesn't go to the connection output buffer, the fiber waits
+ * until it is sent instead.
+ * @retval -1 out of memory, nothing has been sent.
+ */
+static int
+tx_reply_select_spliced(struct iproto_msg *msg, struct port *port)
+{
+	struct iproto_chunk_msg chunk;
+	iproto_chunk_create(&chunk, msg->connection);
+	int rc = iproto_chunk_encode(&chunk, port, IPROTO_OK,
+				     msg->header.sync);
+	if (rc == 0) {
+		tx_send_chunk(&chunk);
+		tx_wait_chunk(&chunk);
+	}
+	iproto_chunk_destroy(&chunk);
+	return rc;
+}
+
+/**
+ * Select tuples in portions of at most chunk_size tuples.
+ * Each portion except the last one is sent as an IPROTO_CHUNK
+ * packet through a chunk message, the last one is an ordinary
+ * reply. Two chunk messages are used in turn, so that a chunk
+ * is encoded while the previous one is being sent.
+ */
+static void
+tx_process_select_chunked(struct iproto_msg *msg)
+{
+	struct iproto_connection *con = msg->connection;
+	struct obuf *out = &msg->iobuf->out;
+	struct request *req = &msg->request;
+	uint64_t sync = msg->header.sync;
+	struct iproto_chunk_msg chunks[2];
+	iproto_chunk_create(&chunks[0], con);
+	iproto_chunk_create(&chunks[1], con);
+	int iterator = req->iterator;
+	const char *key = req->key;
+	const char *key_end = req->key_end;
+	uint32_t offset = req->offset;
+	uint32_t limit = req->limit;
+	/* The key to continue from, see tx_select_is_chunked(). */
+	char *last_key = NULL;
+	size_t region_svp = region_used(&fiber()->gc);
+	struct obuf_svp svp;
+	struct port port;
+	for (int i = 0; ; i = !i) {
+		struct iproto_chunk_msg *chunk = &chunks[i];
+		tx_wait_chunk(chunk);
+		if (chunk->is_closed)
+			goto skip_reply;
+		iproto_chunk_reset(chunk);
+		port_create(&port);
+		uint32_t count = MIN(limit, req->chunk_size);
+		if (box_select(&port, req->space_id, req->index_id,
+			       iterator, offset, count, key, key_end) != 0) {
+			port_destroy(&port);
+			goto error;
+		}
+		offset = 0;
+		limit -= port.size;
+		if (port.size < count || limit == 0)
+			break;
+		/*
+		 * Remember the key of the last tuple before the
+		 * port is encoded and releases the tuples.
+		 */
+		struct tuple *last = port.last->tuples[port.last->size - 1];
+		uint32_t key_size;
+		char *next_key = box_tuple_extract_key(last, req->space_id,
+						       req->index_id,
+						       &key_size);
+		char *buf = next_key == NULL ? NULL :
+			    (char *) realloc(last_key, key_size);
+		if (next_key != NULL && buf == NULL)
+			diag_set(OutOfMemory, key_size, "realloc", "key");
+		if (buf == NULL) {
+			port_destroy(&port);
+			goto error;
+		}
+		last_key = buf;
+		memcpy(last_key, next_key, key_size);
+		region_truncate(&fiber()->gc, region_svp);
+		key = last_key;
+		key_end = last_key + key_size;
+		iterator = iterator_type_is_reverse((enum iterator_type)
+						    req->iterator) ?
+			   ITER_LT : ITER_GT;
+		if (iproto_chunk_encode(chunk, &port, IPROTO_CHUNK,
+					sync) != 0)
+			goto error;
+		tx_send_chunk(chunk);
+	}
+	/*
+	 * The final packet must not overtake the chunks, write
+	 * it to the connection output only when they are sent.
+	 */
+	tx_wait_chunk(&chunks[0]);
+	tx_wait_chunk(&chunks[1]);
+	if (chunks[0].is_closed || chunks[1].is_closed) {
+		port_destroy(&port);
+		goto skip_reply;
+	}
+	if (iproto_port_has_large_tuples(&port)) {
+		iproto_chunk_reset(&chunks[0]);
+		if (iproto_chunk_encode(&chunks[0], &port, IPROTO_OK,
+					sync) != 0)
+			goto error;
+		tx_send_chunk(&chunks[0]);
+		goto skip_reply;
+	}
+	if (iproto_prepare_select(out, &svp) != 0) {
+		port_destroy(&port);
+		goto error;
+	}
+	port_dump(&port, out);
+	iproto_reply_select(out, &svp, sync, port.size);
+	goto end;
+error:
+	tx_wait_chunk(&chunks[0]);
+	tx_wait_chunk(&chunks[1]);
+	iproto_reply_error(out, diag_last_error(&fiber()->diag), sync);
+	goto end;
+skip_reply:
+	tx_wait_chunk(&chunks[0]);
+	tx_wait_chunk(&chunks[1]);
+end:
+	free(last_key);
+	iproto_chunk_destroy(&chunks[0]);
+	iproto_chunk_destroy(&chunks[1]);
+	msg->write_end = obuf_create_svp(out);
+}
+
 static void
 tx_process_select(struct cmsg *m)
 {
@@ -793,11 +1638,20 @@ tx_process_select(struct cmsg *m)
 	if (tx_check_schema(msg->header.schema_id))
 		goto error;
 
+	if (tx_select_is_chunked(req))
+		return tx_process_select_chunked(msg);
+
 	port_create(&port);
 	rc = box_select((struct port *) &port,
 			req->space_id, req->index_id,
 			req->iterator, req->offset, req->limit,
 			req->key, req->key_end);
+	if (rc == 0 && iproto_port_has_large_tuples(&port)) {
+		if (tx_reply_select_spliced(msg, &port) != 0)
+			goto error;
+		msg->write_end = obuf_create_svp(out);
+		return;
+	}
 	if (rc < 0 || iproto_prepare_select(out, &svp) != 0) {
 		port_destroy(&port);
 		goto error;
@@ -812,6 +1666,92 @@ error:
 	msg->write_end = obuf_create_svp(out);
 }
 
+/** Append MP_NIL to the reply, in place of a missing tuple. */
+static inline int
+iproto_encode_nil(struct obuf *out)
+{
+	char nil[1];
+	mp_encode_nil(nil);
+	if (obuf_dup(out, nil, sizeof(nil)) != sizeof(nil)) {
+		diag_set(OutOfMemory, sizeof(nil), "obuf", "nil");
+		return -1;
+	}
+	return 0;
+}
+
+/**
+ * Look up an array of keys and reply with an array of the
+ * same size, having MP_NIL in place of the missing tuples.
+ */
+static void
+tx_process_get_many(struct cmsg *m)
+{
+	struct iproto_msg *msg = (struct iproto_msg *) m;
+	struct obuf *out = &msg->iobuf->out;
+	struct request *req = &msg->request;
+	struct region *gc = &fiber()->gc;
+	size_t used = region_used(gc);
+	struct obuf_svp svp;
+	const char *key;
+	const char **keys;
+	struct tuple **results;
+	uint32_t n;
+	size_t size;
+	int rc;
+
+	tx_fiber_init(msg->connection->session, msg->header.sync);
+
+	if (tx_check_schema(msg->header.schema_id))
+		goto error;
+
+	key = req->key;
+	n = mp_decode_array(&key);
+	size = n * (sizeof(*keys) + sizeof(*results));
+	keys = (const char **) region_alloc(gc, size);
+	if (keys == NULL) {
+		diag_set(OutOfMemory, size, "region", "keys");
+		goto error;
+	}
+	results = (struct tuple **) (keys + n);
+	for (uint32_t i = 0; i < n; i++) {
+		if (mp_typeof(*key) != MP_ARRAY) {
+			diag_set(ClientError, ER_INVALID_MSGPACK, "key");
+			goto error;
+		}
+		keys[i] = key;
+		mp_next(&key);
+	}
+	if (box_index_get_many(req->space_id, req->index_id, keys, n,
+			       results) != 0)
+		goto error;
+	rc = iproto_prepare_select(out, &svp);
+	if (rc == 0) {
+		for (uint32_t i = 0; i < n && rc == 0; i++) {
+			if (results[i] != NULL)
+				rc = tuple_to_obuf(results[i], out);
+			else
+				rc = iproto_encode_nil(out);
+		}
+		if (rc != 0)
+			obuf_rollback_to_svp(out, &svp);
+	}
+	for (uint32_t i = 0; i < n; i++) {
+		if (results[i] != NULL)
+			tuple_unref(results[i]);
+	}
+	if (rc != 0)
+		goto error;
+	iproto_reply_select(out, &svp, msg->header.sync, n);
+	region_truncate(gc, used);
+	msg->write_end = obuf_create_svp(out);
+	return;
+error:
+	region_truncate(gc, used);
+	iproto_reply_error(out, diag_last_error(&fiber()->diag),
+			   msg->header.sync);
+	msg->write_end = obuf_create_svp(out);
+}
+
 static void
 tx_process_misc(struct cmsg *m)
 {
@@ -907,6 +1847,47 @@ net_send_msg(struct cmsg *m)
 	iproto_msg_delete(msg);
 }
 
+static void
+net_send_dml_batch(struct cmsg *m)
+{
+	struct iproto_msg *batch = (struct iproto_msg *) m;
+	/* The batch itself goes first and is deleted last. */
+	stailq_shift(&batch->batch);
+	while (! stailq_empty(&batch->batch)) {
+		struct iproto_msg *msg =
+			stailq_shift_entry(&batch->batch, struct iproto_msg,
+					   in_batch);
+		batch->len += msg->len;
+		iproto_msg_delete(msg);
+	}
+	net_send_msg(batch);
+}
+
+/** Queue a chunk of a streamed response for sending. */
+static void
+net_send_chunk(struct cmsg *m)
+{
+	struct iproto_chunk_msg *chunk = (struct iproto_chunk_msg *) m;
+	struct iproto_connection *con = chunk->connection;
+	if (! evio_has_fd(&con->output)) {
+		chunk->is_closed = true;
+		iproto_chunk_return(chunk);
+		return;
+	}
+	stailq_add_tail_entry(&con->chunks, chunk, in_chunks);
+	if (! ev_is_active(&con->output))
+		ev_feed_event(con->loop, &con->output, EV_WRITE);
+}
+
+/** The chunk is sent, wake up the fiber streaming the response. */
+static void
+tx_end_chunk(struct cmsg *m)
+{
+	struct iproto_chunk_msg *chunk = (struct iproto_chunk_msg *) m;
+	chunk->is_done = true;
+	fiber_wakeup(chunk->fiber);
+}
+
 static void
 net_end_join_subscribe(struct cmsg *m)
 {
@@ -969,7 +1950,8 @@ net_send_greeting(struct cmsg *m)
 						 obuf_iovcnt(out));
 
 			/* Count statistics */
-			rmean_collect(rmean_net, IPROTO_SENT, nwr);
+			rmean_collect(con->thread->rmean_net, IPROTO_SENT,
+				      nwr);
 		} catch (Exception *e) {
 			e->log();
 		}
@@ -990,37 +1972,98 @@ net_send_greeting(struct cmsg *m)
 	iproto_msg_delete(msg);
 }
 
-static const struct cmsg_hop connect_route[] = {
-	{ tx_process_connect, &net_pipe },
-	{ net_send_greeting, NULL },
-};
-
 /** }}} */
 
 /**
- * Create a connection and start input.
+ * Create a connection in the current network thread and start
+ * the handshake.
  */
 static void
-iproto_on_accept(struct evio_service * /* service */, int fd,
-		 struct sockaddr *addr, socklen_t addrlen)
+iproto_connection_accept(int fd)
 {
-	char name[SERVICE_NAME_MAXLEN];
-	snprintf(name, sizeof(name), "%s/%s", "iobuf",
-		sio_strfaddr(addr, addrlen));
-
-	struct iproto_connection *con;
-
-	con = iproto_connection_new(name, fd);
+	struct iproto_connection *con = iproto_connection_new(fd);
 	/*
 	 * Ignore msg allocation failure - the queue size is
 	 * fixed so there is a limited number of msgs in
 	 * use, all stored in just a few blocks of the memory pool.
 	 */
 	struct iproto_msg *msg = iproto_msg_new(con);
-	cmsg_init(msg, connect_route);
+	cmsg_init(msg, con->thread->connect_route);
 	msg->iobuf = con->iobuf[0];
 	msg->close_connection = false;
-	cpipe_push(&tx_pipe, msg);
+	cpipe_push(&con->thread->tx_pipe, msg);
+}
+
+/**
+ * Pick the network thread with the fewest connections for a
+ * new connection. Ties are broken round-robin.
+ */
+static struct iproto_thread *
+iproto_thread_pick()
+{
+	static int next;
+	struct iproto_thread *best = NULL;
+	int best_count = INT_MAX;
+	for (int i = 0; i < iproto_threads_count; i++) {
+		struct iproto_thread *thread =
+			&iproto_threads[(next + i) % iproto_threads_count];
+		int count = __atomic_load_n(&thread->connection_count,
+					    __ATOMIC_RELAXED);
+		if (count < best_count) {
+			best = thread;
+			best_count = count;
+		}
+	}
+	next = (best->id + 1) % iproto_threads_count;
+	__atomic_add_fetch(&best->connection_count, 1, __ATOMIC_RELAXED);
+	return best;
+}
+
+/**
+ * Pass a new connection to the least loaded network thread,
+ * which creates the connection and starts input.
+ */
+static void
+iproto_on_accept(struct evio_service * /* service */, int fd,
+		 struct sockaddr * /* addr */, socklen_t /* addrlen */)
+{
+	struct iproto_thread *thread = iproto_thread_pick();
+	if (thread == iproto_thread) {
+		try {
+			iproto_connection_accept(fd);
+		} catch (Exception *e) {
+			__atomic_sub_fetch(&thread->connection_count, 1,
+					   __ATOMIC_RELAXED);
+			throw;
+		}
+		return;
+	}
+	/* A write of this size to a pipe is atomic. */
+	if (write(thread->accept_pipe[1], &fd, sizeof(fd)) != sizeof(fd)) {
+		__atomic_sub_fetch(&thread->connection_count, 1,
+				   __ATOMIC_RELAXED);
+		tnt_raise(SocketError, fd, "failed to pass the connection "
+			  "to %s", cord_name(&thread->cord));
+	}
+}
+
+/** Pick up connections passed by iproto_on_accept(). */
+static void
+iproto_thread_on_accept_input(ev_loop * /* loop */, struct ev_io *watcher,
+			      int /* revents */)
+{
+	struct iproto_thread *thread = (struct iproto_thread *) watcher->data;
+	int fd;
+	while (read(thread->accept_pipe[0], &fd, sizeof(fd)) == sizeof(fd)) {
+		try {
+			iproto_connection_accept(fd);
+		} catch (Exception *e) {
+			__atomic_sub_fetch(&thread->connection_count, 1,
+					   __ATOMIC_RELAXED);
+			close(fd);
+			e->log();
+		}
+	}
 }
 
 static struct evio_service binary; /* iproto binary listener */
@@ -1030,59 +2073,113 @@ static struct evio_service binary; /* iproto binary listener */
  * begin serving the message bus.
  */
 static int
-net_cord_f(va_list /* ap */)
+net_cord_f(va_list ap)
 {
+	struct iproto_thread *thread = va_arg(ap, struct iproto_thread *);
+	iproto_thread = thread;
 	/* Got to be called in every thread using iobuf */
 	iobuf_init();
-	mempool_create(&iproto_msg_pool, &cord()->slabc,
+	mempool_create(&thread->iproto_msg_pool, &cord()->slabc,
 		       sizeof(struct iproto_msg));
-	mempool_create(&iproto_connection_pool, &cord()->slabc,
+	mempool_create(&thread->iproto_connection_pool, &cord()->slabc,
 		       sizeof(struct iproto_connection));
 
-	evio_service_init(loop(), &binary, "binary",
-			  iproto_on_accept, NULL);
-
+	if (thread->id == 0) {
+		evio_service_init(loop(), &binary, "binary",
+				  iproto_on_accept, NULL);
+	}
+	ev_io_init(&thread->accept_input, iproto_thread_on_accept_input,
+		   thread->accept_pipe[0], EV_READ);
+	thread->accept_input.data = thread;
+	ev_io_start(loop(), &thread->accept_input);
 
 	/* Init statistics counter */
-	rmean_net = rmean_new(rmean_net_strings, IPROTO_LAST);
+	thread->rmean_net = rmean_new(rmean_net_strings, IPROTO_LAST);
 
-	if (rmean_net == NULL) {
+	if (thread->rmean_net == NULL) {
 		tnt_raise(OutOfMemory, sizeof(struct rmean),
 			  "rmean", "struct rmean");
 	}
 
-	cbus_join(&net_tx_bus, &net_pipe);
+	cbus_join(&thread->net_tx_bus, &thread->net_pipe);
 	/*
 	 * Nothing to do in the fiber so far, the service
 	 * will take care of creating events for incoming
 	 * connections.
 	 */
 	fiber_yield();
-	if (evio_service_is_active(&binary))
+	if (thread->id == 0 && evio_service_is_active(&binary))
 		evio_service_stop(&binary);
+	ev_io_stop(loop(), &thread->accept_input);
 
-	rmean_delete(rmean_net);
+	rmean_delete(thread->rmean_net);
 	return 0;
 }
 
-/** Initialize the iproto subsystem and start network io thread */
+/** Initialize the iproto subsystem and start network io threads */
 void
-iproto_init()
+iproto_init(int threads_count)
 {
 	tx_cord = cord();
 
-	cbus_create(&net_tx_bus);
-	rmean_net_tx_bus = net_tx_bus.stats;
-	cpipe_create(&tx_pipe);
-	cpipe_set_max_input(&tx_pipe, IPROTO_MSG_MAX/2);
-	cpipe_create(&net_pipe);
-	cpipe_set_max_input(&net_pipe, IPROTO_MSG_MAX/2);
+	assert(threads_count > 0);
+	iproto_threads = (struct iproto_thread *)
+		calloc(threads_count, sizeof(struct iproto_thread));
+	if (iproto_threads == NULL)
+		panic("failed to allocate iproto threads");
+	iproto_threads_count = threads_count;
+
+	for (int i = 0; i < threads_count; i++) {
+		struct iproto_thread *thread = &iproto_threads[i];
+		thread->id = i;
+		iproto_thread_init_routes(thread);
+		cbus_create(&thread->net_tx_bus);
+		cpipe_create(&thread->tx_pipe);
+		cpipe_set_max_input(&thread->tx_pipe, IPROTO_MSG_MAX/2);
+		cpipe_create(&thread->net_pipe);
+		cpipe_set_max_input(&thread->net_pipe, IPROTO_MSG_MAX/2);
+		if (pipe(thread->accept_pipe) != 0 ||
+		    fcntl(thread->accept_pipe[0], F_SETFL, O_NONBLOCK) != 0)
+			panic_syserror("failed to create iproto pipe");
+
+		char name[FIBER_NAME_MAX];
+		if (i == 0)
+			snprintf(name, sizeof(name), "iproto");
+		else
+			snprintf(name, sizeof(name), "iproto%d", i);
+		if (cord_costart(&thread->cord, name, net_cord_f, thread))
+			panic("failed to initialize iproto thread");
+
+		cbus_join(&thread->net_tx_bus, &thread->tx_pipe);
+	}
+}
+
+int
+iproto_thread_count(void)
+{
+	return iproto_threads_count;
+}
+
+struct rmean *
+iproto_thread_rmean_net(int id)
+{
+	assert(id >= 0 && id < iproto_threads_count);
+	return iproto_threads[id].rmean_net;
+}
 
-	static struct cord net_cord;
-	if (cord_costart(&net_cord, "iproto", net_cord_f, NULL))
-		panic("failed to initialize iproto thread");
+struct rmean *
+iproto_thread_rmean_tx_bus(int id)
+{
+	assert(id >= 0 && id < iproto_threads_count);
+	return iproto_threads[id].net_tx_bus.stats;
+}
 
-	cbus_join(&net_tx_bus, &tx_pipe);
+int
+iproto_thread_connection_count(int id)
+{
+	assert(id >= 0 && id < iproto_threads_count);
+	return __atomic_load_n(&iproto_threads[id].connection_count,
+			       __ATOMIC_RELAXED);
 }
 
 /**
@@ -1116,7 +2213,7 @@ struct iproto_set_listen_msg: public cmsg
 static void
 iproto_on_bind(void *arg)
 {
-	cpipe_push(&tx_pipe, (struct cmsg *) arg);
+	cpipe_push(&iproto_threads[0].tx_pipe, (struct cmsg *) arg);
 }
 
 static void
@@ -1168,7 +2265,7 @@ iproto_set_listen(const char *uri)
 	static struct iproto_set_listen_msg msg;
 	iproto_set_listen_msg_init(&msg, uri);
 
-	cpipe_push(&net_pipe, &msg);
+	cpipe_push(&iproto_threads[0].net_pipe, &msg);
 	/** Wait for the end of bind. */
 	fiber_yield();
 	if (! diag_is_empty(&msg.diag)) {
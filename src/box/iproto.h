@@ -30,10 +30,42 @@
  * THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
  * SUCH DAMAGE.
  */
+#if defined(__cplusplus)
+extern "C" {
+#endif /* defined(__cplusplus) */
+
+struct rmean;
+
+enum {
+	/** The maximal value of box.cfg.iproto_threads. */
+	IPROTO_THREADS_MAX = 1000,
+};
+
+/** The number of network threads. */
+int
+iproto_thread_count(void);
+
+/** SENT and RECEIVED statistics of a network thread. */
+struct rmean *
+iproto_thread_rmean_net(int id);
+
+/** EVENTS and LOCKS statistics of a thread's bus to tx. */
+struct rmean *
+iproto_thread_rmean_tx_bus(int id);
+
+/** The number of client connections served by a thread. */
+int
+iproto_thread_connection_count(int id);
+
+#if defined(__cplusplus)
+} /* extern "C" */
+
 void
-iproto_init();
+iproto_init(int threads_count);
 
 void
 iproto_set_listen(const char *uri);
 
+#endif /* defined(__cplusplus) */
+
 #endif
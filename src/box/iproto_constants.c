@@ -61,10 +61,10 @@ const unsigned char iproto_key_type[IPROTO_KEY_MAX] =
 		/* 0x13 */	MP_UINT, /* IPROTO_OFFSET */
 		/* 0x14 */	MP_UINT, /* IPROTO_ITERATOR */
 		/* 0x15 */	MP_UINT, /* IPROTO_INDEX_BASE */
+		/* 0x16 */	MP_UINT, /* IPROTO_CHUNK_SIZE */
 	/* }}} */
 
 	/* {{{ unused */
-		/* 0x16 */	MP_UINT,
 		/* 0x17 */	MP_UINT,
 		/* 0x18 */	MP_UINT,
 		/* 0x19 */	MP_UINT,
@@ -105,7 +105,7 @@ const char *iproto_type_strs[] =
 };
 
 #define bit(c) (1ULL<<IPROTO_##c)
-const uint64_t iproto_body_key_map[IPROTO_CALL + 1] = {
+const uint64_t iproto_body_key_map[IPROTO_GET_MANY + 1] = {
 	0,                                                     /* unused */
 	bit(SPACE_ID) | bit(LIMIT) | bit(KEY),                 /* SELECT */
 	bit(SPACE_ID) | bit(TUPLE),                            /* INSERT */
@@ -117,6 +117,7 @@ const uint64_t iproto_body_key_map[IPROTO_CALL + 1] = {
 	bit(EXPR)     | bit(TUPLE),                            /* EVAL */
 	bit(SPACE_ID) | bit(OPS) | bit(TUPLE),                 /* UPSERT */
 	bit(FUNCTION_NAME) | bit(TUPLE),                       /* CALL */
+	bit(SPACE_ID) | bit(KEY),                              /* GET_MANY */
 };
 #undef bit
 
@@ -143,7 +144,7 @@ const char *iproto_key_strs[IPROTO_KEY_MAX] = {
 	"offset",           /* 0x13 */
 	"iterator",         /* 0x14 */
 	"index_base",       /* 0x15 */
-	"",                 /* 0x16 */
+	"chunk_size",       /* 0x16 */
 	"",                 /* 0x17 */
 	"",                 /* 0x18 */
 	"",                 /* 0x19 */
@@ -45,7 +45,14 @@ enum {
 	/* Maximal length of text handshake (greeting) */
 	IPROTO_GREETING_SIZE = 128,
 	/** marker + len + prev crc32 + cur crc32 + (padding) */
-	XLOG_FIXHEADER_SIZE = 19
+	XLOG_FIXHEADER_SIZE = 19,
+	/**
+	 * marker + len + unpacked len + compression + crc32 +
+	 * (padding)
+	 */
+	XLOG_BLOCK_FIXHEADER_SIZE = 24,
+	/** Length of a row in a block: uint32 */
+	XLOG_BLOCK_ROW_HEADER_SIZE = 5
 };
 
 enum iproto_key {
@@ -63,6 +70,7 @@ enum iproto_key {
 	IPROTO_OFFSET = 0x13,
 	IPROTO_ITERATOR = 0x14,
 	IPROTO_INDEX_BASE = 0x15,
+	IPROTO_CHUNK_SIZE = 0x16,
 	/* Leave a gap between integer values and other keys */
 	IPROTO_KEY = 0x20,
 	IPROTO_TUPLE = 0x21,
@@ -86,6 +94,7 @@ enum iproto_key {
 			  bit(LSN) | bit(SCHEMA_ID))
 #define IPROTO_BODY_BMAP (bit(SPACE_ID) | bit(INDEX_ID) | bit(LIMIT) |\
 			  bit(OFFSET) | bit(ITERATOR) | bit(INDEX_BASE) |\
+			  bit(CHUNK_SIZE) | \
 			  bit(KEY) | bit(TUPLE) | bit(FUNCTION_NAME) | \
 			  bit(USER_NAME) | bit(EXPR) | bit(OPS))
 
@@ -131,11 +140,21 @@ enum iproto_type {
 	IPROTO_UPSERT = 9,
 	IPROTO_CALL = 10,
 	IPROTO_TYPE_STAT_MAX = IPROTO_CALL + 1,
+	/**
+	 * Look up an array of keys (IPROTO_KEY) in a unique
+	 * index at once. Accounted as SELECT in box.stat.
+	 */
+	IPROTO_GET_MANY = 11,
 	/* admin command codes */
 	IPROTO_PING = 64,
 	IPROTO_JOIN = 65,
 	IPROTO_SUBSCRIBE = 66,
 	IPROTO_TYPE_ADMIN_MAX = IPROTO_SUBSCRIBE + 1,
+	/*
+	 * A part of a response to SELECT with IPROTO_CHUNK_SIZE,
+	 * the final part is sent with IPROTO_OK.
+	 */
+	IPROTO_CHUNK = 128,
 	/* command failed = (IPROTO_TYPE_ERROR | ER_XXX from errcode.h) */
 	IPROTO_TYPE_ERROR = 1 << 15
 };
@@ -165,13 +165,14 @@ iproto_prepare_select(struct obuf *buf, struct obuf_svp *svp)
 }
 
 void
-iproto_reply_select(struct obuf *buf, struct obuf_svp *svp, uint64_t sync,
-		    uint32_t count)
+iproto_reply_data(struct obuf *buf, struct obuf_svp *svp, uint32_t code,
+		  uint64_t sync, uint32_t count, uint32_t spliced)
 {
-	uint32_t len = obuf_size(buf) - svp->used - 5;
+	uint32_t len = obuf_size(buf) - svp->used - 5 + spliced;
 
 	struct iproto_header_bin header = iproto_header_bin;
 	header.v_len = mp_bswap_u32(len);
+	header.v_code = mp_bswap_u32(code);
 	header.v_sync = mp_bswap_u64(sync);
 	header.v_schema_id = mp_bswap_u32(sc_version);
 
@@ -182,3 +183,10 @@ iproto_reply_select(struct obuf *buf, struct obuf_svp *svp, uint64_t sync,
 	memcpy(pos, &header, sizeof(header));
 	memcpy(pos + sizeof(header), &body, sizeof(body));
 }
+
+void
+iproto_reply_select(struct obuf *buf, struct obuf_svp *svp, uint64_t sync,
+		    uint32_t count)
+{
+	iproto_reply_data(buf, svp, IPROTO_OK, sync, count, 0);
+}
@@ -49,6 +49,17 @@ iproto_prepare_select(struct obuf *buf, struct obuf_svp *svp);
 void
 iproto_reply_select(struct obuf *buf, struct obuf_svp *svp, uint64_t sync,
 		    uint32_t count);
+
+/**
+ * Write the header of a packet with data prepared by
+ * iproto_prepare_select(). The packet is followed by @a spliced
+ * bytes of tuples which are sent by reference rather than
+ * stored in @a buf. IPROTO_CHUNK @a code means that more
+ * packets with the same sync follow.
+ */
+void
+iproto_reply_data(struct obuf *buf, struct obuf_svp *svp, uint32_t code,
+		  uint64_t sync, uint32_t count, uint32_t spliced);
 #if defined(__cplusplus)
 } /*  extern "C" */
 
@@ -80,6 +80,8 @@ const char *mp_type_strs[] = {
 const char *index_type_strs[] = { "HASH", "TREE", "BITSET", "RTREE" };
 
 const char *rtree_index_distance_type_strs[] = { "EUCLID", "MANHATTAN" };
+const char *index_compression_type_strs[] = { "none", "lz4", "zstd" };
+const char *hash_index_layout_strs[] = { "chain", "swiss" };
 
 const char *func_language_strs[] = {"LUA", "C"};
 
@@ -104,6 +106,13 @@ const struct key_opts key_opts_default = {
 	/* .path                = */ { 0 },
 	/* .range_size           = */ 0,
 	/* .page_size           = */ 0,
+	/* .bloom_fpr           = */ 0.05,
+	/* .compressionbuf      = */ { '\0' },
+	/* .compression         = */ INDEX_COMPRESSION_NONE,
+	/* .compression_level   = */ 0,
+	/* .hint                = */ false,
+	/* .layoutbuf           = */ { '\0' },
+	/* .layout              = */ HASH_INDEX_LAYOUT_CHAIN,
 };
 
 const struct opt_def key_opts_reg[] = {
@@ -113,6 +122,12 @@ const struct opt_def key_opts_reg[] = {
 	OPT_DEF("path", MP_STR, struct key_opts, path),
 	OPT_DEF("range_size", MP_UINT, struct key_opts, range_size),
 	OPT_DEF("page_size", MP_UINT, struct key_opts, page_size),
+	OPT_DEF("bloom_fpr", MP_DOUBLE, struct key_opts, bloom_fpr),
+	OPT_DEF("compression", MP_STR, struct key_opts, compressionbuf),
+	OPT_DEF("compression_level", MP_UINT, struct key_opts,
+		compression_level),
+	OPT_DEF("hint", MP_BOOL, struct key_opts, hint),
+	OPT_DEF("layout", MP_STR, struct key_opts, layoutbuf),
 	{ NULL, MP_NIL, 0, 0 }
 };
 
@@ -428,10 +443,12 @@ key_def_build_secondary(struct key_def *primary, struct key_def *secondary)
 
 const struct space_opts space_opts_default = {
 	/* .temporary = */ false,
+	/* .read_view = */ false,
 };
 
 const struct opt_def space_opts_reg[] = {
 	OPT_DEF("temporary", MP_BOOL, struct space_opts, temporary),
+	OPT_DEF("read_view", MP_BOOL, struct space_opts, read_view),
 	{ NULL, MP_NIL, 0, 0 }
 };
 
@@ -464,6 +481,11 @@ space_def_check(struct space_def *def, uint32_t namelen, uint32_t engine_namelen
 				  def->name,
 			         "space does not support temporary flag");
 	}
+	if (def->opts.read_view && strcmp(def->engine_name, "memtx") != 0) {
+		tnt_raise(ClientError, ER_ALTER_SPACE,
+			  def->name,
+			  "space does not support read_view flag");
+	}
 }
 
 bool
@@ -152,6 +152,21 @@ enum rtree_index_distance_type {
 };
 extern const char *rtree_index_distance_type_strs[];
 
+enum index_compression_type {
+	INDEX_COMPRESSION_NONE,
+	INDEX_COMPRESSION_LZ4,
+	INDEX_COMPRESSION_ZSTD,
+	index_compression_type_MAX
+};
+extern const char *index_compression_type_strs[];
+
+enum hash_index_layout {
+	HASH_INDEX_LAYOUT_CHAIN,
+	HASH_INDEX_LAYOUT_SWISS,
+	hash_index_layout_MAX
+};
+extern const char *hash_index_layout_strs[];
+
 /** Descriptor of a single part in a multipart key. */
 struct key_part {
 	uint32_t fieldno;
@@ -180,6 +195,28 @@ struct key_opts {
 	char path[PATH_MAX];
 	uint32_t range_size;
 	uint32_t page_size;
+	/**
+	 * False positive rate of run bloom filters,
+	 * 1 disables bloom filters.
+	 */
+	double bloom_fpr;
+	/**
+	 * Compression of vinyl run pages.
+	 */
+	char compressionbuf[16];
+	enum index_compression_type compression;
+	/** Compression level, 0 means the codec default. */
+	uint32_t compression_level;
+	/**
+	 * Store a hint of the first key part along with each
+	 * tuple in a memtx TREE index, see tuple_hint().
+	 */
+	bool hint;
+	/**
+	 * Memory layout of a memtx HASH index.
+	 */
+	char layoutbuf[16];
+	enum hash_index_layout layout;
 };
 
 extern const struct key_opts key_opts_default;
@@ -194,6 +231,10 @@ key_opts_cmp(const struct key_opts *o1, const struct key_opts *o2)
 		return o1->dimension < o2->dimension ? -1 : 1;
 	if (o1->distance != o2->distance)
 		return o1->distance < o2->distance ? -1 : 1;
+	if (o1->hint != o2->hint)
+		return o1->hint < o2->hint ? -1 : 1;
+	if (o1->layout != o2->layout)
+		return o1->layout < o2->layout ? -1 : 1;
 	return 0;
 }
 
@@ -316,6 +357,12 @@ struct space_opts {
 	 * - changes are not part of a snapshot
 	 */
 	bool temporary;
+	/**
+	 * SELECT requests to the space may be executed in
+	 * iproto threads against a periodically refreshed
+	 * read view, see memtx_read_view.h.
+	 */
+	bool read_view;
 };
 
 extern const struct space_opts space_opts_default;
@@ -152,6 +152,17 @@ lbox_cfg_set_read_only(struct lua_State *L)
 	return 0;
 }
 
+static int
+lbox_cfg_set_read_view_period(struct lua_State *L)
+{
+	try {
+		box_set_read_view_period();
+	} catch (Exception *) {
+		lbox_error(L);
+	}
+	return 0;
+}
+
 void
 box_lua_cfg_init(struct lua_State *L)
 {
@@ -166,6 +177,7 @@ box_lua_cfg_init(struct lua_State *L)
 		{"cfg_set_too_long_threshold", lbox_cfg_set_too_long_threshold},
 		{"cfg_set_snap_io_rate_limit", lbox_cfg_set_snap_io_rate_limit},
 		{"cfg_set_read_only", lbox_cfg_set_read_only},
+		{"cfg_set_read_view_period", lbox_cfg_set_read_view_period},
 		{NULL, NULL}
 	};
 
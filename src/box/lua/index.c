@@ -32,8 +32,10 @@
 #include "lua/utils.h"
 #include "box/box.h"
 #include "box/index.h"
+#include "box/tuple.h"
 #include "box/lua/tuple.h"
 #include "box/lua/misc.h" /* lbox_encode_tuple_on_gc() */
+#include "fiber.h"
 
 /** {{{ box.index Lua library: access to spaces and indexes
  */
@@ -168,6 +170,102 @@ lbox_index_get(lua_State *L)
 	return lbox_pushtupleornil(L, tuple);
 }
 
+/** Arguments of index.get_many() passed to protected calls. */
+struct lbox_get_many_ctx {
+	uint32_t n;
+	const char **keys;
+	/** Tuples not passed to Lua yet are referenced. */
+	struct tuple **results;
+};
+
+/** Encode index.get_many() keys, may raise a Lua error. */
+static int
+lbox_index_get_many_encode(lua_State *L)
+{
+	struct lbox_get_many_ctx *ctx =
+		(struct lbox_get_many_ctx *) lua_touserdata(L, 2);
+	for (uint32_t i = 0; i < ctx->n; i++) {
+		lua_rawgeti(L, 1, i + 1);
+		size_t key_len;
+		ctx->keys[i] = lbox_encode_tuple_on_gc(L, -1, &key_len);
+		lua_pop(L, 1);
+	}
+	return 0;
+}
+
+/** Push index.get_many() results, may raise a Lua error. */
+static int
+lbox_index_get_many_push(lua_State *L)
+{
+	struct lbox_get_many_ctx *ctx =
+		(struct lbox_get_many_ctx *) lua_touserdata(L, 1);
+	lua_createtable(L, ctx->n, 0);
+	for (uint32_t i = 0; i < ctx->n; i++) {
+		struct tuple *tuple = ctx->results[i];
+		if (tuple == NULL)
+			continue;
+		lbox_pushtuple(L, tuple);
+		ctx->results[i] = NULL;
+		box_tuple_unref(tuple);
+		lua_rawseti(L, -2, i + 1);
+	}
+	return 1;
+}
+
+static int
+lbox_index_get_many(lua_State *L)
+{
+	if (lua_gettop(L) != 3 || !lua_isnumber(L, 1) ||
+	    !lua_isnumber(L, 2) || !lua_istable(L, 3))
+		return luaL_error(L, "Usage index.get_many(space_id, index_id, "
+				  "keys)");
+
+	uint32_t space_id = lua_tointeger(L, 1);
+	uint32_t index_id = lua_tointeger(L, 2);
+	/*
+	 * Keys and results live on the region and results are
+	 * referenced, so Lua errors are caught to release them.
+	 */
+	lua_pushcfunction(L, lbox_index_get_many_encode);
+	lua_pushcfunction(L, lbox_index_get_many_push);
+	struct lbox_get_many_ctx ctx;
+	ctx.n = lua_objlen(L, 3);
+	struct region *gc = &fiber()->gc;
+	size_t used = region_used(gc);
+	size_t size = ctx.n * (sizeof(const char *) + sizeof(struct tuple *));
+	ctx.keys = (const char **) region_alloc(gc, size);
+	if (ctx.keys == NULL) {
+		diag_set(OutOfMemory, size, "region", "keys");
+		return lbox_error(L);
+	}
+	ctx.results = (struct tuple **) (ctx.keys + ctx.n);
+	lua_pushvalue(L, 4);
+	lua_pushvalue(L, 3);
+	lua_pushlightuserdata(L, &ctx);
+	if (lua_pcall(L, 2, 0, 0) != 0) {
+		region_truncate(gc, used);
+		return lua_error(L);
+	}
+	if (box_index_get_many(space_id, index_id, ctx.keys, ctx.n,
+			       ctx.results) != 0) {
+		region_truncate(gc, used);
+		return lbox_error(L);
+	}
+	lua_pushvalue(L, 5);
+	lua_pushlightuserdata(L, &ctx);
+	int rc = lua_pcall(L, 1, 1, 0);
+	if (rc != 0) {
+		for (uint32_t i = 0; i < ctx.n; i++) {
+			if (ctx.results[i] != NULL)
+				box_tuple_unref(ctx.results[i]);
+		}
+	}
+	region_truncate(gc, used);
+	if (rc != 0)
+		return lua_error(L);
+	return 1;
+}
+
 static int
 lbox_index_min(lua_State *L)
 {
@@ -326,6 +424,7 @@ box_lua_index_init(struct lua_State *L)
 		{"delete",  lbox_index_delete},
 		{"random", lbox_index_random},
 		{"get",  lbox_index_get},
+		{"get_many",  lbox_index_get_many},
 		{"min", lbox_index_min},
 		{"max", lbox_index_max},
 		{"count", lbox_index_count},
@@ -8,10 +8,13 @@ local private = require('box.internal')
 local default_vinyl_cfg = {
     memory_limit      = 1.0, -- 1G
     threads           = 5,
+    read_threads      = 1,
+    cache_size        = 128 * 1024 * 1024,
     compact_wm        = 2, -- try to maintain less than 2 runs in a range
     dump_age          = 40, -- dump idle runs after 40 seconds
     range_size        = 64 * 1024 * 1024,
     page_size        = 128 * 1024,
+    bloom_fpr         = 0.05, -- false positive rate of run bloom filters
 }
 
 -- all available options
@@ -21,6 +24,7 @@ local default_cfg = {
     slab_alloc_minimal  = 16,
     slab_alloc_maximal  = 1024 * 1024,
     slab_alloc_factor   = 1.1,
+    memtx_build_threads = 4,
     work_dir            = nil,
     snap_dir            = ".",
     wal_dir             = ".",
@@ -31,10 +35,17 @@ local default_cfg = {
     log_level           = 5,
     io_collect_interval = nil,
     readahead           = 16320,
+    iproto_threads      = 1,
     snap_io_rate_limit  = nil, -- no limit
+    snap_threads        = 4,
+    snap_compression    = 'none',
     too_long_threshold  = 0.5,
     wal_mode            = "write",
     rows_per_wal        = 500000,
+    wal_tail_size       = 16 * 1024 * 1024,
+    wal_group_commit_bytes = 1024 * 1024,
+    wal_group_commit_usec = 0,
+    wal_prealloc_size = 0,
     wal_dir_rescan_delay= 2,
     panic_on_snap_error = true,
     panic_on_wal_error  = true,
@@ -45,6 +56,7 @@ local default_cfg = {
     username            = nil,
     coredump            = false,
     read_only           = false,
+    read_view_period    = 0.01,
 
     -- snapshot_daemon
     snapshot_period     = 0,        -- 0 = disabled
@@ -55,6 +67,8 @@ local default_cfg = {
 local vinyl_template_cfg = {
     memory_limit      = 'number',
     threads           = 'number',
+    read_threads      = 'number',
+    cache_size        = 'number',
     compact_wm        = 'number',
     run_prio          = 'number',
     run_age           = 'number',
@@ -62,6 +76,7 @@ local vinyl_template_cfg = {
     run_age_wm        = 'number',
     range_size        = 'number',
     page_size        = 'number',
+    bloom_fpr         = 'number',
 }
 
 -- types of available options
@@ -72,6 +87,7 @@ local template_cfg = {
     slab_alloc_minimal  = 'number',
     slab_alloc_maximal  = 'number',
     slab_alloc_factor   = 'number',
+    memtx_build_threads = 'number',
     work_dir            = 'string',
     snap_dir            = 'string',
     wal_dir             = 'string',
@@ -82,10 +98,17 @@ local template_cfg = {
     log_level           = 'number',
     io_collect_interval = 'number',
     readahead           = 'number',
+    iproto_threads      = 'number',
     snap_io_rate_limit  = 'number',
+    snap_threads        = 'number',
+    snap_compression    = 'string',
     too_long_threshold  = 'number',
     wal_mode            = 'string',
     rows_per_wal        = 'number',
+    wal_tail_size       = 'number',
+    wal_group_commit_bytes = 'number',
+    wal_group_commit_usec = 'number',
+    wal_prealloc_size = 'number',
     wal_dir_rescan_delay= 'number',
     panic_on_snap_error = 'boolean',
     panic_on_wal_error  = 'boolean',
@@ -97,7 +120,8 @@ local template_cfg = {
     coredump            = 'boolean',
     snapshot_period     = 'number',
     snapshot_count      = 'number',
-    read_only           = 'boolean'
+    read_only           = 'boolean',
+    read_view_period    = 'number',
 }
 
 local function normalize_uri(port)
@@ -124,6 +148,7 @@ local dynamic_cfg = {
     snap_io_rate_limit      = private.cfg_set_snap_io_rate_limit,
     panic_on_wal_error      = function() end,
     read_only               = private.cfg_set_read_only,
+    read_view_period        = private.cfg_set_read_view_period,
     -- snapshot_daemon
     snapshot_period         = box.internal.snapshot_daemon.set_snapshot_period,
     snapshot_count          = box.internal.snapshot_daemon.set_snapshot_count,
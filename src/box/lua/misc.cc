@@ -63,11 +63,13 @@ static inline void
 lbox_port_to_table(lua_State *L, struct port *port)
 {
 	lua_createtable(L, port->size, 0);
-	struct port_entry *entry = port->first;
-	for (size_t i = 0 ; i < port->size; i++) {
-		lbox_pushtuple(L, entry->tuple);
-		lua_rawseti(L, -2, i + 1);
-		entry = entry->next;
+	int idx = 1;
+	for (struct port_chunk *chunk = port->first; chunk != NULL;
+	     chunk = chunk->next) {
+		for (uint32_t i = 0; i < chunk->size; i++) {
+			lbox_pushtuple(L, chunk->tuples[i]);
+			lua_rawseti(L, -2, idx++);
+		}
 	}
 }
 
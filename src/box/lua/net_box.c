@@ -222,12 +222,13 @@ netbox_encode_select(lua_State *L)
 	if (lua_gettop(L) < 9)
 		return luaL_error(L, "Usage netbox.encode_select(ibuf, sync, "
 				  "schema_id, space_id, index_id, iterator, "
-				  "offset, limit, key)");
+				  "offset, limit, key[, chunk_size])");
 
 	struct mpstream stream;
 	size_t svp = netbox_prepare_request(L, &stream, IPROTO_SELECT);
 
-	luamp_encode_map(cfg, &stream, 6);
+	uint32_t chunk_size = lua_gettop(L) < 10 ? 0 : lua_tointeger(L, 10);
+	luamp_encode_map(cfg, &stream, chunk_size > 0 ? 7 : 6);
 
 	uint32_t space_id = lua_tointeger(L, 4);
 	uint32_t index_id = lua_tointeger(L, 5);
@@ -255,6 +256,12 @@ netbox_encode_select(lua_State *L)
 	luamp_encode_uint(cfg, &stream, IPROTO_LIMIT);
 	luamp_encode_uint(cfg, &stream, limit);
 
+	/* encode chunk size, if the response is to be streamed */
+	if (chunk_size > 0) {
+		luamp_encode_uint(cfg, &stream, IPROTO_CHUNK_SIZE);
+		luamp_encode_uint(cfg, &stream, chunk_size);
+	}
+
 	/* encode key */
 	luamp_encode_uint(cfg, &stream, IPROTO_KEY);
 	luamp_convert_key(L, cfg, &stream, 9);
@@ -331,6 +338,42 @@ netbox_encode_delete(lua_State *L)
 	return 0;
 }
 
+static int
+netbox_encode_get_many(lua_State *L)
+{
+	if (lua_gettop(L) < 6 || !lua_istable(L, 6))
+		return luaL_error(L, "Usage: netbox.encode_get_many(ibuf, "
+		       "sync, schema_id, space_id, index_id, keys)");
+
+	struct mpstream stream;
+	size_t svp = netbox_prepare_request(L, &stream, IPROTO_GET_MANY);
+
+	luamp_encode_map(cfg, &stream, 3);
+
+	/* encode space_id */
+	uint32_t space_id = lua_tointeger(L, 4);
+	luamp_encode_uint(cfg, &stream, IPROTO_SPACE_ID);
+	luamp_encode_uint(cfg, &stream, space_id);
+
+	/* encode index_id */
+	uint32_t index_id = lua_tointeger(L, 5);
+	luamp_encode_uint(cfg, &stream, IPROTO_INDEX_ID);
+	luamp_encode_uint(cfg, &stream, index_id);
+
+	/* encode keys */
+	uint32_t n = lua_objlen(L, 6);
+	luamp_encode_uint(cfg, &stream, IPROTO_KEY);
+	luamp_encode_array(cfg, &stream, n);
+	for (uint32_t i = 0; i < n; i++) {
+		lua_rawgeti(L, 6, i + 1);
+		luamp_convert_key(L, cfg, &stream, lua_gettop(L));
+		lua_pop(L, 1);
+	}
+
+	netbox_encode_request(&stream, svp);
+	return 0;
+}
+
 static int
 netbox_encode_update(lua_State *L)
 {
@@ -457,6 +500,7 @@ luaopen_net_box(struct lua_State *L)
 		{ "encode_insert",  netbox_encode_insert },
 		{ "encode_replace", netbox_encode_replace },
 		{ "encode_delete",  netbox_encode_delete },
+		{ "encode_get_many", netbox_encode_get_many },
 		{ "encode_update",  netbox_encode_update },
 		{ "encode_upsert",  netbox_encode_upsert },
 		{ "encode_auth",    netbox_encode_auth },
@@ -23,7 +23,9 @@ local AUTH              = 7
 local EVAL              = 8
 local UPSERT            = 9
 local CALL              = 10
+local GET_MANY          = 11
 local PING              = 64
+local CHUNK             = 128
 local ERROR_TYPE        = 65536
 
 -- packet keys
@@ -36,6 +38,7 @@ local LIMIT             = 0x12
 local OFFSET            = 0x13
 local ITERATOR          = 0x14
 local INDEX_BASE        = 0x15
+local CHUNK_SIZE        = 0x16
 local KEY               = 0x20
 local TUPLE             = 0x21
 local FUNCTION_NAME     = 0x22
@@ -95,6 +98,20 @@ local function one_tuple(tbl)
     return
 end
 
+-- Tuples of a GET_MANY response, nil in place of missing ones.
+local function optional_tuples(data)
+    local count = #data
+    local has_tuple = rawget(box, 'tuple') ~= nil
+    for i = 1, count do
+        if data[i] == nil then
+            data[i] = nil -- box.NULL
+        elseif has_tuple then
+            data[i] = box.tuple.new(data[i])
+        end
+    end
+    return data
+end
+
 local function multiple_tuples(data)
     if rawget(box, 'tuple') ~= nil then
         for i, v in pairs(data) do
@@ -116,6 +133,7 @@ local requests = {
     [DELETE] = internal.encode_delete;
     [UPDATE]  = internal.encode_update;
     [UPSERT]  = internal.encode_upsert;
+    [GET_MANY] = internal.encode_get_many;
     [SELECT]  = function(wbuf, sync, schema_id, spaceno, indexno, key, opts)
         if opts == nil then
             opts = {}
@@ -142,8 +160,12 @@ local requests = {
         local iterator = require('box.internal').check_iterator_type(opts,
             key == nil or (type(key) == 'table' and #key == 0))
 
+        local chunk_size = 0
+        if opts.chunk_size ~= nil then
+            chunk_size = tonumber(opts.chunk_size)
+        end
         internal.encode_select(wbuf, sync, schema_id, spaceno, indexno,
-            iterator, offset, limit, key)
+            iterator, offset, limit, key, chunk_size)
     end;
 }
 
@@ -198,6 +220,11 @@ local function space_metatable(self)
                     return res[1]
                 end
                 box.error(box.error.MORE_THAN_ONE_TUPLE)
+            end,
+
+            get_many = function(space, keys)
+                check_if_space(space)
+                return self:_get_many(space.id, 0, keys)
             end
         }
     }
@@ -231,6 +258,11 @@ local function index_metatable(self)
                 box.error(box.error.MORE_THAN_ONE_TUPLE)
             end,
 
+            get_many = function(idx, keys)
+                check_if_index(idx)
+                return self:_get_many(idx.space.id, idx.id, keys)
+            end,
+
             min = function(idx, key)
                 check_if_index(idx)
                 local res = self:_select(idx.space.id, idx.id, key,
@@ -530,7 +562,22 @@ local remote_methods = {
         local sync = hdr[SYNC]
 
         local ch = self.ch.sync[sync]
-        if ch ~= nil then
+        if ch ~= nil and hdr[TYPE] == CHUNK then
+            -- A part of a streamed SELECT response, keep waiting
+            -- for the rest.
+            local chunks = ch.chunks or {}
+            ch.chunks = chunks
+            for _, tuple in ipairs(body[DATA]) do
+                table.insert(chunks, tuple)
+            end
+        elseif ch ~= nil then
+            if ch.chunks ~= nil and hdr[TYPE] == OK then
+                local data = ch.chunks
+                for _, tuple in ipairs(body[DATA]) do
+                    table.insert(data, tuple)
+                end
+                body[DATA] = data
+            end
             ch.response = { hdr = hdr, body = body }
             fiber.wakeup(ch.fid)
         else
@@ -1019,6 +1066,14 @@ local remote_methods = {
         return multiple_tuples(res.body[DATA])
     end,
 
+    _get_many = function(self, spaceno, indexno, keys)
+        if type(keys) ~= 'table' then
+            box.error(box.error.PROC_LUA, "Usage: index:get_many(keys)")
+        end
+        local res = self:_request(GET_MANY, true, spaceno, indexno, keys)
+        return optional_tuples(res.body[DATA])
+    end,
+
     _insert = function(self, spaceno, tuple)
         local res = self:_request(INSERT, true, spaceno, tuple)
         return one_tuple(res.body[DATA])
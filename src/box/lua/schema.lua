@@ -13,8 +13,10 @@ local builtin = ffi.C
 -- performance fixup for hot functions
 local tuple_encode = box.tuple.encode
 local tuple_bless = box.tuple.bless
+local tuple_bless_ref = box.tuple.bless_ref
 local is_tuple = box.tuple.is
 assert(tuple_encode ~= nil and tuple_bless ~= nil and is_tuple ~= nil)
+assert(tuple_bless_ref ~= nil)
 
 ffi.cdef[[
     struct space *space_by_id(uint32_t id);
@@ -29,9 +31,16 @@ ffi.cdef[[
                        const char *key, const char *key_end);
     int
     box_iterator_next(box_iterator_t *itr, box_tuple_t **result);
+    ssize_t
+    box_iterator_next_batch(box_iterator_t *itr, box_tuple_t **buf,
+                            uint32_t n);
     void
     box_iterator_free(box_iterator_t *itr);
     /** \endcond public */
+    bool
+    box_iterator_is_valid(box_iterator_t *itr);
+    uint32_t
+    box_iterator_batch_size(box_iterator_t *itr, uint32_t n);
     /** \cond public */
     ssize_t
     box_index_len(uint32_t space_id, uint32_t index_id);
@@ -58,16 +67,17 @@ ffi.cdef[[
     box_txn_begin();
     /** \endcond public */
 
-    struct port_entry {
-        struct port_entry *next;
-        struct tuple *tuple;
+    struct port_chunk {
+        struct port_chunk *next;
+        uint32_t size;
+        struct tuple *tuples[32]; /* PORT_CHUNK_SIZE */
     };
 
     struct port {
         size_t size;
-        struct port_entry *first;
-        struct port_entry *last;
-        struct port_entry first_entry;
+        struct port_chunk *first;
+        struct port_chunk *last;
+        struct port_chunk first_chunk;
     };
 
     void
@@ -82,6 +92,13 @@ ffi.cdef[[
                const char *key, const char *key_end);
     void password_prepare(const char *password, int len,
                           char *out, int out_len);
+
+    struct iterator_batch {
+        uint32_t pos;
+        uint32_t size;
+        bool eof;
+        box_tuple_t *tuples[32]; /* ITERATOR_BATCH_SIZE */
+    };
 ]]
 
 local function user_or_role_resolve(user)
@@ -240,6 +257,7 @@ box.schema.space.create = function(name, options)
         user = 'string, number',
         format = 'table',
         temporary = 'boolean',
+        read_view = 'boolean',
     }
     local options_defaults = {
         engine = 'memtx',
@@ -281,6 +299,7 @@ box.schema.space.create = function(name, options)
     -- filter out global parameters from the options array
     local space_options = {
         temporary = options.temporary,
+        read_view = options.read_view or nil,
     }
     _space:insert{id, uid, name, options.engine, options.field_count,
         space_options, format}
@@ -386,6 +405,11 @@ box.schema.index.create = function(space_id, name, options)
         path = 'string',
         page_size = 'number',
         range_size = 'number',
+        bloom_fpr = 'number',
+        compression = 'string',
+        compression_level = 'number',
+        hint = 'boolean',
+        layout = 'string',
     }
     check_param_table(options, options_template)
     local options_defaults = {
@@ -407,6 +431,7 @@ box.schema.index.create = function(space_id, name, options)
             -- to a subdirectory of the server data dir if it is not set
             page_size = box.cfg.vinyl.page_size,
             range_size = box.cfg.vinyl.range_size,
+            bloom_fpr = box.cfg.vinyl.bloom_fpr,
         }
     else
         options_defaults = {}
@@ -452,6 +477,11 @@ box.schema.index.create = function(space_id, name, options)
             path = options.path,
             page_size = options.page_size,
             range_size = options.range_size,
+            bloom_fpr = options.bloom_fpr,
+            compression = options.compression,
+            compression_level = options.compression_level,
+            hint = options.hint,
+            layout = options.layout,
     }
     local field_type_aliases = {
         num = 'unsigned'; -- Deprecated since 1.7.2
@@ -510,6 +540,7 @@ box.schema.index.alter = function(space_id, index_id, options)
         unique = 'boolean',
         dimension = 'number',
         distance = 'string',
+        layout = 'string',
     }
     check_param_table(options, options_template)
 
@@ -579,6 +610,9 @@ box.schema.index.alter = function(space_id, index_id, options)
     if options.distance ~= nil then
         key_opts.distance = options.distance
     end
+    if options.layout ~= nil then
+        key_opts.layout = options.layout
+    end
     if options.parts ~= nil then
         check_index_parts(options.parts)
         options.parts = update_index_parts(options.parts)
@@ -610,6 +644,23 @@ ffi.metatype(iterator_t, {
     end;
 })
 
+-- index:pairs() fetches tuples from C in batches of up to this size
+-- to amortize the cost of crossing the FFI boundary. A prefetched
+-- tuple is returned as it was when fetched, so the batch is reset to
+-- one tuple after every write, see box_iterator_batch_size(): a loop
+-- which changes the space on every step sees the current data, while
+-- one which changes it only now and then may get up to a batch of
+-- tuples which were changed after they had been fetched.
+local ITERATOR_BATCH_SIZE = 32
+local iterator_batch_t = ffi.typeof('struct iterator_batch')
+
+local iterator_batch_gc = function(batch)
+    -- release the tuples fetched, but not returned to the user
+    for i = batch.pos, batch.size - 1, 1 do
+        builtin.box_tuple_unref(batch.tuples[i])
+    end
+end
+
 local iterator_gen = function(param, state)
     --[[
         index:pairs() mostly conforms to the Lua for-in loop conventions and
@@ -619,8 +670,9 @@ local iterator_gen = function(param, state)
 
         - *param* should contain **immutable** data needed to fully define
           an iterator. *param* is opaque for users. Currently it contains keybuf
-          string just to prevent GC from collecting it. In future some other
-          variables like space_id, index_id, sc_version will be stored here.
+          string just to prevent GC from collecting it and a batch of tuples
+          prefetched from *state*. In future some other variables like
+          space_id, index_id, sc_version will be stored here.
 
         - *state* should contain **immutable** transient state of an iterator.
           *state* is opaque for users. Currently it contains `struct iterator`
@@ -634,14 +686,32 @@ local iterator_gen = function(param, state)
     if not ffi.istype(iterator_t, state) then
         error('usage: next(param, state)')
     end
-    -- next() modifies state in-place
-    if builtin.box_iterator_next(state, ptuple) ~= 0 then
-        return box.error() -- error
-    elseif ptuple[0] ~= nil then
-        return state, tuple_bless(ptuple[0]) -- new state, value
-    else
+    local batch = param.batch
+    if batch.pos == batch.size then
+        if batch.eof then
+            return nil
+        end
+        local limit = builtin.box_iterator_batch_size(state,
+            ITERATOR_BATCH_SIZE)
+        -- next_batch() modifies state in-place
+        local n = tonumber(builtin.box_iterator_next_batch(state,
+            batch.tuples, limit))
+        if n < 0 then
+            return box.error() -- error
+        end
+        batch.pos = 0
+        batch.size = n
+        batch.eof = n < limit
+        if n == 0 then
+            return nil
+        end
+    elseif not builtin.box_iterator_is_valid(state) then
+        -- the index was dropped or altered after the batch was fetched
         return nil
     end
+    local tuple = batch.tuples[batch.pos]
+    batch.pos = batch.pos + 1
+    return state, tuple_bless_ref(tuple) -- new state, value
 end
 
 local iterator_gen_luac = function(param, state)
@@ -655,7 +725,6 @@ end
 
 -- global struct port instance to use by select()/get()
 local port = ffi.new('struct port')
-local port_entry_t = ffi.typeof('struct port_entry')
 
 -- Helper function for nicer error messages
 -- in some cases when space object is misused
@@ -772,7 +841,11 @@ function box.schema.space.bless(space)
         if cdata == nil then
             box.error()
         end
-        return fun.wrap(iterator_gen, keybuf,
+        local param = {
+            keybuf = keybuf,
+            batch = ffi.gc(iterator_batch_t(), iterator_batch_gc)
+        }
+        return fun.wrap(iterator_gen, param,
             ffi.gc(cdata, builtin.box_iterator_free))
     end
     index_mt.pairs_luac = function(index, key, opts)
@@ -824,6 +897,17 @@ function box.schema.space.bless(space)
         return internal.get(index.space_id, index.id, key)
     end
 
+    index_mt.get_many = function(index, keys)
+        if type(keys) ~= 'table' then
+            box.error(box.error.PROC_LUA, "Usage: index:get_many(keys)")
+        end
+        local keyified = {}
+        for i = 1, #keys do
+            keyified[i] = keify(keys[i])
+        end
+        return internal.get_many(index.space_id, index.id, keyified)
+    end
+
     local function check_select_opts(opts, key_is_nil)
         local offset = 0
         local limit = 4294967295
@@ -851,10 +935,14 @@ function box.schema.space.bless(space)
         end
 
         local ret = {}
-        local entry = port.first
-        for i=1,tonumber(port.size),1 do
-            ret[i] = tuple_bless(entry.tuple)
-            entry = entry.next
+        local i = 1
+        local chunk = port.first
+        while chunk ~= nil do
+            for j=0,chunk.size - 1,1 do
+                ret[i] = tuple_bless(chunk.tuples[j])
+                i = i + 1
+            end
+            chunk = chunk.next
         end
         builtin.port_destroy(port);
         return ret
@@ -929,6 +1017,10 @@ function box.schema.space.bless(space)
         check_index(space, 0)
         return space.index[0]:get(key)
     end
+    space_mt.get_many = function(space, keys)
+        check_index(space, 0)
+        return space.index[0]:get_many(keys)
+    end
     space_mt.select = function(space, key, opts)
         check_index(space, 0)
         return space.index[0]:select(key, opts)
@@ -39,12 +39,11 @@
 #include <lualib.h>
 
 #include "lua/utils.h"
+#include "box/wal.h"
+#include "box/iproto.h"
 
 extern struct rmean *rmean_box;
 extern struct rmean *rmean_error;
-/** network statistics (iproto & cbus) */
-extern struct rmean *rmean_net;
-extern struct rmean *rmean_net_tx_bus;
 extern struct rmean *rmean_tx_wal_bus;
 
 static void
@@ -110,29 +109,140 @@ lbox_stat_call(struct lua_State *L)
 	return 1;
 }
 
+enum { STAT_NET_ITEM_MAX = 8 };
+
+/**
+ * Network statistics (iproto & cbus) summed over all network
+ * threads.
+ */
+struct stat_net_sum {
+	int count;
+	const char *name[STAT_NET_ITEM_MAX];
+	int rps[STAT_NET_ITEM_MAX];
+	int64_t total[STAT_NET_ITEM_MAX];
+};
+
+static int
+sum_stat_item(const char *name, int rps, int64_t total, void *cb_ctx)
+{
+	struct stat_net_sum *sum = (struct stat_net_sum *) cb_ctx;
+	int i;
+	for (i = 0; i < sum->count; i++) {
+		if (strcmp(sum->name[i], name) == 0)
+			break;
+	}
+	if (i == sum->count) {
+		if (sum->count == STAT_NET_ITEM_MAX)
+			return 0;
+		sum->name[i] = name;
+		sum->rps[i] = 0;
+		sum->total[i] = 0;
+		sum->count++;
+	}
+	sum->rps[i] += rps;
+	sum->total[i] += total;
+	return 0;
+}
+
+static void
+stat_net_sum(struct stat_net_sum *sum)
+{
+	sum->count = 0;
+	for (int i = 0; i < iproto_thread_count(); i++) {
+		rmean_foreach(iproto_thread_rmean_net(i), sum_stat_item, sum);
+		rmean_foreach(iproto_thread_rmean_tx_bus(i),
+			      sum_stat_item, sum);
+	}
+}
+
+/**
+ * Push statistics of each network thread as an array of
+ * tables, with the number of connections of the thread in
+ * CONNECTIONS.
+ */
+static void
+push_net_threads(struct lua_State *L)
+{
+	lua_newtable(L);
+	for (int i = 0; i < iproto_thread_count(); i++) {
+		lua_newtable(L);
+		rmean_foreach(iproto_thread_rmean_net(i), set_stat_item, L);
+		rmean_foreach(iproto_thread_rmean_tx_bus(i),
+			      set_stat_item, L);
+		lua_pushstring(L, "CONNECTIONS");
+		lua_pushnumber(L, iproto_thread_connection_count(i));
+		lua_settable(L, -3);
+		lua_rawseti(L, -2, i + 1);
+	}
+}
+
 static int
 lbox_stat_net_index(struct lua_State *L)
 {
-	luaL_checkstring(L, -1);
-	int res = rmean_foreach(rmean_net, seek_stat_item, L);
-	if (res)
-		return res;
-	return rmean_foreach(rmean_net_tx_bus, seek_stat_item, L);
+	const char *key = luaL_checkstring(L, -1);
+	if (strcmp(key, "threads") == 0) {
+		push_net_threads(L);
+		return 1;
+	}
+	struct stat_net_sum sum;
+	stat_net_sum(&sum);
+	for (int i = 0; i < sum.count; i++) {
+		if (strcmp(sum.name[i], key) != 0)
+			continue;
+		lua_newtable(L);
+		fill_stat_item(L, sum.rps[i], sum.total[i]);
+		return 1;
+	}
+	return 0;
 }
 
 static int
 lbox_stat_net_call(struct lua_State *L)
 {
 	lua_newtable(L);
-	rmean_foreach(rmean_net, set_stat_item, L);
-	rmean_foreach(rmean_net_tx_bus, set_stat_item, L);
+	struct stat_net_sum sum;
+	stat_net_sum(&sum);
+	for (int i = 0; i < sum.count; i++) {
+		lua_pushstring(L, sum.name[i]);
+		lua_newtable(L);
+		fill_stat_item(L, sum.rps[i], sum.total[i]);
+		lua_settable(L, -3);
+	}
+	lua_pushstring(L, "threads");
+	push_net_threads(L);
+	lua_settable(L, -3);
 	return 1;
 }
 
+/**
+ * Push a WAL histogram as a table which maps the lower bound
+ * of each non-empty bucket to the number of values in it.
+ */
+static void
+push_wal_histogram(struct lua_State *L, const int64_t *histogram)
+{
+	lua_newtable(L);
+	for (int i = 0; i < WAL_HISTOGRAM_SIZE; i++) {
+		if (histogram[i] == 0)
+			continue;
+		lua_pushnumber(L, i == 0 ? 0 : (double) (1ULL << (i - 1)));
+		lua_pushnumber(L, histogram[i]);
+		lua_settable(L, -3);
+	}
+}
+
 static int
 lbox_stat_wal_index(struct lua_State *L)
 {
-	luaL_checkstring(L, -1);
+	const char *key = luaL_checkstring(L, -1);
+	if (wal_stat != NULL && strcmp(key, "batch_rows") == 0) {
+		push_wal_histogram(L, wal_stat->batch_rows);
+		return 1;
+	}
+	if (wal_stat != NULL && strcmp(key, "fsync_usec") == 0) {
+		push_wal_histogram(L, wal_stat->fsync_usec);
+		return 1;
+	}
 	if (rmean_tx_wal_bus == NULL)
 		return 0;
 	return rmean_foreach(rmean_tx_wal_bus, seek_stat_item, L);
@@ -144,6 +254,15 @@ lbox_stat_wal_call(struct lua_State *L)
 	lua_newtable(L);
 	if (rmean_tx_wal_bus)
 		rmean_foreach(rmean_tx_wal_bus, set_stat_item, L);
+	if (wal_stat != NULL) {
+		lua_pushstring(L, "batch_rows");
+		push_wal_histogram(L, wal_stat->batch_rows);
+		lua_settable(L, -3);
+
+		lua_pushstring(L, "fsync_usec");
+		push_wal_histogram(L, wal_stat->fsync_usec);
+		lua_settable(L, -3);
+	}
 	return 1;
 }
 
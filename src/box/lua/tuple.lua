@@ -113,6 +113,12 @@ local tuple_bless = function(tuple)
     return ffi.gc(ffi.cast(const_tuple_ref_t, tuple), tuple_gc)
 end
 
+-- Same as tuple_bless(), but takes over a reference already
+-- held by the caller instead of acquiring a new one
+local tuple_bless_ref = function(tuple)
+    return ffi.gc(ffi.cast(const_tuple_ref_t, tuple), tuple_gc)
+end
+
 local tuple_check = function(tuple, usage)
     if not is_tuple(tuple) then
         error('Usage: ' .. usage)
@@ -340,5 +346,6 @@ cfuncs = nil
 
 -- internal api for box.select and iterators
 box.tuple.bless = tuple_bless
+box.tuple.bless_ref = tuple_bless_ref
 box.tuple.encode = tuple_encode
 box.tuple.is = is_tuple
@@ -39,6 +39,7 @@
 #include "coeio.h"
 #include "errinj.h"
 #include "scoped_guard.h"
+#include "tt_pthread.h"
 
 #include "tuple.h"
 #include "txn.h"
@@ -58,6 +59,7 @@
 #include "relay.h"
 #include "schema.h"
 #include "port.h"
+#include "cbus.h"
 
 /** For all memory used by all indexes.
  * If you decide to use memtx_index_arena or
@@ -443,9 +445,11 @@ MemtxSpace::createIndex(struct space *space, struct key_def *key_def_arg)
 	(void) space;
 	switch (key_def_arg->type) {
 	case HASH:
+		if (key_def_arg->opts.layout == HASH_INDEX_LAYOUT_SWISS)
+			return new MemtxSwissHash(key_def_arg);
 		return new MemtxHash(key_def_arg);
 	case TREE:
-		return new MemtxTree(key_def_arg);
+		return memtx_tree_new(key_def_arg);
 	case RTREE:
 		return new MemtxRTree(key_def_arg);
 	case BITSET:
@@ -502,15 +506,18 @@ MemtxSpace::executeSelect(struct txn *, struct space *space,
 	struct iterator *it = index->position();
 	index->initIterator(it, type, key, part_count);
 
-	struct tuple *tuple;
-	while ((tuple = it->next(it)) != NULL) {
-		if (offset > 0) {
-			offset--;
-			continue;
-		}
-		if (limit == found++)
+	struct tuple *batch[PORT_CHUNK_SIZE];
+	while (found < limit) {
+		/* Do not fetch more than the request needs. */
+		uint64_t want = (uint64_t) offset + limit - found;
+		uint32_t n = iterator_next_batch(it, batch,
+					MIN(want, (uint64_t) lengthof(batch)));
+		uint32_t i = MIN(offset, n);
+		offset -= i;
+		for (; i < n; i++, found++)
+			port_add_tuple(port, batch[i]);
+		if (n < lengthof(batch))
 			break;
-		port_add_tuple(port, tuple);
 	}
 }
 
@@ -637,8 +644,16 @@ memtx_build_secondary_keys(struct space *space, void *param)
 				 space_name(space));
 		}
 
-		for (uint32_t j = 1; j < space->index_count; j++)
-			index_build((MemtxIndex *) space->index[j], pk);
+		struct MemtxEngine *engine = (struct MemtxEngine *) param;
+		RegionGuard region_guard(&fiber()->gc);
+		uint32_t index_count = space->index_count - 1;
+		MemtxIndex **indexes = (MemtxIndex **)
+			region_alloc_xc(&fiber()->gc,
+					sizeof(*indexes) * index_count);
+		for (uint32_t j = 0; j < index_count; j++)
+			indexes[j] = (MemtxIndex *) space->index[j + 1];
+		index_build_parallel(indexes, index_count, pk,
+				     engine->buildThreads());
 
 		if (n_tuples > 0) {
 			say_info("Space '%s': done", space_name(space));
@@ -653,7 +668,10 @@ MemtxEngine::MemtxEngine(const char *snap_dirname, bool panic_on_snap_error,
 	m_checkpoint(0),
 	m_state(MEMTX_INITIALIZED),
 	m_snap_io_rate_limit(UINT64_MAX),
-	m_panic_on_wal_error(panic_on_wal_error)
+	m_panic_on_wal_error(panic_on_wal_error),
+	m_build_threads(1),
+	m_snap_threads(1),
+	m_snap_compression(XLOG_COMPRESSION_NONE)
 {
 	flags = ENGINE_CAN_BE_TEMPORARY;
 	xdir_create(&m_snap_dir, snap_dirname, SNAP, &SERVER_UUID);
@@ -686,6 +704,380 @@ MemtxEngine::lastCheckpoint(struct vclock *vclock)
 	return vclock->signature;
 }
 
+/* {{{ Snapshot reader */
+
+enum {
+	/** Max number of rows in a batch read from a snapshot. */
+	SNAP_BATCH_ROWS_MAX = 1024,
+	/** Default size of the buffer for row bodies of a batch. */
+	SNAP_BATCH_SIZE = 1024 * 1024,
+	/**
+	 * Max number of batches sent to tx and not applied yet.
+	 * Bounds memory used by the reader running ahead of tx.
+	 */
+	SNAP_BATCHES_MAX = 8,
+};
+
+/**
+ * A batch of snapshot rows read, checksummed and decoded
+ * by the reader thread, to be applied by tx.
+ */
+struct snap_batch {
+	struct cmsg base;
+	struct snap_reader *reader;
+	/** Link in snap_reader::ready or snap_reader::free_batches. */
+	struct stailq_entry in_list;
+	/** Number of decoded rows in the batch. */
+	int row_count;
+	struct xrow_header rows[SNAP_BATCH_ROWS_MAX];
+	struct request requests[SNAP_BATCH_ROWS_MAX];
+	/** Row bodies, the rows and requests point here. */
+	char *data;
+	size_t size;
+	size_t capacity;
+};
+
+/**
+ * Reads a snapshot in a separate thread, so that file reads,
+ * checksums and decoding of rows overlap with applying of
+ * rows in tx. Batches of rows travel to tx and back over
+ * cbus.
+ */
+struct snap_reader {
+	struct xlog *snap;
+	struct cord cord;
+	struct cbus bus;
+	/** Batches of rows and the end of the snapshot, to tx. */
+	struct cpipe tx_pipe;
+	/** Applied batches and the stop message, to the reader. */
+	struct cpipe reader_pipe;
+	/** Sent to tx when the reader is done reading. */
+	struct cmsg done_msg;
+	/** Sent to the reader when tx needs no more rows. */
+	struct cmsg stop_msg;
+	/** tx: batches ready to be applied. */
+	struct stailq ready;
+	/** tx: set when all batches have been received. */
+	bool is_done;
+	/** tx: the fiber waiting for a batch, if any. */
+	struct fiber *tx_waiter;
+	/** reader: batches to reuse. */
+	struct stailq free_batches;
+	/** reader: number of batches sent to tx. */
+	int batches_in_flight;
+	/** reader: set when tx asks to stop. */
+	bool is_stopped;
+	/** reader: the fiber waiting for a batch, if any. */
+	struct fiber *reader_waiter;
+	/** Set if the snapshot has a valid EOF marker. */
+	bool eof_read;
+	/** Result of the reader thread, valid after it is joined. */
+	int rc;
+};
+
+/**
+ * Deliver messages pushed to the pipe at once rather than
+ * at the next event loop iteration: neither thread yields
+ * while it has rows to process.
+ */
+static inline void
+snap_reader_push(struct cpipe *pipe, struct cmsg *msg)
+{
+	cpipe_push_input(pipe, msg);
+	ev_invoke(pipe->producer, &pipe->flush_input, EV_CUSTOM);
+}
+
+/** tx: a batch of rows has arrived. */
+static void
+snap_batch_deliver_f(struct cmsg *msg)
+{
+	struct snap_batch *batch = (struct snap_batch *) msg;
+	struct snap_reader *reader = batch->reader;
+	stailq_add_tail_entry(&reader->ready, batch, in_list);
+	if (reader->tx_waiter != NULL)
+		fiber_wakeup(reader->tx_waiter);
+}
+
+/** reader: tx has applied a batch. */
+static void
+snap_batch_return_f(struct cmsg *msg)
+{
+	struct snap_batch *batch = (struct snap_batch *) msg;
+	struct snap_reader *reader = batch->reader;
+	stailq_add_entry(&reader->free_batches, batch, in_list);
+	reader->batches_in_flight--;
+	if (reader->reader_waiter != NULL)
+		fiber_wakeup(reader->reader_waiter);
+}
+
+/** tx: the reader has sent all batches. */
+static void
+snap_reader_done_f(struct cmsg *msg)
+{
+	struct snap_reader *reader =
+		container_of(msg, struct snap_reader, done_msg);
+	reader->is_done = true;
+	if (reader->tx_waiter != NULL)
+		fiber_wakeup(reader->tx_waiter);
+}
+
+/** reader: tx asks to stop reading. */
+static void
+snap_reader_stop_f(struct cmsg *msg)
+{
+	struct snap_reader *reader =
+		container_of(msg, struct snap_reader, stop_msg);
+	reader->is_stopped = true;
+	if (reader->reader_waiter != NULL)
+		fiber_wakeup(reader->reader_waiter);
+}
+
+static void
+snap_reader_create(struct snap_reader *reader, struct xlog *snap)
+{
+	static const struct cmsg_hop done_route[] = {
+		{ snap_reader_done_f, NULL },
+	};
+	static const struct cmsg_hop stop_route[] = {
+		{ snap_reader_stop_f, NULL },
+	};
+	reader->snap = snap;
+	cbus_create(&reader->bus);
+	cpipe_create(&reader->tx_pipe);
+	cpipe_create(&reader->reader_pipe);
+	cmsg_init(&reader->done_msg, done_route);
+	cmsg_init(&reader->stop_msg, stop_route);
+	stailq_create(&reader->ready);
+	reader->is_done = false;
+	reader->tx_waiter = NULL;
+	stailq_create(&reader->free_batches);
+	reader->batches_in_flight = 0;
+	reader->is_stopped = false;
+	reader->reader_waiter = NULL;
+	reader->eof_read = false;
+	reader->rc = 0;
+}
+
+static void
+snap_reader_destroy(struct snap_reader *reader)
+{
+	cbus_destroy(&reader->bus);
+}
+
+/** reader: wait until tx returns a batch or asks to stop. */
+static void
+snap_reader_wait(struct snap_reader *reader)
+{
+	reader->reader_waiter = fiber();
+	fiber_yield();
+	reader->reader_waiter = NULL;
+}
+
+/**
+ * reader: get an empty batch able to fit a row body of
+ * @a size bytes. Return NULL if tx asked to stop.
+ */
+static struct snap_batch *
+snap_reader_get_batch(struct snap_reader *reader, size_t size)
+{
+	while (reader->batches_in_flight >= SNAP_BATCHES_MAX &&
+	       !reader->is_stopped)
+		snap_reader_wait(reader);
+	if (reader->is_stopped)
+		return NULL;
+	struct snap_batch *batch;
+	if (!stailq_empty(&reader->free_batches)) {
+		batch = stailq_shift_entry(&reader->free_batches,
+					   struct snap_batch, in_list);
+	} else {
+		batch = (struct snap_batch *) calloc(1, sizeof(*batch));
+		if (batch == NULL) {
+			tnt_raise(OutOfMemory, sizeof(*batch), "calloc",
+				  "struct snap_batch");
+		}
+		batch->reader = reader;
+	}
+	batch->row_count = 0;
+	batch->size = 0;
+	size = MAX(size, (size_t) SNAP_BATCH_SIZE);
+	if (batch->capacity < size) {
+		char *data = (char *) realloc(batch->data, size);
+		if (data == NULL) {
+			stailq_add_entry(&reader->free_batches, batch, in_list);
+			tnt_raise(OutOfMemory, size, "realloc",
+				  "snap_batch->data");
+		}
+		batch->data = data;
+		batch->capacity = size;
+	}
+	return batch;
+}
+
+/** reader: pass a batch of rows to tx. */
+static void
+snap_reader_send_batch(struct snap_reader *reader, struct cpipe *tx_pipe,
+		       struct snap_batch *batch)
+{
+	static const struct cmsg_hop route[] = {
+		{ snap_batch_deliver_f, NULL },
+	};
+	cmsg_init(&batch->base, route);
+	reader->batches_in_flight++;
+	snap_reader_push(tx_pipe, &batch->base);
+}
+
+/**
+ * Decode a snapshot row. Only needs the row itself, so may
+ * be called from any thread.
+ */
+static void
+snap_row_decode(struct xrow_header *row, struct request *request)
+{
+	assert(row->bodycnt == 1); /* always 1 for read */
+	if (row->type != IPROTO_INSERT) {
+		tnt_raise(ClientError, ER_UNKNOWN_REQUEST_TYPE,
+			  (uint32_t) row->type);
+	}
+	request_create(request, row->type);
+	request_decode(request, (const char *) row->body[0].iov_base,
+		row->body[0].iov_len);
+	request->header = row;
+}
+
+/** reader: read the snapshot and send its rows to tx. */
+static void
+snap_reader_read(struct snap_reader *reader, struct cpipe *tx_pipe)
+{
+	struct xlog_cursor cursor;
+	xlog_cursor_open(&cursor, reader->snap);
+	struct snap_batch *batch = NULL;
+	auto guard = make_scoped_guard([&]{
+		if (batch != NULL) {
+			stailq_add_entry(&reader->free_batches,
+					 batch, in_list);
+		}
+		xlog_cursor_close(&cursor);
+	});
+
+	struct xrow_header row;
+	while (!reader->is_stopped &&
+	       xlog_cursor_next_xc(&cursor, &row) == 0) {
+		size_t len = row.bodycnt > 0 ? row.body[0].iov_len : 0;
+		if (batch != NULL &&
+		    (batch->row_count == SNAP_BATCH_ROWS_MAX ||
+		     batch->size + len > batch->capacity)) {
+			snap_reader_send_batch(reader, tx_pipe, batch);
+			batch = NULL;
+		}
+		if (batch == NULL) {
+			batch = snap_reader_get_batch(reader, len);
+			if (batch == NULL)
+				break;
+		}
+		struct xrow_header *batch_row = &batch->rows[batch->row_count];
+		*batch_row = row;
+		if (len > 0) {
+			memcpy(batch->data + batch->size,
+			       row.body[0].iov_base, len);
+			batch_row->body[0].iov_base = batch->data + batch->size;
+		}
+		try {
+			snap_row_decode(batch_row,
+					&batch->requests[batch->row_count]);
+		} catch (ClientError *e) {
+			if (reader->snap->dir->panic_if_error)
+				throw;
+			say_error("can't apply row: ");
+			e->log();
+			continue;
+		}
+		batch->size += len;
+		batch->row_count++;
+	}
+	if (batch != NULL && batch->row_count > 0) {
+		snap_reader_send_batch(reader, tx_pipe, batch);
+		batch = NULL;
+	}
+	reader->eof_read = cursor.eof_read;
+}
+
+/** Snapshot reader thread. */
+static int
+snap_reader_f(va_list ap)
+{
+	struct snap_reader *reader = va_arg(ap, struct snap_reader *);
+	struct cpipe *tx_pipe = cbus_join(&reader->bus, &reader->reader_pipe);
+
+	int rc = 0;
+	try {
+		snap_reader_read(reader, tx_pipe);
+		/* Drop errors of the rows skipped on the way. */
+		diag_clear(diag_get());
+	} catch (Exception *e) {
+		/* The error is passed to tx by cord_join(). */
+		rc = -1;
+	}
+	reader->rc = rc;
+	snap_reader_push(tx_pipe, &reader->done_msg);
+	/*
+	 * Don't leave before tx has returned all batches and
+	 * won't send anything else.
+	 */
+	while (!reader->is_stopped || reader->batches_in_flight > 0)
+		snap_reader_wait(reader);
+
+	struct snap_batch *batch, *next;
+	stailq_foreach_entry_safe(batch, next, &reader->free_batches,
+				  in_list) {
+		free(batch->data);
+		free(batch);
+	}
+	return rc;
+}
+
+/** tx: wait for the next batch. Return NULL at the end. */
+static struct snap_batch *
+snap_reader_next_batch(struct snap_reader *reader)
+{
+	while (stailq_empty(&reader->ready) && !reader->is_done) {
+		reader->tx_waiter = fiber();
+		fiber_yield();
+		reader->tx_waiter = NULL;
+	}
+	if (stailq_empty(&reader->ready))
+		return NULL;
+	return stailq_shift_entry(&reader->ready, struct snap_batch, in_list);
+}
+
+/** tx: give an applied batch back to the reader. */
+static void
+snap_reader_return_batch(struct cpipe *reader_pipe, struct snap_batch *batch)
+{
+	static const struct cmsg_hop route[] = {
+		{ snap_batch_return_f, NULL },
+	};
+	cmsg_init(&batch->base, route);
+	snap_reader_push(reader_pipe, &batch->base);
+}
+
+/**
+ * tx: stop the reader, drop the rows not applied yet and
+ * join the thread. Return the result of the reader, its
+ * error is moved to the diagnostics area of the caller.
+ */
+static int
+snap_reader_close(struct snap_reader *reader, struct cpipe *reader_pipe)
+{
+	snap_reader_push(reader_pipe, &reader->stop_msg);
+	struct snap_batch *batch;
+	while ((batch = snap_reader_next_batch(reader)) != NULL)
+		snap_reader_return_batch(reader_pipe, batch);
+	cord_join(&reader->cord);
+	return reader->rc;
+}
+
+/* }}} */
+
 void
 MemtxEngine::recoverSnapshot()
 {
@@ -702,30 +1094,55 @@ MemtxEngine::recoverSnapshot()
 	SERVER_UUID = snap->server_uuid;
 
 	say_info("recovering from `%s'", snap->filename);
-	struct xlog_cursor cursor;
-	xlog_cursor_open(&cursor, snap);
+	struct snap_reader reader;
+	snap_reader_create(&reader, snap);
+	if (cord_costart(&reader.cord, "snap.reader", snap_reader_f,
+			 &reader) != 0) {
+		snap_reader_destroy(&reader);
+		diag_raise();
+	}
+	struct cpipe *reader_pipe = cbus_join(&reader.bus, &reader.tx_pipe);
 	auto reader_guard = make_scoped_guard([&]{
-		xlog_cursor_close(&cursor);
+		/* Keep the error being raised, not the reader's one. */
+		struct diag diag;
+		diag_create(&diag);
+		diag_move(diag_get(), &diag);
+		snap_reader_close(&reader, reader_pipe);
+		diag_move(&diag, diag_get());
+		snap_reader_destroy(&reader);
 	});
 
-	struct xrow_header row;
-	while (xlog_cursor_next_xc(&cursor, &row) == 0) {
-		try {
-			recoverSnapshotRow(&row);
-		} catch (ClientError *e) {
-			if (m_snap_dir.panic_if_error)
-				throw;
-			say_error("can't apply row: ");
-			e->log();
+	struct snap_batch *batch;
+	while ((batch = snap_reader_next_batch(&reader)) != NULL) {
+		auto batch_guard = make_scoped_guard([&]{
+			snap_reader_return_batch(reader_pipe, batch);
+		});
+		for (int i = 0; i < batch->row_count; i++) {
+			try {
+				recoverSnapshotRequest(&batch->requests[i]);
+			} catch (ClientError *e) {
+				if (m_snap_dir.panic_if_error)
+					throw;
+				say_error("can't apply row: ");
+				e->log();
+			}
 		}
+		/* Don't let gc pool grow too much. */
+		region_free_after(&fiber()->gc, 128 * 1024);
 	}
 
+	reader_guard.is_active = false;
+	int rc = snap_reader_close(&reader, reader_pipe);
+	snap_reader_destroy(&reader);
+	if (rc != 0)
+		diag_raise();
+
 	/**
 	 * We should never try to read snapshots with no EOF
 	 * marker - such snapshots are very likely corrupted and
 	 * should not be trusted.
 	 */
-	if (!cursor.eof_read)
+	if (!reader.eof_read)
 		panic("snapshot `%s' has no EOF marker", snap->filename);
 
 }
@@ -733,19 +1150,15 @@ MemtxEngine::recoverSnapshot()
 void
 MemtxEngine::recoverSnapshotRow(struct xrow_header *row)
 {
-	assert(row->bodycnt == 1); /* always 1 for read */
-	if (row->type != IPROTO_INSERT) {
-		tnt_raise(ClientError, ER_UNKNOWN_REQUEST_TYPE,
-			  (uint32_t) row->type);
-	}
-
 	struct request *request;
 	request = region_alloc_object_xc(&fiber()->gc, struct request);
-	request_create(request, row->type);
-	request_decode(request, (const char *) row->body[0].iov_base,
-		row->body[0].iov_len);
-	request->header = row;
+	snap_row_decode(row, request);
+	recoverSnapshotRequest(request);
+}
 
+void
+MemtxEngine::recoverSnapshotRequest(struct request *request)
+{
 	struct space *space = space_cache_find(request->space_id);
 	/* memtx snapshot must contain only memtx spaces */
 	if (space->handler->engine != this)
@@ -890,6 +1303,19 @@ MemtxEngine::buildSecondaryKey(struct space *old_space,
 void
 MemtxEngine::keydefCheck(struct space *space, struct key_def *key_def)
 {
+	if (key_def->opts.hint && key_def->type != TREE) {
+		tnt_raise(ClientError, ER_MODIFY_INDEX,
+			  key_def->name,
+			  space_name(space),
+			  "only TREE index supports hints");
+	}
+	if (key_def->opts.layout != HASH_INDEX_LAYOUT_CHAIN &&
+	    key_def->type != HASH) {
+		tnt_raise(ClientError, ER_MODIFY_INDEX,
+			  key_def->name,
+			  space_name(space),
+			  "only HASH index supports layouts");
+	}
 	switch (key_def->type) {
 	case HASH:
 		if (! key_def->opts.is_unique) {
@@ -1076,44 +1502,62 @@ MemtxEngine::bootstrap()
 		recoverSnapshotRow(&row);
 }
 
-static void
-checkpoint_write_row(struct xlog *l, struct xrow_header *row,
-		     uint64_t snap_io_rate_limit)
-{
-	static uint64_t bytes;
-	ev_tstamp elapsed;
-	static ev_tstamp last = 0;
-	ev_loop *loop = loop();
-
-	row->tm = last;
-	row->server_id = 0;
+enum {
+	/** Size of a buffer of rows encoded by a snapshot thread. */
+	CHECKPOINT_BLOCK_SIZE = 1024 * 1024,
 	/**
-	 * Rows in snapshot are numbered from 1 to %rows.
-	 * This makes streaming such rows to a replica or
-	 * to recovery look similar to streaming a normal
-	 * WAL. @sa the place which skips old rows in
-	 * recovery_apply_row().
+	 * Max number of encoded blocks of a space waiting
+	 * to be written. Bounds memory used by encoder threads
+	 * running ahead of the writer.
 	 */
-	row->lsn = ++l->rows;
-	row->sync = 0; /* don't write sync to wal */
+	CHECKPOINT_BLOCKS_MAX = 4,
+};
 
-	struct iovec iov[XROW_IOVMAX];
-	int iovcnt = xlog_encode_row(row, iov);
+/**
+ * A buffer of rows encoded by a snapshot encoder thread, or
+ * a block of the snapshot file made of such rows.
+ */
+struct checkpoint_block {
+	/** Link in checkpoint_entry::blocks. */
+	struct rlist in_entry;
+	/** Number of rows in the block. */
+	uint64_t rows;
+	/** Size of the encoded rows. */
+	size_t size;
+	/** Size of the allocated data. */
+	size_t capacity;
+	char data[0];
+};
 
-	/* TODO: use writev here */
-	for (int i = 0; i < iovcnt; i++) {
-		if (fwrite(iov[i].iov_base, iov[i].iov_len, 1, l->f) != 1) {
-			say_syserror("Can't write row (%zu bytes)",
-				     iov[i].iov_len);
-			tnt_raise(SystemError, "fwrite");
-		}
-		bytes += iov[i].iov_len;
+static struct checkpoint_block *
+checkpoint_block_new(size_t capacity)
+{
+	size_t size = sizeof(struct checkpoint_block) + capacity;
+	struct checkpoint_block *block =
+		(struct checkpoint_block *) malloc(size);
+	if (block == NULL) {
+		tnt_raise(OutOfMemory, size, "malloc",
+			  "struct checkpoint_block");
 	}
+	block->rows = 0;
+	block->size = 0;
+	block->capacity = capacity;
+	return block;
+}
 
-	if (l->rows % 100000 == 0)
-		say_crit("%.1fM rows written", l->rows / 1000000.);
+/**
+ * Account @a len bytes written to the snapshot and sleep
+ * if the write rate exceeds @a snap_io_rate_limit.
+ */
+static void
+checkpoint_throttle(struct xlog *l, size_t len, uint64_t snap_io_rate_limit)
+{
+	static uint64_t bytes;
+	ev_tstamp elapsed;
+	static ev_tstamp last = 0;
+	ev_loop *loop = loop();
 
-	fiber_gc();
+	bytes += len;
 
 	if (snap_io_rate_limit != UINT64_MAX) {
 		if (last == 0) {
@@ -1153,33 +1597,20 @@ checkpoint_write_row(struct xlog *l, struct xrow_header *row,
 	}
 }
 
-static void
-checkpoint_write_tuple(struct xlog *l, uint32_t n, struct tuple *tuple,
-		       uint64_t snap_io_rate_limit)
-{
-	struct request_replace_body body;
-	body.m_body = 0x82; /* map of two elements. */
-	body.k_space_id = IPROTO_SPACE_ID;
-	body.m_space_id = 0xce; /* uint32 */
-	body.v_space_id = mp_bswap_u32(n);
-	body.k_tuple = IPROTO_TUPLE;
-
-	struct xrow_header row;
-	memset(&row, 0, sizeof(struct xrow_header));
-	row.type = IPROTO_INSERT;
-
-	row.bodycnt = 2;
-	row.body[0].iov_base = &body;
-	row.body[0].iov_len = sizeof(body);
-	row.body[1].iov_base = tuple->data;
-	row.body[1].iov_len = tuple->bsize;
-	checkpoint_write_row(l, &row, snap_io_rate_limit);
-}
-
 struct checkpoint_entry {
 	struct space *space;
 	struct iterator *iterator;
 	struct rlist link;
+	/** Number of tuples in the read view. */
+	uint64_t rows;
+	/** LSN of the first row of the space in the snapshot. */
+	int64_t first_lsn;
+	/** Encoded blocks not written yet, in LSN order. */
+	struct rlist blocks;
+	/** Length of the blocks list. */
+	int block_count;
+	/** Set when all rows of the space have been encoded. */
+	bool is_encoded;
 };
 
 struct checkpoint {
@@ -1194,16 +1625,43 @@ struct checkpoint {
 	/** The vclock of the snapshot file. */
 	struct vclock vclock;
 	struct xdir dir;
+	/** Max number of threads encoding snapshot rows. */
+	int snap_threads;
+	/**
+	 * Link of the next entry to be taken by an encoder,
+	 * &entries if all spaces have been taken.
+	 */
+	struct rlist *next_entry;
+	/**
+	 * Protects the state shared between the writer and
+	 * the encoders: next_entry, is_aborted, and blocks,
+	 * block_count and is_encoded of each entry.
+	 */
+	pthread_mutex_t mutex;
+	/** Signalled whenever the shared state changes. */
+	pthread_cond_t cond;
+	/** Set if either the writer or an encoder failed. */
+	bool is_aborted;
+	/** Timestamp of the snapshot rows. */
+	double tm;
 };
 
 static void
 checkpoint_init(struct checkpoint *ckpt, const char *snap_dirname,
-		uint64_t snap_io_rate_limit)
+		uint64_t snap_io_rate_limit, int snap_threads,
+		enum xlog_compression snap_compression)
 {
 	ckpt->entries = RLIST_HEAD_INITIALIZER(ckpt->entries);
 	ckpt->waiting_for_snap_thread = false;
 	xdir_create(&ckpt->dir, snap_dirname, SNAP, &SERVER_UUID);
+	ckpt->dir.compression = snap_compression;
 	ckpt->snap_io_rate_limit = snap_io_rate_limit;
+	ckpt->snap_threads = snap_threads;
+	ckpt->next_entry = &ckpt->entries;
+	tt_pthread_mutex_init(&ckpt->mutex, NULL);
+	tt_pthread_cond_init(&ckpt->cond, NULL);
+	ckpt->is_aborted = false;
+	ckpt->tm = 0;
 	/* May be used in abortCheckpoint() */
 	vclock_create(&ckpt->vclock);
 }
@@ -1216,8 +1674,14 @@ checkpoint_destroy(struct checkpoint *ckpt)
 		Index *pk = space_index(entry->space, 0);
 		pk->destroyReadViewForIterator(entry->iterator);
 		entry->iterator->free(entry->iterator);
+		/* Left over if the checkpoint was aborted. */
+		struct checkpoint_block *block, *tmp;
+		rlist_foreach_entry_safe(block, &entry->blocks, in_entry, tmp)
+			free(block);
 	}
 	ckpt->entries = RLIST_HEAD_INITIALIZER(ckpt->entries);
+	tt_pthread_cond_destroy(&ckpt->cond);
+	tt_pthread_mutex_destroy(&ckpt->mutex);
 	xdir_destroy(&ckpt->dir);
 }
 
@@ -1239,11 +1703,224 @@ checkpoint_add_space(struct space *sp, void *data)
 
 	entry->space = sp;
 	entry->iterator = pk->allocIterator();
+	rlist_create(&entry->blocks);
+	entry->block_count = 0;
+	entry->is_encoded = false;
 
 	pk->initIterator(entry->iterator, ITER_ALL, NULL, 0);
 	pk->createReadViewForIterator(entry->iterator);
+	/*
+	 * The read view is frozen, so the number of rows
+	 * the iterator is going to return is known upfront.
+	 */
+	entry->rows = pk->size();
 };
 
+/** Stop all snapshot threads. */
+static void
+checkpoint_abort(struct checkpoint *ckpt)
+{
+	tt_pthread_mutex_lock(&ckpt->mutex);
+	ckpt->is_aborted = true;
+	pthread_cond_broadcast(&ckpt->cond);
+	tt_pthread_mutex_unlock(&ckpt->mutex);
+}
+
+/**
+ * Take the next space to encode. Return NULL if there are
+ * no spaces left or the checkpoint was aborted.
+ */
+static struct checkpoint_entry *
+checkpoint_take_entry(struct checkpoint *ckpt)
+{
+	struct checkpoint_entry *entry = NULL;
+	tt_pthread_mutex_lock(&ckpt->mutex);
+	if (!ckpt->is_aborted && ckpt->next_entry != &ckpt->entries) {
+		entry = rlist_entry(ckpt->next_entry,
+				    struct checkpoint_entry, link);
+		ckpt->next_entry = ckpt->next_entry->next;
+	}
+	tt_pthread_mutex_unlock(&ckpt->mutex);
+	return entry;
+}
+
+/**
+ * Pass an encoded block to the writer. Wait if the writer
+ * is lagging behind too much. Return false if the
+ * checkpoint was aborted. The block is consumed anyway.
+ */
+static bool
+checkpoint_push_block(struct checkpoint *ckpt, struct checkpoint_entry *entry,
+		      struct checkpoint_block *block)
+{
+	tt_pthread_mutex_lock(&ckpt->mutex);
+	while (entry->block_count >= CHECKPOINT_BLOCKS_MAX &&
+	       !ckpt->is_aborted)
+		tt_pthread_cond_wait(&ckpt->cond, &ckpt->mutex);
+	rlist_add_tail_entry(&entry->blocks, block, in_entry);
+	entry->block_count++;
+	bool is_aborted = ckpt->is_aborted;
+	pthread_cond_broadcast(&ckpt->cond);
+	tt_pthread_mutex_unlock(&ckpt->mutex);
+	return !is_aborted;
+}
+
+/**
+ * Take the next block of @a entry to write. Return NULL if
+ * all rows of the space have been written or the checkpoint
+ * was aborted.
+ */
+static struct checkpoint_block *
+checkpoint_pop_block(struct checkpoint *ckpt, struct checkpoint_entry *entry)
+{
+	struct checkpoint_block *block = NULL;
+	tt_pthread_mutex_lock(&ckpt->mutex);
+	while (rlist_empty(&entry->blocks) && !entry->is_encoded &&
+	       !ckpt->is_aborted)
+		tt_pthread_cond_wait(&ckpt->cond, &ckpt->mutex);
+	if (!ckpt->is_aborted && !rlist_empty(&entry->blocks)) {
+		block = rlist_shift_entry(&entry->blocks,
+					  struct checkpoint_block, in_entry);
+		entry->block_count--;
+		pthread_cond_broadcast(&ckpt->cond);
+	}
+	tt_pthread_mutex_unlock(&ckpt->mutex);
+	return block;
+}
+
+/**
+ * Frame rows accumulated in @a rows into a block of the
+ * snapshot file and pass it to the writer. Empties @a rows.
+ * Return false if the checkpoint was aborted.
+ */
+static bool
+checkpoint_flush_rows(struct checkpoint *ckpt, struct checkpoint_entry *entry,
+		      struct checkpoint_block *rows)
+{
+	struct checkpoint_block *block =
+		checkpoint_block_new(xlog_block_bound(rows->size));
+	ssize_t size = xlog_encode_block(rows->data, rows->size,
+					 ckpt->dir.compression, block->data);
+	if (size < 0) {
+		free(block);
+		diag_raise();
+	}
+	block->size = size;
+	block->rows = rows->rows;
+	rows->size = 0;
+	rows->rows = 0;
+	return checkpoint_push_block(ckpt, entry, block);
+}
+
+/**
+ * Encode all rows of a space into blocks. Since the number
+ * of rows of each space is known in advance, each space
+ * has its own LSN range and can be encoded independently
+ * of other spaces.
+ */
+static void
+checkpoint_encode_entry(struct checkpoint *ckpt, struct checkpoint_entry *entry)
+{
+	struct request_replace_body body;
+	body.m_body = 0x82; /* map of two elements. */
+	body.k_space_id = IPROTO_SPACE_ID;
+	body.m_space_id = 0xce; /* uint32 */
+	body.v_space_id = mp_bswap_u32(space_id(entry->space));
+	body.k_tuple = IPROTO_TUPLE;
+
+	struct xrow_header row;
+	memset(&row, 0, sizeof(struct xrow_header));
+	row.type = IPROTO_INSERT;
+	row.server_id = 0;
+	row.sync = 0; /* don't write sync to wal */
+	row.tm = ckpt->tm;
+	row.bodycnt = 2;
+	row.body[0].iov_base = &body;
+	row.body[0].iov_len = sizeof(body);
+
+	struct checkpoint_block *rows =
+		checkpoint_block_new(CHECKPOINT_BLOCK_SIZE);
+	auto rows_guard = make_scoped_guard([&]{ free(rows); });
+
+	int64_t lsn = entry->first_lsn;
+	struct tuple *tuple;
+	struct iterator *it = entry->iterator;
+	for (tuple = it->next(it); tuple; tuple = it->next(it)) {
+		row.body[1].iov_base = tuple->data;
+		row.body[1].iov_len = tuple->bsize;
+		row.lsn = lsn++;
+
+		struct iovec iov[XROW_IOVMAX];
+		int iovcnt = xlog_encode_block_row(&row, iov);
+		size_t len = 0;
+		for (int i = 0; i < iovcnt; i++)
+			len += iov[i].iov_len;
+
+		if (rows->size + len > rows->capacity && rows->rows > 0 &&
+		    !checkpoint_flush_rows(ckpt, entry, rows))
+			return;
+		if (len > rows->capacity) {
+			free(rows);
+			rows = NULL;
+			rows = checkpoint_block_new(len);
+		}
+		for (int i = 0; i < iovcnt; i++) {
+			memcpy(rows->data + rows->size, iov[i].iov_base,
+			       iov[i].iov_len);
+			rows->size += iov[i].iov_len;
+		}
+		rows->rows++;
+		fiber_gc();
+	}
+	assert(lsn == entry->first_lsn + (int64_t) entry->rows);
+
+	if (rows->rows > 0 && !checkpoint_flush_rows(ckpt, entry, rows))
+		return;
+
+	tt_pthread_mutex_lock(&ckpt->mutex);
+	entry->is_encoded = true;
+	pthread_cond_broadcast(&ckpt->cond);
+	tt_pthread_mutex_unlock(&ckpt->mutex);
+}
+
+/** Snapshot encoder thread. */
+static int
+checkpoint_encode_f(va_list ap)
+{
+	struct checkpoint *ckpt = va_arg(ap, struct checkpoint *);
+	try {
+		struct checkpoint_entry *entry;
+		while ((entry = checkpoint_take_entry(ckpt)) != NULL)
+			checkpoint_encode_entry(ckpt, entry);
+	} catch (Exception *e) {
+		checkpoint_abort(ckpt);
+		throw;
+	}
+	return 0;
+}
+
+/** Write encoded blocks of a space to the snapshot file. */
+static void
+checkpoint_write_entry(struct checkpoint *ckpt, struct xlog *l,
+		       struct checkpoint_entry *entry)
+{
+	struct checkpoint_block *block;
+	while ((block = checkpoint_pop_block(ckpt, entry)) != NULL) {
+		auto block_guard = make_scoped_guard([=]{ free(block); });
+		if (fwrite(block->data, block->size, 1, l->f) != 1) {
+			say_syserror("Can't write rows (%zu bytes)",
+				     block->size);
+			tnt_raise(SystemError, "fwrite");
+		}
+		uint64_t rows = l->rows;
+		l->rows += block->rows;
+		if (l->rows / 100000 != rows / 100000)
+			say_crit("%.1fM rows written",
+				 l->rows / 100000 * 100000 / 1000000.);
+		checkpoint_throttle(l, block->size, ckpt->snap_io_rate_limit);
+	}
+}
+
 int
 checkpoint_f(va_list ap)
 {
@@ -1257,15 +1934,77 @@ checkpoint_f(va_list ap)
 	auto guard = make_scoped_guard([=]{ xlog_close(snap); });
 
 	say_info("saving snapshot `%s'", snap->filename);
+	/**
+	 * Rows in snapshot are numbered from 1 to %rows.
+	 * This makes streaming such rows to a replica or
+	 * to recovery look similar to streaming a normal
+	 * WAL. @sa the place which skips old rows in
+	 * recovery_apply_row().
+	 */
+	int entry_count = 0;
+	int64_t lsn = 1;
 	struct checkpoint_entry *entry;
 	rlist_foreach_entry(entry, &ckpt->entries, link) {
-		struct tuple *tuple;
-		struct iterator *it = entry->iterator;
-		for (tuple = it->next(it); tuple; tuple = it->next(it)) {
-			checkpoint_write_tuple(snap, space_id(entry->space),
-					       tuple, ckpt->snap_io_rate_limit);
-		}
+		entry->first_lsn = lsn;
+		lsn += entry->rows;
+		entry_count++;
+	}
+	ckpt->next_entry = ckpt->entries.next;
+	ckpt->tm = ev_time();
+
+	/*
+	 * Spaces are encoded in parallel, each by a single
+	 * thread, and written to the file in order by this
+	 * thread.
+	 */
+	int thread_count = MIN(ckpt->snap_threads, entry_count);
+	struct cord *encoders = (struct cord *)
+		region_alloc_xc(&fiber()->gc, sizeof(*encoders) * thread_count);
+	int started = 0;
+	auto encoders_guard = make_scoped_guard([&]{
+		checkpoint_abort(ckpt);
+		/*
+		 * cord_join() replaces the diagnostics area,
+		 * keep the error being raised.
+		 */
+		struct diag diag;
+		diag_create(&diag);
+		diag_move(diag_get(), &diag);
+		for (int i = 0; i < started; i++)
+			cord_join(&encoders[i]);
+		diag_move(&diag, diag_get());
+	});
+	for (; started < thread_count; started++) {
+		if (cord_costart(&encoders[started], "snapshot.encoder",
+				 checkpoint_encode_f, ckpt) != 0)
+			diag_raise();
+	}
+
+	rlist_foreach_entry(entry, &ckpt->entries, link)
+		checkpoint_write_entry(ckpt, snap, entry);
+
+	encoders_guard.is_active = false;
+	/*
+	 * An encoder failure aborts the checkpoint, so the
+	 * writer may have stopped early. cord_join() only
+	 * reports the status of pthread_join(), the error of
+	 * the encoder is left in the diagnostics area, which
+	 * the next cord_join() clears: keep the first one.
+	 */
+	struct diag diag;
+	diag_create(&diag);
+	for (int i = 0; i < started; i++) {
+		cord_join(&encoders[i]);
+		if (!diag_is_empty(diag_get()) && diag_is_empty(&diag))
+			diag_move(diag_get(), &diag);
+	}
+	if (ckpt->is_aborted) {
+		assert(!diag_is_empty(&diag));
+		diag_move(&diag, diag_get());
+		diag_raise();
 	}
+	diag_destroy(&diag);
+	assert(snap->rows == (int64_t) lsn - 1);
 	say_info("done");
 	return 0;
 }
@@ -1277,7 +2016,8 @@ MemtxEngine::beginCheckpoint()
 
 	m_checkpoint = region_alloc_object_xc(&fiber()->gc, struct checkpoint);
 
-	checkpoint_init(m_checkpoint, m_snap_dir.dirname, m_snap_io_rate_limit);
+	checkpoint_init(m_checkpoint, m_snap_dir.dirname, m_snap_io_rate_limit,
+			m_snap_threads, m_snap_compression);
 	space_foreach(checkpoint_add_space, m_checkpoint);
 
 	/* increment snapshot version; set tuple deletion to delayed mode */
@@ -77,6 +77,25 @@ struct MemtxEngine: public Engine {
 		if (m_snap_io_rate_limit == 0)
 			m_snap_io_rate_limit = UINT64_MAX;
 	}
+	/* Update the number of threads used to build indexes. */
+	void setBuildThreads(int build_threads)
+	{
+		m_build_threads = build_threads;
+	}
+	int buildThreads() const
+	{
+		return m_build_threads;
+	}
+	/* Update the number of threads used to encode snapshot rows. */
+	void setSnapThreads(int snap_threads)
+	{
+		m_snap_threads = snap_threads;
+	}
+	/* Update compression of snapshot blocks. */
+	void setSnapCompression(enum xlog_compression compression)
+	{
+		m_snap_compression = compression;
+	}
 	/**
 	 * Return LSN of the most recent snapshot or -1 if there is
 	 * no snapshot.
@@ -86,6 +105,8 @@ struct MemtxEngine: public Engine {
 private:
 	void
 	recoverSnapshotRow(struct xrow_header *row);
+	void
+	recoverSnapshotRequest(struct request *request);
 	/** Non-zero if there is a checkpoint (snapshot) in progress. */
 	struct checkpoint *m_checkpoint;
 	enum memtx_recovery_state m_state;
@@ -96,6 +117,12 @@ private:
 	struct vclock m_last_checkpoint;
 	bool m_has_checkpoint;
 	bool m_panic_on_wal_error;
+	/** Number of threads to build secondary keys on recovery. */
+	int m_build_threads;
+	/** Number of threads to encode snapshot rows. */
+	int m_snap_threads;
+	/** Compression of snapshot blocks. */
+	enum xlog_compression m_snap_compression;
 };
 
 enum {
@@ -39,7 +39,14 @@
 #include "third_party/PMurHash.h"
 
 enum {
-	HASH_SEED = 13U
+	HASH_SEED = 13U,
+	/**
+	 * How many lookups of findByKeys() are in flight at
+	 * once: all their buckets are prefetched before the
+	 * first one is compared. Roughly the number of cache
+	 * misses a core can have outstanding.
+	 */
+	HASH_PREFETCH_BATCH = 16
 };
 
 static inline bool
@@ -153,6 +160,14 @@ key_hash(const char *key, const struct key_def *key_def)
 typedef uint32_t hash_t;
 #include "salad/light.h"
 
+#define SWISS_NAME _index
+#define SWISS_DATA_TYPE struct tuple *
+#define SWISS_KEY_TYPE const char *
+#define SWISS_CMP_ARG_TYPE struct key_def *
+#define SWISS_EQUAL(a, b, c) equal(a, b, c)
+#define SWISS_EQUAL_KEY(a, b, c) equal_key(a, b, c)
+#include "salad/swiss.h"
+
 /* {{{ MemtxHash Iterators ****************************************/
 
 struct hash_iterator {
@@ -206,6 +221,31 @@ hash_iterator_eq(struct iterator *it)
 	return hash_iterator_ge(it);
 }
 
+static uint32_t
+hash_iterator_next_batch(struct iterator *ptr, struct tuple **buf,
+			 uint32_t n)
+{
+	assert(ptr->free == hash_iterator_free);
+	uint32_t count = 0;
+	/* Let next() position the iterator for GT and EQ. */
+	while (count < n && ptr->next != hash_iterator_ge) {
+		struct tuple *tuple = ptr->next(ptr);
+		if (tuple == NULL)
+			return count;
+		buf[count++] = tuple;
+	}
+	struct hash_iterator *it = (struct hash_iterator *) ptr;
+	for (; count < n; count++) {
+		struct tuple **res =
+			light_index_iterator_get_and_next(it->hash_table,
+							  &it->iterator);
+		if (res == NULL)
+			break;
+		buf[count] = *res;
+	}
+	return count;
+}
+
 /* }}} */
 
 /* {{{ MemtxHash -- implementation of all hashes. **********************/
@@ -275,6 +315,29 @@ MemtxHash::findByKey(const char *key, uint32_t part_count) const
 	return ret;
 }
 
+void
+MemtxHash::findByKeys(const char **keys, uint32_t part_count, uint32_t n,
+		      struct tuple **result) const
+{
+	assert(key_def->opts.is_unique && part_count == key_def->part_count);
+	(void) part_count;
+
+	uint32_t hash[HASH_PREFETCH_BATCH];
+	for (uint32_t i = 0; i < n; i += HASH_PREFETCH_BATCH) {
+		uint32_t count = MIN(n - i, (uint32_t) HASH_PREFETCH_BATCH);
+		for (uint32_t j = 0; j < count; j++) {
+			hash[j] = key_hash(keys[i + j], key_def);
+			light_index_prefetch(hash_table, hash[j]);
+		}
+		for (uint32_t j = 0; j < count; j++) {
+			uint32_t k = light_index_find_key(hash_table, hash[j],
+							  keys[i + j]);
+			result[i + j] = k != light_index_end ?
+					light_index_get(hash_table, k) : NULL;
+		}
+	}
+}
+
 struct tuple *
 MemtxHash::replace(struct tuple *old_tuple, struct tuple *new_tuple,
 		   enum dup_replace_mode mode)
@@ -337,6 +400,7 @@ MemtxHash::allocIterator() const
 	}
 
 	it->base.next = hash_iterator_ge;
+	it->base.next_batch = hash_iterator_next_batch;
 	it->base.free = hash_iterator_free;
 	it->hash_table = hash_table;
 	light_index_iterator_begin(it->hash_table, &it->iterator);
@@ -402,3 +466,287 @@ MemtxHash::destroyReadViewForIterator(struct iterator *iterator)
 }
 
 /* }}} */
+
+/* {{{ MemtxSwissHash Iterators ***********************************/
+
+struct swiss_hash_iterator {
+	struct iterator base; /* Must be the first member. */
+	struct swiss_index_core *hash_table;
+	struct swiss_index_iterator iterator;
+};
+
+static void
+swiss_hash_iterator_free(struct iterator *iterator)
+{
+	assert(iterator->free == swiss_hash_iterator_free);
+	free(iterator);
+}
+
+static struct tuple *
+swiss_hash_iterator_ge(struct iterator *ptr)
+{
+	assert(ptr->free == swiss_hash_iterator_free);
+	struct swiss_hash_iterator *it = (struct swiss_hash_iterator *) ptr;
+	struct tuple **res =
+		swiss_index_iterator_get_and_next(it->hash_table,
+						  &it->iterator);
+	return res ? *res : 0;
+}
+
+static struct tuple *
+swiss_hash_iterator_gt(struct iterator *ptr)
+{
+	assert(ptr->free == swiss_hash_iterator_free);
+	ptr->next = swiss_hash_iterator_ge;
+	struct swiss_hash_iterator *it = (struct swiss_hash_iterator *) ptr;
+	struct tuple **res =
+		swiss_index_iterator_get_and_next(it->hash_table,
+						  &it->iterator);
+	if (!res)
+		return 0;
+	res = swiss_index_iterator_get_and_next(it->hash_table,
+						&it->iterator);
+	return res ? *res : 0;
+}
+
+static struct tuple *
+swiss_hash_iterator_eq(struct iterator *it)
+{
+	it->next = hash_iterator_eq_next;
+	return swiss_hash_iterator_ge(it);
+}
+
+static uint32_t
+swiss_hash_iterator_next_batch(struct iterator *ptr, struct tuple **buf,
+			       uint32_t n)
+{
+	assert(ptr->free == swiss_hash_iterator_free);
+	uint32_t count = 0;
+	/* Let next() position the iterator for GT and EQ. */
+	while (count < n && ptr->next != swiss_hash_iterator_ge) {
+		struct tuple *tuple = ptr->next(ptr);
+		if (tuple == NULL)
+			return count;
+		buf[count++] = tuple;
+	}
+	struct swiss_hash_iterator *it = (struct swiss_hash_iterator *) ptr;
+	for (; count < n; count++) {
+		struct tuple **res =
+			swiss_index_iterator_get_and_next(it->hash_table,
+							  &it->iterator);
+		if (res == NULL)
+			break;
+		buf[count] = *res;
+	}
+	return count;
+}
+
+/* }}} */
+
+/* {{{ MemtxSwissHash *********************************************/
+
+MemtxSwissHash::MemtxSwissHash(struct key_def *key_def_arg)
+	: MemtxIndex(key_def_arg)
+{
+	memtx_index_arena_init();
+	hash_table = (struct swiss_index_core *) malloc(sizeof(*hash_table));
+	if (hash_table == NULL) {
+		tnt_raise(OutOfMemory, sizeof(*hash_table),
+			  "MemtxSwissHash", "hash_table");
+	}
+	swiss_index_create(hash_table, HASH_INDEX_EXTENT_SIZE,
+			   memtx_index_extent_alloc, memtx_index_extent_free,
+			   this->key_def);
+}
+
+MemtxSwissHash::~MemtxSwissHash()
+{
+	swiss_index_destroy(hash_table);
+	free(hash_table);
+}
+
+size_t
+MemtxSwissHash::size() const
+{
+	return hash_table->count;
+}
+
+size_t
+MemtxSwissHash::bsize() const
+{
+	return swiss_index_extent_count(hash_table) * HASH_INDEX_EXTENT_SIZE;
+}
+
+struct tuple *
+MemtxSwissHash::random(uint32_t rnd) const
+{
+	if (hash_table->count == 0)
+		return NULL;
+	uint32_t capacity = swiss_index_capacity(hash_table);
+	rnd %= capacity;
+	while (!swiss_index_pos_valid(hash_table, rnd)) {
+		rnd++;
+		rnd %= capacity;
+	}
+	return swiss_index_get(hash_table, rnd);
+}
+
+struct tuple *
+MemtxSwissHash::findByKey(const char *key, uint32_t part_count) const
+{
+	assert(key_def->opts.is_unique && part_count == key_def->part_count);
+	(void) part_count;
+
+	struct tuple *ret = NULL;
+	uint32_t h = key_hash(key, key_def);
+	uint32_t k = swiss_index_find_key(hash_table, h, key);
+	if (k != swiss_index_end)
+		ret = swiss_index_get(hash_table, k);
+	return ret;
+}
+
+void
+MemtxSwissHash::findByKeys(const char **keys, uint32_t part_count,
+			   uint32_t n, struct tuple **result) const
+{
+	assert(key_def->opts.is_unique && part_count == key_def->part_count);
+	(void) part_count;
+
+	uint32_t hash[HASH_PREFETCH_BATCH];
+	for (uint32_t i = 0; i < n; i += HASH_PREFETCH_BATCH) {
+		uint32_t count = MIN(n - i, (uint32_t) HASH_PREFETCH_BATCH);
+		for (uint32_t j = 0; j < count; j++) {
+			hash[j] = key_hash(keys[i + j], key_def);
+			swiss_index_prefetch(hash_table, hash[j]);
+		}
+		for (uint32_t j = 0; j < count; j++) {
+			uint32_t k = swiss_index_find_key(hash_table, hash[j],
+							  keys[i + j]);
+			result[i + j] = k != swiss_index_end ?
+					swiss_index_get(hash_table, k) : NULL;
+		}
+	}
+}
+
+struct tuple *
+MemtxSwissHash::replace(struct tuple *old_tuple, struct tuple *new_tuple,
+			enum dup_replace_mode mode)
+{
+	uint32_t errcode;
+
+	if (new_tuple) {
+		uint32_t h = tuple_hash(new_tuple, key_def);
+		struct tuple *dup_tuple = NULL;
+		uint32_t pos = swiss_index_replace(hash_table, h, new_tuple,
+						   &dup_tuple);
+		if (pos == swiss_index_end)
+			pos = swiss_index_insert(hash_table, h, new_tuple);
+
+		ERROR_INJECT(ERRINJ_INDEX_ALLOC,
+		{
+			swiss_index_delete(hash_table, pos);
+			pos = swiss_index_end;
+		});
+
+		if (pos == swiss_index_end) {
+			tnt_raise(OutOfMemory, (ssize_t)hash_table->count,
+				  "hash_table", "key");
+		}
+		errcode = replace_check_dup(old_tuple, dup_tuple, mode);
+
+		if (errcode) {
+			if (dup_tuple) {
+				/* Put the old tuple back into its slot. */
+				struct tuple *unused;
+				swiss_index_replace(hash_table, h, dup_tuple,
+						    &unused);
+			} else {
+				swiss_index_delete(hash_table, pos);
+			}
+			struct space *sp = space_cache_find(key_def->space_id);
+			tnt_raise(ClientError, errcode, index_name(this),
+				  space_name(sp));
+		}
+
+		if (dup_tuple)
+			return dup_tuple;
+	}
+
+	if (old_tuple) {
+		uint32_t h = tuple_hash(old_tuple, key_def);
+		int res = swiss_index_delete_value(hash_table, h, old_tuple);
+		assert(res == 0); (void) res;
+	}
+	return old_tuple;
+}
+
+struct iterator *
+MemtxSwissHash::allocIterator() const
+{
+	struct swiss_hash_iterator *it = (struct swiss_hash_iterator *)
+			calloc(1, sizeof(*it));
+	if (it == NULL) {
+		tnt_raise(OutOfMemory, sizeof(struct swiss_hash_iterator),
+			  "MemtxSwissHash", "iterator");
+	}
+
+	it->base.next = swiss_hash_iterator_ge;
+	it->base.next_batch = swiss_hash_iterator_next_batch;
+	it->base.free = swiss_hash_iterator_free;
+	it->hash_table = hash_table;
+	swiss_index_iterator_begin(it->hash_table, &it->iterator);
+	return (struct iterator *) it;
+}
+
+void
+MemtxSwissHash::initIterator(struct iterator *ptr, enum iterator_type type,
+			     const char *key, uint32_t part_count) const
+{
+	assert(part_count == 0 || key != NULL);
+	(void) part_count;
+	assert(ptr->free == swiss_hash_iterator_free);
+
+	struct swiss_hash_iterator *it = (struct swiss_hash_iterator *) ptr;
+
+	switch (type) {
+	case ITER_GT:
+		if (part_count != 0) {
+			swiss_index_iterator_key(it->hash_table, &it->iterator,
+						 key_hash(key, key_def), key);
+			it->base.next = swiss_hash_iterator_gt;
+		} else {
+			swiss_index_iterator_begin(it->hash_table,
+						   &it->iterator);
+			it->base.next = swiss_hash_iterator_ge;
+		}
+		break;
+	case ITER_ALL:
+		swiss_index_iterator_begin(it->hash_table, &it->iterator);
+		it->base.next = swiss_hash_iterator_ge;
+		break;
+	case ITER_EQ:
+		assert(part_count > 0);
+		swiss_index_iterator_key(it->hash_table, &it->iterator,
+					 key_hash(key, key_def), key);
+		it->base.next = swiss_hash_iterator_eq;
+		break;
+	default:
+		return Index::initIterator(ptr, type, key, part_count);
+	}
+}
+
+void
+MemtxSwissHash::createReadViewForIterator(struct iterator *iterator)
+{
+	struct swiss_hash_iterator *it = (struct swiss_hash_iterator *) iterator;
+	swiss_index_iterator_freeze(it->hash_table, &it->iterator);
+}
+
+void
+MemtxSwissHash::destroyReadViewForIterator(struct iterator *iterator)
+{
+	struct swiss_hash_iterator *it = (struct swiss_hash_iterator *) iterator;
+	swiss_index_iterator_destroy(it->hash_table, &it->iterator);
+}
+
+/* }}} */
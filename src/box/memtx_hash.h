@@ -45,6 +45,9 @@ public:
 	virtual struct tuple *random(uint32_t rnd) const override;
 	virtual struct tuple *findByKey(const char *key,
 					uint32_t part_count) const override;
+	virtual void findByKeys(const char **keys, uint32_t part_count,
+				uint32_t n,
+				struct tuple **result) const override;
 	virtual struct tuple *replace(struct tuple *old_tuple,
 				      struct tuple *new_tuple,
 				      enum dup_replace_mode mode) override;
@@ -72,4 +75,42 @@ protected:
 	struct light_index_core *hash_table;
 };
 
+struct swiss_index_core;
+
+/**
+ * HASH index with the 'swiss' layout: an open addressing table
+ * which keeps the hash of each tuple next to the tuple pointer,
+ * see salad/swiss.h.
+ */
+class MemtxSwissHash: public MemtxIndex {
+public:
+	MemtxSwissHash(struct key_def *key_def);
+	virtual ~MemtxSwissHash() override;
+
+	virtual size_t size() const override;
+	virtual struct tuple *random(uint32_t rnd) const override;
+	virtual struct tuple *findByKey(const char *key,
+					uint32_t part_count) const override;
+	virtual void findByKeys(const char **keys, uint32_t part_count,
+				uint32_t n,
+				struct tuple **result) const override;
+	virtual struct tuple *replace(struct tuple *old_tuple,
+				      struct tuple *new_tuple,
+				      enum dup_replace_mode mode) override;
+
+	virtual struct iterator *allocIterator() const override;
+	virtual void initIterator(struct iterator *iterator,
+				  enum iterator_type type,
+				  const char *key,
+				  uint32_t part_count) const override;
+
+	virtual void createReadViewForIterator(struct iterator *iterator) override;
+	virtual void destroyReadViewForIterator(struct iterator *iterator) override;
+
+	virtual size_t bsize() const override;
+
+protected:
+	struct swiss_index_core *hash_table;
+};
+
 #endif /* TARANTOOL_BOX_MEMTX_HASH_H_INCLUDED */
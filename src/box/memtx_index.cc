@@ -36,6 +36,8 @@
 #include "schema.h"
 #include "user_def.h"
 #include "space.h"
+#include "fiber.h"
+#include "small/pmatomic.h"
 
 void
 MemtxIndex::beginBuild()
@@ -51,6 +53,10 @@ MemtxIndex::buildNext(struct tuple *tuple)
 	replace(NULL, tuple, DUP_INSERT);
 }
 
+void
+MemtxIndex::sortBuild()
+{}
+
 void
 MemtxIndex::endBuild()
 {}
@@ -86,26 +92,84 @@ MemtxIndex::count(enum iterator_type type, const char *key,
 	return count;
 }
 
+/** A queue of indexes which build data should be sorted. */
+struct index_sort_queue {
+	MemtxIndex **indexes;
+	uint32_t index_count;
+	/** Position of the next index to sort. */
+	uint32_t next;
+};
+
+static void *
+index_sort_f(void *arg)
+{
+	struct index_sort_queue *queue = (struct index_sort_queue *) arg;
+	uint32_t i;
+	while ((i = pm_atomic_fetch_add(&queue->next, 1)) < queue->index_count)
+		queue->indexes[i]->sortBuild();
+	return NULL;
+}
+
 void
 index_build(MemtxIndex *index, MemtxIndex *pk)
+{
+	index_build_parallel(&index, 1, pk, 1);
+}
+
+void
+index_build_parallel(MemtxIndex **indexes, uint32_t index_count,
+		     MemtxIndex *pk, int thread_count)
 {
 	uint32_t n_tuples = pk->size();
 	uint32_t estimated_tuples = n_tuples * 1.2;
 
-	index->beginBuild();
-	index->reserve(estimated_tuples);
+	for (uint32_t i = 0; i < index_count; i++) {
+		MemtxIndex *index = indexes[i];
+		index->beginBuild();
+		index->reserve(estimated_tuples);
 
-	if (n_tuples > 0) {
-		say_info("Adding %" PRIu32 " keys to %s index '%s' ...",
-			 n_tuples, index_type_strs[index->key_def->type],
-			 index_name(index));
+		if (n_tuples > 0) {
+			say_info("Adding %" PRIu32 " keys to %s index '%s' ...",
+				 n_tuples, index_type_strs[index->key_def->type],
+				 index_name(index));
+		}
 	}
 
 	struct iterator *it = pk->position();
 	pk->initIterator(it, ITER_ALL, NULL, 0);
 	struct tuple *tuple;
-	while ((tuple = it->next(it)))
-		index->buildNext(tuple);
+	while ((tuple = it->next(it))) {
+		for (uint32_t i = 0; i < index_count; i++)
+			indexes[i]->buildNext(tuple);
+	}
+
+	/*
+	 * Sorting is the most expensive part of a build, and
+	 * the indexes are independent of each other, so sort
+	 * them concurrently. The current thread takes part in
+	 * the work too, so only thread_count - 1 extra threads
+	 * are started.
+	 */
+	struct index_sort_queue queue = { indexes, index_count, 0 };
+	int worker_count = MIN((uint32_t) thread_count, index_count) - 1;
+	struct cord *workers = NULL;
+	if (worker_count > 0)
+		workers = (struct cord *) calloc(worker_count, sizeof(*workers));
+	int started = 0;
+	for (; workers != NULL && started < worker_count; started++) {
+		if (cord_start(&workers[started], "memtx.build",
+			       index_sort_f, &queue) != 0) {
+			say_syserror("failed to start index build thread");
+			break;
+		}
+	}
+	index_sort_f(&queue);
+	for (int i = 0; i < started; i++) {
+		if (cord_join(&workers[i]) != 0)
+			panic_syserror("index build: thread join failed");
+	}
+	free(workers);
 
-	index->endBuild();
+	for (uint32_t i = 0; i < index_count; i++)
+		indexes[i]->endBuild();
 }
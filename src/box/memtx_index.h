@@ -66,6 +66,14 @@ public:
 	 */
 	virtual void reserve(uint32_t /* size_hint */);
 	virtual void buildNext(struct tuple *tuple);
+	/**
+	 * Sort the data collected by buildNext(). Optional,
+	 * called before endBuild(). May be called from a worker
+	 * thread, so must touch nothing but the build state of
+	 * this index: neither the index itself nor the memory
+	 * allocator.
+	 */
+	virtual void sortBuild();
 	virtual void endBuild();
 protected:
 	/*
@@ -79,4 +87,14 @@ protected:
 void
 index_build(MemtxIndex *index, MemtxIndex *pk);
 
+/**
+ * Build a number of indexes based on the contents of another
+ * index. The primary key is scanned once, the build data of
+ * the indexes is sorted concurrently in up to thread_count
+ * threads.
+ */
+void
+index_build_parallel(MemtxIndex **indexes, uint32_t index_count,
+		     MemtxIndex *pk, int thread_count);
+
 #endif /* TARANTOOL_BOX_MEMTX_INDEX_H_INCLUDED */
@@ -0,0 +1,384 @@
+/*
+ * Copyright 2010-2016, Tarantool AUTHORS, please see AUTHORS file.
+ *
+ * Redistribution and use in source and binary forms, with or
+ * without modification, are permitted provided that the following
+ * conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above
+ *    copyright notice, this list of conditions and the
+ *    following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above
+ *    copyright notice, this list of conditions and the following
+ *    disclaimer in the documentation and/or other materials
+ *    provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY <COPYRIGHT HOLDER> ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+ * <COPYRIGHT HOLDER> OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+ * THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+#include "memtx_read_view.h"
+
+#include <pthread.h>
+
+#include "memtx_tree.h"
+#include "space.h"
+#include "schema.h"
+#include "user_def.h"
+#include "tuple.h"
+#include "fiber.h"
+#include "assoc.h"
+#include "tt_pthread.h"
+
+enum {
+	/**
+	 * The max number of tuples a request may look at in
+	 * a read view. Larger requests are executed in tx: the
+	 * tx thread can't drop the read view until all iproto
+	 * threads stop using it.
+	 */
+	READ_VIEW_SCAN_MAX = 1000
+};
+
+/**
+ * How often replaced views still used by iproto threads are
+ * checked when read views are disabled, in seconds.
+ */
+static const double READ_VIEW_GC_PERIOD = 0.01;
+
+struct memtx_read_view_index {
+	/** The index, or NULL if the index has no read view. */
+	MemtxTree *index;
+	struct memtx_tree_view view;
+};
+
+struct memtx_read_view_space {
+	/** Space owner. */
+	uint32_t uid;
+	/** Auth tokens of the users which can read the space. */
+	uint32_t read_access;
+	uint32_t index_id_max;
+	/** Read views of indexes, by index id. */
+	struct memtx_read_view_index indexes[];
+};
+
+/** Read views of all read_view spaces at some moment. */
+struct memtx_read_view {
+	/** Keeps deleted tuples until the view is dropped. */
+	struct tuple_read_view *tuples;
+	/** space id -> struct memtx_read_view_space. */
+	struct mh_i32ptr_t *spaces;
+	/** The number of iproto threads using the view. */
+	int refs;
+	/** Link in read_view_retired. */
+	struct rlist in_retired;
+};
+
+/**
+ * Protects read_view_current, read_view_retired and view
+ * reference counters.
+ */
+static pthread_mutex_t read_view_mutex = PTHREAD_MUTEX_INITIALIZER;
+/** Signalled when an iproto thread releases a replaced view. */
+static pthread_cond_t read_view_cond = PTHREAD_COND_INITIALIZER;
+/** The view used by iproto threads. */
+static struct memtx_read_view *read_view_current;
+/**
+ * Replaced views, deleted in the tx thread once iproto threads
+ * stop using them.
+ */
+static RLIST_HEAD(read_view_retired);
+static struct fiber *read_view_fiber;
+static double read_view_period;
+
+static void
+memtx_read_view_delete(struct memtx_read_view *view)
+{
+	mh_int_t i;
+	mh_foreach(view->spaces, i) {
+		struct memtx_read_view_space *space =
+			(struct memtx_read_view_space *)
+			mh_i32ptr_node(view->spaces, i)->val;
+		for (uint32_t id = 0; id <= space->index_id_max; id++) {
+			struct memtx_read_view_index *index =
+				&space->indexes[id];
+			if (index->index != NULL)
+				index->index->destroyReadView(&index->view);
+		}
+		free(space);
+	}
+	mh_i32ptr_delete(view->spaces);
+	if (view->tuples != NULL)
+		tuple_read_view_close(view->tuples);
+	free(view);
+}
+
+static void
+memtx_read_view_add_space(struct space *space, void *udata)
+{
+	struct memtx_read_view *view = (struct memtx_read_view *) udata;
+	if (!space->def.opts.read_view || !space_is_memtx(space))
+		return;
+	size_t size = sizeof(struct memtx_read_view_space) +
+		(space->index_id_max + 1) *
+		sizeof(struct memtx_read_view_index);
+	struct memtx_read_view_space *rv_space =
+		(struct memtx_read_view_space *) calloc(1, size);
+	if (rv_space == NULL) {
+		tnt_raise(OutOfMemory, size, "malloc",
+			  "struct memtx_read_view_space");
+	}
+	const struct mh_i32ptr_node_t node = { space_id(space), rv_space };
+	if (mh_i32ptr_put(view->spaces, &node, NULL, NULL) ==
+	    mh_end(view->spaces)) {
+		free(rv_space);
+		tnt_raise(OutOfMemory, sizeof(node), "malloc",
+			  "read view spaces");
+	}
+	rv_space->uid = space->def.uid;
+	for (uint32_t token = 0; token < BOX_USER_MAX; token++) {
+		if (space->access[token].effective & PRIV_R)
+			rv_space->read_access |= 1U << token;
+	}
+	rv_space->index_id_max = space->index_id_max;
+	if (view->tuples == NULL)
+		view->tuples = tuple_read_view_open();
+	for (uint32_t id = 0; id <= space->index_id_max; id++) {
+		Index *index = space->index_map[id];
+		if (index == NULL || index->key_def->type != TREE)
+			continue;
+		MemtxTree *tree = (MemtxTree *) index;
+		tree->createReadView(&rv_space->indexes[id].view);
+		rv_space->indexes[id].index = tree;
+	}
+}
+
+/**
+ * Freeze all read_view spaces.
+ * @retval NULL there are no such spaces.
+ */
+static struct memtx_read_view *
+memtx_read_view_new()
+{
+	struct memtx_read_view *view = (struct memtx_read_view *)
+		calloc(1, sizeof(*view));
+	if (view == NULL) {
+		tnt_raise(OutOfMemory, sizeof(*view), "malloc",
+			  "struct memtx_read_view");
+	}
+	view->spaces = mh_i32ptr_new();
+	if (view->spaces == NULL) {
+		free(view);
+		tnt_raise(OutOfMemory, sizeof(*view->spaces), "malloc",
+			  "read view spaces");
+	}
+	try {
+		space_foreach(memtx_read_view_add_space, view);
+	} catch (Exception *e) {
+		memtx_read_view_delete(view);
+		throw;
+	}
+	if (mh_size(view->spaces) == 0) {
+		memtx_read_view_delete(view);
+		return NULL;
+	}
+	return view;
+}
+
+/**
+ * Delete replaced views which are not used anymore.
+ * @param wait wait until iproto threads release all of them.
+ *             An iproto thread uses a view for a single request
+ *             of a limited size, see READ_VIEW_SCAN_MAX.
+ */
+static void
+memtx_read_view_gc(bool wait)
+{
+	RLIST_HEAD(garbage);
+	struct memtx_read_view *view, *tmp;
+	tt_pthread_mutex_lock(&read_view_mutex);
+	rlist_foreach_entry_safe(view, &read_view_retired, in_retired, tmp) {
+		while (wait && view->refs > 0)
+			tt_pthread_cond_wait(&read_view_cond, &read_view_mutex);
+		if (view->refs > 0)
+			continue;
+		rlist_del_entry(view, in_retired);
+		rlist_add_tail_entry(&garbage, view, in_retired);
+	}
+	tt_pthread_mutex_unlock(&read_view_mutex);
+	rlist_foreach_entry_safe(view, &garbage, in_retired, tmp)
+		memtx_read_view_delete(view);
+}
+
+/**
+ * Make @a view current and drop the old current view.
+ * @param wait see memtx_read_view_gc().
+ */
+static void
+memtx_read_view_replace(struct memtx_read_view *view, bool wait)
+{
+	tt_pthread_mutex_lock(&read_view_mutex);
+	struct memtx_read_view *old = read_view_current;
+	read_view_current = view;
+	if (old != NULL)
+		rlist_add_tail_entry(&read_view_retired, old, in_retired);
+	tt_pthread_mutex_unlock(&read_view_mutex);
+	memtx_read_view_gc(wait);
+}
+
+static int
+memtx_read_view_f(va_list /* ap */)
+{
+	while (! fiber_is_cancelled()) {
+		memtx_read_view_gc(false);
+		if (read_view_period == 0) {
+			if (rlist_empty(&read_view_retired))
+				fiber_yield();
+			else
+				fiber_sleep(READ_VIEW_GC_PERIOD);
+			continue;
+		}
+		fiber_sleep(read_view_period);
+		if (read_view_period == 0)
+			continue;
+		try {
+			memtx_read_view_replace(memtx_read_view_new(), false);
+		} catch (Exception *e) {
+			e->log();
+			memtx_read_view_replace(NULL, false);
+		}
+	}
+	return 0;
+}
+
+void
+memtx_read_view_init()
+{
+	read_view_fiber = fiber_new_xc("read_view", memtx_read_view_f);
+	fiber_start(read_view_fiber);
+}
+
+void
+memtx_read_view_free()
+{
+	memtx_read_view_replace(NULL, true);
+}
+
+void
+memtx_read_view_set_period(double period)
+{
+	read_view_period = period;
+	if (period == 0)
+		memtx_read_view_replace(NULL, false);
+	if (read_view_fiber != NULL)
+		fiber_wakeup(read_view_fiber);
+}
+
+void
+memtx_read_view_invalidate()
+{
+	/* Replaced views may refer to the changed objects too. */
+	if (read_view_current != NULL || ! rlist_empty(&read_view_retired))
+		memtx_read_view_replace(NULL, true);
+}
+
+static struct memtx_read_view *
+memtx_read_view_acquire()
+{
+	tt_pthread_mutex_lock(&read_view_mutex);
+	struct memtx_read_view *view = read_view_current;
+	if (view != NULL)
+		view->refs++;
+	tt_pthread_mutex_unlock(&read_view_mutex);
+	return view;
+}
+
+static void
+memtx_read_view_release(struct memtx_read_view *view)
+{
+	tt_pthread_mutex_lock(&read_view_mutex);
+	assert(view->refs > 0);
+	if (--view->refs == 0 && view != read_view_current)
+		tt_pthread_cond_signal(&read_view_cond);
+	tt_pthread_mutex_unlock(&read_view_mutex);
+}
+
+static int
+memtx_read_view_select_in(struct memtx_read_view *view,
+			  const struct credentials *cr, uint32_t space_id,
+			  uint32_t index_id, uint32_t iterator,
+			  uint32_t offset, uint32_t limit, const char *key,
+			  struct obuf *out, uint32_t *count)
+{
+	mh_int_t k = mh_i32ptr_find(view->spaces, space_id, NULL);
+	if (k == mh_end(view->spaces))
+		return -1;
+	struct memtx_read_view_space *space =
+		(struct memtx_read_view_space *)
+		mh_i32ptr_node(view->spaces, k)->val;
+	/* See access_check_space(). */
+	if ((cr->universal_access & PRIV_R) == 0 && space->uid != cr->uid &&
+	    (space->read_access & (1U << cr->auth_token)) == 0)
+		return -1;
+	if (index_id > space->index_id_max ||
+	    space->indexes[index_id].index == NULL)
+		return -1;
+	struct memtx_read_view_index *rv_index = &space->indexes[index_id];
+	MemtxTree *index = rv_index->index;
+	if (iterator > ITER_GT)
+		return -1;
+	enum iterator_type type = (enum iterator_type) iterator;
+
+	uint32_t part_count = key ? mp_decode_array(&key) : 0;
+	try {
+		key_validate(index->key_def, type, key, part_count);
+		struct iterator *it = index->allocIterator();
+		IteratorGuard guard(it);
+		index->initReadViewIterator(it, &rv_index->view, type, key,
+					    part_count);
+		uint32_t found = 0;
+		uint32_t scanned = 0;
+		struct tuple *tuple;
+		while (found < limit && (tuple = it->next(it)) != NULL) {
+			if (++scanned > READ_VIEW_SCAN_MAX)
+				return -1;
+			if (offset > 0) {
+				offset--;
+				continue;
+			}
+			tuple_to_obuf(tuple, out);
+			found++;
+		}
+		*count = found;
+	} catch (Exception *e) {
+		return -1;
+	}
+	return 0;
+}
+
+int
+memtx_read_view_select(const struct credentials *cr, uint32_t space_id,
+		       uint32_t index_id, uint32_t iterator, uint32_t offset,
+		       uint32_t limit, const char *key, struct obuf *out,
+		       uint32_t *count)
+{
+	struct memtx_read_view *view = memtx_read_view_acquire();
+	if (view == NULL)
+		return -1;
+	int rc = memtx_read_view_select_in(view, cr, space_id, index_id,
+					   iterator, offset, limit, key,
+					   out, count);
+	memtx_read_view_release(view);
+	return rc;
+}
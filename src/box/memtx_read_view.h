@@ -0,0 +1,90 @@
+#ifndef TARANTOOL_BOX_MEMTX_READ_VIEW_H_INCLUDED
+#define TARANTOOL_BOX_MEMTX_READ_VIEW_H_INCLUDED
+/*
+ * Copyright 2010-2016, Tarantool AUTHORS, please see AUTHORS file.
+ *
+ * Redistribution and use in source and binary forms, with or
+ * without modification, are permitted provided that the following
+ * conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above
+ *    copyright notice, this list of conditions and the
+ *    following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above
+ *    copyright notice, this list of conditions and the following
+ *    disclaimer in the documentation and/or other materials
+ *    provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY <COPYRIGHT HOLDER> ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+ * <COPYRIGHT HOLDER> OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+ * THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+#include <stdint.h>
+
+/**
+ * Read views of memtx spaces created with read_view = true.
+ *
+ * Every box.cfg.read_view_period seconds the tx thread freezes
+ * TREE indexes of such spaces and publishes the frozen views,
+ * so that iproto threads can execute SELECT requests on their
+ * own, without a round trip to the tx thread. The data seen by
+ * such requests is at most one period old. Any change of the
+ * data dictionary or privileges drops the views until the next
+ * refresh, so a request is never executed against a space
+ * definition it doesn't match.
+ */
+
+struct obuf;
+struct credentials;
+
+/** Start the refresh fiber. Called once recovery is complete. */
+void
+memtx_read_view_init();
+
+/** Drop the current read views. */
+void
+memtx_read_view_free();
+
+/**
+ * Set the refresh period, in seconds. 0 disables read views.
+ */
+void
+memtx_read_view_set_period(double period);
+
+/**
+ * Drop the current read views. Called from the tx thread before
+ * a space, an index or a privilege is changed. Waits for iproto
+ * threads which are using the views.
+ */
+void
+memtx_read_view_invalidate();
+
+/**
+ * Execute a SELECT request in the current read view. Can be
+ * called from any thread. On success, the selected tuples are
+ * appended to @a out and their number is stored in @a count.
+ *
+ * @retval 0 the request has been executed.
+ * @retval -1 the request must be executed in the tx thread:
+ * there is no read view of the space or the index, the request
+ * is not supported or failed. @a out may contain garbage then,
+ * the caller is supposed to roll it back.
+ */
+int
+memtx_read_view_select(const struct credentials *cr, uint32_t space_id,
+		       uint32_t index_id, uint32_t iterator, uint32_t offset,
+		       uint32_t limit, const char *key, struct obuf *out,
+		       uint32_t *count);
+
+#endif /* TARANTOOL_BOX_MEMTX_READ_VIEW_H_INCLUDED */
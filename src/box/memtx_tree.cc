@@ -35,6 +35,7 @@
 #include "errinj.h"
 #include "memory.h"
 #include "fiber.h"
+#include "memtx_read_view.h"
 #include <third_party/qsort_arg.h>
 
 /* {{{ Utilities. *************************************************/
@@ -43,10 +44,23 @@ struct key_data
 {
 	const char *key;
 	uint32_t part_count;
+	/** Hint of the first part, if there is one. */
+	uint64_t hint;
 };
 
+static inline void
+key_data_create(struct key_data *key_data, const char *key,
+		uint32_t part_count, struct key_def *key_def)
+{
+	key_data->key = key;
+	key_data->part_count = part_count;
+	key_data->hint = key_def->opts.hint && part_count > 0 ?
+			 key_hint(key, key_def) : 0;
+}
+
 int
-memtx_tree_compare(const tuple *a, const tuple *b, struct key_def *key_def)
+memtx_tree_compare(const struct tuple *a, const struct tuple *b,
+		   struct key_def *key_def)
 {
 	int r = tuple_compare(a, b, key_def);
 	if (r == 0 && !key_def->opts.is_unique)
@@ -55,7 +69,8 @@ memtx_tree_compare(const tuple *a, const tuple *b, struct key_def *key_def)
 }
 
 int
-memtx_tree_compare_key(const tuple *a, const struct key_data *key_data,
+memtx_tree_compare_key(const struct tuple *a,
+		       const struct key_data *key_data,
 		       struct key_def *key_def)
 {
 	return tuple_compare_with_key(a, key_data->key,
@@ -63,31 +78,157 @@ memtx_tree_compare_key(const tuple *a, const struct key_data *key_data,
 }
 
 int
+memtx_tree_compare(const struct memtx_tree_data &a,
+		   const struct memtx_tree_data &b, struct key_def *key_def)
+{
+	if (a.hint != b.hint)
+		return a.hint < b.hint ? -1 : 1;
+	return memtx_tree_compare(a.tuple, b.tuple, key_def);
+}
+
+int
+memtx_tree_compare_key(const struct memtx_tree_data &a,
+		       const struct key_data *key_data,
+		       struct key_def *key_def)
+{
+	/* A key without parts matches any hint. */
+	if (a.hint != key_data->hint && key_data->part_count > 0)
+		return a.hint < key_data->hint ? -1 : 1;
+	return memtx_tree_compare_key(a.tuple, key_data, key_def);
+}
+
+/** Make an element of a tree without hints. */
+static inline void
+memtx_tree_elem_create(struct tuple **elem, struct tuple *tuple,
+		       struct key_def *key_def)
+{
+	(void) key_def;
+	*elem = tuple;
+}
+
+/** Make an element of a tree with hints. */
+static inline void
+memtx_tree_elem_create(struct memtx_tree_data *elem, struct tuple *tuple,
+		       struct key_def *key_def)
+{
+	elem->tuple = tuple;
+	elem->hint = tuple_hint(tuple, key_def);
+}
+
+static inline struct tuple *
+memtx_tree_elem_tuple(struct tuple *elem)
+{
+	return elem;
+}
+
+static inline struct tuple *
+memtx_tree_elem_tuple(const struct memtx_tree_data &elem)
+{
+	return elem.tuple;
+}
+
+/**
+ * Wrap the API of a bps tree named @a name into a struct, so
+ * that the index code can be shared by trees with and without
+ * hints, see MemtxTreeImpl.
+ */
+#define MEMTX_TREE_OP(name, op)						\
+	template <class... Args>					\
+	static inline auto op(Args... args)				\
+		-> decltype(name##_##op(args...))			\
+	{								\
+		return name##_##op(args...);				\
+	}
+
+#define MEMTX_TREE_API(name, elem_type, view_member)			\
+struct name##_api {							\
+	typedef elem_type elem_t;					\
+	typedef struct name tree_t;					\
+	typedef struct name##_iterator iterator_t;			\
+	typedef struct name##_view view_t;				\
+	static inline view_t *						\
+	view(struct memtx_tree_view *v)					\
+	{								\
+		return &v->view_member;					\
+	}								\
+	static inline const view_t *					\
+	view(const struct memtx_tree_view *v)				\
+	{								\
+		return &v->view_member;					\
+	}								\
+	MEMTX_TREE_OP(name, create)					\
+	MEMTX_TREE_OP(name, destroy)					\
+	MEMTX_TREE_OP(name, build)					\
+	MEMTX_TREE_OP(name, size)					\
+	MEMTX_TREE_OP(name, mem_used)					\
+	MEMTX_TREE_OP(name, random)					\
+	MEMTX_TREE_OP(name, find)					\
+	MEMTX_TREE_OP(name, insert)					\
+	MEMTX_TREE_OP(name, count_between)				\
+	MEMTX_TREE_OP(name, lower_bound_rank)				\
+	MEMTX_TREE_OP(name, upper_bound_rank)				\
+	MEMTX_TREE_OP(name, lower_bound)				\
+	MEMTX_TREE_OP(name, upper_bound)				\
+	MEMTX_TREE_OP(name, invalid_iterator)				\
+	MEMTX_TREE_OP(name, iterator_is_invalid)			\
+	MEMTX_TREE_OP(name, iterator_first)				\
+	MEMTX_TREE_OP(name, iterator_get_elem)				\
+	MEMTX_TREE_OP(name, iterator_next)				\
+	MEMTX_TREE_OP(name, iterator_prev)				\
+	MEMTX_TREE_OP(name, iterator_freeze)				\
+	MEMTX_TREE_OP(name, iterator_destroy)				\
+	MEMTX_TREE_OP(name, view_create)				\
+	MEMTX_TREE_OP(name, view_destroy)				\
+	MEMTX_TREE_OP(name, view_first)					\
+	MEMTX_TREE_OP(name, view_last)					\
+	MEMTX_TREE_OP(name, view_lower_bound)				\
+	MEMTX_TREE_OP(name, view_upper_bound)				\
+	/* delete is a keyword. */					\
+	static inline int						\
+	remove(tree_t *tree, elem_t elem)				\
+	{								\
+		return name##_delete(tree, elem);			\
+	}								\
+};
+
+MEMTX_TREE_API(memtx_tuple_tree, struct tuple *, tuple_view)
+MEMTX_TREE_API(memtx_hint_tree, struct memtx_tree_data, hint_view)
+
+#undef MEMTX_TREE_API
+#undef MEMTX_TREE_OP
+
+template <class Tree>
+static int
 memtx_tree_qcompare(const void* a, const void *b, void *c)
 {
-	return memtx_tree_compare(*(struct tuple **)a,
-		*(struct tuple **)b, (struct key_def *)c);
+	typedef typename Tree::elem_t elem_t;
+	return memtx_tree_compare(*(const elem_t *)a, *(const elem_t *)b,
+				  (struct key_def *)c);
 }
 
 /* {{{ MemtxTree Iterators ****************************************/
+template <class Tree>
 struct tree_iterator {
 	struct iterator base;
-	const struct memtx_tree *tree;
+	const typename Tree::tree_t *tree;
 	struct key_def *key_def;
-	struct memtx_tree_iterator tree_iterator;
+	typename Tree::iterator_t tree_iterator;
 	struct key_data key_data;
 };
 
+template <class Tree>
 static void
 tree_iterator_free(struct iterator *iterator);
 
-static inline struct tree_iterator *
-tree_iterator(struct iterator *it)
+template <class Tree>
+static inline struct tree_iterator<Tree> *
+tree_iterator_cast(struct iterator *it)
 {
-	assert(it->free == tree_iterator_free);
-	return (struct tree_iterator *) it;
+	assert(it->free == tree_iterator_free<Tree>);
+	return (struct tree_iterator<Tree> *) it;
 }
 
+template <class Tree>
 static void
 tree_iterator_free(struct iterator *iterator)
 {
@@ -101,161 +242,398 @@ tree_iterator_dummie(struct iterator *iterator)
 	return 0;
 }
 
+template <class Tree>
 static struct tuple *
 tree_iterator_fwd(struct iterator *iterator)
 {
-	struct tree_iterator *it = tree_iterator(iterator);
-	tuple **res = memtx_tree_iterator_get_elem(it->tree, &it->tree_iterator);
+	struct tree_iterator<Tree> *it = tree_iterator_cast<Tree>(iterator);
+	typename Tree::elem_t *res =
+		Tree::iterator_get_elem(it->tree, &it->tree_iterator);
 	if (!res)
 		return 0;
-	memtx_tree_iterator_next(it->tree, &it->tree_iterator);
-	return *res;
+	Tree::iterator_next(it->tree, &it->tree_iterator);
+	return memtx_tree_elem_tuple(*res);
 }
 
+template <class Tree>
 static struct tuple *
 tree_iterator_bwd(struct iterator *iterator)
 {
-	struct tree_iterator *it = tree_iterator(iterator);
-	tuple **res = memtx_tree_iterator_get_elem(it->tree, &it->tree_iterator);
+	struct tree_iterator<Tree> *it = tree_iterator_cast<Tree>(iterator);
+	typename Tree::elem_t *res =
+		Tree::iterator_get_elem(it->tree, &it->tree_iterator);
 	if (!res)
 		return 0;
-	memtx_tree_iterator_prev(it->tree, &it->tree_iterator);
-	return *res;
+	Tree::iterator_prev(it->tree, &it->tree_iterator);
+	return memtx_tree_elem_tuple(*res);
 }
 
+template <class Tree>
 static struct tuple *
 tree_iterator_fwd_check_equality(struct iterator *iterator)
 {
-	struct tree_iterator *it = tree_iterator(iterator);
-	tuple **res = memtx_tree_iterator_get_elem(it->tree, &it->tree_iterator);
+	struct tree_iterator<Tree> *it = tree_iterator_cast<Tree>(iterator);
+	typename Tree::elem_t *res =
+		Tree::iterator_get_elem(it->tree, &it->tree_iterator);
 	if (!res)
 		return 0;
 	if (memtx_tree_compare_key(*res, &it->key_data, it->key_def) != 0) {
-		it->tree_iterator = memtx_tree_invalid_iterator();
+		it->tree_iterator = Tree::invalid_iterator();
 		return 0;
 	}
-	memtx_tree_iterator_next(it->tree, &it->tree_iterator);
-	return *res;
+	Tree::iterator_next(it->tree, &it->tree_iterator);
+	return memtx_tree_elem_tuple(*res);
 }
 
+template <class Tree>
 static struct tuple *
 tree_iterator_fwd_check_next_equality(struct iterator *iterator)
 {
-	struct tree_iterator *it = tree_iterator(iterator);
-	tuple **res = memtx_tree_iterator_get_elem(it->tree, &it->tree_iterator);
+	struct tree_iterator<Tree> *it = tree_iterator_cast<Tree>(iterator);
+	typename Tree::elem_t *res =
+		Tree::iterator_get_elem(it->tree, &it->tree_iterator);
 	if (!res)
 		return 0;
-	memtx_tree_iterator_next(it->tree, &it->tree_iterator);
-	iterator->next = tree_iterator_fwd_check_equality;
-	return *res;
+	Tree::iterator_next(it->tree, &it->tree_iterator);
+	iterator->next = tree_iterator_fwd_check_equality<Tree>;
+	return memtx_tree_elem_tuple(*res);
 }
 
+template <class Tree>
 static struct tuple *
 tree_iterator_bwd_skip_one(struct iterator *iterator)
 {
-	struct tree_iterator *it = tree_iterator(iterator);
-	memtx_tree_iterator_prev(it->tree, &it->tree_iterator);
-	iterator->next = tree_iterator_bwd;
-	return tree_iterator_bwd(iterator);
+	struct tree_iterator<Tree> *it = tree_iterator_cast<Tree>(iterator);
+	Tree::iterator_prev(it->tree, &it->tree_iterator);
+	iterator->next = tree_iterator_bwd<Tree>;
+	return tree_iterator_bwd<Tree>(iterator);
 }
 
+template <class Tree>
 static struct tuple *
 tree_iterator_bwd_check_equality(struct iterator *iterator)
 {
-	struct tree_iterator *it = tree_iterator(iterator);
-	tuple **res = memtx_tree_iterator_get_elem(it->tree, &it->tree_iterator);
+	struct tree_iterator<Tree> *it = tree_iterator_cast<Tree>(iterator);
+	typename Tree::elem_t *res =
+		Tree::iterator_get_elem(it->tree, &it->tree_iterator);
 	if (!res)
 		return 0;
 	if (memtx_tree_compare_key(*res, &it->key_data, it->key_def) != 0) {
-		it->tree_iterator = memtx_tree_invalid_iterator();
+		it->tree_iterator = Tree::invalid_iterator();
 		return 0;
 	}
-	memtx_tree_iterator_prev(it->tree, &it->tree_iterator);
-	return *res;
+	Tree::iterator_prev(it->tree, &it->tree_iterator);
+	return memtx_tree_elem_tuple(*res);
 }
 
+template <class Tree>
 static struct tuple *
 tree_iterator_bwd_skip_one_check_next_equality(struct iterator *iterator)
 {
-	struct tree_iterator *it = tree_iterator(iterator);
-	memtx_tree_iterator_prev(it->tree, &it->tree_iterator);
-	iterator->next = tree_iterator_bwd_check_equality;
-	return tree_iterator_bwd_check_equality(iterator);
+	struct tree_iterator<Tree> *it = tree_iterator_cast<Tree>(iterator);
+	Tree::iterator_prev(it->tree, &it->tree_iterator);
+	iterator->next = tree_iterator_bwd_check_equality<Tree>;
+	return tree_iterator_bwd_check_equality<Tree>(iterator);
+}
+
+/**
+ * Batched next(): walk the tree leaves without going through
+ * the next() callback for every tuple. Transitional states
+ * (skip one, check next equality) are handled by next() which
+ * switches the iterator to one of the steady states below.
+ */
+template <class Tree>
+static uint32_t
+tree_iterator_next_batch(struct iterator *iterator, struct tuple **buf,
+			 uint32_t n)
+{
+	struct tree_iterator<Tree> *it = tree_iterator_cast<Tree>(iterator);
+	uint32_t count = 0;
+	while (count < n) {
+		struct tuple *(*next)(struct iterator *) = iterator->next;
+		bool fwd = next == tree_iterator_fwd<Tree> ||
+			   next == tree_iterator_fwd_check_equality<Tree>;
+		bool bwd = next == tree_iterator_bwd<Tree> ||
+			   next == tree_iterator_bwd_check_equality<Tree>;
+		if (!fwd && !bwd) {
+			struct tuple *tuple = next(iterator);
+			if (tuple == NULL)
+				break;
+			buf[count++] = tuple;
+			continue;
+		}
+		bool check_equality =
+			next == tree_iterator_fwd_check_equality<Tree> ||
+			next == tree_iterator_bwd_check_equality<Tree>;
+		const typename Tree::tree_t *tree = it->tree;
+		typename Tree::iterator_t *tree_it = &it->tree_iterator;
+		for (; count < n; count++) {
+			typename Tree::elem_t *res =
+				Tree::iterator_get_elem(tree, tree_it);
+			if (res == NULL)
+				return count;
+			if (check_equality &&
+			    memtx_tree_compare_key(*res, &it->key_data,
+						   it->key_def) != 0) {
+				*tree_it = Tree::invalid_iterator();
+				return count;
+			}
+			if (fwd)
+				Tree::iterator_next(tree, tree_it);
+			else
+				Tree::iterator_prev(tree, tree_it);
+			buf[count] = memtx_tree_elem_tuple(*res);
+		}
+	}
+	return count;
 }
 /* }}} */
 
-/* {{{ MemtxTree  **********************************************************/
+/* {{{ MemtxTreeImpl  ******************************************************/
+
+/**
+ * A TREE index on top of a bps tree wrapped into @a Tree, see
+ * MEMTX_TREE_API.
+ */
+template <class Tree>
+class MemtxTreeImpl: public MemtxTree {
+public:
+	typedef typename Tree::elem_t elem_t;
+
+	MemtxTreeImpl(struct key_def *key_def);
+	virtual ~MemtxTreeImpl() override;
+
+	virtual void beginBuild() override;
+	virtual void reserve(uint32_t size_hint) override;
+	virtual void buildNext(struct tuple *tuple) override;
+	virtual void sortBuild() override;
+	virtual void endBuild() override;
+	virtual size_t size() const override;
+	virtual struct tuple *random(uint32_t rnd) const override;
+	virtual struct tuple *findByKey(const char *key,
+					uint32_t part_count) const override;
+	virtual void findByKeys(const char **keys, uint32_t part_count,
+				uint32_t n,
+				struct tuple **result) const override;
+	virtual size_t count(enum iterator_type type, const char *key,
+			     uint32_t part_count) const override;
+	virtual struct tuple *replace(struct tuple *old_tuple,
+				      struct tuple *new_tuple,
+				      enum dup_replace_mode mode) override;
+
+	virtual size_t bsize() const override;
+	virtual struct iterator *allocIterator() const override;
+	virtual void initIterator(struct iterator *iterator,
+				  enum iterator_type type,
+				  const char *key,
+				  uint32_t part_count) const override;
+
+	/**
+	 * Create a read view for iterator so further index modifications
+	 * will not affect the iterator iteration.
+	 */
+	virtual void createReadViewForIterator(struct iterator *iterator) override;
+	/**
+	 * Destroy a read view of an iterator. Must be called for iterators,
+	 * for which createReadViewForIterator was called.
+	 */
+	virtual void destroyReadViewForIterator(struct iterator *iterator) override;
+
+	virtual void createReadView(struct memtx_tree_view *view) override;
+	virtual void destroyReadView(struct memtx_tree_view *view) override;
+	virtual void initReadViewIterator(struct iterator *iterator,
+					  const struct memtx_tree_view *view,
+					  enum iterator_type type,
+					  const char *key,
+					  uint32_t part_count) const override;
+
+// protected:
+	typename Tree::tree_t tree;
+	elem_t *build_array;
+	size_t build_array_size, build_array_alloc_size;
+	/** True if build_array has been sorted by sortBuild(). */
+	bool build_array_is_sorted;
+};
 
-MemtxTree::MemtxTree(struct key_def *key_def_arg)
-	: MemtxIndex(key_def_arg), build_array(0), build_array_size(0),
-	  build_array_alloc_size(0)
+template <class Tree>
+MemtxTreeImpl<Tree>::MemtxTreeImpl(struct key_def *key_def_arg)
+	: MemtxTree(key_def_arg), build_array(0), build_array_size(0),
+	  build_array_alloc_size(0), build_array_is_sorted(false)
 {
 	memtx_index_arena_init();
-	memtx_tree_create(&tree, key_def,
-			      memtx_index_extent_alloc,
-			      memtx_index_extent_free);
+	Tree::create(&tree, key_def,
+		     memtx_index_extent_alloc,
+		     memtx_index_extent_free);
 }
 
-MemtxTree::~MemtxTree()
+template <class Tree>
+MemtxTreeImpl<Tree>::~MemtxTreeImpl()
 {
-	memtx_tree_destroy(&tree);
+	/* Read views may refer to the tree. */
+	memtx_read_view_invalidate();
+	Tree::destroy(&tree);
 	free(build_array);
 }
 
+template <class Tree>
 size_t
-MemtxTree::size() const
+MemtxTreeImpl<Tree>::size() const
 {
-	return memtx_tree_size(&tree);
+	return Tree::size(&tree);
 }
 
+template <class Tree>
 size_t
-MemtxTree::bsize() const
+MemtxTreeImpl<Tree>::bsize() const
 {
-	return memtx_tree_mem_used(&tree);
+	return Tree::mem_used(&tree);
 }
 
+template <class Tree>
 struct tuple *
-MemtxTree::random(uint32_t rnd) const
+MemtxTreeImpl<Tree>::random(uint32_t rnd) const
 {
-	struct tuple **res = memtx_tree_random(&tree, rnd);
-	return res ? *res : 0;
+	elem_t *res = Tree::random(&tree, rnd);
+	return res ? memtx_tree_elem_tuple(*res) : 0;
 }
 
+template <class Tree>
 struct tuple *
-MemtxTree::findByKey(const char *key, uint32_t part_count) const
+MemtxTreeImpl<Tree>::findByKey(const char *key, uint32_t part_count) const
 {
 	assert(key_def->opts.is_unique && part_count == key_def->part_count);
 
 	struct key_data key_data;
-	key_data.key = key;
-	key_data.part_count = part_count;
-	struct tuple **res = memtx_tree_find(&tree, &key_data);
-	return res ? *res : 0;
+	key_data_create(&key_data, key, part_count, key_def);
+	elem_t *res = Tree::find(&tree, &key_data);
+	return res ? memtx_tree_elem_tuple(*res) : 0;
 }
 
+/** A key of findByKeys() along with its position in the batch. */
+struct key_lookup {
+	struct key_data key_data;
+	uint32_t pos;
+};
+
+/** Compare two full keys of findByKeys(), hints first. */
+static int
+key_lookup_compare(const void *a, const void *b, void *arg)
+{
+	const struct key_lookup *la = (const struct key_lookup *) a;
+	const struct key_lookup *lb = (const struct key_lookup *) b;
+	struct key_def *key_def = (struct key_def *) arg;
+	if (la->key_data.hint != lb->key_data.hint)
+		return la->key_data.hint < lb->key_data.hint ? -1 : 1;
+	const char *key_a = la->key_data.key;
+	const char *key_b = lb->key_data.key;
+	for (uint32_t i = 0; i < key_def->part_count; i++) {
+		int r = tuple_compare_field(key_a, key_b,
+					    key_def->parts[i].type);
+		if (r != 0)
+			return r;
+		mp_next(&key_a);
+		mp_next(&key_b);
+	}
+	return 0;
+}
+
+template <class Tree>
+void
+MemtxTreeImpl<Tree>::findByKeys(const char **keys, uint32_t part_count,
+				uint32_t n, struct tuple **result) const
+{
+	assert(key_def->opts.is_unique && part_count == key_def->part_count);
+	if (n < 2) {
+		Index::findByKeys(keys, part_count, n, result);
+		return;
+	}
+	/*
+	 * Look the keys up in the index order: consecutive
+	 * lookups then descend along mostly the same, already
+	 * cached, path from the root and hit neighbouring
+	 * leaves. Equal keys are looked up once.
+	 */
+	struct region *region = &fiber()->gc;
+	size_t region_svp = region_used(region);
+	struct key_lookup *lookups = (struct key_lookup *)
+		region_alloc_xc(region, sizeof(*lookups) * n);
+	for (uint32_t i = 0; i < n; i++) {
+		key_data_create(&lookups[i].key_data, keys[i], part_count,
+				key_def);
+		lookups[i].pos = i;
+	}
+	qsort_arg(lookups, n, sizeof(*lookups), key_lookup_compare, key_def);
+	struct tuple *tuple = NULL;
+	for (uint32_t i = 0; i < n; i++) {
+		if (i == 0 || key_lookup_compare(&lookups[i - 1],
+						 &lookups[i], key_def) != 0) {
+			elem_t *res = Tree::find(&tree, &lookups[i].key_data);
+			tuple = res ? memtx_tree_elem_tuple(*res) : NULL;
+		}
+		result[lookups[i].pos] = tuple;
+	}
+	region_truncate(region, region_svp);
+}
+
+template <class Tree>
+size_t
+MemtxTreeImpl<Tree>::count(enum iterator_type type, const char *key,
+			   uint32_t part_count) const
+{
+	if (part_count == 0 && type >= 0 && type <= ITER_GT)
+		return Tree::size(&tree);
+
+	struct key_data key_data;
+	key_data_create(&key_data, key, part_count, key_def);
+	/* Ranks are calculated in O(log n) using subtree counts. */
+	switch (type) {
+	case ITER_EQ:
+	case ITER_REQ:
+		return Tree::count_between(&tree, &key_data, &key_data);
+	case ITER_ALL:
+	case ITER_GE:
+		return Tree::size(&tree) -
+		       Tree::lower_bound_rank(&tree, &key_data);
+	case ITER_GT:
+		return Tree::size(&tree) -
+		       Tree::upper_bound_rank(&tree, &key_data);
+	case ITER_LE:
+		return Tree::upper_bound_rank(&tree, &key_data);
+	case ITER_LT:
+		return Tree::lower_bound_rank(&tree, &key_data);
+	default:
+		return MemtxIndex::count(type, key, part_count);
+	}
+}
+
+template <class Tree>
 struct tuple *
-MemtxTree::replace(struct tuple *old_tuple, struct tuple *new_tuple,
-		   enum dup_replace_mode mode)
+MemtxTreeImpl<Tree>::replace(struct tuple *old_tuple,
+			     struct tuple *new_tuple,
+			     enum dup_replace_mode mode)
 {
 	uint32_t errcode;
 
 	if (new_tuple) {
-		struct tuple *dup_tuple = NULL;
+		elem_t new_elem;
+		memtx_tree_elem_create(&new_elem, new_tuple, key_def);
+		elem_t dup_elem = elem_t();
 
 		/* Try to optimistically replace the new_tuple. */
 		int tree_res =
-		memtx_tree_insert(&tree, new_tuple, &dup_tuple);
+		Tree::insert(&tree, new_elem, &dup_elem);
 		if (tree_res) {
 			tnt_raise(OutOfMemory, BPS_TREE_EXTENT_SIZE,
 				  "MemtxTree", "replace");
 		}
+		struct tuple *dup_tuple = memtx_tree_elem_tuple(dup_elem);
 
 		errcode = replace_check_dup(old_tuple, dup_tuple, mode);
 
 		if (errcode) {
-			memtx_tree_delete(&tree, new_tuple);
+			Tree::remove(&tree, new_elem);
 			if (dup_tuple)
-				memtx_tree_insert(&tree, dup_tuple, 0);
+				Tree::insert(&tree, dup_elem, (elem_t *) NULL);
 			struct space *sp = space_cache_find(key_def->space_id);
 			tnt_raise(ClientError, errcode, index_name(this),
 				  space_name(sp));
@@ -264,34 +642,40 @@ MemtxTree::replace(struct tuple *old_tuple, struct tuple *new_tuple,
 			return dup_tuple;
 	}
 	if (old_tuple) {
-		memtx_tree_delete(&tree, old_tuple);
+		elem_t old_elem;
+		memtx_tree_elem_create(&old_elem, old_tuple, key_def);
+		Tree::remove(&tree, old_elem);
 	}
 	return old_tuple;
 }
 
+template <class Tree>
 struct iterator *
-MemtxTree::allocIterator() const
+MemtxTreeImpl<Tree>::allocIterator() const
 {
-	struct tree_iterator *it = (struct tree_iterator *)
+	struct tree_iterator<Tree> *it = (struct tree_iterator<Tree> *)
 			calloc(1, sizeof(*it));
 	if (it == NULL) {
-		tnt_raise(OutOfMemory, sizeof(struct tree_iterator),
+		tnt_raise(OutOfMemory, sizeof(struct tree_iterator<Tree>),
 			  "MemtxTree", "iterator");
 	}
 
 	it->key_def = key_def;
 	it->tree = &tree;
-	it->base.free = tree_iterator_free;
-	it->tree_iterator = memtx_tree_invalid_iterator();
+	it->base.next_batch = tree_iterator_next_batch<Tree>;
+	it->base.free = tree_iterator_free<Tree>;
+	it->tree_iterator = Tree::invalid_iterator();
 	return (struct iterator *) it;
 }
 
+template <class Tree>
 void
-MemtxTree::initIterator(struct iterator *iterator, enum iterator_type type,
-			const char *key, uint32_t part_count) const
+MemtxTreeImpl<Tree>::initIterator(struct iterator *iterator,
+				  enum iterator_type type,
+				  const char *key, uint32_t part_count) const
 {
 	assert(part_count == 0 || key != NULL);
-	struct tree_iterator *it = tree_iterator(iterator);
+	struct tree_iterator<Tree> *it = tree_iterator_cast<Tree>(iterator);
 
 	if (part_count == 0) {
 		/*
@@ -305,24 +689,23 @@ MemtxTree::initIterator(struct iterator *iterator, enum iterator_type type,
 		type = iterator_type_is_reverse(type) ? ITER_LE : ITER_GE;
 		key = 0;
 	}
-	it->key_data.key = key;
-	it->key_data.part_count = part_count;
+	key_data_create(&it->key_data, key, part_count, key_def);
 
 	bool exact = false;
 	if (key == 0) {
 		if (iterator_type_is_reverse(type))
-			it->tree_iterator = memtx_tree_invalid_iterator();
+			it->tree_iterator = Tree::invalid_iterator();
 		else
-			it->tree_iterator = memtx_tree_iterator_first(&tree);
+			it->tree_iterator = Tree::iterator_first(&tree);
 	} else {
 		if (type == ITER_ALL || type == ITER_EQ || type == ITER_GE || type == ITER_LT) {
-			it->tree_iterator = memtx_tree_lower_bound(&tree, &it->key_data, &exact);
+			it->tree_iterator = Tree::lower_bound(&tree, &it->key_data, &exact);
 			if (type == ITER_EQ && !exact) {
 				it->base.next = tree_iterator_dummie;
 				return;
 			}
 		} else { // ITER_GT, ITER_REQ, ITER_LE
-			it->tree_iterator = memtx_tree_upper_bound(&tree, &it->key_data, &exact);
+			it->tree_iterator = Tree::upper_bound(&tree, &it->key_data, &exact);
 			if (type == ITER_REQ && !exact) {
 				it->base.next = tree_iterator_dummie;
 				return;
@@ -332,97 +715,195 @@ MemtxTree::initIterator(struct iterator *iterator, enum iterator_type type,
 
 	switch (type) {
 	case ITER_EQ:
-		it->base.next = tree_iterator_fwd_check_next_equality;
+		it->base.next = tree_iterator_fwd_check_next_equality<Tree>;
 		break;
 	case ITER_REQ:
-		it->base.next = tree_iterator_bwd_skip_one_check_next_equality;
+		it->base.next =
+			tree_iterator_bwd_skip_one_check_next_equality<Tree>;
 		break;
 	case ITER_ALL:
 	case ITER_GE:
-		it->base.next = tree_iterator_fwd;
+		it->base.next = tree_iterator_fwd<Tree>;
 		break;
 	case ITER_GT:
-		it->base.next = tree_iterator_fwd;
+		it->base.next = tree_iterator_fwd<Tree>;
 		break;
 	case ITER_LE:
-		it->base.next = tree_iterator_bwd_skip_one;
+		it->base.next = tree_iterator_bwd_skip_one<Tree>;
 		break;
 	case ITER_LT:
-		it->base.next = tree_iterator_bwd_skip_one;
+		it->base.next = tree_iterator_bwd_skip_one<Tree>;
 		break;
 	default:
 		return Index::initIterator(iterator, type, key, part_count);
 	}
 }
 
+template <class Tree>
 void
-MemtxTree::beginBuild()
+MemtxTreeImpl<Tree>::beginBuild()
 {
-	assert(memtx_tree_size(&tree) == 0);
+	assert(Tree::size(&tree) == 0);
 }
 
+template <class Tree>
 void
-MemtxTree::reserve(uint32_t size_hint)
+MemtxTreeImpl<Tree>::reserve(uint32_t size_hint)
 {
 	if (size_hint < build_array_alloc_size)
 		return;
-	build_array = (struct tuple**)
-		realloc(build_array, size_hint * sizeof(struct tuple *));
+	build_array = (elem_t *)
+		realloc(build_array, size_hint * sizeof(build_array[0]));
 	build_array_alloc_size = size_hint;
 }
 
+template <class Tree>
 void
-MemtxTree::buildNext(struct tuple *tuple)
+MemtxTreeImpl<Tree>::buildNext(struct tuple *tuple)
 {
 	if (!build_array) {
-		build_array = (struct tuple**)malloc(BPS_TREE_EXTENT_SIZE);
+		build_array = (elem_t *) malloc(BPS_TREE_EXTENT_SIZE);
 		build_array_alloc_size =
-			BPS_TREE_EXTENT_SIZE / sizeof(struct tuple*);
+			BPS_TREE_EXTENT_SIZE / sizeof(build_array[0]);
 	}
 	assert(build_array_size <= build_array_alloc_size);
 	if (build_array_size == build_array_alloc_size) {
 		build_array_alloc_size = build_array_alloc_size +
 					 build_array_alloc_size / 2;
-		build_array = (struct tuple**)
+		build_array = (elem_t *)
 			realloc(build_array,
 				build_array_alloc_size *
-				sizeof(struct tuple *));
+				sizeof(build_array[0]));
 	}
-	build_array[build_array_size++] = tuple;
+	memtx_tree_elem_create(&build_array[build_array_size++], tuple,
+			       key_def);
+}
+
+template <class Tree>
+void
+MemtxTreeImpl<Tree>::sortBuild()
+{
+	qsort_arg(build_array, build_array_size, sizeof(build_array[0]),
+		  memtx_tree_qcompare<Tree>, key_def);
+	build_array_is_sorted = true;
 }
 
+template <class Tree>
 void
-MemtxTree::endBuild()
+MemtxTreeImpl<Tree>::endBuild()
 {
-	qsort_arg(build_array, build_array_size, sizeof(struct tuple *), memtx_tree_qcompare, key_def);
-	memtx_tree_build(&tree, build_array, build_array_size);
+	if (!build_array_is_sorted)
+		sortBuild();
+	Tree::build(&tree, build_array, build_array_size);
 
 	free(build_array);
 	build_array = 0;
 	build_array_size = 0;
 	build_array_alloc_size = 0;
+	build_array_is_sorted = false;
 }
 
-/**
- * Create a read view for iterator so further index modifications
- * will not affect the iterator iteration.
- */
+template <class Tree>
 void
-MemtxTree::createReadViewForIterator(struct iterator *iterator)
+MemtxTreeImpl<Tree>::createReadViewForIterator(struct iterator *iterator)
 {
-	struct tree_iterator *it = tree_iterator(iterator);
-	struct memtx_tree *tree = (struct memtx_tree *)it->tree;
-	memtx_tree_iterator_freeze(tree, &it->tree_iterator);
+	struct tree_iterator<Tree> *it = tree_iterator_cast<Tree>(iterator);
+	typename Tree::tree_t *tree = (typename Tree::tree_t *)it->tree;
+	Tree::iterator_freeze(tree, &it->tree_iterator);
 }
 
-/**
- * Destroy a read view of an iterator. Must be called for iterators,
- * for which createReadViewForIterator was called.
- */
+template <class Tree>
 void
-MemtxTree::destroyReadViewForIterator(struct iterator *iterator)
+MemtxTreeImpl<Tree>::destroyReadViewForIterator(struct iterator *iterator)
+{
+	struct tree_iterator<Tree> *it = tree_iterator_cast<Tree>(iterator);
+	typename Tree::tree_t *tree = (typename Tree::tree_t *)it->tree;
+	Tree::iterator_destroy(tree, &it->tree_iterator);
+}
+
+template <class Tree>
+void
+MemtxTreeImpl<Tree>::createReadView(struct memtx_tree_view *view)
+{
+	Tree::view_create(&tree, Tree::view(view));
+}
+
+template <class Tree>
+void
+MemtxTreeImpl<Tree>::destroyReadView(struct memtx_tree_view *view)
+{
+	Tree::view_destroy(&tree, Tree::view(view));
+}
+
+template <class Tree>
+void
+MemtxTreeImpl<Tree>::initReadViewIterator(
+	struct iterator *iterator, const struct memtx_tree_view *view_arg,
+	enum iterator_type type, const char *key, uint32_t part_count) const
+{
+	assert(part_count == 0 || key != NULL);
+	assert(type >= 0 && type <= ITER_GT);
+	struct tree_iterator<Tree> *it = tree_iterator_cast<Tree>(iterator);
+	const typename Tree::view_t *view = Tree::view(view_arg);
+
+	if (part_count == 0) {
+		type = iterator_type_is_reverse(type) ? ITER_LE : ITER_GE;
+		key = 0;
+	}
+	key_data_create(&it->key_data, key, part_count, key_def);
+
+	bool exact = false;
+	if (key == 0) {
+		if (iterator_type_is_reverse(type)) {
+			it->tree_iterator = Tree::view_last(&tree, view);
+			it->base.next = tree_iterator_bwd<Tree>;
+		} else {
+			it->tree_iterator = Tree::view_first(&tree, view);
+			it->base.next = tree_iterator_fwd<Tree>;
+		}
+		return;
+	}
+	if (type == ITER_ALL || type == ITER_EQ || type == ITER_GE || type == ITER_LT) {
+		it->tree_iterator = Tree::view_lower_bound(&tree, view,
+							   &it->key_data,
+							   &exact);
+	} else { // ITER_GT, ITER_REQ, ITER_LE
+		it->tree_iterator = Tree::view_upper_bound(&tree, view,
+							   &it->key_data,
+							   &exact);
+	}
+	if ((type == ITER_EQ || type == ITER_REQ) && !exact) {
+		it->base.next = tree_iterator_dummie;
+		return;
+	}
+	if (!iterator_type_is_reverse(type)) {
+		it->base.next = type == ITER_EQ ?
+				tree_iterator_fwd_check_next_equality<Tree> :
+				tree_iterator_fwd<Tree>;
+		return;
+	}
+	/*
+	 * Unlike a tree iterator, an invalid read view iterator
+	 * can't be stepped back to the last element, start from
+	 * the last element explicitly.
+	 */
+	if (Tree::iterator_is_invalid(&it->tree_iterator)) {
+		it->tree_iterator = Tree::view_last(&tree, view);
+		it->base.next = type == ITER_REQ ?
+				tree_iterator_bwd_check_equality<Tree> :
+				tree_iterator_bwd<Tree>;
+	} else {
+		it->base.next = type == ITER_REQ ?
+			tree_iterator_bwd_skip_one_check_next_equality<Tree> :
+			tree_iterator_bwd_skip_one<Tree>;
+	}
+}
+/* }}} */
+
+MemtxTree *
+memtx_tree_new(struct key_def *key_def)
 {
-	struct tree_iterator *it = tree_iterator(iterator);
-	struct memtx_tree *tree = (struct memtx_tree *)it->tree;
-	memtx_tree_iterator_destroy(tree, &it->tree_iterator);
+	if (key_def->opts.hint)
+		return new MemtxTreeImpl<memtx_hint_tree_api>(key_def);
+	return new MemtxTreeImpl<memtx_tuple_tree_api>(key_def);
 }
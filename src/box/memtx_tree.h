@@ -37,62 +37,107 @@
 struct tuple;
 struct key_data;
 
+/**
+ * An element of a TREE index with the hint option. The hint of
+ * the tuple is stored next to the tuple pointer, so that most
+ * comparisons are decided without touching the tuple, see
+ * tuple_hint(). Indexes without hints store bare tuple pointers
+ * and don't pay for the hint.
+ */
+struct memtx_tree_data {
+	struct tuple *tuple;
+	uint64_t hint;
+};
+
+/** Used by the debug checks of the tree. */
+static inline bool
+operator!=(const struct memtx_tree_data &a, const struct memtx_tree_data &b)
+{
+	return a.tuple != b.tuple;
+}
+
 int
-memtx_tree_compare(const struct tuple *a, const struct tuple *b, struct key_def *key_def);
+memtx_tree_compare(const struct tuple *a, const struct tuple *b,
+		   struct key_def *key_def);
 
 int
-memtx_tree_compare_key(const tuple *a, const key_data *b, struct key_def *key_def);
+memtx_tree_compare_key(const struct tuple *a, const struct key_data *b,
+		       struct key_def *key_def);
+
+/** Same as above, but hints are compared first. */
+int
+memtx_tree_compare(const struct memtx_tree_data &a,
+		   const struct memtx_tree_data &b, struct key_def *key_def);
+
+int
+memtx_tree_compare_key(const struct memtx_tree_data &a,
+		       const struct key_data *b, struct key_def *key_def);
 
-#define BPS_TREE_NAME memtx_tree
 #define BPS_TREE_BLOCK_SIZE (512)
 #define BPS_TREE_EXTENT_SIZE MEMTX_EXTENT_SIZE
 #define BPS_TREE_COMPARE(a, b, arg) memtx_tree_compare(a, b, arg)
 #define BPS_TREE_COMPARE_KEY(a, b, arg) memtx_tree_compare_key(a, b, arg)
-#define bps_tree_elem_t struct tuple *
 #define bps_tree_key_t struct key_data *
 #define bps_tree_arg_t struct key_def *
+#define BPS_TREE_SUBTREE_COUNT
 
+/* A tree of tuples, used by indexes without hints. */
+#define BPS_TREE_NAME memtx_tuple_tree
+#define bps_tree_elem_t struct tuple *
+#include "salad/bps_tree.h"
+#undef BPS_TREE_NAME
+#undef bps_tree_elem_t
+
+/* A tree of tuples with hints, used by indexes with hints. */
+#define BPS_TREE_NAME memtx_hint_tree
+#define bps_tree_elem_t struct memtx_tree_data
 #include "salad/bps_tree.h"
+#undef BPS_TREE_NAME
+#undef bps_tree_elem_t
+
+/** A read view of a TREE index, see MemtxTree::createReadView(). */
+struct memtx_tree_view {
+	union {
+		struct memtx_tuple_tree_view tuple_view;
+		struct memtx_hint_tree_view hint_view;
+	};
+};
 
+/**
+ * A TREE index. The implementation depends on whether the index
+ * has hints, see memtx_tree_new().
+ */
 class MemtxTree: public MemtxIndex {
 public:
-	MemtxTree(struct key_def *key_def);
-	virtual ~MemtxTree() override;
-
-	virtual void beginBuild() override;
-	virtual void reserve(uint32_t size_hint) override;
-	virtual void buildNext(struct tuple *tuple) override;
-	virtual void endBuild() override;
-	virtual size_t size() const override;
-	virtual struct tuple *random(uint32_t rnd) const override;
-	virtual struct tuple *findByKey(const char *key,
-					uint32_t part_count) const override;
-	virtual struct tuple *replace(struct tuple *old_tuple,
-				      struct tuple *new_tuple,
-				      enum dup_replace_mode mode) override;
-
-	virtual size_t bsize() const override;
-	virtual struct iterator *allocIterator() const override;
-	virtual void initIterator(struct iterator *iterator,
-				  enum iterator_type type,
-				  const char *key,
-				  uint32_t part_count) const override;
+	MemtxTree(struct key_def *key_def) : MemtxIndex(key_def) {}
 
 	/**
-	 * Create a read view for iterator so further index modifications
-	 * will not affect the iterator iteration.
+	 * Create a read view of the index. Further index
+	 * modifications are not visible in the view, so it can
+	 * be searched with initReadViewIterator() from another
+	 * thread.
 	 */
-	virtual void createReadViewForIterator(struct iterator *iterator) override;
+	virtual void createReadView(struct memtx_tree_view *view) = 0;
+	/** Destroy a read view created by createReadView(). */
+	virtual void destroyReadView(struct memtx_tree_view *view) = 0;
 	/**
-	 * Destroy a read view of an iterator. Must be called for iterators,
-	 * for which createReadViewForIterator was called.
+	 * Position an iterator in a read view. Only ITER_EQ,
+	 * ITER_REQ, ITER_ALL, ITER_LT, ITER_LE, ITER_GE and
+	 * ITER_GT are supported. Doesn't throw, can be called
+	 * from any thread.
 	 */
-	virtual void destroyReadViewForIterator(struct iterator *iterator) override;
-
-// protected:
-	struct memtx_tree tree;
-	struct tuple **build_array;
-	size_t build_array_size, build_array_alloc_size;
+	virtual void initReadViewIterator(struct iterator *iterator,
+					  const struct memtx_tree_view *view,
+					  enum iterator_type type,
+					  const char *key,
+					  uint32_t part_count) const = 0;
 };
 
+/**
+ * Create a TREE index. Elements of an index with the hint
+ * option are twice as big as elements of an index without it.
+ */
+MemtxTree *
+memtx_tree_new(struct key_def *key_def);
+
 #endif /* TARANTOOL_BOX_MEMTX_TREE_H_INCLUDED */
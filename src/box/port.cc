@@ -34,30 +34,29 @@
 #include <small/mempool.h>
 #include <fiber.h>
 
-static struct mempool port_entry_pool;
+static struct mempool port_chunk_pool;
 
 void
 port_add_tuple(struct port *port, struct tuple *tuple)
 {
-	struct port_entry *e;
-	if (port->size == 0) {
-		tuple_ref(tuple); /* throws */
-		e = &port->first_entry;
-		port->first = port->last = e;
-	} else {
-		e = (struct port_entry *)
-			mempool_alloc_xc(&port_entry_pool); /* throws */
+	struct port_chunk *chunk = port->last;
+	if (chunk->size == PORT_CHUNK_SIZE) {
+		chunk = (struct port_chunk *)
+			mempool_alloc_xc(&port_chunk_pool); /* throws */
 		try {
 			tuple_ref(tuple); /* throws */
 		} catch (Exception *) {
-			mempool_free(&port_entry_pool, e);
+			mempool_free(&port_chunk_pool, chunk);
 			throw;
 		}
-		port->last->next = e;
-		port->last = e;
+		chunk->next = NULL;
+		chunk->size = 0;
+		port->last->next = chunk;
+		port->last = chunk;
+	} else {
+		tuple_ref(tuple); /* throws */
 	}
-	e->tuple = tuple;
-	e->next = NULL;
+	chunk->tuples[chunk->size++] = tuple;
 	++port->size;
 }
 
@@ -65,53 +64,63 @@ void
 port_create(struct port *port)
 {
 	port->size = 0;
-	port->first = NULL;
-	port->last = NULL;
+	port->first_chunk.next = NULL;
+	port->first_chunk.size = 0;
+	port->first = port->last = &port->first_chunk;
 }
 
 void
 port_destroy(struct port *port)
 {
-	struct port_entry *e = port->first;
-	if (e == NULL)
-		return;
-	tuple_unref(e->tuple);
-	e = e->next;
-	while (e != NULL) {
-		struct port_entry *cur = e;
-		e = e->next;
-		tuple_unref(cur->tuple);
-		mempool_free(&port_entry_pool, cur);
+	struct port_chunk *chunk = port->first;
+	while (chunk != NULL) {
+		struct port_chunk *cur = chunk;
+		chunk = chunk->next;
+		for (uint32_t i = 0; i < cur->size; i++)
+			tuple_unref(cur->tuples[i]);
+		if (cur != &port->first_chunk)
+			mempool_free(&port_chunk_pool, cur);
 	}
 }
 
 void
 port_dump(struct port *port, struct obuf *out)
 {
-	struct port_entry *e = port->first;
-	if (e == NULL)
-		return;
-	tuple_to_obuf(e->tuple, out);
-	tuple_unref(e->tuple);
-	e = e->next;
-	while (e != NULL) {
-		struct port_entry *cur = e;
-		tuple_to_obuf(e->tuple, out);
-		e = e->next;
-		tuple_unref(cur->tuple);
-		mempool_free(&port_entry_pool, cur);
+	struct port_chunk *chunk = port->first;
+	while (chunk != NULL) {
+		struct port_chunk *cur = chunk;
+		chunk = chunk->next;
+		for (uint32_t i = 0; i < cur->size; i++) {
+			tuple_to_obuf(cur->tuples[i], out);
+			tuple_unref(cur->tuples[i]);
+		}
+		if (cur != &port->first_chunk)
+			mempool_free(&port_chunk_pool, cur);
+	}
+}
+
+int
+port_to_obuf(struct port *port, struct obuf *out)
+{
+	for (struct port_chunk *chunk = port->first; chunk != NULL;
+	     chunk = chunk->next) {
+		for (uint32_t i = 0; i < chunk->size; i++) {
+			if (tuple_to_obuf(chunk->tuples[i], out) != 0)
+				return -1;
+		}
 	}
+	return 0;
 }
 
 void
 port_init(void)
 {
-	mempool_create(&port_entry_pool, &cord()->slabc,
-		       sizeof(struct port_entry));
+	mempool_create(&port_chunk_pool, &cord()->slabc,
+		       sizeof(struct port_chunk));
 }
 
 void
 port_free(void)
 {
-	mempool_destroy(&port_entry_pool);
+	mempool_destroy(&port_chunk_pool);
 }
@@ -37,6 +37,7 @@ extern "C" {
 #endif /* defined(__cplusplus) */
 
 struct tuple;
+struct obuf;
 
 /**
  * A single port represents a destination of box_process output.
@@ -57,16 +58,34 @@ struct tuple;
  * format defines the internal structure of the tuple.
  */
 
-struct port_entry {
-	struct port_entry *next;
-	struct tuple *tuple;
+enum {
+	/**
+	 * Number of tuples in a port chunk. Keep in sync with
+	 * struct port_chunk definition in box/lua/schema.lua.
+	 */
+	PORT_CHUNK_SIZE = 32
+};
+
+/**
+ * Tuples are stored in a list of fixed-size chunks rather than
+ * one list entry per tuple, so that appending a tuple is
+ * usually a store to an array and the readers walk contiguous
+ * memory.
+ */
+struct port_chunk {
+	struct port_chunk *next;
+	/** Number of tuples used in this chunk. */
+	uint32_t size;
+	struct tuple *tuples[PORT_CHUNK_SIZE];
 };
 
 struct port {
+	/** Total number of tuples in the port. */
 	size_t size;
-	struct port_entry *first;
-	struct port_entry *last;
-	struct port_entry first_entry;
+	struct port_chunk *first;
+	struct port_chunk *last;
+	/** Embedded to avoid allocations for small results. */
+	struct port_chunk first_chunk;
 };
 
 void
@@ -81,6 +100,15 @@ port_destroy(struct port *port);
 void
 port_dump(struct port *port, struct obuf *out);
 
+/**
+ * Encode all tuples of the port into @a out. The tuples stay
+ * in the port.
+ * @retval 0 success
+ * @retval -1 out of memory
+ */
+int
+port_to_obuf(struct port *port, struct obuf *out);
+
 void
 port_add_tuple(struct port *port, struct tuple *tuple);
 
@@ -156,6 +156,7 @@ recovery_new(const char *wal_dirname, bool panic_on_wal_error,
 	xdir_check_xc(&r->wal_dir);
 
 	r->watcher = NULL;
+	wal_tail_cursor_create(&r->tail_cursor);
 
 	guard.is_active = false;
 	return r;
@@ -486,36 +487,57 @@ recovery_follow_f(va_list ap)
 	while (! fiber_is_cancelled()) {
 
 		/*
-		 * Recover until there is no new stuff which appeared in
-		 * the log dir while recovery was running.
-		 *
-		 * Use vclock signature to represent the current wal
-		 * since the xlog object itself may be freed in
-		 * recover_remaining_rows().
+		 * A relay sends rows from the WAL tail buffer
+		 * while it keeps up with the WAL writer and reads
+		 * xlogs only when it lags behind.
 		 */
-		int64_t start, end;
-		do {
-			start = r->current_wal ? vclock_sum(&r->current_wal->vclock) : 0;
+		if (wal_tail_read(wal, &r->vclock, &r->tail_cursor,
+				  stream) == 0) {
 			/*
-			 * If there is no current WAL, or we reached
-			 * an end  of one, look for new WALs.
+			 * The current WAL position is stale, look
+			 * the WAL up by vclock if we ever fall back
+			 * to reading files.
 			 */
-			if (r->current_wal == NULL || r->current_wal->eof_read)
-				xdir_scan_xc(&r->wal_dir);
-
-			recover_remaining_wals(r, stream, NULL);
-
-			end = r->current_wal ? vclock_sum(&r->current_wal->vclock) : 0;
+			if (r->current_wal != NULL) {
+				xlog_close(r->current_wal);
+				r->current_wal = NULL;
+			}
+			fiber_gc();
+		} else {
 			/*
-			 * Continue, given there's been progress *and* there is a
-			 * chance new WALs have appeared since.
-			 * Sic: end * is < start (is 0) if someone deleted all logs
-			 * on the filesystem.
+			 * Recover until there is no new stuff which appeared in
+			 * the log dir while recovery was running.
+			 *
+			 * Use vclock signature to represent the current wal
+			 * since the xlog object itself may be freed in
+			 * recover_remaining_rows().
 			 */
-		} while (end > start && (r->current_wal == NULL || r->current_wal->eof_read));
+			int64_t start, end;
+			do {
+				start = r->current_wal ? vclock_sum(&r->current_wal->vclock) : 0;
+				/*
+				 * If there is no current WAL, or we reached
+				 * an end  of one, look for new WALs.
+				 */
+				if (r->current_wal == NULL || r->current_wal->eof_read)
+					xdir_scan_xc(&r->wal_dir);
+
+				recover_remaining_wals(r, stream, NULL);
+
+				end = r->current_wal ? vclock_sum(&r->current_wal->vclock) : 0;
+				/*
+				 * Continue, given there's been progress *and* there is a
+				 * chance new WALs have appeared since.
+				 * Sic: end * is < start (is 0) if someone deleted all logs
+				 * on the filesystem.
+				 */
+			} while (end > start && (r->current_wal == NULL || r->current_wal->eof_read));
+
+			subscription.set_log_path(r->current_wal != NULL ?
+						  r->current_wal->filename : NULL);
+		}
 
-		subscription.set_log_path(r->current_wal != NULL ?
-					  r->current_wal->filename : NULL);
+		xstream_flush(stream);
 
 		if (subscription.signaled == false) {
 			/**
@@ -35,6 +35,7 @@
 #include "xlog.h"
 #include "vclock.h"
 #include "tt_uuid.h"
+#include "wal.h"
 
 #if defined(__cplusplus)
 extern "C" {
@@ -58,6 +59,8 @@ struct recovery {
 	 */
 	struct fiber *watcher;
 	uint32_t server_id;
+	/** Where the relay stopped in the WAL tail buffer. */
+	struct wal_tail_cursor tail_cursor;
 };
 
 struct recovery *
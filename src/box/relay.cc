@@ -45,12 +45,24 @@
 #include "errinj.h"
 #include "xrow_io.h"
 
+enum {
+	/** Rows are sent to the replica in batches of this size. */
+	RELAY_BATCH_SIZE = 128 * 1024,
+};
+
+/** Max time a row may wait in a batch before it is sent. */
+static const ev_tstamp RELAY_BATCH_TIMEOUT = 0.01;
+
 static void
 relay_send_initial_join_row(struct xstream *stream, struct xrow_header *row);
 static void
 relay_send_final_join_row(struct xstream *stream, struct xrow_header *packet);
 static void
 relay_send_subscribe_row(struct xstream *stream, struct xrow_header *row);
+static void
+relay_flush(struct relay *relay);
+static void
+relay_flush_stream(struct xstream *stream);
 
 static inline void
 relay_create(struct relay *relay, int fd, uint64_t sync,
@@ -58,6 +70,7 @@ relay_create(struct relay *relay, int fd, uint64_t sync,
 {
 	memset(relay, 0, sizeof(*relay));
 	xstream_create(&relay->stream, stream_write);
+	relay->stream.flush = relay_flush_stream;
 	coio_init(&relay->io, fd);
 	relay->sync = sync;
 }
@@ -86,10 +99,15 @@ relay_initial_join_f(va_list ap)
 	struct relay *relay = va_arg(ap, struct relay *);
 	coeio_enable();
 	relay_set_cord_name(relay->io.fd);
+	obuf_create(&relay->out, &cord()->slabc, RELAY_BATCH_SIZE);
+	auto out_guard = make_scoped_guard([&]{
+		obuf_destroy(&relay->out);
+	});
 
 	/* Send snapshot */
 	assert(relay->stream.write != NULL);
 	engine_join(&relay->stream);
+	relay_flush(relay);
 
 	return 0;
 }
@@ -114,12 +132,17 @@ relay_final_join_f(va_list ap)
 	struct relay *relay = va_arg(ap, struct relay *);
 	coeio_enable();
 	relay_set_cord_name(relay->io.fd);
+	obuf_create(&relay->out, &cord()->slabc, RELAY_BATCH_SIZE);
+	auto out_guard = make_scoped_guard([&]{
+		obuf_destroy(&relay->out);
+	});
 
 	/* Send all WALs until stop_vclock */
 	assert(relay->stream.write != NULL);
 	xdir_scan_xc(&relay->r->wal_dir);
 	recover_remaining_wals(relay->r, &relay->stream, &relay->stop_vclock);
 	assert(vclock_compare(&relay->r->vclock, &relay->stop_vclock) == 0);
+	relay_flush(relay);
 	return 0;
 }
 
@@ -162,6 +185,10 @@ relay_subscribe_f(va_list ap)
 	coeio_enable();
 	relay->stream.write = relay_send_subscribe_row;
 	relay_set_cord_name(relay->io.fd);
+	obuf_create(&relay->out, &cord()->slabc, RELAY_BATCH_SIZE);
+	auto out_guard = make_scoped_guard([&]{
+		obuf_destroy(&relay->out);
+	});
 	recovery_follow_local(r, &relay->stream, fiber_name(fiber()),
 			      relay->wal_dir_rescan_delay);
 
@@ -250,11 +277,41 @@ relay_subscribe(int fd, uint64_t sync, struct server *server,
 	diag_raise();
 }
 
+/** Send the batch of rows to the replica. */
+static void
+relay_flush(struct relay *relay)
+{
+	struct obuf *out = &relay->out;
+	if (obuf_size(out) == 0)
+		return;
+	coio_writev(&relay->io, out->iov, obuf_iovcnt(out), obuf_size(out));
+	obuf_reset(out);
+}
+
+static void
+relay_flush_stream(struct xstream *stream)
+{
+	relay_flush(container_of(stream, struct relay, stream));
+}
+
+/**
+ * Add a row to the batch. The batch is sent when it's big
+ * enough or has been waiting for too long, or when there are
+ * no more rows to send for now, see relay_flush_stream().
+ */
 static void
 relay_send(struct relay *relay, struct xrow_header *packet)
 {
-	packet->sync = relay->sync;
-	coio_write_xrow(&relay->io, packet);
+	struct obuf *out = &relay->out;
+	if (obuf_size(out) == 0)
+		relay->batch_start = ev_time();
+	struct iovec iov[XROW_IOVMAX];
+	int iovcnt = xrow_to_iovec(packet, iov);
+	for (int i = 0; i < iovcnt; i++)
+		obuf_dup_xc(out, iov[i].iov_base, iov[i].iov_len);
+	if (obuf_size(out) >= RELAY_BATCH_SIZE ||
+	    ev_time() - relay->batch_start >= RELAY_BATCH_TIMEOUT)
+		relay_flush(relay);
 }
 
 static void
@@ -264,6 +321,7 @@ relay_send_initial_join_row(struct xstream *stream, struct xrow_header *row)
 	relay_send(relay, row);
 	ERROR_INJECT(ERRINJ_RELAY,
 	{
+		relay_flush(relay);
 		fiber_sleep(1000.0);
 	});
 }
@@ -280,6 +338,7 @@ relay_send_final_join_row(struct xstream *stream, struct xrow_header *row)
 	relay_send(relay, row);
 	ERROR_INJECT(ERRINJ_RELAY,
 	{
+		relay_flush(relay);
 		fiber_sleep(1000.0);
 	});
 }
@@ -302,6 +361,7 @@ relay_send_subscribe_row(struct xstream *stream, struct xrow_header *packet)
 		relay_send(relay, packet);
 		ERROR_INJECT(ERRINJ_RELAY,
 		{
+			relay_flush(relay);
 			fiber_sleep(1000.0);
 		});
 	}
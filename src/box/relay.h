@@ -34,6 +34,7 @@
 #include "fiber.h"
 #include "vclock.h"
 #include "xstream.h"
+#include "small/obuf.h"
 
 struct server;
 struct tt_uuid;
@@ -50,6 +51,10 @@ struct relay {
 	struct xstream stream;
 	struct vclock stop_vclock;
 	ev_tstamp wal_dir_rescan_delay;
+	/** Rows to be sent to the replica in one go. */
+	struct obuf out;
+	/** When the first row of the batch was added. */
+	ev_tstamp batch_start;
 };
 
 /**
@@ -63,6 +63,11 @@ struct request
 	uint32_t offset;
 	uint32_t limit;
 	uint32_t iterator;
+	/**
+	 * SELECT: if not 0, send the result in packets of at
+	 * most this many tuples, see IPROTO_CHUNK.
+	 */
+	uint32_t chunk_size;
 	/** Search key or proc name. */
 	const char *key;
 	const char *key_end;
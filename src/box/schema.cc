@@ -32,6 +32,7 @@
 #include "user_def.h"
 #include "engine.h"
 #include "memtx_index.h"
+#include "memtx_read_view.h"
 #include "func.h"
 #include "tuple.h"
 #include "assoc.h"
@@ -144,6 +145,7 @@ space_cache_delete(uint32_t id)
 	assert(k != mh_end(spaces));
 	struct space *space = (struct space *)mh_i32ptr_node(spaces, k)->val;
 	mh_i32ptr_del(spaces, k, NULL);
+	memtx_read_view_invalidate();
 	sc_version++;
 	return space;
 }
@@ -162,6 +164,7 @@ space_cache_replace(struct space *space)
 		panic_syserror("Out of memory for the data "
 			       "dictionary cache.");
 	}
+	memtx_read_view_invalidate();
 	sc_version++;
 	/*
 	 * Must be after the space is put into the hash, since
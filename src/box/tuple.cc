@@ -194,22 +194,112 @@ tuple_alloc(struct tuple_format *format, size_t size)
 }
 
 /**
- * Free the tuple.
- * @pre tuple->refs  == 0
+ * A read view of memtx memory, see tuple_read_view_open().
  */
-void
-tuple_delete(struct tuple *tuple)
+struct tuple_read_view {
+	/** Link in tuple_read_views. */
+	struct rlist link;
+	/**
+	 * Tuples deleted while this view was the newest one.
+	 * They may be visible in this view or in older ones.
+	 */
+	struct tuple **garbage;
+	uint32_t garbage_size;
+	uint32_t garbage_capacity;
+};
+
+/** Open read views, the newest one goes first. */
+static RLIST_HEAD(tuple_read_views);
+
+/** Return the tuple memory to the allocator. */
+static void
+tuple_free_memory(struct tuple *tuple)
 {
-	say_debug("tuple_delete(%p)", tuple);
-	assert(tuple->refs == 0);
 	struct tuple_format *format = tuple_format(tuple);
 	size_t total = sizeof(struct tuple) + tuple->bsize + format->field_map_size;
 	char *ptr = (char *) tuple - format->field_map_size;
-	tuple_format_ref(format, -1);
 	if (!memtx_alloc.is_delayed_free_mode || tuple->version == snapshot_version)
 		smfree(&memtx_alloc, ptr, total);
 	else
 		smfree_delayed(&memtx_alloc, ptr, total);
+	tuple_format_ref(format, -1);
+}
+
+static void
+tuple_read_view_add_garbage(struct tuple_read_view *view, struct tuple *tuple)
+{
+	if (view->garbage_size == view->garbage_capacity) {
+		uint32_t capacity = view->garbage_capacity ?
+				    view->garbage_capacity * 2 : 1024;
+		struct tuple **garbage = (struct tuple **)
+			realloc(view->garbage, capacity * sizeof(*garbage));
+		/* tuple_delete() can't fail. */
+		if (garbage == NULL)
+			panic("failed to allocate %zu bytes for "
+			      "read view garbage", capacity * sizeof(*garbage));
+		view->garbage = garbage;
+		view->garbage_capacity = capacity;
+	}
+	view->garbage[view->garbage_size++] = tuple;
+}
+
+struct tuple_read_view *
+tuple_read_view_open()
+{
+	struct tuple_read_view *view = (struct tuple_read_view *)
+		calloc(1, sizeof(*view));
+	if (view == NULL)
+		tnt_raise(OutOfMemory, sizeof(*view), "malloc",
+			  "struct tuple_read_view");
+	/*
+	 * Tuples allocated after this point are not visible in
+	 * the view and can be freed right away.
+	 */
+	snapshot_version++;
+	rlist_add_entry(&tuple_read_views, view, link);
+	return view;
+}
+
+void
+tuple_read_view_close(struct tuple_read_view *view)
+{
+	/*
+	 * The garbage of the view may still be visible in older
+	 * views, which are next in the list.
+	 */
+	struct tuple_read_view *older = NULL;
+	if (view->link.next != &tuple_read_views)
+		older = rlist_next_entry(view, link);
+	rlist_del_entry(view, link);
+	for (uint32_t i = 0; i < view->garbage_size; i++) {
+		if (older != NULL)
+			tuple_read_view_add_garbage(older, view->garbage[i]);
+		else
+			tuple_free_memory(view->garbage[i]);
+	}
+	free(view->garbage);
+	free(view);
+}
+
+/**
+ * Free the tuple.
+ * @pre tuple->refs  == 0
+ */
+void
+tuple_delete(struct tuple *tuple)
+{
+	say_debug("tuple_delete(%p)", tuple);
+	assert(tuple->refs == 0);
+	if (!rlist_empty(&tuple_read_views) &&
+	    tuple->version != snapshot_version) {
+		/* The tuple may be visible in an open read view. */
+		struct tuple_read_view *newest =
+			rlist_first_entry(&tuple_read_views,
+					  struct tuple_read_view, link);
+		tuple_read_view_add_garbage(newest, tuple);
+		return;
+	}
+	tuple_free_memory(tuple);
 }
 
 /**
@@ -656,6 +746,71 @@ tuple_compare_with_key_default(const struct tuple *tuple, const char *key,
 	return r;
 }
 
+/**
+ * Map a double to an unsigned integer so that the integers
+ * compare the same way as the doubles.
+ */
+static inline uint64_t
+double_hint(double val)
+{
+	if (val == 0)
+		val = 0; /* -0.0 == 0.0 */
+	uint64_t bits;
+	memcpy(&bits, &val, sizeof(bits));
+	const uint64_t sign = 1ULL << 63;
+	return (bits & sign) != 0 ? ~bits : bits | sign;
+}
+
+static uint64_t
+field_hint(const char *field, enum field_type type)
+{
+	const uint64_t sign = 1ULL << 63;
+	switch (type) {
+	case FIELD_TYPE_UNSIGNED:
+		return mp_decode_uint(&field);
+	case FIELD_TYPE_INTEGER:
+		if (mp_typeof(*field) == MP_UINT) {
+			uint64_t val = mp_decode_uint(&field);
+			/* Values above INT64_MAX share the top hint. */
+			return val > INT64_MAX ? UINT64_MAX : val + sign;
+		}
+		return (uint64_t) mp_decode_int(&field) + sign;
+	case FIELD_TYPE_NUMBER:
+		return double_hint(mp_decode_number(&field));
+	case FIELD_TYPE_STRING: {
+		/* The first 8 bytes, zero-padded, big-endian. */
+		uint32_t len;
+		const char *str = mp_decode_str(&field, &len);
+		uint64_t hint = 0;
+		for (uint32_t i = 0; i < sizeof(hint); i++) {
+			hint <<= 8;
+			if (i < len)
+				hint |= (uint8_t) str[i];
+		}
+		return hint;
+	}
+	default:
+		return 0;
+	}
+}
+
+uint64_t
+tuple_hint(const struct tuple *tuple, const struct key_def *key_def)
+{
+	const struct key_part *part = key_def->parts;
+	const char *field = tuple_field_old(tuple_format(tuple), tuple,
+					    part->fieldno);
+	assert(field != NULL);
+	return field_hint(field, part->type);
+}
+
+uint64_t
+key_hint(const char *key, const struct key_def *key_def)
+{
+	assert(key != NULL);
+	return field_hint(key, key_def->parts[0].type);
+}
+
 void
 tuple_init(float tuple_arena_max_size, uint32_t objsize_min,
 	   uint32_t objsize_max, float alloc_factor)
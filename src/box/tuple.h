@@ -726,6 +726,27 @@ tuple_compare(const struct tuple *tuple_a, const struct tuple *tuple_b,
 	return key_def->tuple_compare(tuple_a, tuple_b, key_def);
 }
 
+/**
+ * @brief Summarize the first key part of a tuple in 64 bits
+ * Hints preserve the order: if the hints of two tuples differ,
+ * the tuples compare the same way as their hints, while equal
+ * hints say nothing. Field types without a hint give 0.
+ * @param tuple tuple
+ * @param key_def key definition
+ * @return hint
+ */
+uint64_t
+tuple_hint(const struct tuple *tuple, const struct key_def *key_def);
+
+/**
+ * @brief Same as tuple_hint(), but for a key
+ * @param key the key parts, at least one
+ * @param key_def key definition
+ * @return hint
+ */
+uint64_t
+key_hint(const char *key, const struct key_def *key_def);
+
 
 /** These functions are implemented in tuple_convert.cc. */
 
@@ -754,6 +775,25 @@ tuple_begin_snapshot();
 void
 tuple_end_snapshot();
 
+struct tuple_read_view;
+
+/**
+ * Open a read view of memtx memory: tuples deleted after this
+ * call are not freed until the view is closed, so that other
+ * threads can read them through frozen index views.
+ * Must be called from the tx thread.
+ * \throw OutOfMemory
+ */
+struct tuple_read_view *
+tuple_read_view_open();
+
+/**
+ * Close a read view and free the tuples deleted since it was
+ * opened which are not visible in other open views.
+ */
+void
+tuple_read_view_close(struct tuple_read_view *view);
+
 extern struct tuple *box_tuple_last;
 
 /**
@@ -31,11 +31,28 @@
 #include "tuple_compare.h"
 #include "tuple.h"
 
+/** Comparators generated for the part types of a key_def. */
+struct typed_comparators {
+	tuple_compare_t compare;
+	tuple_compare_with_key_t compare_with_key;
+};
+
+static bool
+typed_comparators_create(const struct key_def *def,
+			 struct typed_comparators *cmp);
+
 /* {{{ tuple_compare */
 
+/**
+ * Types without a specialization below (INTEGER, NUMBER,
+ * SCALAR) fall back to the generic field comparator.
+ */
 template <int TYPE>
 static inline int
-field_compare(const char **field_a, const char **field_b);
+field_compare(const char **field_a, const char **field_b)
+{
+	return tuple_compare_field(*field_a, *field_b, (enum field_type) TYPE);
+}
 
 template <>
 inline int
@@ -59,7 +76,13 @@ field_compare<FIELD_TYPE_STRING>(const char **field_a, const char **field_b)
 
 template <int TYPE>
 static inline int
-field_compare_and_next(const char **field_a, const char **field_b);
+field_compare_and_next(const char **field_a, const char **field_b)
+{
+	int r = tuple_compare_field(*field_a, *field_b, (enum field_type) TYPE);
+	mp_next(field_a);
+	mp_next(field_b);
+	return r;
+}
 
 template <>
 inline int
@@ -216,6 +239,9 @@ tuple_compare_create(const struct key_def *def) {
 		if (i == def->part_count && cmp_arr[k].p[i * 2] == UINT32_MAX)
 			return cmp_arr[k].f;
 	}
+	struct typed_comparators cmp;
+	if (typed_comparators_create(def, &cmp))
+		return cmp.compare;
 	return tuple_compare_default;
 }
 
@@ -224,7 +250,11 @@ tuple_compare_create(const struct key_def *def) {
 /* {{{ tuple_compare_with_key */
 
 template <int TYPE>
-static inline int field_compare_with_key(const char **field, const char **key);
+static inline int
+field_compare_with_key(const char **field, const char **key)
+{
+	return tuple_compare_field(*field, *key, (enum field_type) TYPE);
+}
 
 template <>
 inline int
@@ -248,7 +278,13 @@ field_compare_with_key<FIELD_TYPE_STRING>(const char **field, const char **key)
 
 template <int TYPE>
 static inline int
-field_compare_with_key_and_next(const char **field_a, const char **field_b);
+field_compare_with_key_and_next(const char **field_a, const char **field_b)
+{
+	int r = tuple_compare_field(*field_a, *field_b, (enum field_type) TYPE);
+	mp_next(field_a);
+	mp_next(field_b);
+	return r;
+}
 
 template <>
 inline int
@@ -414,7 +450,220 @@ tuple_compare_with_key_create(const struct key_def *def)
 		if (i == def->part_count)
 			return cmp_wk_arr[k].f;
 	}
+	struct typed_comparators cmp;
+	if (typed_comparators_create(def, &cmp))
+		return cmp.compare_with_key;
 	return tuple_compare_with_key_default;
 }
 
 /* }}} tuple_compare_with_key */
+
+/* {{{ typed comparators */
+
+/*
+ * The hand-picked comparators above only cover keys on the
+ * leading fields. Typed comparators cover any key_def: the types
+ * of the first TYPED_PART_MAX parts are template arguments, while
+ * field numbers are taken from the key_def at run time, so the
+ * fields are located with the field map in any order. Parts
+ * beyond TYPED_PART_MAX are compared by the generic loop.
+ */
+enum { TYPED_PART_MAX = 3 };
+
+namespace /* local symbols */ {
+
+template <int PART, int ...TYPES>
+struct TypedFieldCompare;
+
+template <int PART, int TYPE, int ...MORE_TYPES>
+struct TypedFieldCompare<PART, TYPE, MORE_TYPES...>
+{
+	inline static int compare(const struct tuple *tuple_a,
+				  const struct tuple *tuple_b,
+				  const struct tuple_format *format_a,
+				  const struct tuple_format *format_b,
+				  const struct key_def *key_def)
+	{
+		uint32_t fieldno = key_def->parts[PART].fieldno;
+		const char *field_a = tuple_field_old(format_a, tuple_a, fieldno);
+		const char *field_b = tuple_field_old(format_b, tuple_b, fieldno);
+		int r = field_compare<TYPE>(&field_a, &field_b);
+		if (r != 0)
+			return r;
+		return TypedFieldCompare<PART + 1, MORE_TYPES...>::
+			compare(tuple_a, tuple_b, format_a, format_b, key_def);
+	}
+};
+
+/**
+ * Parts which have no type in the template arguments.
+ */
+template <int PART>
+struct TypedFieldCompare<PART>
+{
+	inline static int compare(const struct tuple *tuple_a,
+				  const struct tuple *tuple_b,
+				  const struct tuple_format *format_a,
+				  const struct tuple_format *format_b,
+				  const struct key_def *key_def)
+	{
+		for (uint32_t i = PART; i < key_def->part_count; i++) {
+			const struct key_part *part = &key_def->parts[i];
+			const char *field_a =
+				tuple_field_old(format_a, tuple_a, part->fieldno);
+			const char *field_b =
+				tuple_field_old(format_b, tuple_b, part->fieldno);
+			int r = tuple_compare_field(field_a, field_b, part->type);
+			if (r != 0)
+				return r;
+		}
+		return 0;
+	}
+};
+
+template <int PART, int ...TYPES>
+struct TypedFieldCompareWithKey;
+
+template <int PART, int TYPE, int ...MORE_TYPES>
+struct TypedFieldCompareWithKey<PART, TYPE, MORE_TYPES...>
+{
+	inline static int compare(const struct tuple *tuple, const char *key,
+				  uint32_t part_count,
+				  const struct key_def *key_def,
+				  const struct tuple_format *format)
+	{
+		uint32_t fieldno = key_def->parts[PART].fieldno;
+		const char *field = tuple_field_old(format, tuple, fieldno);
+		if (part_count == PART + 1)
+			return field_compare_with_key<TYPE>(&field, &key);
+		int r = field_compare_with_key_and_next<TYPE>(&field, &key);
+		if (r != 0)
+			return r;
+		return TypedFieldCompareWithKey<PART + 1, MORE_TYPES...>::
+			compare(tuple, key, part_count, key_def, format);
+	}
+};
+
+template <int PART>
+struct TypedFieldCompareWithKey<PART>
+{
+	inline static int compare(const struct tuple *tuple, const char *key,
+				  uint32_t part_count,
+				  const struct key_def *key_def,
+				  const struct tuple_format *format)
+	{
+		for (uint32_t i = PART; i < part_count; i++) {
+			const struct key_part *part = &key_def->parts[i];
+			const char *field =
+				tuple_field_old(format, tuple, part->fieldno);
+			int r = tuple_compare_field(field, key, part->type);
+			if (r != 0)
+				return r;
+			mp_next(&key);
+		}
+		return 0;
+	}
+};
+
+/**
+ * header
+ */
+template <int ...TYPES>
+struct TypedCompare
+{
+	static int compare(const struct tuple *tuple_a,
+			   const struct tuple *tuple_b,
+			   const struct key_def *key_def)
+	{
+		return TypedFieldCompare<0, TYPES...>::
+			compare(tuple_a, tuple_b, tuple_format(tuple_a),
+				tuple_format(tuple_b), key_def);
+	}
+
+	static int compare_with_key(const struct tuple *tuple,
+				    const char *key, uint32_t part_count,
+				    const struct key_def *key_def)
+	{
+		assert(part_count <= key_def->part_count);
+		/* Part count can be 0 in wildcard searches. */
+		if (part_count == 0)
+			return 0;
+		return TypedFieldCompareWithKey<0, TYPES...>::
+			compare(tuple, key, part_count, key_def,
+				tuple_format(tuple));
+	}
+};
+
+/**
+ * Pick the template arguments for TypedCompare one part at a
+ * time. IS_LAST is set when TYPED_PART_MAX types are chosen.
+ */
+template <bool IS_LAST, int ...TYPES>
+struct TypedCompareFactory;
+
+template <int ...TYPES>
+struct TypedCompareFactory<true, TYPES...>
+{
+	static bool create(const struct key_def *,
+			   struct typed_comparators *cmp)
+	{
+		cmp->compare = TypedCompare<TYPES...>::compare;
+		cmp->compare_with_key = TypedCompare<TYPES...>::compare_with_key;
+		return true;
+	}
+};
+
+template <int ...TYPES>
+struct TypedCompareFactory<false, TYPES...>
+{
+	template <int TYPE>
+	using Next = TypedCompareFactory<sizeof...(TYPES) + 1 ==
+					 TYPED_PART_MAX, TYPES..., TYPE>;
+
+	static bool create(const struct key_def *def,
+			   struct typed_comparators *cmp)
+	{
+		uint32_t part = sizeof...(TYPES);
+		if (part == def->part_count)
+			return TypedCompareFactory<true, TYPES...>::
+				create(def, cmp);
+		switch (def->parts[part].type) {
+		case FIELD_TYPE_UNSIGNED:
+			return Next<FIELD_TYPE_UNSIGNED>::create(def, cmp);
+		case FIELD_TYPE_STRING:
+			return Next<FIELD_TYPE_STRING>::create(def, cmp);
+		case FIELD_TYPE_INTEGER:
+			return Next<FIELD_TYPE_INTEGER>::create(def, cmp);
+		case FIELD_TYPE_NUMBER:
+			return Next<FIELD_TYPE_NUMBER>::create(def, cmp);
+		case FIELD_TYPE_SCALAR:
+			return Next<FIELD_TYPE_SCALAR>::create(def, cmp);
+		default:
+			/* ANY and ARRAY are not comparable. */
+			return false;
+		}
+	}
+};
+
+} /* end of anonymous namespace */
+
+/**
+ * Find typed comparators for a key_def.
+ * Returns false if some part type has no typed comparator.
+ */
+static bool
+typed_comparators_create(const struct key_def *def,
+			 struct typed_comparators *cmp)
+{
+	if (def->part_count == 0)
+		return false;
+	/* All parts must be comparable, including the untyped tail. */
+	for (uint32_t i = TYPED_PART_MAX; i < def->part_count; i++) {
+		if (def->parts[i].type == FIELD_TYPE_ANY ||
+		    def->parts[i].type == FIELD_TYPE_ARRAY)
+			return false;
+	}
+	return TypedCompareFactory<false>::create(def, cmp);
+}
+
+/* }}} typed comparators */
@@ -75,16 +75,22 @@ tuple_format_register(struct tuple_format *format)
 		format->id = (uint16_t) recycled_format_ids;
 		recycled_format_ids = (intptr_t) tuple_formats[recycled_format_ids];
 	} else {
-		if (formats_size == formats_capacity) {
-			uint32_t new_capacity = formats_capacity ?
-						formats_capacity * 2 : 16;
+		if (formats_capacity == 0) {
+			/*
+			 * The table is allocated once and is never
+			 * moved: tuple_format() is called by
+			 * iproto threads serving memtx read views,
+			 * see memtx_read_view.h. Untouched pages of
+			 * the table do not consume memory.
+			 */
+			uint32_t new_capacity = FORMAT_ID_MAX + 1;
 			struct tuple_format **formats;
 			formats = (struct tuple_format **)
-				realloc(tuple_formats, new_capacity *
-						       sizeof(tuple_formats[0]));
+				calloc(new_capacity, sizeof(tuple_formats[0]));
 			if (formats == NULL)
 				tnt_raise(OutOfMemory,
-					  sizeof(struct tuple_format),
+					  new_capacity *
+					  sizeof(tuple_formats[0]),
 					  "malloc", "tuple_formats");
 
 			formats_capacity = new_capacity;
@@ -39,6 +39,7 @@
 #include "xrow.h"
 
 double too_long_threshold;
+uint64_t txn_write_count;
 
 static inline void
 fiber_set_txn(struct fiber *fiber, struct txn *txn)
@@ -134,6 +135,7 @@ txn_begin_stmt(struct space *space)
 	stmt->space = space;
 
 	engine->beginStatement(txn);
+	txn_write_count++;
 	return txn;
 }
 
@@ -41,6 +41,11 @@
 #include "salad/stailq.h"
 
 extern double too_long_threshold;
+/**
+ * The number of data change statements begun so far, tells
+ * readers which keep tuples that the data may have changed.
+ */
+extern uint64_t txn_write_count;
 struct tuple;
 
 /**
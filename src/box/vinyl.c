@@ -42,6 +42,9 @@
 #include <small/region.h>
 #include <msgpuck/msgpuck.h>
 #include <coeio_file.h>
+#include <lz4.h>
+#include <lz4hc.h>
+#include <zstd.h>
 
 #include "trivia/util.h"
 #include "crc32.h"
@@ -66,6 +69,8 @@
 
 #define HEAP_FORWARD_DECLARATION
 #include "salad/heap.h"
+#include "salad/bloom.h"
+#include "third_party/PMurHash.h"
 
 #define vy_cmp(a, b) \
 	((a) == (b) ? 0 : (((a) > (b)) ? 1 : -1))
@@ -83,6 +88,8 @@ struct vy_conf;
 struct vy_quota;
 struct tx_manager;
 struct vy_scheduler;
+struct vy_page_read_pool;
+struct vy_page_cache;
 struct vy_task;
 struct vy_stat;
 struct srzone;
@@ -95,8 +102,19 @@ struct vy_env {
 	struct vy_quota     *quota;
 	struct tx_manager   *xm;
 	struct vy_scheduler *scheduler;
+	struct vy_page_read_pool *read_pool;
+	struct vy_page_cache *page_cache;
 	struct vy_stat      *stat;
 	struct mempool      cursor_pool;
+	/**
+	 * The number of read iterators open in the TX thread.
+	 * A read iterator may yield while waiting for a page
+	 * to be loaded by the read pool, so ranges can't be
+	 * freed while there are active readers.
+	 */
+	int active_reads;
+	/** Ranges waiting for active_reads to drop to 0. */
+	struct rlist retired_ranges;
 };
 
 static struct srzone *
@@ -483,6 +501,9 @@ static int
 vy_tuple_compare(const char *tuple_data_a, const char *tuple_data_b,
 		 const struct key_def *key_def);
 
+static uint32_t
+vy_tuple_hash(const char *tuple_data, const struct key_def *key_def);
+
 static struct vy_tuple *
 vy_tuple_from_key(struct vy_index *index, const char *key,
 			  uint32_t part_count);
@@ -708,6 +729,14 @@ struct PACKED vy_run_info {
 
 	uint64_t  total;
 	uint64_t  totalorigin;
+	/** Number of bloom filter probes, 0 if there's no filter. */
+	uint32_t  bloom_hash_count;
+	/** Size of the bloom filter table. */
+	uint32_t  bloom_size;
+	/** Offset of the bloom filter table in the file. */
+	uint64_t  bloom_offset;
+	/** Page compression, enum index_compression_type. */
+	uint32_t  compression;
 };
 
 struct PACKED vy_page_info {
@@ -751,6 +780,13 @@ struct vy_run {
 	struct vy_run_info info;
 	struct vy_buf pages, minmax;
 	struct vy_run *next;
+	/** Pages of this run stored in the page cache. */
+	struct rlist cached_pages;
+	/**
+	 * Bloom filter of full keys stored in the run,
+	 * bloom.table is NULL if the run has no filter.
+	 */
+	struct bloom bloom;
 };
 
 struct vy_range {
@@ -777,6 +813,8 @@ struct vy_range {
 	struct heap_node   nodecompact;
 	struct heap_node   nodedump;
 	uint32_t range_version;
+	/** Link in vy_env->retired_ranges. */
+	struct rlist in_retired;
 };
 
 typedef rb_tree(struct vy_range) vy_range_tree_t;
@@ -1280,12 +1318,22 @@ vy_tx_rollback(struct vy_env *e, struct vy_tx *tx)
 }
 
 struct vy_page {
+	/** The run the page was read from */
+	struct vy_run *run;
 	/** Page position in the run file */
 	uint32_t page_no;
 	/** The number of tuples */
 	uint32_t count;
 	/** Size of raw page data */
 	uint32_t size;
+	/** Reference counter, see vy_page_ref()/vy_page_unref() */
+	int refs;
+	/** The page cache the page is stored in or NULL */
+	struct vy_page_cache *cache;
+	/** Link in vy_page_cache::lru */
+	struct rlist in_lru;
+	/** Link in vy_run::cached_pages */
+	struct rlist in_run;
 	/** Raw page data */
 	char data[0];
 };
@@ -1345,7 +1393,7 @@ vy_run_size(struct vy_run *run)
 {
 	return sizeof(run->info) +
 	       run->info.count * sizeof(struct vy_page_info) +
-	       run->info.minmax_size;
+	       run->info.minmax_size + run->info.bloom_size;
 }
 
 static int
@@ -1366,12 +1414,23 @@ vy_run_new()
 	vy_buf_create(&run->minmax);
 	memset(&run->info, 0, sizeof(run->info));
 	run->next = NULL;
+	rlist_create(&run->cached_pages);
+	memset(&run->bloom, 0, sizeof(run->bloom));
 	return run;
 }
 
+static void
+vy_page_cache_evict(struct vy_page_cache *cache, struct vy_page *page);
+
 static void
 vy_run_delete(struct vy_run *run)
 {
+	/* Drop pages of the run from the page cache. */
+	struct vy_page *page, *tmp;
+	rlist_foreach_entry_safe(page, &run->cached_pages, in_run, tmp)
+		vy_page_cache_evict(page->cache, page);
+	if (run->bloom.table != NULL)
+		bloom_destroy(&run->bloom);
 	vy_buf_destroy(&run->pages);
 	vy_buf_destroy(&run->minmax);
 	TRASH(run);
@@ -1412,29 +1471,413 @@ vy_pread_file(int fd, void *buf, uint32_t size, off_t offset)
 	return pos;
 }
 
+/** {{{ Page compression */
+
+#ifndef LZ4HC_CLEVEL_MAX
+#define LZ4HC_CLEVEL_MAX 12
+#endif
+
+int
+vy_compression_level_max(uint32_t compression)
+{
+	switch (compression) {
+	case INDEX_COMPRESSION_LZ4:
+		return LZ4HC_CLEVEL_MAX;
+	case INDEX_COMPRESSION_ZSTD:
+		return ZSTD_maxCLevel();
+	default:
+		return 0;
+	}
+}
+
+/**
+ * Compress page data and append it to the buffer.
+ * @param level compression level, 0 for the codec default
+ */
+static int
+vy_page_compress(enum index_compression_type compression, int level,
+		 const char *src, uint32_t src_size, struct vy_buf *dst)
+{
+	switch (compression) {
+	case INDEX_COMPRESSION_LZ4: {
+		int bound = LZ4_compressBound(src_size);
+		if (vy_buf_ensure(dst, bound))
+			return -1;
+		int size = level > 0 ?
+			LZ4_compress_HC(src, dst->p, src_size, bound, level) :
+			LZ4_compress_default(src, dst->p, src_size, bound);
+		if (size <= 0) {
+			vy_error("%s", "lz4 compression failed");
+			return -1;
+		}
+		vy_buf_advance(dst, size);
+		return 0;
+	}
+	case INDEX_COMPRESSION_ZSTD: {
+		size_t bound = ZSTD_compressBound(src_size);
+		if (vy_buf_ensure(dst, bound))
+			return -1;
+		/* Level 0 selects the zstd default level. */
+		size_t size = ZSTD_compress(dst->p, bound, src, src_size,
+					    level);
+		if (ZSTD_isError(size)) {
+			vy_error("zstd compression failed: %s",
+				 ZSTD_getErrorName(size));
+			return -1;
+		}
+		vy_buf_advance(dst, size);
+		return 0;
+	}
+	default:
+		unreachable();
+		return -1;
+	}
+}
+
+/**
+ * Decompress page data.
+ * Runs in reader threads, so doesn't touch the diagnostics area.
+ * @retval >= 0 size of decompressed data
+ * @retval -1 malformed data, errno is set to EBADMSG
+ */
+static ssize_t
+vy_page_decompress(uint32_t compression, const char *src, uint32_t src_size,
+		   char *dst, uint32_t dst_capacity)
+{
+	ssize_t size = -1;
+	switch (compression) {
+	case INDEX_COMPRESSION_LZ4:
+		size = LZ4_decompress_safe(src, dst, src_size, dst_capacity);
+		break;
+	case INDEX_COMPRESSION_ZSTD: {
+		size_t rc = ZSTD_decompress(dst, dst_capacity, src, src_size);
+		if (!ZSTD_isError(rc))
+			size = rc;
+		break;
+	}
+	default:
+		/* Unknown codec, the run was written by a newer version. */
+		break;
+	}
+	if (size < 0) {
+		errno = EBADMSG;
+		return -1;
+	}
+	return size;
+}
+
 /**
- * Load from page with given number
- * If the page is loaded by somebody else, it's returned from cache
- * In every case increments page's reference counter
- * After usage user must call vy_run_unload_page
+ * Read a page from the run file and decompress it if necessary.
+ * @param data buffer of page_info->unpacked_size bytes if the
+ *        page is compressed, page_info->size bytes otherwise
+ * @retval >= 0 size of page data
+ * @retval -1 error, errno is set
+ */
+static ssize_t
+vy_page_read_data(int fd, const struct vy_page_info *page_info,
+		  uint32_t compression, char *data)
+{
+	if (compression == INDEX_COMPRESSION_NONE)
+		return vy_pread_file(fd, data, page_info->size,
+				     page_info->offset);
+	char *packed = malloc(page_info->size);
+	if (packed == NULL) {
+		errno = ENOMEM;
+		return -1;
+	}
+	ssize_t rc = vy_pread_file(fd, packed, page_info->size,
+				   page_info->offset);
+	if (rc == (ssize_t) page_info->size) {
+		rc = vy_page_decompress(compression, packed, page_info->size,
+					data, page_info->unpacked_size);
+	} else if (rc >= 0) {
+		errno = EBADMSG; /* truncated page */
+		rc = -1;
+	}
+	free(packed);
+	return rc;
+}
+
+/** }}} Page compression */
+
+/** {{{ Page read pool */
+
+/**
+ * A request to read a page of a run file. Allocated on the
+ * stack of the fiber which needs the page and executed by
+ * one of the read pool threads, which also decompress the page.
+ */
+struct vy_page_read_task {
+	/** Link in the input or output queue of the pool. */
+	struct stailq_entry link;
+	/** Run file descriptor. */
+	int fd;
+	/** Page to read. */
+	const struct vy_page_info *page_info;
+	/** Page compression of the run. */
+	uint32_t compression;
+	/** Destination buffer. */
+	char *buf;
+	/** Return value of vy_page_read_data(). */
+	ssize_t rc;
+	/** errno set by a failed read. */
+	int error;
+	/** The fiber waiting for the page. */
+	struct fiber *fiber;
+	/** Set when the task is returned to the TX thread. */
+	bool is_done;
+};
+
+/**
+ * A pool of threads loading run pages on behalf of TX fibers,
+ * so that a page cache miss doesn't stall the event loop: the
+ * reading fiber yields until the page arrives.
+ * The pool size is vinyl.read_threads, 0 means that pages
+ * are read synchronously.
+ */
+struct vy_page_read_pool {
+	pthread_mutex_t mutex;
+	/**
+	 * There is a pending task for readers in the pool,
+	 * or we want to shutdown readers.
+	 */
+	pthread_cond_t reader_cond;
+	/** Tasks not yet taken by a reader. */
+	struct stailq input_queue;
+	/** Tasks processed by readers. */
+	struct stailq output_queue;
+	struct cord *reader_pool;
+	int reader_pool_size;
+	bool is_reader_pool_running;
+	/** TX thread loop and a watcher to deliver processed tasks. */
+	struct ev_loop *loop;
+	struct ev_async output_async;
+};
+
+/**
+ * Wake up fibers waiting for processed tasks.
+ */
+static void
+vy_page_read_pool_complete(struct stailq *output_queue)
+{
+	struct vy_page_read_task *task, *next;
+	stailq_foreach_entry_safe(task, next, output_queue, link) {
+		/* The task may be freed as soon as the fiber runs. */
+		task->is_done = true;
+		fiber_wakeup(task->fiber);
+	}
+}
+
+static void
+vy_page_read_pool_async_cb(ev_loop *loop, struct ev_async *watcher,
+			   int events)
+{
+	(void) loop;
+	(void) events;
+	struct vy_page_read_pool *pool =
+		container_of(watcher, struct vy_page_read_pool, output_async);
+	struct stailq output_queue;
+	stailq_create(&output_queue);
+	tt_pthread_mutex_lock(&pool->mutex);
+	stailq_concat(&output_queue, &pool->output_queue);
+	tt_pthread_mutex_unlock(&pool->mutex);
+	vy_page_read_pool_complete(&output_queue);
+}
+
+static int
+vy_page_reader_f(va_list va)
+{
+	struct vy_page_read_pool *pool =
+		va_arg(va, struct vy_page_read_pool *);
+
+	tt_pthread_mutex_lock(&pool->mutex);
+	while (pool->is_reader_pool_running) {
+		/* Wait for a task */
+		if (stailq_empty(&pool->input_queue)) {
+			tt_pthread_cond_wait(&pool->reader_cond,
+					     &pool->mutex);
+			continue;
+		}
+		struct vy_page_read_task *task =
+			stailq_shift_entry(&pool->input_queue,
+					   struct vy_page_read_task, link);
+		tt_pthread_mutex_unlock(&pool->mutex);
+
+		/* Execute task */
+		task->rc = vy_page_read_data(task->fd, task->page_info,
+					     task->compression, task->buf);
+		task->error = task->rc < 0 ? errno : 0;
+
+		/* Return processed task to TX */
+		tt_pthread_mutex_lock(&pool->mutex);
+		bool was_empty = stailq_empty(&pool->output_queue);
+		stailq_add_tail_entry(&pool->output_queue, task, link);
+		if (was_empty)
+			ev_async_send(pool->loop, &pool->output_async);
+	}
+	tt_pthread_mutex_unlock(&pool->mutex);
+	return 0;
+}
+
+static struct vy_page_read_pool *
+vy_page_read_pool_new(int reader_pool_size)
+{
+	struct vy_page_read_pool *pool = calloc(1, sizeof(*pool));
+	if (pool == NULL) {
+		diag_set(OutOfMemory, sizeof(*pool), "read_pool",
+			 "struct");
+		return NULL;
+	}
+	tt_pthread_mutex_init(&pool->mutex, NULL);
+	tt_pthread_cond_init(&pool->reader_cond, NULL);
+	stailq_create(&pool->input_queue);
+	stailq_create(&pool->output_queue);
+	pool->reader_pool_size = reader_pool_size;
+	pool->loop = loop();
+	ev_async_init(&pool->output_async, vy_page_read_pool_async_cb);
+	return pool;
+}
+
+/**
+ * Start reader threads. Called on demand, on the first read,
+ * to not create threads before the daemon has forked.
+ */
+static void
+vy_page_read_pool_start(struct vy_page_read_pool *pool)
+{
+	assert(!pool->is_reader_pool_running);
+	assert(pool->reader_pool_size > 0);
+
+	pool->is_reader_pool_running = true;
+	pool->reader_pool = (struct cord *)
+		calloc(pool->reader_pool_size, sizeof(struct cord));
+	if (pool->reader_pool == NULL)
+		panic("failed to allocate vinyl reader pool");
+	ev_async_start(pool->loop, &pool->output_async);
+	for (int i = 0; i < pool->reader_pool_size; i++) {
+		cord_costart(&pool->reader_pool[i], "vinyl.reader",
+			     vy_page_reader_f, pool);
+	}
+}
+
+static void
+vy_page_read_pool_stop(struct vy_page_read_pool *pool)
+{
+	assert(pool->is_reader_pool_running);
+
+	/* Wake up and join reader threads */
+	tt_pthread_mutex_lock(&pool->mutex);
+	pool->is_reader_pool_running = false;
+	pthread_cond_broadcast(&pool->reader_cond);
+	tt_pthread_mutex_unlock(&pool->mutex);
+	for (int i = 0; i < pool->reader_pool_size; i++)
+		cord_join(&pool->reader_pool[i]);
+	free(pool->reader_pool);
+	pool->reader_pool = NULL;
+	ev_async_stop(pool->loop, &pool->output_async);
+
+	/* Fail all tasks which weren't taken by readers */
+	struct vy_page_read_task *task;
+	stailq_foreach_entry(task, &pool->input_queue, link) {
+		task->rc = -1;
+		task->error = ECANCELED;
+	}
+	stailq_concat(&pool->output_queue, &pool->input_queue);
+	vy_page_read_pool_complete(&pool->output_queue);
+	stailq_create(&pool->output_queue);
+}
+
+static void
+vy_page_read_pool_delete(struct vy_page_read_pool *pool)
+{
+	if (pool->is_reader_pool_running)
+		vy_page_read_pool_stop(pool);
+	TRASH(&pool->output_async);
+	tt_pthread_cond_destroy(&pool->reader_cond);
+	tt_pthread_mutex_destroy(&pool->mutex);
+	free(pool);
+}
+
+/**
+ * Read a page in a reader thread, see vy_page_read_data().
+ * Yields the current fiber until the read is complete. Falls
+ * back to a blocking read if the pool is disabled or the caller
+ * isn't in the TX thread (e.g. a write iterator in a worker
+ * thread).
+ */
+static ssize_t
+vy_page_read_pool_read(struct vy_page_read_pool *pool, int fd,
+		       const struct vy_page_info *page_info,
+		       uint32_t compression, char *buf)
+{
+	if (pool->reader_pool_size == 0 || !cord_is_main())
+		return vy_page_read_data(fd, page_info, compression, buf);
+	if (!pool->is_reader_pool_running)
+		vy_page_read_pool_start(pool);
+
+	struct vy_page_read_task task;
+	task.fd = fd;
+	task.page_info = page_info;
+	task.compression = compression;
+	task.buf = buf;
+	task.rc = -1;
+	task.error = 0;
+	task.fiber = fiber();
+	task.is_done = false;
+
+	tt_pthread_mutex_lock(&pool->mutex);
+	bool was_empty = stailq_empty(&pool->input_queue);
+	stailq_add_tail_entry(&pool->input_queue, &task, link);
+	if (was_empty)                  /* Notify readers */
+		tt_pthread_cond_signal(&pool->reader_cond);
+	tt_pthread_mutex_unlock(&pool->mutex);
+
+	/*
+	 * The buffer and the task belong to this fiber, so wait
+	 * for the reader even if the fiber is woken up or
+	 * cancelled by someone else.
+	 */
+	while (!task.is_done)
+		fiber_yield();
+	if (task.rc < 0)
+		errno = task.error;
+	return task.rc;
+}
+
+/** }}} Page read pool */
+
+/**
+ * Read a page with the given number from the run file.
+ * The page is returned with the reference counter set to 1,
+ * the caller must call vy_page_unref() after usage.
  */
 static struct vy_page *
-vy_run_read_page(struct vy_run *run, uint32_t page_no, int fd)
+vy_run_read_page(struct vy_env *env, struct vy_run *run, uint32_t page_no,
+		 int fd)
 {
 	struct vy_page_info *page_info = vy_run_page(run, page_no);
-	struct vy_page *page = malloc(sizeof(*page) + page_info->size);
+	uint32_t compression = run->info.compression;
+	uint32_t data_size = compression == INDEX_COMPRESSION_NONE ?
+			     page_info->size : page_info->unpacked_size;
+	struct vy_page *page = malloc(sizeof(*page) + data_size);
 	if (page == NULL) {
-		diag_set(OutOfMemory, sizeof(*page) + page_info->size,
+		diag_set(OutOfMemory, sizeof(*page) + data_size,
 			"load_page", "page cache");
 		return NULL;
 	}
 
+	page->run = run;
 	page->page_no = page_no;
 	page->count = page_info->count;
 	page->size = page_info->size;
+	page->refs = 1;
+	page->cache = NULL;
+	rlist_create(&page->in_lru);
+	rlist_create(&page->in_run);
 
-	int rc = vy_pread_file(fd, page->data, page_info->size,
-				  page_info->offset);
+	/* May yield, see vy_page_read_pool_read(). */
+	ssize_t rc = vy_page_read_pool_read(env->read_pool, fd, page_info,
+					    compression, page->data);
 
 	if (rc < 0) {
 		free(page);
@@ -1443,6 +1886,8 @@ vy_run_read_page(struct vy_run *run, uint32_t page_no, int fd)
 			 strerror(errno));
 		return NULL;
 	}
+	/* Size of decompressed data */
+	page->size = rc;
 
 	return page;
 }
@@ -1456,6 +1901,226 @@ vy_page_delete(struct vy_page *page)
 	free(page);
 }
 
+static void
+vy_page_ref(struct vy_page *page)
+{
+	assert(page->refs > 0);
+	page->refs++;
+}
+
+static void
+vy_page_unref(struct vy_page *page)
+{
+	assert(page->refs > 0);
+	if (--page->refs == 0) {
+		assert(page->cache == NULL);
+		vy_page_delete(page);
+	}
+}
+
+/** {{{ Page cache */
+
+/**
+ * Pages read by the TX thread are shared between all run
+ * iterators through the page cache. The cache is limited
+ * by vinyl.cache_size bytes, least recently used pages are
+ * evicted first. A page evicted while in use by an iterator
+ * is freed when the iterator drops its reference.
+ *
+ * Pages read by worker threads bypass the cache.
+ */
+struct vy_page_cache {
+	/** (run, page_no) -> struct vy_page */
+	struct mh_vy_page_t *hash;
+	/** Cached pages, the most recently used first. */
+	struct rlist lru;
+	/** Memory used by cached pages, in bytes. */
+	uint64_t mem_used;
+	/** Memory limit, in bytes. */
+	uint64_t mem_quota;
+	/** Number of page lookups served from the cache. */
+	uint64_t hit;
+	/** Number of page lookups that went to the disk. */
+	uint64_t miss;
+};
+
+struct vy_page_cache_key {
+	struct vy_run *run;
+	uint32_t page_no;
+};
+
+static inline uint32_t
+vy_page_cache_hash(const struct vy_run *run, uint32_t page_no)
+{
+	uintptr_t h = (uintptr_t) run;
+	h ^= h >> 16;
+	return (uint32_t) h ^ (page_no * 2654435761U);
+}
+
+#define mh_name _vy_page
+#define mh_key_t const struct vy_page_cache_key *
+#define mh_node_t struct vy_page *
+#define mh_arg_t void *
+#define mh_hash(a, arg) (vy_page_cache_hash((*(a))->run, (*(a))->page_no))
+#define mh_hash_key(a, arg) (vy_page_cache_hash((a)->run, (a)->page_no))
+#define mh_cmp(a, b, arg) ((*(a))->run != (*(b))->run || \
+			   (*(a))->page_no != (*(b))->page_no)
+#define mh_cmp_key(a, b, arg) ((a)->run != (*(b))->run || \
+			       (a)->page_no != (*(b))->page_no)
+#define MH_SOURCE 1
+#include "salad/mhash.h"
+
+static inline size_t
+vy_page_mem_size(struct vy_page *page)
+{
+	return sizeof(*page) + page->size;
+}
+
+static struct vy_page_cache *
+vy_page_cache_new(uint64_t mem_quota)
+{
+	struct vy_page_cache *cache = calloc(1, sizeof(*cache));
+	if (cache == NULL) {
+		diag_set(OutOfMemory, sizeof(*cache), "page cache",
+			 "struct vy_page_cache");
+		return NULL;
+	}
+	cache->hash = mh_vy_page_new();
+	if (cache->hash == NULL) {
+		diag_set(OutOfMemory, sizeof(*cache->hash), "page cache",
+			 "hash");
+		free(cache);
+		return NULL;
+	}
+	rlist_create(&cache->lru);
+	cache->mem_quota = mem_quota;
+	return cache;
+}
+
+/**
+ * Remove a page from the cache and drop the cache's reference.
+ */
+static void
+vy_page_cache_evict(struct vy_page_cache *cache, struct vy_page *page)
+{
+	assert(page->cache == cache);
+	struct vy_page_cache_key key = { page->run, page->page_no };
+	mh_int_t pos = mh_vy_page_find(cache->hash, &key, NULL);
+	assert(pos != mh_end(cache->hash));
+	mh_vy_page_del(cache->hash, pos, NULL);
+	rlist_del_entry(page, in_lru);
+	rlist_del_entry(page, in_run);
+	cache->mem_used -= vy_page_mem_size(page);
+	page->cache = NULL;
+	vy_page_unref(page);
+}
+
+static void
+vy_page_cache_delete(struct vy_page_cache *cache)
+{
+	struct vy_page *page, *tmp;
+	rlist_foreach_entry_safe(page, &cache->lru, in_lru, tmp)
+		vy_page_cache_evict(cache, page);
+	mh_vy_page_delete(cache->hash);
+	TRASH(cache);
+	free(cache);
+}
+
+/**
+ * Look up a page in the cache.
+ * @retval page with incremented reference counter if found
+ * @retval NULL otherwise
+ */
+static struct vy_page *
+vy_page_cache_get(struct vy_page_cache *cache, struct vy_run *run,
+		  uint32_t page_no)
+{
+	struct vy_page_cache_key key = { run, page_no };
+	mh_int_t pos = mh_vy_page_find(cache->hash, &key, NULL);
+	if (pos == mh_end(cache->hash)) {
+		cache->miss++;
+		return NULL;
+	}
+	cache->hit++;
+	struct vy_page *page = *mh_vy_page_node(cache->hash, pos);
+	rlist_move_entry(&cache->lru, page, in_lru);
+	vy_page_ref(page);
+	return page;
+}
+
+/**
+ * Insert a page just read from the disk into the cache and
+ * evict least recently used pages if the cache is full.
+ * If another fiber has cached the same page while this one was
+ * waiting for the disk, the given page is dropped and the cached
+ * one is returned instead.
+ *
+ * Failure to cache a page isn't an error: the page is still
+ * returned to the caller, only it isn't shared.
+ */
+static struct vy_page *
+vy_page_cache_put(struct vy_page_cache *cache, struct vy_page *page)
+{
+	assert(page->cache == NULL);
+	struct vy_page_cache_key key = { page->run, page->page_no };
+	mh_int_t pos = mh_vy_page_find(cache->hash, &key, NULL);
+	if (pos != mh_end(cache->hash)) {
+		struct vy_page *cached = *mh_vy_page_node(cache->hash, pos);
+		vy_page_ref(cached);
+		vy_page_unref(page);
+		return cached;
+	}
+	size_t size = vy_page_mem_size(page);
+	if (size > cache->mem_quota)
+		return page;
+	if (mh_vy_page_put(cache->hash, &page, NULL, NULL) ==
+	    mh_end(cache->hash))
+		return page;
+	page->cache = cache;
+	rlist_add_entry(&cache->lru, page, in_lru);
+	rlist_add_entry(&page->run->cached_pages, page, in_run);
+	cache->mem_used += size;
+	vy_page_ref(page);
+	while (cache->mem_used > cache->mem_quota) {
+		struct vy_page *victim = rlist_last_entry(&cache->lru,
+							  struct vy_page,
+							  in_lru);
+		assert(victim != page);
+		vy_page_cache_evict(cache, victim);
+	}
+	return page;
+}
+
+/**
+ * Get a page of a run, from the page cache if possible.
+ * Updates read_cache/read_disk statistics of the index.
+ * The caller must call vy_page_unref() after usage.
+ */
+static struct vy_page *
+vy_index_load_page(struct vy_index *index, struct vy_run *run,
+		   uint32_t page_no, int fd)
+{
+	struct vy_env *env = index->env;
+	if (!cord_is_main()) {
+		/* The cache is not thread-safe. */
+		return vy_run_read_page(env, run, page_no, fd);
+	}
+	struct vy_page *page = vy_page_cache_get(env->page_cache,
+						 run, page_no);
+	if (page != NULL) {
+		index->read_cache++;
+		return page;
+	}
+	/* May yield. */
+	page = vy_run_read_page(env, run, page_no, fd);
+	if (page == NULL)
+		return NULL;
+	index->read_disk++;
+	return vy_page_cache_put(env->page_cache, page);
+}
+
+/** }}} Page cache */
+
 static int64_t
 vy_range_mem_min_lsn(struct vy_range *range)
 {
@@ -1789,14 +2454,15 @@ vy_write_iterator_delete(struct vy_write_iterator *wi);
 static int
 vy_run_write_page(struct vy_run *run, int fd, struct vy_write_iterator *wi,
 		  struct vy_tuple *split_key, struct key_def *key_def,
-		  uint32_t page_size)
+		  uint32_t page_size, struct vy_buf *key_hashes)
 {
 	struct vy_run_info *run_info = &run->info;
 	bool run_done = false;
 
-	struct vy_buf tuplesinfo, values, compressed;
+	struct vy_buf tuplesinfo, values, raw, compressed;
 	vy_buf_create(&tuplesinfo);
 	vy_buf_create(&values);
+	vy_buf_create(&raw);
 	vy_buf_create(&compressed);
 
 	if (vy_buf_ensure(&run->pages, sizeof(struct vy_page_info)))
@@ -1823,20 +2489,42 @@ vy_run_write_page(struct vy_run *run, int fd, struct vy_write_iterator *wi,
 			break;
 		if (vy_run_dump_tuple(tuple, &tuplesinfo, &values, page) != 0)
 			goto err;
+		if (key_hashes != NULL) {
+			if (vy_buf_ensure(key_hashes, sizeof(uint32_t)))
+				goto err;
+			*(uint32_t *) key_hashes->p =
+				vy_tuple_hash(tuple->data, key_def);
+			vy_buf_advance(key_hashes, sizeof(uint32_t));
+		}
 		vy_write_iterator_next(wi);
 	}
 	page->unpacked_size = vy_buf_used(&tuplesinfo) + vy_buf_used(&values);
 	page->unpacked_size = ALIGN_POS(page->unpacked_size);
 
-	vy_buf_ensure(&compressed, page->unpacked_size);
-	memcpy(compressed.p, tuplesinfo.s, vy_buf_used(&tuplesinfo));
-	vy_buf_advance(&compressed, vy_buf_used(&tuplesinfo));
-	memcpy(compressed.p, values.s, vy_buf_used(&values));
-	vy_buf_advance(&compressed, vy_buf_used(&values));
+	if (vy_buf_ensure(&raw, page->unpacked_size))
+		goto err;
+	memcpy(raw.p, tuplesinfo.s, vy_buf_used(&tuplesinfo));
+	vy_buf_advance(&raw, vy_buf_used(&tuplesinfo));
+	memcpy(raw.p, values.s, vy_buf_used(&values));
+	vy_buf_advance(&raw, vy_buf_used(&values));
+
+	/* Compress the page if requested, see vy_page_read_data(). */
+	struct vy_buf *data = &raw;
+	if (key_def->opts.compression != INDEX_COMPRESSION_NONE) {
+		if (vy_page_compress(key_def->opts.compression,
+				     key_def->opts.compression_level,
+				     raw.s, vy_buf_used(&raw),
+				     &compressed) != 0)
+			goto err;
+		data = &compressed;
+	}
 
-	page->size = vy_buf_used(&compressed);
-	vy_write_file(fd, compressed.s, page->size);
-	page->crc = crc32_calc(0, compressed.s, vy_buf_used(&compressed));
+	page->size = vy_buf_used(data);
+	if (vy_write_file(fd, data->s, page->size) < 0) {
+		vy_error("index file write error: %s", strerror(errno));
+		goto err;
+	}
+	page->crc = crc32_calc(0, data->s, vy_buf_used(data));
 
 	if (page->count > 0) {
 		struct vy_buf *minmax_buf = &run->minmax;
@@ -1871,31 +2559,68 @@ vy_run_write_page(struct vy_run *run, int fd, struct vy_write_iterator *wi,
 
 	run_info->keys += page->count;
 
+	vy_buf_destroy(&raw);
 	vy_buf_destroy(&compressed);
 	vy_buf_destroy(&tuplesinfo);
 	vy_buf_destroy(&values);
 	return run_done ? 1 : 0;
 err:
+	vy_buf_destroy(&raw);
 	vy_buf_destroy(&compressed);
 	vy_buf_destroy(&tuplesinfo);
 	vy_buf_destroy(&values);
 	return -1;
 }
 
+/**
+ * Build the bloom filter of a run from hashes of its keys
+ * and write it to the file.
+ */
+static int
+vy_run_write_bloom(struct vy_run *run, int fd, struct vy_buf *key_hashes,
+		   double bloom_fpr)
+{
+	struct vy_run_info *header = &run->info;
+	uint32_t count = vy_buf_used(key_hashes) / sizeof(uint32_t);
+	if (bloom_create(&run->bloom, count, bloom_fpr) != 0) {
+		diag_set(OutOfMemory, count, "bloom_create",
+			 "struct bloom");
+		return -1;
+	}
+	uint32_t *hashes = (uint32_t *) key_hashes->s;
+	for (uint32_t i = 0; i < count; i++)
+		bloom_add(&run->bloom, hashes[i]);
+
+	header->bloom_offset = header->offset + header->size;
+	header->bloom_size = bloom_store_size(&run->bloom);
+	header->bloom_hash_count = run->bloom.hash_count;
+	if (vy_write_file(fd, run->bloom.table, header->bloom_size) == -1)
+		return -1;
+	header->size += header->bloom_size;
+	return 0;
+}
+
 /**
  * Write tuples from the iterator to a new run
  * and set up the corresponding run index structures.
+ * Unless bloom_fpr is 1, a bloom filter of the run keys
+ * is built and stored after the page index. Pages are
+ * compressed as set by key_def->opts.compression.
  */
 static int
 vy_run_write(int fd, struct vy_write_iterator *wi,
 	     struct vy_tuple *split_key, struct key_def *key_def,
-	     uint32_t page_size, struct vy_run **result)
+	     uint32_t page_size, double bloom_fpr, struct vy_run **result)
 {
 	int rc = 0;
 	struct vy_run *run = vy_run_new();
 	if (!run)
 		return -1;
 
+	struct vy_buf key_hashes;
+	vy_buf_create(&key_hashes);
+	bool has_bloom = bloom_fpr < 1;
+
 	struct vy_run_info *header = &run->info;
 	/*
 	 * Store start run offset in file. In case of run write
@@ -1913,6 +2638,7 @@ vy_run_write(int fd, struct vy_write_iterator *wi,
 		FILE_ALIGN
 	};
 	header->min_lsn = INT64_MAX;
+	header->compression = key_def->opts.compression;
 
 	/* write run info header and adjust size */
 	uint32_t header_size = sizeof(*header);
@@ -1925,7 +2651,8 @@ vy_run_write(int fd, struct vy_write_iterator *wi,
 	 */
 	do {
 		rc = vy_run_write_page(run, fd, wi, split_key, key_def,
-				       page_size);
+				       page_size,
+				       has_bloom ? &key_hashes : NULL);
 		if (rc < 0)
 			goto err;
 	} while (rc == 0);
@@ -1948,6 +2675,14 @@ vy_run_write(int fd, struct vy_write_iterator *wi,
 		goto err;
 	header->size += header->minmax_size;
 
+	/* Write bloom filter of the run keys */
+	if (has_bloom && vy_buf_used(&key_hashes) > 0) {
+		rc = vy_run_write_bloom(run, fd, &key_hashes, bloom_fpr);
+		if (rc == -1)
+			goto err;
+	}
+	vy_buf_destroy(&key_hashes);
+
 	/*
 	 * Sync written data
 	 * TODO: check, maybe we can use O_SYNC flag instead
@@ -1981,7 +2716,8 @@ err:
 	lseek(fd, header->offset, SEEK_SET);
 	rc = ftruncate(fd, header->offset);
 	(void) rc;
-	free(run);
+	vy_buf_destroy(&key_hashes);
+	vy_run_delete(run);
 	return -1;
 }
 
@@ -2022,6 +2758,33 @@ vy_range_close(struct vy_range *range)
 	return rcret;
 }
 
+static int
+vy_run_recover_bloom(struct vy_run *run, int fd)
+{
+	struct vy_run_info *info = &run->info;
+	char *table = malloc(info->bloom_size);
+	if (table == NULL) {
+		diag_set(OutOfMemory, info->bloom_size, "malloc",
+			 "bloom filter");
+		return -1;
+	}
+	if (vy_pread_file(fd, table, info->bloom_size,
+			  info->bloom_offset) == -1) {
+		vy_error("index file read error: %s", strerror(errno));
+		free(table);
+		return -1;
+	}
+	int rc = bloom_load_table(&run->bloom, info->bloom_hash_count,
+				  info->bloom_size / sizeof(uint64_t), table);
+	free(table);
+	if (rc != 0) {
+		diag_set(OutOfMemory, info->bloom_size, "bloom_load_table",
+			 "bloom filter");
+		return -1;
+	}
+	return 0;
+}
+
 static int
 vy_range_recover(struct vy_range *range)
 {
@@ -2042,6 +2805,15 @@ vy_range_recover(struct vy_range *range)
 		}
 		struct vy_run *vy_run = vy_run_new();
 		vy_run->info = *run_info;
+		/*
+		 * Runs written by older versions have no members
+		 * past footprint.run_info_size, zero them out.
+		 */
+		uint16_t run_info_size = run_info->footprint.run_info_size;
+		if (run_info_size < sizeof(struct vy_run_info)) {
+			memset((char *) &vy_run->info + run_info_size, 0,
+			       sizeof(struct vy_run_info) - run_info_size);
+		}
 
 		vy_buf_ensure(&vy_run->pages, run_info->pages_size);
 		if (vy_pread_file(fd, vy_run->pages.s,
@@ -2057,6 +2829,10 @@ vy_range_recover(struct vy_range *range)
 				     run_info->minmax_offset) == -1)
 			return -1;
 
+		if (vy_run->info.bloom_hash_count > 0 &&
+		    vy_run_recover_bloom(vy_run, fd) != 0)
+			return -1;
+
 		vy_run->next = range->run;
 		range->run = vy_run;
 		++range->run_count;
@@ -2154,6 +2930,23 @@ vy_range_delete(struct vy_range *range)
 	return rcret;
 }
 
+/**
+ * Delete a range removed from the index. A read iterator may
+ * yield waiting for a page and still reference the range, its
+ * runs or its file after it's woken up, so if there are active
+ * readers, postpone deletion until the last of them is closed.
+ */
+static void
+vy_range_retire(struct vy_range *range)
+{
+	struct vy_env *env = range->index->env;
+	if (env->active_reads > 0) {
+		rlist_add_tail_entry(&env->retired_ranges, range, in_retired);
+		return;
+	}
+	vy_range_delete(range);
+}
+
 static int
 vy_range_complete(struct vy_range *range, struct vy_index *index)
 {
@@ -2307,7 +3100,7 @@ vy_range_compact_commit(struct vy_range *range, int n_parts,
 		 */
 		if (r->run == NULL && r->used == 0 && index->range_count > 1) {
 			vy_index_remove_range(index, r);
-			vy_range_delete(r);
+			vy_range_retire(r);
 			continue;
 		}
 
@@ -2320,7 +3113,7 @@ vy_range_compact_commit(struct vy_range *range, int n_parts,
 		/* Make the new range visible to the scheduler. */
 		vy_scheduler_add_range(range->index->env->scheduler, r);
 	}
-	vy_range_delete(range);
+	vy_range_retire(range);
 }
 
 static void
@@ -2354,7 +3147,7 @@ vy_range_compact_abort(struct vy_range *range, int n_parts,
 			r->mem->next = NULL;
 		r->run = NULL;
 		r->fd = -1;
-		vy_range_delete(r);
+		vy_range_retire(r);
 
 		if (parts[i].run != NULL)
 			vy_run_delete(parts[i].run);
@@ -2834,8 +3627,9 @@ vy_task_dump_execute(struct vy_task *task)
 		if (rc != 0)
 			goto out;
 	}
-	rc = vy_run_write(range->fd, wi, NULL, NULL,
+	rc = vy_run_write(range->fd, wi, NULL, index->key_def,
 			  index->key_def->opts.page_size,
+			  index->key_def->opts.bloom_fpr,
 			  &task->dump.new_run);
 out:
 	vy_write_iterator_delete(wi);
@@ -2973,7 +3767,8 @@ vy_task_compact_execute(struct vy_task *task)
 			goto out;
 
 		rc = vy_run_write(p->fd, wi, split_key, index->key_def,
-				  index->key_def->opts.page_size, &p->run);
+				  index->key_def->opts.page_size,
+				  index->key_def->opts.bloom_fpr, &p->run);
 		if (rc != 0)
 			goto out;
 
@@ -3810,6 +4605,10 @@ struct vy_conf {
 	struct srzonemap zones;
 	/* memory */
 	uint64_t memory_limit;
+	/* size of the page read thread pool */
+	int read_threads;
+	/* page cache size, in bytes */
+	uint64_t cache_size;
 };
 
 static struct vy_conf *
@@ -3851,6 +4650,17 @@ vy_conf_new()
 		goto error_2;
 	}
 	z->dump_age = cfg_geti("vinyl.dump_age");
+	conf->read_threads = cfg_geti("vinyl.read_threads");
+	if (conf->read_threads < 0) {
+		vy_error("bad read_threads value %d", conf->read_threads);
+		goto error_2;
+	}
+	int64_t cache_size = cfg_geti64("vinyl.cache_size");
+	if (cache_size < 0) {
+		vy_error("bad cache_size value %lld", (long long) cache_size);
+		goto error_2;
+	}
+	conf->cache_size = cache_size;
 
 	return conf;
 
@@ -3954,6 +4764,20 @@ vy_info_append_memory(struct vy_info *info, struct vy_info_node *root)
 	return 0;
 }
 
+static int
+vy_info_append_cache(struct vy_info *info, struct vy_info_node *root)
+{
+	struct vy_info_node *node = vy_info_append(root, "cache");
+	if (vy_info_reserve(info, node, 4) != 0)
+		return 1;
+	struct vy_page_cache *cache = info->env->page_cache;
+	vy_info_append_u64(node, "used", cache->mem_used);
+	vy_info_append_u64(node, "limit", cache->mem_quota);
+	vy_info_append_u64(node, "hit", cache->hit);
+	vy_info_append_u64(node, "miss", cache->miss);
+	return 0;
+}
+
 static int
 vy_info_append_compaction(struct vy_info *info, struct vy_info_node *root)
 {
@@ -4078,10 +4902,11 @@ vy_info_create(struct vy_info *info, struct vy_env *e)
 	info->env = e;
 	region_create(&info->allocator, cord_slab_cache());
 	struct vy_info_node *root = &info->root;
-	if (vy_info_reserve(info, root, 7) != 0 ||
+	if (vy_info_reserve(info, root, 8) != 0 ||
 	    vy_info_append_indices(info, root) != 0 ||
 	    vy_info_append_global(info, root) != 0 ||
 	    vy_info_append_memory(info, root) != 0 ||
+	    vy_info_append_cache(info, root) != 0 ||
 	    vy_info_append_metric(info, root) != 0 ||
 	    vy_info_append_scheduler(info, root) != 0 ||
 	    vy_info_append_compaction(info, root) != 0 ||
@@ -4797,6 +5622,69 @@ vy_tuple_key_is_full(const char *tuple_data, const struct key_def *key_def)
 	return true;
 }
 
+/**
+ * Feed a key field to the hash. Fields that compare equal must
+ * produce equal hashes: strings and binary strings are hashed
+ * without the MsgPack header, numbers are hashed by value, since
+ * e.g. 1 and 1.0 are equal in 'number' and 'scalar' parts.
+ * @return the number of bytes hashed
+ */
+static uint32_t
+vy_tuple_hash_field(uint32_t *ph, uint32_t *pcarry, const char *field)
+{
+	const char *f = field;
+	uint32_t size;
+	double number;
+	switch (mp_typeof(*field)) {
+	case MP_STR:
+		f = mp_decode_str(&field, &size);
+		PMurHash32_Process(ph, pcarry, f, size);
+		return size;
+	case MP_BIN:
+		f = mp_decode_bin(&field, &size);
+		PMurHash32_Process(ph, pcarry, f, size);
+		return size;
+	case MP_UINT:
+		number = mp_decode_uint(&field);
+		break;
+	case MP_INT:
+		number = mp_decode_int(&field);
+		break;
+	case MP_FLOAT:
+		number = mp_decode_float(&field);
+		break;
+	case MP_DOUBLE:
+		number = mp_decode_double(&field);
+		break;
+	default:
+		mp_next(&field);
+		size = field - f;
+		PMurHash32_Process(ph, pcarry, f, size);
+		return size;
+	}
+	if (number == 0)
+		number = 0; /* -0.0 == 0.0 */
+	PMurHash32_Process(ph, pcarry, &number, sizeof(number));
+	return sizeof(number);
+}
+
+/**
+ * Calculate hash of the full key of a tuple.
+ */
+static uint32_t
+vy_tuple_hash(const char *tuple_data, const struct key_def *key_def)
+{
+	uint32_t h = 13;
+	uint32_t carry = 0;
+	uint32_t total_size = 0;
+	for (uint32_t part_id = 0; part_id < key_def->part_count; part_id++) {
+		const char *field = vy_tuple_key_part(tuple_data, part_id);
+		assert(field != NULL);
+		total_size += vy_tuple_hash_field(&h, &carry, field);
+	}
+	return PMurHash32_Result(h, carry, total_size);
+}
+
 /**
  * Compare two tuples
  */
@@ -5314,6 +6202,7 @@ vy_env_new(void)
 	}
 	memset(e, 0, sizeof(*e));
 	rlist_create(&e->indexes);
+	rlist_create(&e->retired_ranges);
 	e->status = VINYL_OFFLINE;
 	e->conf = vy_conf_new();
 	if (e->conf == NULL)
@@ -5330,10 +6219,20 @@ vy_env_new(void)
 	e->scheduler = vy_scheduler_new(e);
 	if (e->scheduler == NULL)
 		goto error_sched;
+	e->read_pool = vy_page_read_pool_new(e->conf->read_threads);
+	if (e->read_pool == NULL)
+		goto error_read_pool;
+	e->page_cache = vy_page_cache_new(e->conf->cache_size);
+	if (e->page_cache == NULL)
+		goto error_page_cache;
 
 	mempool_create(&e->cursor_pool, cord_slab_cache(),
 	               sizeof(struct vy_cursor));
 	return e;
+error_page_cache:
+	vy_page_read_pool_delete(e->read_pool);
+error_read_pool:
+	vy_scheduler_delete(e->scheduler);
 error_sched:
 	vy_stat_delete(e->stat);
 error_stat:
@@ -5351,6 +6250,8 @@ void
 vy_env_delete(struct vy_env *e)
 {
 	vy_scheduler_delete(e->scheduler);
+	vy_page_read_pool_delete(e->read_pool);
+	vy_page_cache_delete(e->page_cache);
 	/* TODO: tarantool doesn't delete indexes during shutdown */
 	//assert(rlist_empty(&e->db));
 	tx_manager_delete(e->xm);
@@ -5538,7 +6439,7 @@ static void
 vy_run_iterator_cache_put(struct vy_run_iterator *itr, struct vy_page *page)
 {
 	if (itr->prev_page != NULL)
-		vy_page_delete(itr->prev_page);
+		vy_page_unref(itr->prev_page);
 	itr->prev_page = itr->curr_page;
 	itr->curr_page = page;
 }
@@ -5555,15 +6456,16 @@ vy_run_iterator_cache_clean(struct vy_run_iterator *itr)
 		itr->curr_tuple_pos.page_no = UINT32_MAX;
 	}
 	if (itr->curr_page != NULL) {
-		vy_page_delete(itr->curr_page);
+		vy_page_unref(itr->curr_page);
 		if (itr->prev_page != NULL)
-			vy_page_delete(itr->prev_page);
+			vy_page_unref(itr->prev_page);
 		itr->curr_page = itr->prev_page = NULL;
 	}
 }
 
 /**
- * Get a page by the given number the cache or load it from the disk.
+ * Get a page by the given number from the iterator's LRU cache,
+ * the page cache or load it from the disk.
  */
 static int
 vy_run_iterator_load_page(struct vy_run_iterator *itr, uint32_t page_no,
@@ -5574,8 +6476,9 @@ vy_run_iterator_load_page(struct vy_run_iterator *itr, uint32_t page_no,
 	if (*result != NULL)
 		return 0;
 
-	/* Read from the disk (may yield) */
-	struct vy_page *page = vy_run_read_page(itr->run, page_no, itr->fd);
+	/* Check the page cache or read from the disk (may yield) */
+	struct vy_page *page = vy_index_load_page(itr->index, itr->run,
+						  page_no, itr->fd);
 	if (page == NULL)
 		return -1; /* read error */
 
@@ -5887,6 +6790,16 @@ vy_run_iterator_start(struct vy_run_iterator *itr)
 	assert(!itr->search_started);
 	itr->search_started = true;
 
+	struct key_def *key_def = itr->index->key_def;
+	if (itr->order == VINYL_EQ && itr->run->bloom.table != NULL &&
+	    vy_tuple_key_is_full(itr->key, key_def) &&
+	    !bloom_possible_has(&itr->run->bloom,
+				vy_tuple_hash(itr->key, key_def))) {
+		/* The key is definitely absent, skip the run. */
+		itr->search_ended = true;
+		return 1;
+	}
+
 	if (itr->run->info.count == 1) {
 		/* there can be a stupid bootstrap run in which it's EOF */
 		struct vy_page_info *page_info = vy_run_page(itr->run, 0);
@@ -7865,6 +8778,8 @@ vy_read_iterator_open(struct vy_read_iterator *itr,
 	itr->only_disk = only_disk;
 
 	itr->curr_tuple = NULL;
+	if (cord_is_main())
+		index->env->active_reads++;
 	vy_range_iterator_open(&itr->range_iterator, index,
 			  order == VINYL_EQ ? VINYL_GE : order, key, 0);
 	itr->curr_range = vy_range_iterator_get(&itr->range_iterator);
@@ -8024,6 +8939,18 @@ vy_read_iterator_close(struct vy_read_iterator *itr)
 		vy_tuple_unref(itr->curr_tuple);
 	itr->curr_tuple = NULL;
 	vy_merge_iterator_close(&itr->merge_iterator);
+	if (cord_is_main()) {
+		struct vy_env *env = itr->index->env;
+		assert(env->active_reads > 0);
+		if (--env->active_reads == 0) {
+			/* Delete ranges retired while we were reading. */
+			struct vy_range *range, *tmp;
+			rlist_foreach_entry_safe(range, &env->retired_ranges,
+						 in_retired, tmp)
+				vy_range_delete(range);
+			rlist_create(&env->retired_ranges);
+		}
+	}
 }
 
 /* }}} Iterator over index */
@@ -8072,6 +8999,9 @@ vy_index_read(struct vy_index *index, struct vy_tuple *key,
 
 	int64_t vlsn = tx != NULL ? tx->vlsn : e->xm->lsn;
 
+	uint64_t read_disk = index->read_disk;
+	uint64_t read_cache = index->read_cache;
+
 	struct vy_read_iterator itr;
 	vy_read_iterator_open(&itr, index, tx, order, key->data, vlsn, false);
 	int rc = vy_read_iterator_get(&itr, result);
@@ -8084,8 +9014,8 @@ vy_index_read(struct vy_index *index, struct vy_tuple *key,
 	vy_read_iterator_close(&itr);
 
 	struct vy_stat_get statget;
-	statget.read_disk = 0; // q.read_disk;
-	statget.read_cache = 0; // q.read_cache;
+	statget.read_disk = index->read_disk - read_disk;
+	statget.read_cache = index->read_cache - read_cache;
 	statget.read_latency = clock_monotonic64() - start;
 	vy_stat_get(e->stat, &statget);
 
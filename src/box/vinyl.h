@@ -86,6 +86,14 @@ vy_wait_checkpoint(struct vy_env *env, struct vclock *vlock);
 void
 vy_commit_checkpoint(struct vy_env *env, struct vclock *vclock);
 
+/**
+ * Maximal page compression level of a codec, see
+ * key_opts::compression_level.
+ * @param compression enum index_compression_type
+ */
+int
+vy_compression_level_max(uint32_t compression);
+
 /*
  * Introspection
  */
@@ -209,6 +209,20 @@ VinylEngine::keydefCheck(struct space *space, struct key_def *key_def)
 		          key_def->name,
 		          space_name(space));
 	}
+	if (key_def->opts.bloom_fpr <= 0 || key_def->opts.bloom_fpr > 1) {
+		tnt_raise(ClientError, ER_MODIFY_INDEX,
+			  key_def->name, space_name(space),
+			  "bloom_fpr must be greater than 0 and "
+			  "less than or equal to 1");
+	}
+	int level_max = vy_compression_level_max(key_def->opts.compression);
+	if (key_def->opts.compression_level > (uint32_t) level_max) {
+		char msg[80];
+		snprintf(msg, sizeof(msg), "compression_level must be "
+			 "less than or equal to %d", level_max);
+		tnt_raise(ClientError, ER_MODIFY_INDEX,
+			  key_def->name, space_name(space), msg);
+	}
 }
 
 void
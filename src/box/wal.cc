@@ -29,19 +29,81 @@
  * SUCH DAMAGE.
  */
 #include "wal.h"
+#include <msgpuck.h>
+#include <fcntl.h>
 
 #include "vclock.h"
 #include "fiber.h"
 #include "fio.h"
 #include "errinj.h"
+#include "clock.h"
+#include "ipc.h"
 
 #include "xlog.h"
 #include "xrow.h"
+#include "xstream.h"
+#include "iproto_constants.h"
 #include "cbus.h"
 #include "coeio.h"
+#include "coeio_file.h"
+#include "latch.h"
+#include "scoped_guard.h"
+#if defined(HAVE_FALLOCATE)
+#include <linux/falloc.h> /* FALLOC_FL_KEEP_SIZE */
+#endif /* defined(HAVE_FALLOCATE) */
 
 const char *wal_mode_STRS[] = { "none", "write", "fsync", NULL };
 
+enum { WAL_TAIL_BLOCK_SIZE = 256 * 1024 };
+
+/**
+ * A block of rows in the WAL tail buffer. Rows are stored one
+ * after another, each prefixed with its length and encoded the
+ * same way they are sent to replicas, less the fixed header.
+ */
+struct wal_tail_block {
+	/** Link in wal_tail::blocks. */
+	struct rlist in_tail;
+	/** Sequential number of the block, see wal_tail_next(). */
+	int64_t id;
+	/**
+	 * Number of relays reading the block, plus one while
+	 * the block is in the tail.
+	 */
+	int refs;
+	/** The WAL vclock before the first row of the block. */
+	struct vclock vclock;
+	/** Size of the rows visible to relays. */
+	size_t used;
+	/** Size of the data buffer. */
+	size_t size;
+	char data[0];
+};
+
+/**
+ * The WAL tail buffer: blocks of the most recently written
+ * rows, oldest first. Relays send rows from it while they keep
+ * up with the WAL writer and read xlog files only when they
+ * lag behind it, so that the rows are not read from disk and
+ * parsed again by every relay.
+ */
+struct wal_tail {
+	struct rlist blocks;
+	/** Total size of the blocks in the list. */
+	size_t size;
+	/** The wal_tail_size setting, 0 disables the tail. */
+	size_t size_max;
+	/** Id of the next block. */
+	int64_t next_id;
+	/**
+	 * Where the WAL writer appends rows in the last block.
+	 * Published to relays by wal_tail_flush().
+	 */
+	size_t wpos;
+	/** Protects the list, block refs and block used size. */
+	pthread_mutex_t mutex;
+};
+
 /*
  * WAL writer - maintain a Write Ahead Log for every change
  * in the data state.
@@ -107,6 +169,52 @@ struct wal_writer
 	struct rlist watchers;
 	/** The lock protecting the watchers list. */
 	pthread_mutex_t watchers_mutex;
+	/** The most recently written rows, shared with relays. */
+	struct wal_tail tail;
+	/** wal_group_commit_bytes setting. */
+	int64_t group_commit_bytes;
+	/** wal_group_commit_usec setting, in seconds. */
+	ev_tstamp group_commit_timeout;
+	/** Messages to be written to the WAL in one go. */
+	struct stailq group;
+	/** Estimated size of the group, see wal_request_size(). */
+	size_t group_size;
+	/**
+	 * Signalled when a group commit is complete or a message
+	 * leaves wal_write_to_disk().
+	 */
+	struct ipc_cond group_cond;
+	/** Number of messages entered wal_write_to_disk(). */
+	int64_t msgs_in;
+	/**
+	 * Number of messages left wal_write_to_disk(). They leave
+	 * in the order they entered, so that tx gets the results
+	 * in LSN order and rolls requests back newest first.
+	 */
+	int64_t msgs_out;
+	/**
+	 * Taken while a group commit is written. The next group
+	 * may be written while the previous one is being synced.
+	 */
+	struct latch write_latch;
+	/** Number of group commits written to the WAL. */
+	int64_t write_seq;
+	/** Number of group commits written and synced. */
+	int64_t commit_seq;
+	/** wal_prealloc_size setting. */
+	int64_t prealloc_size;
+	/** Written by the WAL thread, read by tx. */
+	struct wal_stat stat;
+};
+
+/** A group commit, see wal_write_group(). */
+struct wal_group {
+	/** Messages, linked by wal_msg::in_group. */
+	struct stailq msgs;
+	/** The WAL vclock before the group. */
+	struct vclock vclock;
+	/** The WAL file to sync after the write, or -1. */
+	int sync_fd;
 };
 
 struct wal_msg: public cmsg {
@@ -117,12 +225,19 @@ struct wal_msg: public cmsg {
 	 * be rolled back.
 	 */
 	struct stailq rollback;
+	/** Link in wal_writer::group. */
+	struct stailq_entry in_group;
+	/** Set when the group commit of the message is complete. */
+	bool is_written;
+	/** Order of the message in wal_write_to_disk(). */
+	int64_t seq;
 };
 
 static struct wal_writer wal_writer_singleton;
 
 struct wal_writer *wal = NULL;
 struct rmean *rmean_tx_wal_bus;
+struct wal_stat *wal_stat;
 
 static void
 wal_write_to_disk(struct cmsg *msg);
@@ -141,6 +256,8 @@ wal_msg_create(struct wal_msg *batch)
 	cmsg_init(batch, wal_request_route);
 	stailq_create(&batch->commit);
 	stailq_create(&batch->rollback);
+	batch->is_written = false;
+	batch->seq = 0;
 }
 
 static struct wal_msg *
@@ -209,6 +326,262 @@ tx_schedule_rollback(struct cmsg *msg)
 	stailq_create(&writer->rollback);
 }
 
+/* {{{ WAL tail buffer */
+
+static void
+wal_tail_create(struct wal_tail *tail, size_t size_max)
+{
+	rlist_create(&tail->blocks);
+	tail->size = 0;
+	tail->size_max = size_max;
+	tail->next_id = 0;
+	tail->wpos = 0;
+	tt_pthread_mutex_init(&tail->mutex, NULL);
+}
+
+/** Called with the mutex held. */
+static inline void
+wal_tail_unref(struct wal_tail_block *block)
+{
+	assert(block->refs > 0);
+	if (--block->refs == 0)
+		free(block);
+}
+
+/** Drop the oldest block. Called with the mutex held. */
+static void
+wal_tail_evict(struct wal_tail *tail)
+{
+	struct wal_tail_block *block =
+		rlist_first_entry(&tail->blocks, struct wal_tail_block,
+				  in_tail);
+	rlist_del_entry(block, in_tail);
+	tail->size -= block->size;
+	/* Relays still reading the block keep it alive. */
+	wal_tail_unref(block);
+}
+
+static void
+wal_tail_destroy(struct wal_tail *tail)
+{
+	tt_pthread_mutex_lock(&tail->mutex);
+	while (! rlist_empty(&tail->blocks))
+		wal_tail_evict(tail);
+	tt_pthread_mutex_unlock(&tail->mutex);
+	tt_pthread_mutex_destroy(&tail->mutex);
+}
+
+/**
+ * Append a row written to the WAL to the tail.
+ * @param vclock the WAL vclock before the row
+ */
+static void
+wal_tail_append(struct wal_tail *tail, struct xrow_header *row,
+		const struct vclock *vclock)
+{
+	if (tail->size_max == 0)
+		return;
+	struct iovec iov[XROW_IOVMAX];
+	int iovcnt = xrow_header_encode(row, iov, 0);
+	size_t len = 0;
+	for (int i = 0; i < iovcnt; i++)
+		len += iov[i].iov_len;
+	size_t need = mp_sizeof_uint(len) + len;
+
+	struct wal_tail_block *block = rlist_empty(&tail->blocks) ? NULL :
+		rlist_last_entry(&tail->blocks, struct wal_tail_block,
+				 in_tail);
+	if (block == NULL || block->size - tail->wpos < need) {
+		size_t size = MAX((size_t) WAL_TAIL_BLOCK_SIZE, need);
+		struct wal_tail_block *new_block = (struct wal_tail_block *)
+			malloc(sizeof(*new_block) + size);
+		tt_pthread_mutex_lock(&tail->mutex);
+		if (block != NULL)
+			block->used = tail->wpos;
+		if (new_block == NULL) {
+			/*
+			 * A gap in the tail would make relays
+			 * skip rows, drop the whole tail.
+			 */
+			say_error("failed to allocate %zu bytes for "
+				  "the WAL tail", sizeof(*new_block) + size);
+			while (! rlist_empty(&tail->blocks))
+				wal_tail_evict(tail);
+			tt_pthread_mutex_unlock(&tail->mutex);
+			return;
+		}
+		new_block->id = tail->next_id++;
+		new_block->refs = 1;
+		vclock_copy(&new_block->vclock, vclock);
+		new_block->used = 0;
+		new_block->size = size;
+		rlist_add_tail_entry(&tail->blocks, new_block, in_tail);
+		tail->size += size;
+		while (tail->size > tail->size_max &&
+		       rlist_first(&tail->blocks) != &new_block->in_tail)
+			wal_tail_evict(tail);
+		tt_pthread_mutex_unlock(&tail->mutex);
+		block = new_block;
+		tail->wpos = 0;
+	}
+	char *pos = mp_encode_uint(block->data + tail->wpos, len);
+	for (int i = 0; i < iovcnt; i++) {
+		memcpy(pos, iov[i].iov_base, iov[i].iov_len);
+		pos += iov[i].iov_len;
+	}
+	tail->wpos = pos - block->data;
+}
+
+/** Make the appended rows visible to relays. */
+static void
+wal_tail_flush(struct wal_tail *tail)
+{
+	if (rlist_empty(&tail->blocks))
+		return;
+	struct wal_tail_block *block =
+		rlist_last_entry(&tail->blocks, struct wal_tail_block,
+				 in_tail);
+	tt_pthread_mutex_lock(&tail->mutex);
+	block->used = tail->wpos;
+	tt_pthread_mutex_unlock(&tail->mutex);
+}
+
+/**
+ * Find the block to start reading at the given vclock from:
+ * the newest one which starts at or before it.
+ * Called with the mutex held.
+ */
+static struct wal_tail_block *
+wal_tail_find(struct wal_tail *tail, const struct vclock *vclock)
+{
+	struct wal_tail_block *block;
+	rlist_foreach_entry_reverse(block, &tail->blocks, in_tail) {
+		if (vclock_compare(&block->vclock, vclock) <= 0)
+			return block;
+	}
+	return NULL;
+}
+
+/**
+ * Find a block by id, NULL if it has been dropped.
+ * Called with the mutex held.
+ */
+static struct wal_tail_block *
+wal_tail_lookup(struct wal_tail *tail, int64_t id)
+{
+	struct wal_tail_block *block;
+	rlist_foreach_entry_reverse(block, &tail->blocks, in_tail) {
+		if (block->id == id)
+			return block;
+		if (block->id < id)
+			break;
+	}
+	return NULL;
+}
+
+/**
+ * Find the block following the given one. Sets *next to NULL
+ * if there is no such block yet.
+ * Called with the mutex held.
+ * @retval -1 the next block has already been dropped
+ */
+static int
+wal_tail_next(struct wal_tail *tail, struct wal_tail_block *block,
+	      struct wal_tail_block **next)
+{
+	*next = NULL;
+	struct wal_tail_block *b;
+	rlist_foreach_entry(b, &tail->blocks, in_tail) {
+		if (b->id <= block->id)
+			continue;
+		if (b->id != block->id + 1)
+			return -1;
+		*next = b;
+		break;
+	}
+	return 0;
+}
+
+int
+wal_tail_read(struct wal_writer *writer, struct vclock *vclock,
+	      struct wal_tail_cursor *cursor, struct xstream *stream)
+{
+	if (writer == NULL)
+		return -1;
+	struct wal_tail *tail = &writer->tail;
+	struct wal_tail_block *block = NULL;
+	size_t pos = 0;
+	tt_pthread_mutex_lock(&tail->mutex);
+	/*
+	 * All rows before the cursor have been seen if the vclock
+	 * hasn't moved since, e.g. by reading xlog files.
+	 */
+	if (cursor->block_id >= 0 &&
+	    cursor->signature == vclock_sum(vclock))
+		block = wal_tail_lookup(tail, cursor->block_id);
+	if (block != NULL)
+		pos = cursor->pos;
+	else
+		block = wal_tail_find(tail, vclock);
+	if (block != NULL)
+		block->refs++;
+	tt_pthread_mutex_unlock(&tail->mutex);
+	/* Set again once the rows are sent. */
+	wal_tail_cursor_create(cursor);
+	if (block == NULL)
+		return -1;
+
+	auto guard = make_scoped_guard([&]{
+		tt_pthread_mutex_lock(&tail->mutex);
+		wal_tail_unref(block);
+		tt_pthread_mutex_unlock(&tail->mutex);
+	});
+	while (true) {
+		struct wal_tail_block *next = NULL;
+		tt_pthread_mutex_lock(&tail->mutex);
+		size_t used = block->used;
+		int rc = 0;
+		if (pos == used) {
+			rc = wal_tail_next(tail, block, &next);
+			if (next != NULL) {
+				next->refs++;
+				wal_tail_unref(block);
+				block = next;
+				pos = 0;
+			}
+		}
+		tt_pthread_mutex_unlock(&tail->mutex);
+		if (rc != 0)
+			return -1; /* Lagged behind the tail. */
+		if (next != NULL)
+			continue;
+		if (pos == used) {
+			/* Caught up with the WAL. */
+			cursor->block_id = block->id;
+			cursor->pos = pos;
+			cursor->signature = vclock_sum(vclock);
+			return 0;
+		}
+		/*
+		 * Rows below the used mark are never changed,
+		 * read them without the lock.
+		 */
+		const char *data = block->data + pos;
+		const char *end = block->data + used;
+		while (data < end) {
+			uint32_t len = mp_decode_uint(&data);
+			struct xrow_header row;
+			xrow_header_decode(&row, &data, data + len);
+			if (row.lsn <= vclock_get(vclock, row.server_id))
+				continue;
+			xstream_write(stream, &row);
+		}
+		pos = used;
+	}
+}
+
+/* }}} */
+
 /**
  * Initialize WAL writer context. Even though it's a singleton,
  * encapsulate the details just in case we may use
@@ -217,15 +590,19 @@ tx_schedule_rollback(struct cmsg *msg)
 static void
 wal_writer_create(struct wal_writer *writer, enum wal_mode wal_mode,
 		  const char *wal_dirname, const struct tt_uuid *server_uuid,
-		  struct vclock *vclock, int64_t rows_per_wal)
+		  struct vclock *vclock, int64_t rows_per_wal,
+		  size_t tail_size, int64_t group_commit_bytes,
+		  int64_t group_commit_usec, int64_t prealloc_size)
 {
 	writer->wal_mode = wal_mode;
 	writer->rows_per_wal = rows_per_wal;
 
+	/*
+	 * In fsync mode, the WAL is synced once per group commit
+	 * rather than on every write, see wal_write_group().
+	 */
 	xdir_create(&writer->wal_dir, wal_dirname, XLOG, server_uuid);
 	writer->current_wal = NULL;
-	if (wal_mode == WAL_FSYNC)
-		(void) strcat(writer->wal_dir.open_wflags, "s");
 	cbus_create(&writer->tx_wal_bus);
 
 	cpipe_create(&writer->tx_pipe);
@@ -245,6 +622,20 @@ wal_writer_create(struct wal_writer *writer, enum wal_mode wal_mode,
 
 	tt_pthread_mutex_init(&writer->watchers_mutex, NULL);
 	rlist_create(&writer->watchers);
+	wal_tail_create(&writer->tail, tail_size);
+
+	writer->group_commit_bytes = group_commit_bytes;
+	writer->group_commit_timeout = group_commit_usec / 1000000.;
+	stailq_create(&writer->group);
+	writer->group_size = 0;
+	ipc_cond_create(&writer->group_cond);
+	writer->msgs_in = 0;
+	writer->msgs_out = 0;
+	latch_create(&writer->write_latch);
+	writer->write_seq = 0;
+	writer->commit_seq = 0;
+	writer->prealloc_size = prealloc_size;
+	memset(&writer->stat, 0, sizeof(writer->stat));
 }
 
 /** Destroy a WAL writer structure. */
@@ -255,6 +646,9 @@ wal_writer_destroy(struct wal_writer *writer)
 	cbus_destroy(&writer->tx_wal_bus);
 	fio_batch_delete(writer->batch);
 	tt_pthread_mutex_destroy(&writer->watchers_mutex);
+	wal_tail_destroy(&writer->tail);
+	ipc_cond_destroy(&writer->group_cond);
+	latch_destroy(&writer->write_latch);
 }
 
 /** WAL writer thread routine. */
@@ -280,7 +674,9 @@ wal_opt_rotate(struct wal_writer *writer);
 void
 wal_writer_start(enum wal_mode wal_mode, const char *wal_dirname,
 		 const struct tt_uuid *server_uuid, struct vclock *vclock,
-		 int64_t rows_per_wal)
+		 int64_t rows_per_wal, size_t tail_size,
+		 int64_t group_commit_bytes, int64_t group_commit_usec,
+		 int64_t prealloc_size)
 {
 	assert(rows_per_wal > 1);
 
@@ -288,9 +684,11 @@ wal_writer_start(enum wal_mode wal_mode, const char *wal_dirname,
 
 	/* I. Initialize the state. */
 	wal_writer_create(writer, wal_mode, wal_dirname, server_uuid,
-			vclock, rows_per_wal);
+			vclock, rows_per_wal, tail_size, group_commit_bytes,
+			group_commit_usec, prealloc_size);
 
 	rmean_tx_wal_bus = writer->tx_wal_bus.stats;
+	wal_stat = &writer->stat;
 
 	/* II. Start the thread. */
 
@@ -303,10 +701,14 @@ wal_writer_start(enum wal_mode wal_mode, const char *wal_dirname,
 	wal = writer;
 }
 
+static void
+wal_write_group(struct wal_writer *writer);
+
 static void
 wal_writer_stop_f(struct cmsg *msg)
 {
 	(void) msg;
+	wal_write_group(wal);
 	fiber_wakeup(wal->main_f);
 }
 
@@ -335,9 +737,55 @@ wal_writer_stop()
 	wal_writer_destroy(writer);
 
 	rmean_tx_wal_bus = NULL;
+	wal_stat = NULL;
 	wal = NULL;
 }
 
+/** Wait until all written group commits are synced. */
+static void
+wal_wait_sync(struct wal_writer *writer)
+{
+	while (writer->commit_seq != writer->write_seq)
+		ipc_cond_wait(&writer->group_cond);
+}
+
+/**
+ * Close a WAL file once nothing is being synced in it, and
+ * release the space preallocated past its end.
+ */
+static void
+wal_close_log(struct wal_writer *writer, struct xlog *l)
+{
+	wal_wait_sync(writer);
+	if (writer->prealloc_size > 0) {
+		off_t size = fio_lseek(fileno(l->f), 0, SEEK_CUR);
+		if (size < 0 || ftruncate(fileno(l->f), size) != 0)
+			say_syserror("%s: failed to truncate", l->filename);
+	}
+	xlog_close(l);
+}
+
+/**
+ * Reserve disk space for a new WAL file, so that writes don't
+ * have to allocate blocks and update file metadata, which the
+ * next sync would have to flush. The file size is kept, so
+ * that readers don't see the reserved space.
+ */
+static void
+wal_preallocate(struct wal_writer *writer, struct xlog *l)
+{
+	if (writer->prealloc_size == 0)
+		return;
+#if defined(HAVE_FALLOCATE)
+	if (fallocate(fileno(l->f), FALLOC_FL_KEEP_SIZE, 0,
+		      writer->prealloc_size) != 0) {
+		say_syserror("%s: fallocate failed", l->filename);
+	}
+#else
+	(void) l;
+#endif
+}
+
 struct wal_checkpoint: public cmsg
 {
 	struct vclock *vclock;
@@ -350,6 +798,9 @@ wal_checkpoint_f(struct cmsg *data)
 {
 	struct wal_checkpoint *msg = (struct wal_checkpoint *) data;
 	struct wal_writer *writer = wal;
+	/* The checkpoint must include all requests sent before it. */
+	wal_write_group(writer);
+	latch_lock(&writer->write_latch);
 	/*
 	 * Avoid closing the current WAL if it has no rows (empty).
 	 */
@@ -357,7 +808,7 @@ wal_checkpoint_f(struct cmsg *data)
 	    vclock_sum(&writer->current_wal->vclock) !=
 	    vclock_sum(&writer->vclock)) {
 
-		xlog_close(writer->current_wal);
+		wal_close_log(writer, writer->current_wal);
 		writer->current_wal = NULL;
 		/*
 		 * Avoid creating an empty xlog if this is the
@@ -365,6 +816,7 @@ wal_checkpoint_f(struct cmsg *data)
 		 */
 	}
 	vclock_copy(msg->vclock, &writer->vclock);
+	latch_unlock(&writer->write_latch);
 }
 
 void
@@ -428,11 +880,13 @@ wal_opt_rotate(struct wal_writer *writer)
 			 * A warning is written to the server
 			 * log file.
 			 */
-			xlog_close(wal_to_close);
+			wal_close_log(writer, wal_to_close);
 			wal_to_close = NULL;
 		}
 		/* Open WAL with '.inprogress' suffix. */
 		l = xlog_create(&writer->wal_dir, &writer->vclock);
+		if (l != NULL)
+			wal_preallocate(writer, l);
 	}
 	assert(wal_to_close == NULL);
 	writer->current_wal = l;
@@ -456,6 +910,21 @@ wal_writer_clear_bus(struct cmsg *msg)
 	(void) msg;
 }
 
+static void
+wal_writer_clear_group(struct cmsg *msg)
+{
+	(void) msg;
+	/*
+	 * Requests waiting for the group commit must go to
+	 * the rollback queue before the rollback starts, i.e.
+	 * get to the tx thread before this message.
+	 */
+	struct wal_writer *writer = wal;
+	wal_write_group(writer);
+	while (writer->msgs_out != writer->msgs_in)
+		ipc_cond_wait(&writer->group_cond);
+}
+
 static void
 wal_writer_end_rollback(struct cmsg *msg)
 {
@@ -477,7 +946,7 @@ wal_writer_begin_rollback(struct wal_writer *writer)
 		 * list.
 		 */
 		{ wal_writer_clear_bus, &wal_writer_singleton.wal_pipe },
-		{ wal_writer_clear_bus, &wal_writer_singleton.tx_pipe },
+		{ wal_writer_clear_group, &wal_writer_singleton.tx_pipe },
 		/*
 		 * Step 2: writer->rollback queue contains all
 		 * messages which need to be rolled back,
@@ -501,21 +970,67 @@ wal_writer_begin_rollback(struct wal_writer *writer)
 static void
 wal_notify_watchers(struct wal_writer *writer);
 
+/**
+ * A rough estimate of the size of a request in the WAL,
+ * used to tell when a group commit is big enough.
+ */
+static size_t
+wal_request_size(struct wal_request *req)
+{
+	size_t size = 0;
+	for (int i = 0; i < req->n_rows; i++) {
+		struct xrow_header *row = req->rows[i];
+		size += XLOG_FIXHEADER_SIZE;
+		for (int j = 0; j < row->bodycnt; j++)
+			size += row->body[j].iov_len;
+	}
+	return size;
+}
+
+/** Count a value in a power of two histogram. */
+static inline void
+wal_histogram_collect(int64_t *histogram, uint64_t value)
+{
+	int bucket = value == 0 ? 0 : 64 - __builtin_clzll(value);
+	histogram[MIN(bucket, WAL_HISTOGRAM_SIZE - 1)]++;
+}
+
+/**
+ * Move the given request of the given message and all requests
+ * following it in the group commit to rollback queues.
+ */
 static void
-wal_write_to_disk(struct cmsg *msg)
+wal_group_rollback(struct wal_msg *msg, struct wal_request *req)
 {
-	struct wal_writer *writer = wal;
-	struct wal_msg *wal_msg = (struct wal_msg *) msg;
+	stailq_splice(&msg->commit, &req->fifo, &msg->rollback);
+	while (stailq_next(&msg->in_group) != NULL) {
+		msg = stailq_next_entry(msg, in_group);
+		stailq_concat(&msg->rollback, &msg->commit);
+	}
+}
 
+/**
+ * Write all requests of a group commit to the WAL with as few
+ * system calls as possible. The WAL is synced by the caller.
+ */
+static void
+wal_write_batch(struct wal_writer *writer, struct wal_group *wal_group)
+{
+	struct stailq *group = &wal_group->msgs;
+	struct wal_msg *wal_msg;
+	vclock_copy(&wal_group->vclock, &writer->vclock);
+	wal_group->sync_fd = -1;
 	if (writer->in_rollback.route != NULL) {
 		/* We're rolling back a failed write. */
-		stailq_concat(&wal_msg->rollback, &wal_msg->commit);
+		stailq_foreach_entry(wal_msg, group, in_group)
+			stailq_concat(&wal_msg->rollback, &wal_msg->commit);
 		return;
 	}
 
 	/* Xlog is only rotated between queue processing  */
 	if (wal_opt_rotate(writer) != 0) {
-		stailq_concat(&wal_msg->rollback, &wal_msg->commit);
+		stailq_foreach_entry(wal_msg, group, in_group)
+			stailq_concat(&wal_msg->rollback, &wal_msg->commit);
 		return wal_writer_begin_rollback(writer);
 	}
 
@@ -538,6 +1053,9 @@ wal_write_to_disk(struct cmsg *msg)
 	 * to file or isn't written at all, ftruncate(2) is used to shrink
 	 * the file to the last fully written request. The absolute position
 	 * of request in xlog file is stored inside `struct wal_request`.
+	 *
+	 * Requests of all messages of the group commit are written
+	 * together.
 	 */
 
 	struct xlog *l = writer->current_wal;
@@ -545,6 +1063,8 @@ wal_write_to_disk(struct cmsg *msg)
 	off_t batched_bytes = 0;
 	/* The size of written data */
 	off_t written_bytes = 0;
+	/* Number of rows in the group */
+	int64_t n_rows = 0;
 	/* Start new iov batch */
 	struct fio_batch *batch = writer->batch;
 	fio_batch_reset(batch);
@@ -553,41 +1073,50 @@ wal_write_to_disk(struct cmsg *msg)
 	 * Iterate over requests (transactions)
 	 */
 	struct wal_request *req;
-	stailq_foreach_entry(req, &wal_msg->commit, fifo) {
-		/* Save relative offset of request start */
-		req->start_offset = batched_bytes;
-		req->end_offset = -1;
+	stailq_foreach_entry(wal_msg, group, in_group) {
+		stailq_foreach_entry(req, &wal_msg->commit, fifo) {
+			/* Save relative offset of request start */
+			req->start_offset = batched_bytes;
+			req->end_offset = -1;
 
-		/*
-		 * Iterate over request rows (tx statements)
-		 */
-		struct xrow_header **row = req->rows;
-		for (; row < req->rows + req->n_rows; row++) {
-			/* Check batch has enough space to fit statement */
-			if (unlikely(fio_batch_unused(batch) < XROW_IOVMAX)) {
+			/*
+			 * Iterate over request rows (tx statements)
+			 */
+			struct xrow_header **row = req->rows;
+			for (; row < req->rows + req->n_rows; row++) {
 				/*
-				 * No space in the batch for this statement,
-				 * flush added statements and rotate batch.
+				 * Check batch has enough space to fit
+				 * statement
 				 */
-				assert(fio_batch_size(batch) > 0);
-				ssize_t nwr = wal_fio_batch_write(batch,
-					fileno(l->f));
-				if (nwr < 0)
-					goto done; /* to break outer loop */
-
-				/* Update cached file offset */
-				written_bytes += nwr;
+				if (unlikely(fio_batch_unused(batch) <
+					     XROW_IOVMAX)) {
+					/*
+					 * No space in the batch for
+					 * this statement, flush added
+					 * statements and rotate batch.
+					 */
+					assert(fio_batch_size(batch) > 0);
+					ssize_t nwr = wal_fio_batch_write(batch,
+						fileno(l->f));
+					if (nwr < 0)
+						goto done; /* to break outer loop */
+
+					/* Update cached file offset */
+					written_bytes += nwr;
+				}
+
+				/* Add the statement to iov batch */
+				struct iovec *iov =
+					fio_batch_book(batch, XROW_IOVMAX);
+				assert(iov != NULL); /* checked above */
+				int iovcnt = xlog_encode_row(*row, iov);
+				batched_bytes += fio_batch_add(batch, iovcnt);
 			}
+			n_rows += req->n_rows;
 
-			/* Add the statement to iov batch */
-			struct iovec *iov = fio_batch_book(batch, XROW_IOVMAX);
-			assert(iov != NULL); /* checked above */
-			int iovcnt = xlog_encode_row(*row, iov);
-			batched_bytes += fio_batch_add(batch, iovcnt);
+			/* Save relative offset of request end */
+			req->end_offset = batched_bytes;
 		}
-
-		/* Save relative offset of request end */
-		req->end_offset = batched_bytes;
 	}
 	/* Flush remaining data in batch (if any) */
 	while (fio_batch_size(batch) > 0) {
@@ -601,60 +1130,190 @@ wal_write_to_disk(struct cmsg *msg)
 	}
 
 done:
+	if (writer->wal_mode == WAL_FSYNC && written_bytes > 0)
+		wal_group->sync_fd = fileno(l->f);
+	wal_histogram_collect(writer->stat.batch_rows, n_rows);
+
 	/*
-	 * Iterate over `input` queue and add all processed requests to
-	 * `commit` queue and all other to `rollback` queue.
+	 * Iterate over the group and leave all committed requests
+	 * in `commit` queues, move all other ones to `rollback`
+	 * queues.
 	 */
-	struct wal_request *reqend = req;
-	for (req = stailq_first_entry(&wal_msg->commit, struct wal_request, fifo);
-	     req != reqend;
-	     req = stailq_next_entry(req, fifo)) {
-		/*
-		 * Check if request has been fully written to xlog.
-		 */
-		if (unlikely(req->end_offset == -1 ||
-			     req->end_offset > written_bytes)) {
+	stailq_foreach_entry(wal_msg, group, in_group) {
+		stailq_foreach_entry(req, &wal_msg->commit, fifo) {
 			/*
-			 * This and all subsequent requests have failed
-			 * to write. Truncate xlog to the end of last
-			 * successfully written request.
+			 * Check if request has been fully written
+			 * to xlog.
 			 */
+			if (unlikely(req->end_offset == -1 ||
+				     req->end_offset > written_bytes)) {
+				/*
+				 * This and all subsequent requests
+				 * have failed to write. Truncate xlog
+				 * to the end of last successfully
+				 * written request.
+				 */
 
-			/* Calculate relative position of the good request */
-			off_t garbage_bytes = written_bytes - req->start_offset;
-			assert(garbage_bytes >= 0);
+				/*
+				 * Calculate relative position of the
+				 * good request
+				 */
+				off_t garbage_bytes =
+					written_bytes - req->start_offset;
+				assert(garbage_bytes >= 0);
+
+				/* Get absolute position */
+				off_t good_offset = fio_lseek(fileno(l->f),
+					-garbage_bytes, SEEK_CUR);
+				if (good_offset < 0)
+					panic_syserror("failed to get xlog "
+						       "position");
+
+				/* Truncate xlog */
+				if (ftruncate(fileno(l->f), good_offset) != 0)
+					panic_syserror("failed to rollback xlog");
+
+				/* Move the tail to `rollback` queues. */
+				wal_group_rollback(wal_msg, req);
+				wal_writer_begin_rollback(writer);
+				return;
+			}
 
-			/* Get absolute position */
-			off_t good_offset = fio_lseek(fileno(l->f),
-				-garbage_bytes, SEEK_CUR);
-			if (good_offset < 0)
-				panic_syserror("failed to get xlog position");
+			/* Update internal vclock */
+			struct xrow_header **row = req->rows;
+			for (; row < req->rows + req->n_rows; row++) {
+				vclock_follow(&writer->vclock,
+					      (*row)->server_id, (*row)->lsn);
+			}
+			/* Update row counter for wal_opt_rotate() */
+			l->rows += req->n_rows;
+			/* Mark request as successful for tx thread */
+			req->res = vclock_sum(&writer->vclock);
+		}
+	}
+}
 
-			/* Truncate xlog */
-			if (ftruncate(fileno(l->f), good_offset) != 0)
-				panic_syserror("failed to rollback xlog");
-			written_bytes = req->start_offset;
+/**
+ * Write the group commit and let its messages go back to
+ * the tx thread.
+ *
+ * The WAL is synced outside of the write latch, in a coeio
+ * thread, so that the next group can be written while this
+ * one is being synced. Groups are still completed in order:
+ * a group waits for all groups written before it.
+ */
+static void
+wal_write_group(struct wal_writer *writer)
+{
+	struct wal_group group;
+	stailq_create(&group.msgs);
 
-			/* Move tail to `rollback` queue. */
-			stailq_splice(&wal_msg->commit, &req->fifo, &wal_msg->rollback);
-			wal_writer_begin_rollback(writer);
-			break;
-		}
+	latch_lock(&writer->write_latch);
+	if (stailq_empty(&writer->group)) {
+		latch_unlock(&writer->write_latch);
+		return;
+	}
+	stailq_concat(&group.msgs, &writer->group);
+	writer->group_size = 0;
+	wal_write_batch(writer, &group);
+	int64_t seq = ++writer->write_seq;
+	latch_unlock(&writer->write_latch);
+
+	if (group.sync_fd >= 0) {
+		uint64_t start = clock_monotonic64();
+		/*
+		 * Groups written after this one may already be
+		 * in the file, so there is no way to roll this
+		 * one back.
+		 */
+		if (coeio_fdatasync(group.sync_fd) != 0)
+			panic_syserror("failed to sync xlog");
+		wal_histogram_collect(writer->stat.fsync_usec,
+				      (clock_monotonic64() - start) / 1000);
+	}
+	while (writer->commit_seq != seq - 1)
+		ipc_cond_wait(&writer->group_cond);
 
-		/* Update internal vclock */
-		vclock_follow(&writer->vclock,
-			      req->rows[req->n_rows - 1]->server_id,
-			      req->rows[req->n_rows - 1]->lsn);
-		/* Update row counter for wal_opt_rotate() */
-		l->rows += req->n_rows;
-		/* Mark request as successful for tx thread */
-		req->res = vclock_sum(&writer->vclock);
+	/*
+	 * Only synced rows go to the WAL tail, so that relays
+	 * don't send rows which may be lost on crash.
+	 */
+	struct wal_msg *wal_msg;
+	struct wal_request *req;
+	stailq_foreach_entry(wal_msg, &group.msgs, in_group) {
+		stailq_foreach_entry(req, &wal_msg->commit, fifo) {
+			struct xrow_header **row = req->rows;
+			for (; row < req->rows + req->n_rows; row++) {
+				wal_tail_append(&writer->tail, *row,
+						&group.vclock);
+				vclock_follow(&group.vclock,
+					      (*row)->server_id, (*row)->lsn);
+			}
+		}
+		wal_msg->is_written = true;
 	}
+	writer->commit_seq = seq;
+	ipc_cond_broadcast(&writer->group_cond);
 
+	wal_tail_flush(&writer->tail);
 	fiber_gc();
 	wal_notify_watchers(writer);
 }
 
+/**
+ * Add the message to the group commit. The group is written
+ * when its size reaches wal_group_commit_bytes or when
+ * wal_group_commit_usec have passed since its first message
+ * arrived, whichever comes first.
+ */
+static void
+wal_write_to_disk(struct cmsg *msg)
+{
+	struct wal_writer *writer = wal;
+	struct wal_msg *wal_msg = (struct wal_msg *) msg;
+
+	wal_msg->seq = writer->msgs_in++;
+	bool is_first = stailq_empty(&writer->group);
+	stailq_add_tail_entry(&writer->group, wal_msg, in_group);
+	struct wal_request *req;
+	stailq_foreach_entry(req, &wal_msg->commit, fifo)
+		writer->group_size += wal_request_size(req);
+
+	if (writer->group_commit_timeout == 0 ||
+	    writer->group_size >= (size_t) writer->group_commit_bytes) {
+		wal_write_group(writer);
+	} else if (is_first) {
+		/*
+		 * Let more requests join the group, until someone
+		 * else takes it or the timeout expires.
+		 */
+		ev_tstamp deadline = ev_now(loop()) +
+				     writer->group_commit_timeout;
+		while (! wal_msg->is_written &&
+		       stailq_first(&writer->group) == &wal_msg->in_group) {
+			ev_tstamp timeout = deadline -
+					    ev_now(loop());
+			if (timeout <= 0 ||
+			    ipc_cond_wait_timeout(&writer->group_cond,
+						  timeout) != 0)
+				break;
+		}
+		if (! wal_msg->is_written)
+			wal_write_group(writer);
+	}
+	/*
+	 * The message goes back to tx as soon as this function
+	 * returns, so wait until the group is complete and all
+	 * messages which came before this one have gone back.
+	 * A message which has written the group may not be the
+	 * first one in it.
+	 */
+	while (! wal_msg->is_written || writer->msgs_out != wal_msg->seq)
+		ipc_cond_wait(&writer->group_cond);
+	writer->msgs_out++;
+	ipc_cond_broadcast(&writer->group_cond);
+}
+
 /** WAL writer thread main loop.  */
 static int
 wal_writer_f(va_list ap)
@@ -669,7 +1328,7 @@ wal_writer_f(va_list ap)
 	fiber_yield();
 
 	if (writer->current_wal != NULL) {
-		xlog_close(writer->current_wal);
+		wal_close_log(writer, writer->current_wal);
 		writer->current_wal = NULL;
 	}
 	return 0;
@@ -37,14 +37,53 @@
 
 struct fiber;
 struct wal_writer;
+struct vclock;
+struct xstream;
 
 enum wal_mode { WAL_NONE = 0, WAL_WRITE, WAL_FSYNC, WAL_MODE_MAX };
 
 /** String constants for the supported modes. */
 extern const char *wal_mode_STRS[];
 
+enum { WAL_HISTOGRAM_SIZE = 32 };
+
+/**
+ * WAL write statistics. Bucket i of a histogram counts values
+ * in range [2^(i - 1), 2^i), bucket 0 counts zeros.
+ */
+struct wal_stat {
+	/** Number of rows written by one group commit. */
+	int64_t batch_rows[WAL_HISTOGRAM_SIZE];
+	/** Time taken by fdatasync() in fsync mode, microseconds. */
+	int64_t fsync_usec[WAL_HISTOGRAM_SIZE];
+};
+
+/**
+ * A position in the WAL tail buffer where a reader stopped,
+ * so that the next wal_tail_read() doesn't have to scan the
+ * block from the start again.
+ */
+struct wal_tail_cursor {
+	/** Id of the block, -1 if the position is unknown. */
+	int64_t block_id;
+	/** Offset of the next row in the block. */
+	size_t pos;
+	/** Signature of the reader vclock at the position. */
+	int64_t signature;
+};
+
+static inline void
+wal_tail_cursor_create(struct wal_tail_cursor *cursor)
+{
+	cursor->block_id = -1;
+	cursor->pos = 0;
+	cursor->signature = -1;
+}
+
 extern struct wal_writer *wal;
 extern struct rmean *rmean_tx_wal_bus;
+/** NULL if there is no WAL writer. */
+extern struct wal_stat *wal_stat;
 
 #if defined(__cplusplus)
 
@@ -71,7 +110,9 @@ wal_write(struct wal_writer *writer, struct wal_request *req);
 void
 wal_writer_start(enum wal_mode wal_mode, const char *wal_dirname,
 		 const struct tt_uuid *server_uuid, struct vclock *vclock,
-		 int64_t rows_per_wal);
+		 int64_t rows_per_wal, size_t tail_size,
+		 int64_t group_commit_bytes, int64_t group_commit_usec,
+		 int64_t prealloc_size);
 
 void
 wal_writer_stop();
@@ -95,6 +136,22 @@ wal_set_watcher(struct wal_writer *, struct wal_watcher *,
 void
 wal_clear_watcher(struct wal_writer *, struct wal_watcher *);
 
+/**
+ * Send rows following the given vclock from the WAL tail
+ * buffer, i.e. from memory rather than from xlog files.
+ * The stream must advance the vclock.
+ * Reading resumes at the cursor if the block is still in the
+ * tail and the vclock hasn't changed since the last call.
+ * Can be called from any thread.
+ *
+ * @retval 0 all rows written to the WAL so far have been sent
+ * @retval -1 the rows are not in the tail (anymore), the
+ *            caller should read them from xlog files
+ */
+int
+wal_tail_read(struct wal_writer *writer, struct vclock *vclock,
+	      struct wal_tail_cursor *cursor, struct xstream *stream);
+
 void
 wal_atfork();
 
@@ -39,6 +39,7 @@
 #include "fiob.h"
 #include "third_party/tarantool_eio.h"
 #include <msgpuck.h>
+#include <zstd.h>
 #include "scoped_guard.h"
 
 #include "error.h"
@@ -55,8 +56,16 @@ typedef uint32_t log_magic_t;
 
 static const log_magic_t row_marker = mp_bswap_u32(0xd5ba0bab); /* host byte order */
 static const log_magic_t eof_marker = mp_bswap_u32(0xd510aded); /* host byte order */
+static const log_magic_t block_marker = mp_bswap_u32(0xd5b10cc5); /* host byte order */
 static const char inprogress_suffix[] = ".inprogress";
 static const char v12[] = "0.12\n";
+/** Same as 0.12, but may contain blocks of rows. */
+static const char v13[] = "0.13\n";
+
+/** zstd compression level of blocks of rows. */
+enum { XLOG_ZSTD_LEVEL = 3 };
+
+const char *xlog_compression_strs[] = { "none", "zstd" };
 
 const struct type type_XlogError = make_type("XlogError", &type_Exception);
 XlogError::XlogError(const char *file, unsigned line,
@@ -115,6 +124,7 @@ xdir_create(struct xdir *dir, const char *dirname,
 		dir->filename_ext = ".snap";
 		dir->panic_if_error = true;
 		dir->suffix = INPROGRESS;
+		dir->use_blocks = true;
 	} else {
 		strcpy(dir->open_wflags, "wx");
 		dir->sync_is_async = true;
@@ -501,6 +511,219 @@ xlog_encode_row(const struct xrow_header *row, struct iovec *iov)
 	return iovcnt;
 }
 
+int
+xlog_encode_block_row(const struct xrow_header *row, struct iovec *iov)
+{
+	int iovcnt = xrow_header_encode(row, iov, XLOG_BLOCK_ROW_HEADER_SIZE);
+	uint32_t len = iov[0].iov_len - XLOG_BLOCK_ROW_HEADER_SIZE;
+	for (int i = 1; i < iovcnt; i++)
+		len += iov[i].iov_len;
+
+	/* Always encode the length as uint32 to fill the space. */
+	char *data = (char *) iov[0].iov_base;
+	*data++ = 0xce; /* uint32 */
+	uint32_t len_be = mp_bswap_u32(len);
+	memcpy(data, &len_be, sizeof(len_be));
+
+	assert(iovcnt <= XROW_IOVMAX);
+	return iovcnt;
+}
+
+size_t
+xlog_block_bound(size_t size)
+{
+	return XLOG_BLOCK_FIXHEADER_SIZE + MAX(size, ZSTD_compressBound(size));
+}
+
+ssize_t
+xlog_encode_block(const char *rows, size_t size,
+		  enum xlog_compression compression, char *buf)
+{
+	assert(size <= UINT32_MAX);
+	char *payload = buf + XLOG_BLOCK_FIXHEADER_SIZE;
+	size_t len = size;
+	if (compression == XLOG_COMPRESSION_ZSTD) {
+		len = ZSTD_compress(payload, ZSTD_compressBound(size),
+				    rows, size, XLOG_ZSTD_LEVEL);
+		if (ZSTD_isError(len)) {
+			tnt_error(XlogError, "zstd compression failed: %s",
+				  ZSTD_getErrorName(len));
+			return -1;
+		}
+		/* Store incompressible rows as is. */
+		if (len >= size)
+			compression = XLOG_COMPRESSION_NONE;
+	}
+	if (compression == XLOG_COMPRESSION_NONE) {
+		memcpy(payload, rows, size);
+		len = size;
+	}
+	uint32_t crc32c = crc32_calc(0, payload, len);
+
+	char *data = buf;
+	*(log_magic_t *) data = block_marker;
+	data += sizeof(block_marker);
+	data = mp_encode_uint(data, len);
+	data = mp_encode_uint(data, size);
+	data = mp_encode_uint(data, compression);
+	data = mp_encode_uint(data, crc32c);
+	/* Encode padding */
+	ssize_t padding = XLOG_BLOCK_FIXHEADER_SIZE - (data - buf);
+	if (padding > 0)
+		data = mp_encode_strl(data, padding - 1) + padding - 1;
+	assert(data == buf + XLOG_BLOCK_FIXHEADER_SIZE);
+	return XLOG_BLOCK_FIXHEADER_SIZE + len;
+}
+
+/** Make sure the cursor block buffer fits @a size bytes. */
+static int
+xlog_cursor_reserve(struct xlog_cursor *i, size_t size)
+{
+	if (i->block_buf_size >= size)
+		return 0;
+	char *buf = (char *) realloc(i->block_buf, size);
+	if (buf == NULL) {
+		tnt_error(OutOfMemory, size, "realloc", "xlog block");
+		return -1;
+	}
+	i->block_buf = buf;
+	i->block_buf_size = size;
+	return 0;
+}
+
+/**
+ * Read a block of rows and uncompress it into the cursor
+ * buffer.
+ *
+ * @retval -1 error
+ * @retval 0 success
+ * @retval 1 EOF
+ */
+static int
+block_reader(struct xlog_cursor *i, FILE *f)
+{
+	const char *data;
+
+	/* Read fixed header */
+	char fixheader[XLOG_BLOCK_FIXHEADER_SIZE - sizeof(log_magic_t)];
+	if (fread(fixheader, sizeof(fixheader), 1, f) != 1) {
+		if (feof(f))
+			return 1;
+error:
+		char buf[PATH_MAX];
+		snprintf(buf, sizeof(buf), "%s: failed to read or parse block "
+			 "header at offset %" PRIu64, fio_filename(fileno(f)),
+			 (uint64_t) ftello(f));
+		tnt_error(ClientError, ER_INVALID_MSGPACK, buf);
+		return -1;
+	}
+
+	/* Decode len, unpacked len, compression and crc32 */
+	data = fixheader;
+	if (mp_check(&data, data + sizeof(fixheader)) != 0)
+		goto error;
+	data = fixheader;
+
+	if (mp_typeof(*data) != MP_UINT)
+		goto error;
+	uint64_t len = mp_decode_uint(&data);
+	if (mp_typeof(*data) != MP_UINT)
+		goto error;
+	uint64_t unpacked_len = mp_decode_uint(&data);
+	if (mp_typeof(*data) != MP_UINT)
+		goto error;
+	uint64_t compression = mp_decode_uint(&data);
+	if (mp_typeof(*data) != MP_UINT)
+		goto error;
+	uint32_t crc32c = mp_decode_uint(&data);
+	assert(data <= fixheader + sizeof(fixheader));
+	if (unpacked_len > IPROTO_BODY_LEN_MAX) {
+		char buf[PATH_MAX];
+		snprintf(buf, sizeof(buf),
+			 "%s: block is too big at offset %" PRIu64,
+			 fio_filename(fileno(f)), (uint64_t) ftello(f));
+		tnt_error(ClientError, ER_INVALID_MSGPACK, buf);
+		return -1;
+	}
+	/*
+	 * Incompressible rows are stored as is, so a compressed
+	 * block is always smaller than its rows.
+	 */
+	if (compression >= xlog_compression_MAX ||
+	    (compression == XLOG_COMPRESSION_NONE && len != unpacked_len) ||
+	    (compression != XLOG_COMPRESSION_NONE && len >= unpacked_len))
+		goto error;
+
+	if (xlog_cursor_reserve(i, unpacked_len) != 0)
+		return -1;
+	char *payload = i->block_buf;
+	if (compression != XLOG_COMPRESSION_NONE) {
+		payload = (char *) region_alloc(&fiber()->gc, len);
+		if (payload == NULL) {
+			tnt_error(OutOfMemory, len, "region", "new slab");
+			return -1;
+		}
+	}
+
+	/* Read the rows */
+	if (fread(payload, len, 1, f) != 1)
+		return 1;
+
+	/* Validate checksum */
+	if (crc32_calc(0, payload, len) != crc32c) {
+		char buf[PATH_MAX];
+
+		snprintf(buf, sizeof(buf), "%s: block checksum mismatch "
+			 "(expected %u) at offset %" PRIu64,
+			 fio_filename(fileno(f)), (unsigned) crc32c,
+			 (uint64_t) ftello(f));
+		tnt_error(ClientError, ER_INVALID_MSGPACK, buf);
+		return -1;
+	}
+
+	if (compression == XLOG_COMPRESSION_ZSTD) {
+		size_t rc = ZSTD_decompress(i->block_buf, unpacked_len,
+					    payload, len);
+		if (ZSTD_isError(rc) || rc != unpacked_len) {
+			char buf[PATH_MAX];
+
+			snprintf(buf, sizeof(buf), "%s: failed to decompress "
+				 "block at offset %" PRIu64,
+				 fio_filename(fileno(f)), (uint64_t) ftello(f));
+			tnt_error(ClientError, ER_INVALID_MSGPACK, buf);
+			return -1;
+		}
+	}
+
+	i->block_pos = i->block_buf;
+	i->block_end = i->block_buf + unpacked_len;
+	i->block_next_offset = ftello(f);
+	return 0;
+}
+
+/**
+ * Decode the next row of the current block.
+ */
+static void
+block_row_reader(struct xlog_cursor *i, struct xrow_header *row)
+{
+	const char *data = i->block_pos;
+	const char *end = i->block_end;
+	const char *len_end = data;
+	if (mp_typeof(*data) != MP_UINT || mp_check(&len_end, end) != 0)
+		goto error;
+	{
+		uint32_t len = mp_decode_uint(&data);
+		if (len > (size_t) (end - data))
+			goto error;
+		i->block_pos = data + len;
+		xrow_header_decode(row, &data, i->block_pos);
+	}
+	return;
+error:
+	tnt_raise(ClientError, ER_INVALID_MSGPACK, "block row length");
+}
+
 void
 xlog_cursor_open(struct xlog_cursor *i, struct xlog *l)
 {
@@ -508,6 +731,10 @@ xlog_cursor_open(struct xlog_cursor *i, struct xlog *l)
 	i->row_count = 0;
 	i->good_offset = ftello(l->f);
 	i->eof_read  = false;
+	i->block_buf = NULL;
+	i->block_buf_size = 0;
+	i->block_pos = i->block_end = NULL;
+	i->block_next_offset = 0;
 }
 
 void
@@ -523,6 +750,9 @@ xlog_cursor_close(struct xlog_cursor *i)
 	 * Seek back to last known good offset.
 	 */
 	fseeko(l->f, i->good_offset, SEEK_SET);
+	free(i->block_buf);
+	i->block_buf = NULL;
+	i->block_pos = i->block_end = NULL;
 	region_free(&fiber()->gc);
 }
 
@@ -554,6 +784,8 @@ xlog_cursor_next(struct xlog_cursor *i, struct xrow_header *row)
 	 */
 	region_free_after(&fiber()->gc, 128 * 1024);
 
+	if (i->block_pos < i->block_end)
+		goto block_row;
 restart:
 	if (marker_offset > 0)
 		fseeko(l->f, marker_offset + 1, SEEK_SET);
@@ -561,7 +793,7 @@ restart:
 	if (fread(&magic, sizeof(magic), 1, l->f) != 1)
 		goto eof;
 
-	while (magic != row_marker) {
+	while (magic != row_marker && magic != block_marker) {
 		int c = fgetc(l->f);
 		if (c == EOF) {
 			say_debug("eof while looking for magic");
@@ -578,8 +810,12 @@ restart:
 	say_debug("magic found at 0x%08jx", (uintmax_t)marker_offset);
 
 	try {
-		if (row_reader(l->f, row) != 0)
+		if (magic == block_marker) {
+			if (block_reader(i, l->f) != 0)
+				goto eof;
+		} else if (row_reader(l->f, row) != 0) {
 			goto eof;
+		}
 	} catch (ClientError *e) {
 		if (l->dir->panic_if_error)
 			throw;
@@ -594,9 +830,44 @@ restart:
 		goto restart;
 	}
 
+	if (magic == block_marker) {
+		/*
+		 * The cursor stays at the beginning of the block
+		 * until all its rows are read.
+		 */
+		if (i->block_pos == i->block_end) {
+			/* An empty block. */
+			i->good_offset = i->block_next_offset;
+			marker_offset = 0;
+			goto restart;
+		}
+		goto block_row;
+	}
+
 	i->good_offset = ftello(l->f);
 	i->row_count++;
 
+	if (i->row_count % 100000 == 0)
+		say_info("%.1fM rows processed", i->row_count / 1000000.);
+
+	return 0;
+block_row:
+	try {
+		block_row_reader(i, row);
+	} catch (ClientError *e) {
+		/* Skip the rest of the block. */
+		i->block_pos = i->block_end;
+		i->good_offset = i->block_next_offset;
+		if (l->dir->panic_if_error)
+			throw;
+		say_warn("failed to read row");
+		marker_offset = 0;
+		goto restart;
+	}
+	if (i->block_pos == i->block_end)
+		i->good_offset = i->block_next_offset;
+	i->row_count++;
+
 	if (i->row_count % 100000 == 0)
 		say_info("%.1fM rows processed", i->row_count / 1000000.);
 
@@ -620,7 +891,7 @@ eof:
 		if (magic == eof_marker) {
 			i->good_offset = ftello(l->f);
 			i->eof_read = true;
-		} else if (magic == row_marker) {
+		} else if (magic == row_marker || magic == block_marker) {
 			/*
 			 * Row marker at the end of a file: a sign
 			 * of a corrupt log file in case of
@@ -723,7 +994,8 @@ static int
 xlog_write_meta(struct xlog *l)
 {
 	char *vstr = NULL;
-	if (fprintf(l->f, "%s%s", l->dir->filetype, v12) < 0 ||
+	const char *version = l->dir->use_blocks ? v13 : v12;
+	if (fprintf(l->f, "%s%s", l->dir->filetype, version) < 0 ||
 	    fprintf(l->f, SERVER_UUID_KEY ": %s\n",
 		    tt_uuid_str(l->dir->server_uuid)) < 0 ||
 	    (vstr = vclock_to_string(&l->vclock)) == NULL ||
@@ -761,7 +1033,7 @@ xlog_read_meta(struct xlog *l, int64_t signature)
 		return -1;
 	}
 
-	if (strcmp(v12, version) != 0) {
+	if (strcmp(v12, version) != 0 && strcmp(v13, version) != 0) {
 		tnt_error(XlogError, "%s: unsupported file format version",
 			  l->filename);
 		return -1;
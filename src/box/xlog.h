@@ -59,6 +59,15 @@ enum xdir_type { SNAP, XLOG };
  */
 enum log_suffix { NONE, INPROGRESS };
 
+/** Compression of blocks of rows, see xlog_encode_block(). */
+enum xlog_compression {
+	XLOG_COMPRESSION_NONE = 0,
+	XLOG_COMPRESSION_ZSTD = 1,
+	xlog_compression_MAX
+};
+
+extern const char *xlog_compression_strs[];
+
 /**
  * A handle for a data directory with write ahead logs or snapshots.
  * Can be used to find the last log in the directory, scan
@@ -120,6 +129,14 @@ struct xdir {
 	char dirname[PATH_MAX+1];
 	/** Snapshots or xlogs */
 	enum xdir_type type;
+	/**
+	 * Files in this directory are written with blocks of
+	 * rows (xlog_encode_block()), which requires file
+	 * format version 0.13. Set for snapshots.
+	 */
+	bool use_blocks;
+	/** Compression of blocks written to this directory. */
+	enum xlog_compression compression;
 };
 
 /**
@@ -274,6 +291,18 @@ struct xlog_cursor
 	int row_count;
 	off_t good_offset;
 	bool eof_read;
+	/**
+	 * Rows of the block being read, uncompressed. Rows
+	 * returned from a block point here and are valid
+	 * until the next call to xlog_cursor_next().
+	 */
+	char *block_buf;
+	size_t block_buf_size;
+	/** Unread rows of the current block. */
+	const char *block_pos;
+	const char *block_end;
+	/** File offset right after the current block. */
+	off_t block_next_offset;
 };
 
 void
@@ -296,6 +325,39 @@ xlog_cursor_next(struct xlog_cursor *i, struct xrow_header *packet);
 char *
 format_filename(struct xdir *dir, int64_t signature, enum log_suffix suffix);
 
+/**
+ * Encode a row to be put into a block of rows: the row length
+ * followed by the row header and body.
+ * @sa xlog_encode_block()
+ */
+int
+xlog_encode_block_row(const struct xrow_header *row, struct iovec *iov);
+
+/**
+ * Max size of a block with @a size bytes of rows.
+ */
+size_t
+xlog_block_bound(size_t size);
+
+/**
+ * Frame rows encoded with xlog_encode_block_row() into a single
+ * block with one header and one checksum, compressing them if
+ * asked to. A block is written to a file as a whole and
+ * is read by xlog_cursor_next() row by row. Doesn't use the
+ * fiber region, so may be called from any thread.
+ *
+ * @param rows         encoded rows
+ * @param size         size of the rows
+ * @param compression  how to compress the rows
+ * @param[out] buf     a buffer of at least xlog_block_bound(size)
+ *                     bytes
+ *
+ * @return the size of the block, -1 on error (diag is set).
+ */
+ssize_t
+xlog_encode_block(const char *rows, size_t size,
+		  enum xlog_compression compression, char *buf);
+
 /**
  * Construct a row to write to the log file.
  */
@@ -38,15 +38,23 @@ struct xrow_header;
 struct xstream;
 
 typedef void (*xstream_write_f)(struct xstream *, struct xrow_header *);
+typedef void (*xstream_flush_f)(struct xstream *);
 
 struct xstream {
 	xstream_write_f write;
+	/**
+	 * Optional, called when there are no more rows to write
+	 * for now, so that a stream which batches rows can
+	 * send them out.
+	 */
+	xstream_flush_f flush;
 };
 
 static inline void
 xstream_create(struct xstream *xstream, xstream_write_f write)
 {
 	xstream->write = write;
+	xstream->flush = NULL;
 }
 
 static inline void
@@ -56,4 +64,11 @@ xstream_write(struct xstream *stream, struct xrow_header *row)
 	return stream->write(stream, row);
 }
 
+static inline void
+xstream_flush(struct xstream *stream)
+{
+	if (stream->flush != NULL)
+		stream->flush(stream);
+}
+
 #endif /* TARANTOOL_XSTREAM_H_INCLUDED */
@@ -0,0 +1,157 @@
+#ifndef TARANTOOL_LIB_SALAD_BLOOM_H_INCLUDED
+#define TARANTOOL_LIB_SALAD_BLOOM_H_INCLUDED
+
+/*
+ * Copyright 2010-2016, Tarantool AUTHORS, please see AUTHORS file.
+ *
+ * Redistribution and use in source and binary forms, with or
+ * without modification, are permitted provided that the following
+ * conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above
+ *    copyright notice, this list of conditions and the
+ *    following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above
+ *    copyright notice, this list of conditions and the following
+ *    disclaimer in the documentation and/or other materials
+ *    provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY <COPYRIGHT HOLDER> ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+ * <COPYRIGHT HOLDER> OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+ * THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+/*
+ * Classic bloom filter over a bit table. The filter doesn't
+ * hash values itself: the user passes a 32-bit hash of the
+ * value, k probe positions are derived from it with double
+ * hashing (Kirsch, Mitzenmacher, "Less Hashing, Same
+ * Performance: Building a Better Bloom Filter").
+ */
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+typedef uint32_t bloom_hash_t;
+
+struct bloom {
+	/** Size of the table, in 64-bit words. */
+	uint32_t table_size;
+	/** Number of probes per value. */
+	uint16_t hash_count;
+	/** Bit table. */
+	uint64_t *table;
+};
+
+/**
+ * Allocate and initialize an empty bloom filter.
+ * @param bloom - the filter
+ * @param number_of_values - expected number of values
+ * @param false_positive_rate - desired false positive rate,
+ *        must be in (0, 1)
+ * @retval 0 success
+ * @retval -1 memory allocation error
+ */
+int
+bloom_create(struct bloom *bloom, uint32_t number_of_values,
+	     double false_positive_rate);
+
+/**
+ * Initialize a bloom filter from a table previously stored
+ * with bloom_store().
+ * @retval 0 success
+ * @retval -1 memory allocation error
+ */
+int
+bloom_load_table(struct bloom *bloom, uint16_t hash_count,
+		 uint32_t table_size, const char *table);
+
+/**
+ * Free the memory allocated by the filter.
+ */
+void
+bloom_destroy(struct bloom *bloom);
+
+/**
+ * Size of the memory needed to store the filter table.
+ */
+static inline size_t
+bloom_store_size(const struct bloom *bloom)
+{
+	return bloom->table_size * sizeof(*bloom->table);
+}
+
+/**
+ * Store the filter table to the buffer.
+ * @return pointer past the last written byte
+ */
+char *
+bloom_store(const struct bloom *bloom, char *buf);
+
+/** Calculate the secondary hash used for double hashing. */
+static inline uint32_t
+bloom_hash2(bloom_hash_t hash)
+{
+	/* An odd number, so that probes don't collapse. */
+	return ((hash >> 17) | (hash << 15)) * 0x5bd1e995U | 1;
+}
+
+/**
+ * Add a value to the filter.
+ * @param hash - hash of the value
+ */
+static inline void
+bloom_add(struct bloom *bloom, bloom_hash_t hash)
+{
+	uint64_t bit_count = (uint64_t) bloom->table_size * 64;
+	uint32_t h2 = bloom_hash2(hash);
+	uint64_t probe = hash;
+	for (uint16_t i = 0; i < bloom->hash_count; i++) {
+		uint64_t bit = probe % bit_count;
+		bloom->table[bit / 64] |= (uint64_t) 1 << (bit % 64);
+		probe += h2;
+	}
+}
+
+/**
+ * Check if a value may be in the filter.
+ * @param hash - hash of the value
+ * @retval false - the value definitely wasn't added
+ * @retval true - the value was added or it's a false positive
+ */
+static inline bool
+bloom_possible_has(const struct bloom *bloom, bloom_hash_t hash)
+{
+	uint64_t bit_count = (uint64_t) bloom->table_size * 64;
+	uint32_t h2 = bloom_hash2(hash);
+	uint64_t probe = hash;
+	for (uint16_t i = 0; i < bloom->hash_count; i++) {
+		uint64_t bit = probe % bit_count;
+		if (!(bloom->table[bit / 64] & ((uint64_t) 1 << (bit % 64))))
+			return false;
+		probe += h2;
+	}
+	return true;
+}
+
+#if defined(__cplusplus)
+} /* extern C */
+#endif
+
+#endif /* TARANTOOL_LIB_SALAD_BLOOM_H_INCLUDED */
@@ -141,6 +141,10 @@
  * size_t bps_tree_size(tree);
  * size_t bps_tree_mem_used(tree);
  * bps_tree_elem_t *bps_tree_random(tree, rnd);
+ * // only with BPS_TREE_SUBTREE_COUNT:
+ * size_t bps_tree_lower_bound_rank(tree, key);
+ * size_t bps_tree_upper_bound_rank(tree, key);
+ * size_t bps_tree_count_between(tree, low_key, high_key);
  * int bps_tree_debug_check(tree);
  * void bps_tree_print(tree, "%p");
  * int bps_tree_debug_check_internal_functions(assert_on_error);
@@ -157,6 +161,13 @@
  * bool bps_tree_iterator_prev(tree, itr);
  * void bps_tree_iterator_freeze(tree, itr);
  * void bps_tree_iterator_destroy(tree, itr);
+ * // read views:
+ * void bps_tree_view_create(tree, view);
+ * void bps_tree_view_destroy(tree, view);
+ * struct bps_tree_iterator bps_tree_view_first(tree, view);
+ * struct bps_tree_iterator bps_tree_view_last(tree, view);
+ * struct bps_tree_iterator bps_tree_view_lower_bound(tree, view, key, exact);
+ * struct bps_tree_iterator bps_tree_view_upper_bound(tree, view, key, exact);
  */
 /* }}} */
 
@@ -277,6 +288,16 @@
  * #define BPS_BLOCK_LINEAR_SEARCH
  */
 
+/**
+ * A switch that makes every inner block keep the number of
+ * elements in its subtree. It costs one size_t per inner block
+ * and a counter update along the path on every insertion or
+ * deletion, but allows to calculate the position (rank) of a key
+ * in the tree and the number of elements between two keys in
+ * logarithmic time. To turn it on
+ * #define BPS_TREE_SUBTREE_COUNT
+ */
+
 /**
  * A switch that enables collection of executions of different
  * branches of code. Used only for debug purposes, I hope you
@@ -348,6 +369,9 @@ typedef uint32_t bps_tree_block_id_t;
 #define bps_tree_size _api_name(size)
 #define bps_tree_mem_used _api_name(mem_used)
 #define bps_tree_random _api_name(random)
+#define bps_tree_lower_bound_rank _api_name(lower_bound_rank)
+#define bps_tree_upper_bound_rank _api_name(upper_bound_rank)
+#define bps_tree_count_between _api_name(count_between)
 #define bps_tree_invalid_iterator _api_name(invalid_iterator)
 #define bps_tree_iterator_is_invalid _api_name(iterator_is_invalid)
 #define bps_tree_iterator_are_equal _api_name(iterator_are_equal)
@@ -360,6 +384,13 @@ typedef uint32_t bps_tree_block_id_t;
 #define bps_tree_iterator_prev _api_name(iterator_prev)
 #define bps_tree_iterator_freeze _api_name(iterator_freeze)
 #define bps_tree_iterator_destroy _api_name(iterator_destroy)
+#define bps_tree_view _api_name(view)
+#define bps_tree_view_create _api_name(view_create)
+#define bps_tree_view_destroy _api_name(view_destroy)
+#define bps_tree_view_first _api_name(view_first)
+#define bps_tree_view_last _api_name(view_last)
+#define bps_tree_view_lower_bound _api_name(view_lower_bound)
+#define bps_tree_view_upper_bound _api_name(view_upper_bound)
 #define bps_tree_debug_check _api_name(debug_check)
 #define bps_tree_print _api_name(print)
 #define bps_tree_debug_check_internal_functions \
@@ -378,6 +409,11 @@ typedef uint32_t bps_tree_block_id_t;
 #define bps_tree_restore_block_ver _bps_tree(restore_block_ver)
 #define bps_tree_root _bps_tree(root)
 #define bps_tree_touch_block _bps_tree(touch_block)
+#define bps_tree_subtree_count _bps_tree(subtree_count)
+#define bps_tree_children_count _bps_tree(children_count)
+#define bps_tree_children_count_before _bps_tree(children_count_before)
+#define bps_tree_inner_recount _bps_tree(inner_recount)
+#define bps_tree_update_path_count _bps_tree(update_path_count)
 #define bps_tree_find_ins_point_key _bps_tree(find_ins_point_key)
 #define bps_tree_find_ins_point_elem _bps_tree(find_ins_point_elem)
 #define bps_tree_find_after_ins_point_key _bps_tree(find_after_ins_point_key)
@@ -532,6 +568,25 @@ struct bps_tree_iterator {
 	struct matras_view view;
 };
 
+/**
+ * Read view of a tree. Unlike a frozen iterator, can be searched
+ * for a key. Iterators of a read view share its matras view and
+ * must not be destroyed. A read view and its iterators may be
+ * used in another thread, while the tree is being modified.
+ */
+struct bps_tree_view {
+	/* Version of matras memory for MVCC */
+	struct matras_view view;
+	/* ID of root block at the moment of view creation */
+	bps_tree_block_id_t root_id;
+	/* IDs of first and last block at the moment of view creation */
+	bps_tree_block_id_t first_id, last_id;
+	/* Depth of the tree at the moment of view creation */
+	bps_tree_block_id_t depth;
+	/* Number of elements at the moment of view creation */
+	size_t size;
+};
+
 /**
  * Pointer to function that allocates extent of size BPS_TREE_EXTENT_SIZE
  * BPS-tree properly handles with NULL result but could leak memory
@@ -637,6 +692,40 @@ bps_tree_mem_used(const struct bps_tree *tree);
 bps_tree_elem_t *
 bps_tree_random(const struct bps_tree *tree, size_t rnd);
 
+#ifdef BPS_TREE_SUBTREE_COUNT
+/**
+ * @brief Get the number of elements that are less than the key,
+ *  i.e. the position of the lower bound of the key in the tree.
+ * @param tree - pointer to a tree
+ * @param key - key that will be compared with elements
+ * @return - count of elements less than the key
+ */
+size_t
+bps_tree_lower_bound_rank(const struct bps_tree *tree, bps_tree_key_t key);
+
+/**
+ * @brief Get the number of elements that are less than or equal to
+ *  the key, i.e. the position of the upper bound of the key in the tree.
+ * @param tree - pointer to a tree
+ * @param key - key that will be compared with elements
+ * @return - count of elements less than or equal to the key
+ */
+size_t
+bps_tree_upper_bound_rank(const struct bps_tree *tree, bps_tree_key_t key);
+
+/**
+ * @brief Get the number of elements that are greater than or equal to
+ *  low_key and less than or equal to high_key.
+ * @param tree - pointer to a tree
+ * @param low_key - lower key of the range
+ * @param high_key - upper key of the range
+ * @return - count of elements in the range
+ */
+size_t
+bps_tree_count_between(const struct bps_tree *tree, bps_tree_key_t low_key,
+		       bps_tree_key_t high_key);
+#endif /* BPS_TREE_SUBTREE_COUNT */
+
 /**
  * @brief Get an invalid iterator. See iterator description.
  * @return - Invalid iterator
@@ -764,6 +853,60 @@ bps_tree_iterator_freeze(struct bps_tree *tree, struct bps_tree_iterator *itr);
 void
 bps_tree_iterator_destroy(struct bps_tree *tree, struct bps_tree_iterator *itr);
 
+/**
+ * @brief Create a read view of the tree. All following tree
+ * modifications will not be visible in the view. The view must
+ * be destroyed with bps_tree_view_destroy after usage.
+ * @param tree - pointer to a tree
+ * @param view - pointer to a view
+ */
+void
+bps_tree_view_create(struct bps_tree *tree, struct bps_tree_view *view);
+
+/**
+ * @brief Destroy a read view of the tree.
+ * @param tree - pointer to a tree
+ * @param view - pointer to a view
+ */
+void
+bps_tree_view_destroy(struct bps_tree *tree, struct bps_tree_view *view);
+
+/**
+ * @brief Get an iterator to the first element of a read view.
+ * @param tree - pointer to a tree
+ * @param view - pointer to a view
+ * @return - First iterator. Could be invalid if the view is empty.
+ */
+struct bps_tree_iterator
+bps_tree_view_first(const struct bps_tree *tree,
+		    const struct bps_tree_view *view);
+
+/**
+ * @brief Get an iterator to the last element of a read view.
+ * @param tree - pointer to a tree
+ * @param view - pointer to a view
+ * @return - Last iterator. Could be invalid if the view is empty.
+ */
+struct bps_tree_iterator
+bps_tree_view_last(const struct bps_tree *tree,
+		   const struct bps_tree_view *view);
+
+/**
+ * @brief bps_tree_lower_bound() in a read view.
+ */
+struct bps_tree_iterator
+bps_tree_view_lower_bound(const struct bps_tree *tree,
+			  const struct bps_tree_view *view,
+			  bps_tree_key_t key, bool *exact);
+
+/**
+ * @brief bps_tree_upper_bound() in a read view.
+ */
+struct bps_tree_iterator
+bps_tree_view_upper_bound(const struct bps_tree *tree,
+			  const struct bps_tree_view *view,
+			  bps_tree_key_t key, bool *exact);
+
 /**
  * @brief Debug self-checking. Returns bitmask of found errors (0
  * on success).
@@ -830,6 +973,18 @@ struct bps_block {
 	bps_tree_pos_t size;
 };
 
+/**
+ * Size of the part of an inner block that precedes its arrays
+ * (the subtree count is aligned after the block header)
+ */
+#ifdef BPS_TREE_SUBTREE_COUNT
+#define BPS_TREE_INNER_HEADER_SIZE \
+	(((sizeof(struct bps_block) + sizeof(size_t) - 1) / sizeof(size_t) \
+	  + 1) * sizeof(size_t))
+#else
+#define BPS_TREE_INNER_HEADER_SIZE (sizeof(struct bps_block))
+#endif
+
 /**
  * Calculation of max sizes (max count + 1)
  */
@@ -839,7 +994,7 @@ enum bps_tree_max_sizes {
 		 - 2 * sizeof(bps_tree_block_id_t) )
 		/ sizeof(bps_tree_elem_t),
 	BPS_TREE_MAX_COUNT_IN_INNER =
-		(BPS_TREE_BLOCK_SIZE - sizeof(struct bps_block))
+		(BPS_TREE_BLOCK_SIZE - BPS_TREE_INNER_HEADER_SIZE)
 		/ (sizeof(bps_tree_elem_t) + sizeof(bps_tree_block_id_t)),
 	BPS_TREE_MAX_DEPTH = 16
 };
@@ -882,6 +1037,10 @@ CT_ASSERT_G(sizeof(struct bps_leaf) <= BPS_TREE_BLOCK_SIZE);
 struct bps_inner {
 	/* Block header */
 	struct bps_block header;
+#ifdef BPS_TREE_SUBTREE_COUNT
+	/* Total count of elements in leaves of the subtree */
+	size_t subtree_count;
+#endif
 	/* Ordered array of elements. Note -1 in size. See struct descr. */
 	bps_tree_elem_t elems[BPS_TREE_MAX_COUNT_IN_INNER - 1];
 	/* Corresponding child IDs */
@@ -1089,6 +1248,9 @@ bps_tree_build(struct bps_tree *tree, bps_tree_elem_t *sorted_array,
 				}
 				parents[i]->header.type = BPS_TREE_BT_INNER;
 				parents[i]->header.size = 0;
+#ifdef BPS_TREE_SUBTREE_COUNT
+				parents[i]->subtree_count = 0;
+#endif
 				inner_count++;
 			}
 			parents[i]->child_ids[parents[i]->header.size] =
@@ -1102,6 +1264,12 @@ bps_tree_build(struct bps_tree *tree, bps_tree_elem_t *sorted_array,
 			}
 		}
 
+#ifdef BPS_TREE_SUBTREE_COUNT
+		/* The leaf belongs to subtrees of all the open parents */
+		for (bps_tree_block_id_t i = 0; i < depth - 1; i++)
+			parents[i]->subtree_count += leaf->header.size;
+#endif
+
 		bps_tree_elem_t insert_value = current[leaf->header.size - 1];
 		for (bps_tree_block_id_t i = 0; i < depth - 1; i++) {
 			parents[i]->header.size++;
@@ -1218,6 +1386,65 @@ bps_tree_touch_block(struct bps_tree *tree, bps_tree_block_id_t id)
 	return (struct bps_block *)matras_touch(&tree->matras, id);
 }
 
+#ifdef BPS_TREE_SUBTREE_COUNT
+/**
+ * @brief Get count of elements in a subtree by ID of its root block.
+ */
+static inline size_t
+bps_tree_subtree_count(const struct bps_tree *tree, bps_tree_block_id_t id)
+{
+	struct bps_block *block = bps_tree_restore_block(tree, id);
+	if (block->type == BPS_TREE_BT_LEAF)
+		return block->size;
+	assert(block->type == BPS_TREE_BT_INNER);
+	return ((struct bps_inner *)block)->subtree_count;
+}
+
+/**
+ * @brief Get count of elements in subtrees of children [begin, end)
+ *  of an inner block.
+ */
+static inline size_t
+bps_tree_children_count(const struct bps_tree *tree,
+			const struct bps_inner *inner,
+			bps_tree_pos_t begin, bps_tree_pos_t end)
+{
+	size_t count = 0;
+	for (bps_tree_pos_t i = begin; i < end; i++)
+		count += bps_tree_subtree_count(tree, inner->child_ids[i]);
+	return count;
+}
+
+/**
+ * @brief Get count of elements in subtrees of children before pos
+ *  of an inner block. Walks the shorter side of the block.
+ */
+static inline size_t
+bps_tree_children_count_before(const struct bps_tree *tree,
+			       const struct bps_inner *inner,
+			       bps_tree_pos_t pos)
+{
+	if (pos <= inner->header.size / 2)
+		return bps_tree_children_count(tree, inner, 0, pos);
+	return inner->subtree_count -
+	       bps_tree_children_count(tree, inner, pos, inner->header.size);
+}
+
+/**
+ * @brief Recalculate the subtree count of an inner block after its
+ *  children were rearranged.
+ */
+static inline void
+bps_tree_inner_recount(struct bps_tree *tree, struct bps_inner *inner)
+{
+	/* exclusive behaviuor for debug checks */
+	if (tree->root_id == (bps_tree_block_id_t) -1)
+		return;
+	inner->subtree_count = bps_tree_children_count(tree, inner, 0,
+						       inner->header.size);
+}
+#endif /* BPS_TREE_SUBTREE_COUNT */
+
 /**
  * @brief Get a random element in a tree.
  * @param tree - pointer to a tree
@@ -1635,6 +1862,85 @@ bps_tree_upper_bound(const struct bps_tree *tree, bps_tree_key_t key,
 	return res;
 }
 
+#ifdef BPS_TREE_SUBTREE_COUNT
+/**
+ * @brief Get the number of elements that are less than the key.
+ * @param tree - pointer to a tree
+ * @param key - key that will be compared with elements
+ * @return - count of elements less than the key
+ */
+inline size_t
+bps_tree_lower_bound_rank(const struct bps_tree *tree, bps_tree_key_t key)
+{
+	if (tree->root_id == (bps_tree_block_id_t)(-1))
+		return 0;
+	size_t rank = 0;
+	bool exact = false;
+	struct bps_block *block = bps_tree_root(tree);
+	for (bps_tree_block_id_t i = 0; i < tree->depth - 1; i++) {
+		struct bps_inner *inner = (struct bps_inner *)block;
+		bps_tree_pos_t pos;
+		pos = bps_tree_find_ins_point_key(tree, inner->elems,
+						  inner->header.size - 1,
+						  key, &exact);
+		rank += bps_tree_children_count_before(tree, inner, pos);
+		block = bps_tree_restore_block(tree, inner->child_ids[pos]);
+	}
+	struct bps_leaf *leaf = (struct bps_leaf *)block;
+	rank += bps_tree_find_ins_point_key(tree, leaf->elems,
+					    leaf->header.size, key, &exact);
+	return rank;
+}
+
+/**
+ * @brief Get the number of elements that are less than or equal to
+ *  the key.
+ * @param tree - pointer to a tree
+ * @param key - key that will be compared with elements
+ * @return - count of elements less than or equal to the key
+ */
+inline size_t
+bps_tree_upper_bound_rank(const struct bps_tree *tree, bps_tree_key_t key)
+{
+	if (tree->root_id == (bps_tree_block_id_t)(-1))
+		return 0;
+	size_t rank = 0;
+	bool exact = false;
+	struct bps_block *block = bps_tree_root(tree);
+	for (bps_tree_block_id_t i = 0; i < tree->depth - 1; i++) {
+		struct bps_inner *inner = (struct bps_inner *)block;
+		bps_tree_pos_t pos;
+		pos = bps_tree_find_after_ins_point_key(tree, inner->elems,
+							inner->header.size - 1,
+							key, &exact);
+		rank += bps_tree_children_count_before(tree, inner, pos);
+		block = bps_tree_restore_block(tree, inner->child_ids[pos]);
+	}
+	struct bps_leaf *leaf = (struct bps_leaf *)block;
+	rank += bps_tree_find_after_ins_point_key(tree, leaf->elems,
+						  leaf->header.size,
+						  key, &exact);
+	return rank;
+}
+
+/**
+ * @brief Get the number of elements that are greater than or equal to
+ *  low_key and less than or equal to high_key.
+ * @param tree - pointer to a tree
+ * @param low_key - lower key of the range
+ * @param high_key - upper key of the range
+ * @return - count of elements in the range
+ */
+inline size_t
+bps_tree_count_between(const struct bps_tree *tree, bps_tree_key_t low_key,
+		       bps_tree_key_t high_key)
+{
+	size_t low = bps_tree_lower_bound_rank(tree, low_key);
+	size_t high = bps_tree_upper_bound_rank(tree, high_key);
+	return high > low ? high - low : 0;
+}
+#endif /* BPS_TREE_SUBTREE_COUNT */
+
 /**
  * @brief Get a pointer to the element pointed by iterator.
  *  If iterator is detected as broken, it is invalidated and NULL returned.
@@ -1741,6 +2047,169 @@ bps_tree_iterator_destroy(struct bps_tree *tree, struct bps_tree_iterator *itr)
 	matras_destroy_read_view(&tree->matras, &itr->view);
 }
 
+/**
+ * @brief Create a read view of the tree. All following tree
+ * modifications will not be visible in the view. The view must
+ * be destroyed with bps_tree_view_destroy after usage.
+ * @param tree - pointer to a tree
+ * @param view - pointer to a view
+ */
+inline void
+bps_tree_view_create(struct bps_tree *tree, struct bps_tree_view *view)
+{
+	matras_create_read_view(&tree->matras, &view->view);
+	view->root_id = tree->root_id;
+	view->first_id = tree->first_id;
+	view->last_id = tree->last_id;
+	view->depth = tree->depth;
+	view->size = tree->size;
+}
+
+/**
+ * @brief Destroy a read view of the tree.
+ * @param tree - pointer to a tree
+ * @param view - pointer to a view
+ */
+inline void
+bps_tree_view_destroy(struct bps_tree *tree, struct bps_tree_view *view)
+{
+	matras_destroy_read_view(&tree->matras, &view->view);
+}
+
+/**
+ * @brief Get an iterator to the first element of a read view.
+ * @param tree - pointer to a tree
+ * @param view - pointer to a view
+ * @return - First iterator. Could be invalid if the view is empty.
+ */
+inline struct bps_tree_iterator
+bps_tree_view_first(const struct bps_tree *tree,
+		    const struct bps_tree_view *view)
+{
+	(void)tree;
+	struct bps_tree_iterator itr;
+	itr.block_id = view->first_id;
+	itr.pos = 0;
+	itr.view = view->view;
+	return itr;
+}
+
+/**
+ * @brief Get an iterator to the last element of a read view.
+ * @param tree - pointer to a tree
+ * @param view - pointer to a view
+ * @return - Last iterator. Could be invalid if the view is empty.
+ */
+inline struct bps_tree_iterator
+bps_tree_view_last(const struct bps_tree *tree,
+		   const struct bps_tree_view *view)
+{
+	(void)tree;
+	struct bps_tree_iterator itr;
+	itr.block_id = view->last_id;
+	itr.pos = (bps_tree_pos_t)(-1);
+	itr.view = view->view;
+	return itr;
+}
+
+/**
+ * @brief bps_tree_lower_bound() in a read view.
+ */
+inline struct bps_tree_iterator
+bps_tree_view_lower_bound(const struct bps_tree *tree,
+			  const struct bps_tree_view *view,
+			  bps_tree_key_t key, bool *exact)
+{
+	struct bps_tree_iterator res;
+	res.view = view->view;
+	bool local_result;
+	if (!exact)
+		exact = &local_result;
+	*exact = false;
+	if (view->root_id == (bps_tree_block_id_t)(-1)) {
+		res.block_id = (bps_tree_block_id_t)(-1);
+		res.pos = 0;
+		return res;
+	}
+	bps_tree_block_id_t block_id = view->root_id;
+	struct bps_block *block =
+		bps_tree_restore_block_ver(tree, block_id, &res.view);
+	for (bps_tree_block_id_t i = 0; i < view->depth - 1; i++) {
+		struct bps_inner *inner = (struct bps_inner *)block;
+		bps_tree_pos_t pos;
+		pos = bps_tree_find_ins_point_key(tree, inner->elems,
+						  inner->header.size - 1,
+						  key, exact);
+		block_id = inner->child_ids[pos];
+		block = bps_tree_restore_block_ver(tree, block_id, &res.view);
+	}
+
+	struct bps_leaf *leaf = (struct bps_leaf *)block;
+	bps_tree_pos_t pos;
+	pos = bps_tree_find_ins_point_key(tree, leaf->elems, leaf->header.size,
+					  key, exact);
+	if (pos >= leaf->header.size) {
+		res.block_id = leaf->next_id;
+		res.pos = 0;
+	} else {
+		res.block_id = block_id;
+		res.pos = pos;
+	}
+	return res;
+}
+
+/**
+ * @brief bps_tree_upper_bound() in a read view.
+ */
+inline struct bps_tree_iterator
+bps_tree_view_upper_bound(const struct bps_tree *tree,
+			  const struct bps_tree_view *view,
+			  bps_tree_key_t key, bool *exact)
+{
+	struct bps_tree_iterator res;
+	res.view = view->view;
+	bool local_result;
+	if (!exact)
+		exact = &local_result;
+	*exact = false;
+	bool exact_test;
+	if (view->root_id == (bps_tree_block_id_t)(-1)) {
+		res.block_id = (bps_tree_block_id_t)(-1);
+		res.pos = 0;
+		return res;
+	}
+	bps_tree_block_id_t block_id = view->root_id;
+	struct bps_block *block =
+		bps_tree_restore_block_ver(tree, block_id, &res.view);
+	for (bps_tree_block_id_t i = 0; i < view->depth - 1; i++) {
+		struct bps_inner *inner = (struct bps_inner *)block;
+		bps_tree_pos_t pos;
+		pos = bps_tree_find_after_ins_point_key(tree, inner->elems,
+							inner->header.size - 1,
+							key, &exact_test);
+		if (exact_test)
+			*exact = true;
+		block_id = inner->child_ids[pos];
+		block = bps_tree_restore_block_ver(tree, block_id, &res.view);
+	}
+
+	struct bps_leaf *leaf = (struct bps_leaf *)block;
+	bps_tree_pos_t pos;
+	pos = bps_tree_find_after_ins_point_key(tree, leaf->elems,
+						leaf->header.size,
+						key, &exact_test);
+	if (exact_test)
+		*exact = true;
+	if (pos >= leaf->header.size) {
+		res.block_id = leaf->next_id;
+		res.pos = 0;
+	} else {
+		res.block_id = block_id;
+		res.pos = pos;
+	}
+	return res;
+}
+
 /**
  * @brief Find the first element that is equal to the key (comparator returns 0)
  * @param tree - pointer to a tree
@@ -1843,6 +2312,9 @@ bps_tree_create_inner(struct bps_tree *tree, bps_tree_block_id_t *id)
 	if (!res)
 		res = (struct bps_inner *)matras_alloc(&tree->matras, id);
 	res->header.type = BPS_TREE_BT_INNER;
+#ifdef BPS_TREE_SUBTREE_COUNT
+	res->subtree_count = 0;
+#endif
 	tree->inner_count++;
 	return res;
 }
@@ -2012,6 +2484,26 @@ bps_tree_touch_path(struct bps_tree *tree,
 	}
 }
 
+#ifdef BPS_TREE_SUBTREE_COUNT
+/**
+ * @brief Add delta to subtree counts of all inner blocks of the path.
+ *  Must be called before an element is inserted to or deleted from the
+ *  leaf of the path; rebalancing keeps the counts consistent after that.
+ */
+static inline void
+bps_tree_update_path_count(struct bps_tree *tree,
+			   struct bps_leaf_path_elem *leaf_path_elem,
+			   int delta)
+{
+	for (struct bps_inner_path_elem *path = leaf_path_elem->parent;
+	     path; path = path->parent) {
+		path->block = (struct bps_inner *)
+			bps_tree_touch_block(tree, path->block_id);
+		path->block->subtree_count += delta;
+	}
+}
+#endif
+
 /**
  * @brief Replace element by it's path and fill the *replaced argument
  */
@@ -2345,6 +2837,10 @@ bps_tree_move_elems_to_right_inner(struct bps_tree *tree,
 
 	a->header.size -= num;
 	b->header.size += num;
+#ifdef BPS_TREE_SUBTREE_COUNT
+	bps_tree_inner_recount(tree, a);
+	bps_tree_inner_recount(tree, b);
+#endif
 }
 
 /**
@@ -2424,6 +2920,10 @@ bps_tree_move_elems_to_left_inner(struct bps_tree *tree,
 
 	a->header.size += num;
 	b->header.size -= num;
+#ifdef BPS_TREE_SUBTREE_COUNT
+	bps_tree_inner_recount(tree, a);
+	bps_tree_inner_recount(tree, b);
+#endif
 }
 
 /**
@@ -2623,6 +3123,10 @@ bps_tree_insert_and_move_elems_to_right_inner(struct bps_tree *tree,
 
 	a->header.size -= (num - 1);
 	b->header.size += num;
+#ifdef BPS_TREE_SUBTREE_COUNT
+	bps_tree_inner_recount(tree, a);
+	bps_tree_inner_recount(tree, b);
+#endif
 }
 
 /**
@@ -2816,6 +3320,10 @@ bps_tree_insert_and_move_elems_to_left_inner(struct bps_tree *tree,
 
 	a->header.size += num;
 	b->header.size -= (num - 1);
+#ifdef BPS_TREE_SUBTREE_COUNT
+	bps_tree_inner_recount(tree, a);
+	bps_tree_inner_recount(tree, b);
+#endif
 }
 
 /**
@@ -3325,6 +3833,9 @@ bps_tree_process_insert_leaf(struct bps_tree *tree,
 		new_root->child_ids[0] = tree->root_id;
 		new_root->child_ids[1] = new_block_id;
 		new_root->elems[0] = tree->max_elem;
+#ifdef BPS_TREE_SUBTREE_COUNT
+		bps_tree_inner_recount(tree, new_root);
+#endif
 		tree->root_id = new_root_id;
 		tree->max_elem = new_max_elem;
 		tree->depth++;
@@ -3641,6 +4152,9 @@ bps_tree_process_insert_inner(struct bps_tree *tree,
 		new_root->child_ids[0] = tree->root_id;
 		new_root->child_ids[1] = new_block_id;
 		new_root->elems[0] = tree->max_elem;
+#ifdef BPS_TREE_SUBTREE_COUNT
+		bps_tree_inner_recount(tree, new_root);
+#endif
 		tree->root_id = new_root_id;
 		tree->max_elem = new_max_elem;
 		tree->depth++;
@@ -4054,10 +4568,18 @@ bps_tree_insert(struct bps_tree *tree, bps_tree_elem_t new_elem,
 		bps_tree_process_replace(tree, &leaf_path_elem, new_elem,
 					 replaced);
 		return 0;
-	} else {
-		return bps_tree_process_insert_leaf(tree, &leaf_path_elem,
-						    new_elem);
 	}
+#ifdef BPS_TREE_SUBTREE_COUNT
+	bps_tree_update_path_count(tree, &leaf_path_elem, 1);
+	if (bps_tree_process_insert_leaf(tree, &leaf_path_elem,
+					 new_elem) != 0) {
+		bps_tree_update_path_count(tree, &leaf_path_elem, -1);
+		return -1;
+	}
+	return 0;
+#else
+	return bps_tree_process_insert_leaf(tree, &leaf_path_elem, new_elem);
+#endif
 }
 
 /**
@@ -4079,6 +4601,9 @@ bps_tree_delete(struct bps_tree *tree, bps_tree_elem_t elem)
 	if (!exact)
 		return -1;
 
+#ifdef BPS_TREE_SUBTREE_COUNT
+	bps_tree_update_path_count(tree, &leaf_path_elem, -1);
+#endif
 	bps_tree_process_delete_leaf(tree, &leaf_path_elem);
 	return 0;
 }
@@ -4194,6 +4719,9 @@ bps_tree_debug_check_block(const struct bps_tree *tree, struct bps_block *block,
 				result |= 0x4000000;
 		}
 
+#ifdef BPS_TREE_SUBTREE_COUNT
+		size_t count_before = *calc_count;
+#endif
 		for (bps_tree_pos_t i = 0; i < block->size; i++)
 			result |= bps_tree_debug_check_block(tree,
 				bps_tree_restore_block(tree,
@@ -4201,6 +4729,10 @@ bps_tree_debug_check_block(const struct bps_tree *tree, struct bps_block *block,
 				inner->child_ids[i], level - 1, calc_count,
 				expected_prev_id, expected_this_id,
 				check_fullness_next);
+#ifdef BPS_TREE_SUBTREE_COUNT
+		if (inner->subtree_count != *calc_count - count_before)
+			result |= 0x8000000;
+#endif
 		return result;
 	}
 }
@@ -5576,6 +6108,7 @@ bps_tree_debug_check_internal_functions(bool assertme)
 
 #undef BPS_TREE_MEMMOVE
 #undef BPS_TREE_DATAMOVE
+#undef BPS_TREE_INNER_HEADER_SIZE
 #undef BPS_TREE_BRANCH_TRACE
 
 /* {{{ Macros for custom naming of structs and functions */
@@ -5603,6 +6136,9 @@ bps_tree_debug_check_internal_functions(bool assertme)
 #undef bps_tree_size
 #undef bps_tree_mem_used
 #undef bps_tree_random
+#undef bps_tree_lower_bound_rank
+#undef bps_tree_upper_bound_rank
+#undef bps_tree_count_between
 #undef bps_tree_invalid_iterator
 #undef bps_tree_iterator_is_invalid
 #undef bps_tree_iterator_are_equal
@@ -5615,6 +6151,13 @@ bps_tree_debug_check_internal_functions(bool assertme)
 #undef bps_tree_iterator_prev
 #undef bps_tree_iterator_freeze
 #undef bps_tree_iterator_destroy
+#undef bps_tree_view
+#undef bps_tree_view_create
+#undef bps_tree_view_destroy
+#undef bps_tree_view_first
+#undef bps_tree_view_last
+#undef bps_tree_view_lower_bound
+#undef bps_tree_view_upper_bound
 #undef bps_tree_debug_check
 #undef bps_tree_print
 #undef bps_tree_debug_check_internal_functions
@@ -5632,6 +6175,11 @@ bps_tree_debug_check_internal_functions(bool assertme)
 #undef bps_tree_restore_block_ver
 #undef bps_tree_root
 #undef bps_tree_touch_block
+#undef bps_tree_subtree_count
+#undef bps_tree_children_count
+#undef bps_tree_children_count_before
+#undef bps_tree_inner_recount
+#undef bps_tree_update_path_count
 #undef bps_tree_find_ins_point_key
 #undef bps_tree_find_ins_point_elem
 #undef bps_tree_find_after_ins_point_key
@@ -0,0 +1,1053 @@
+/*
+ * *No header guard*: the header is allowed to be included twice
+ * with different sets of defines.
+ */
+/*
+ * Copyright 2010-2017, Tarantool AUTHORS, please see AUTHORS file.
+ *
+ * Redistribution and use in source and binary forms, with or
+ * without modification, are permitted provided that the following
+ * conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above
+ *    copyright notice, this list of conditions and the
+ *    following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above
+ *    copyright notice, this list of conditions and the following
+ *    disclaimer in the documentation and/or other materials
+ *    provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY <COPYRIGHT HOLDER> ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+ * <COPYRIGHT HOLDER> OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+ * THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+/*
+ * Open addressing hash table with a "swiss table" layout.
+ *
+ * Slots are grouped by SWISS_GROUP_SIZE. Every group keeps a control
+ * byte per slot, which is either EMPTY, DELETED, or 7 bits of the
+ * hash of the value stored in the slot. A lookup matches all
+ * control bytes of a group at once (with SSE2 if available) and
+ * then compares the full 32-bit hash, which is stored next to the
+ * value, so a mismatching value is almost never passed to
+ * SWISS_EQUAL. Stored hashes are reused when the table grows.
+ *
+ * Groups live in matras blocks, so that iterators can be frozen
+ * like with light.h. When the table grows, a new matras is
+ * allocated and the values are moved into it one group per
+ * insert, so that no single insert pays for moving the whole
+ * table. Until all groups are moved, lookups search both
+ * storages. The old matras is kept until it is drained and its
+ * last read view is destroyed.
+ *
+ * The interface follows light.h, so that a user can switch between
+ * the two by renaming the calls.
+ */
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <assert.h>
+#include "small/matras.h"
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+/**
+ * Additional user defined name that appended to prefix 'swiss'
+ * for all names of structs and functions in this header file.
+ * May be empty, but still have to be defined (just #define SWISS_NAME)
+ */
+#ifndef SWISS_NAME
+#error "SWISS_NAME must be defined"
+#endif
+
+/**
+ * Data type that hash table holds. Must be not greater than 8 bytes.
+ */
+#ifndef SWISS_DATA_TYPE
+#error "SWISS_DATA_TYPE must be defined"
+#endif
+
+/**
+ * Data type that used to for finding values.
+ */
+#ifndef SWISS_KEY_TYPE
+#error "SWISS_KEY_TYPE must be defined"
+#endif
+
+/**
+ * Type of optional third parameter of comparing function.
+ * If not needed, simply use #define SWISS_CMP_ARG_TYPE int
+ */
+#ifndef SWISS_CMP_ARG_TYPE
+#error "SWISS_CMP_ARG_TYPE must be defined"
+#endif
+
+/**
+ * Data comparing function, see LIGHT_EQUAL.
+ */
+#ifndef SWISS_EQUAL
+#error "SWISS_EQUAL must be defined"
+#endif
+
+/**
+ * Data with key comparing function, see LIGHT_EQUAL_KEY.
+ */
+#ifndef SWISS_EQUAL_KEY
+#error "SWISS_EQUAL_KEY must be defined"
+#endif
+
+/**
+ * Tools for name substitution:
+ */
+#ifndef CONCAT4
+#define CONCAT4_R(a, b, c, d) a##b##c##d
+#define CONCAT4(a, b, c, d) CONCAT4_R(a, b, c, d)
+#endif
+
+#ifdef _
+#error '_' must be undefinded!
+#endif
+#define SWISS(name) CONCAT4(swiss, SWISS_NAME, _, name)
+
+#ifndef SWISS_GROUP_SIZE
+/** Number of slots in a group, one SSE2 register of control bytes */
+#define SWISS_GROUP_SIZE 16
+/** Size of a matras block holding a group */
+#define SWISS_BLOCK_SIZE 256
+/** Control byte of a slot that never held a value */
+#define SWISS_CTRL_EMPTY ((uint8_t)0x80)
+/** Control byte of a slot whose value was deleted */
+#define SWISS_CTRL_DELETED ((uint8_t)0xfe)
+#endif
+
+/**
+ * A group of slots, stored in one matras block.
+ */
+struct SWISS(group) {
+	/* EMPTY, DELETED or the low 7 bits of the mixed hash */
+	uint8_t ctrl[SWISS_GROUP_SIZE];
+	/* hashes of values */
+	uint32_t hash[SWISS_GROUP_SIZE];
+	/* the values */
+	union {
+		SWISS_DATA_TYPE value;
+		uint64_t uint64_padding;
+	} slot[SWISS_GROUP_SIZE];
+};
+
+/**
+ * Storage of the table of a certain size.
+ */
+struct SWISS(gen) {
+	/* groups, one per matras block */
+	struct matras mtable;
+	/* number of groups, a power of two */
+	uint32_t group_count;
+	/* number of read views created in mtable */
+	uint32_t view_count;
+	/* next storage kept for read views */
+	struct SWISS(gen) *next;
+};
+
+/**
+ * Main struct for holding hash table
+ */
+struct SWISS(core) {
+	/* count of values in hash table */
+	uint32_t count;
+	/* number of inserts into EMPTY slots left before a rehash */
+	uint32_t growth_left;
+	/* current storage, NULL until the first insert */
+	struct SWISS(gen) *gen;
+	/* storage whose values are being moved into gen, or NULL */
+	struct SWISS(gen) *old;
+	/* number of groups of old that are already moved */
+	uint32_t moved;
+	/* older storages which still have read views */
+	struct SWISS(gen) *retired;
+	/* parameters of matras */
+	uint32_t extent_size;
+	void *(*extent_alloc_func)();
+	void (*extent_free_func)(void *);
+	/* additional parameter for data comparison */
+	SWISS_CMP_ARG_TYPE arg;
+};
+
+/**
+ * Iterator, for iterating all values in hash_table.
+ * It also may be used for restoring one value by key.
+ */
+struct SWISS(iterator) {
+	/* Current position on table (ID of a current slot) */
+	uint32_t slotpos;
+	/* Set if the iterator is frozen */
+	bool is_frozen;
+	/* Frozen storage, NULL if the table was empty */
+	struct SWISS(gen) *gen;
+	/* Version of matras memory for MVCC */
+	struct matras_view view;
+	/* Frozen storage being moved, NULL if there was none */
+	struct SWISS(gen) *old;
+	/* Version of its matras memory */
+	struct matras_view old_view;
+	/* Number of its groups that were moved when frozen */
+	uint32_t moved;
+};
+
+/**
+ * Type of functions for memory allocation and deallocation
+ */
+typedef void *(*SWISS(extent_alloc_t))();
+typedef void (*SWISS(extent_free_t))(void *);
+
+/**
+ * Special result of swiss_find that means that nothing was found
+ */
+static const uint32_t SWISS(end) = 0xFFFFFFFF;
+
+/* {{{ Group matching */
+
+/**
+ * Spread the bits of a hash, so that sequential hashes, like
+ * hashes of integers, are not crowded into one group.
+ */
+static inline uint32_t
+SWISS(mix)(uint32_t hash)
+{
+	hash ^= hash >> 16;
+	hash *= 0x85ebca6b;
+	hash ^= hash >> 13;
+	hash *= 0xc2b2ae35;
+	hash ^= hash >> 16;
+	return hash;
+}
+
+/** Bit mask of slots whose control byte equals @a byte */
+static inline uint32_t
+SWISS(match)(const struct SWISS(group) *group, uint8_t byte)
+{
+#if defined(__SSE2__)
+	__m128i ctrl = _mm_loadu_si128((const __m128i *)group->ctrl);
+	return _mm_movemask_epi8(_mm_cmpeq_epi8(ctrl,
+						_mm_set1_epi8((char)byte)));
+#else
+	uint32_t mask = 0;
+	for (int i = 0; i < SWISS_GROUP_SIZE; i++)
+		mask |= (uint32_t)(group->ctrl[i] == byte) << i;
+	return mask;
+#endif
+}
+
+/** Bit mask of slots which do not hold a value */
+static inline uint32_t
+SWISS(match_free)(const struct SWISS(group) *group)
+{
+#if defined(__SSE2__)
+	__m128i ctrl = _mm_loadu_si128((const __m128i *)group->ctrl);
+	return _mm_movemask_epi8(ctrl);
+#else
+	uint32_t mask = 0;
+	for (int i = 0; i < SWISS_GROUP_SIZE; i++)
+		mask |= (uint32_t)(group->ctrl[i] >> 7) << i;
+	return mask;
+#endif
+}
+
+/** Bit mask of slots which hold a value */
+static inline uint32_t
+SWISS(match_full)(const struct SWISS(group) *group)
+{
+	return ~SWISS(match_free)(group) & ((1U << SWISS_GROUP_SIZE) - 1);
+}
+
+/* }}} */
+
+/* {{{ Storage */
+
+/**
+ * Allocate a storage of @a group_count empty groups.
+ * @return NULL on memory error
+ */
+static inline struct SWISS(gen) *
+SWISS(gen_new)(struct SWISS(core) *ht, uint32_t group_count)
+{
+	struct SWISS(gen) *gen =
+		(struct SWISS(gen) *)malloc(sizeof(*gen));
+	if (gen == NULL)
+		return NULL;
+	matras_create(&gen->mtable, ht->extent_size, SWISS_BLOCK_SIZE,
+		      ht->extent_alloc_func, ht->extent_free_func);
+	gen->group_count = group_count;
+	gen->view_count = 0;
+	gen->next = NULL;
+	for (uint32_t i = 0; i < group_count; i++) {
+		matras_id_t id;
+		struct SWISS(group) *group = (struct SWISS(group) *)
+			matras_alloc(&gen->mtable, &id);
+		if (group == NULL) {
+			matras_destroy(&gen->mtable);
+			free(gen);
+			return NULL;
+		}
+		assert(id == i);
+		memset(group->ctrl, SWISS_CTRL_EMPTY, sizeof(group->ctrl));
+	}
+	return gen;
+}
+
+static inline void
+SWISS(gen_delete)(struct SWISS(gen) *gen)
+{
+	matras_destroy(&gen->mtable);
+	free(gen);
+}
+
+/**
+ * Find a free slot for a value with the given hash.
+ */
+static inline uint32_t
+SWISS(find_free)(const struct SWISS(gen) *gen, uint32_t hash)
+{
+	uint32_t mask = gen->group_count - 1;
+	uint32_t g = (SWISS(mix)(hash) >> 7) & mask;
+	for (uint32_t step = 1; ; step++) {
+		const struct SWISS(group) *group = (const struct SWISS(group) *)
+			matras_get(&gen->mtable, g);
+		uint32_t free_mask = SWISS(match_free)(group);
+		if (free_mask != 0)
+			return g * SWISS_GROUP_SIZE + __builtin_ctz(free_mask);
+		/* Triangular probing visits every group. */
+		g = (g + step) & mask;
+	}
+}
+
+/**
+ * Delete a storage that is no longer searched, or keep it
+ * until its last read view is destroyed.
+ */
+static inline void
+SWISS(gen_retire)(struct SWISS(core) *ht, struct SWISS(gen) *gen)
+{
+	if (gen->view_count > 0) {
+		gen->next = ht->retired;
+		ht->retired = gen;
+	} else {
+		SWISS(gen_delete)(gen);
+	}
+}
+
+/**
+ * Move the values of the next group of the old storage into
+ * the current one.
+ * @return 0 on success, -1 on memory error
+ */
+static inline int
+SWISS(move_group)(struct SWISS(core) *ht)
+{
+	struct SWISS(gen) *old = ht->old;
+	struct SWISS(gen) *gen = ht->gen;
+	assert(old != NULL && ht->moved < old->group_count);
+	const struct SWISS(group) *old_group = (const struct SWISS(group) *)
+		matras_get(&old->mtable, ht->moved);
+	/* Destinations and their control bytes, to undo a failure. */
+	uint32_t dst_slot[SWISS_GROUP_SIZE];
+	uint8_t dst_ctrl[SWISS_GROUP_SIZE];
+	uint32_t dst_count = 0;
+	uint32_t full_mask = SWISS(match_full)(old_group);
+	for (; full_mask != 0; full_mask &= full_mask - 1) {
+		uint32_t i = __builtin_ctz(full_mask);
+		uint32_t hash = old_group->hash[i];
+		uint32_t slot = SWISS(find_free)(gen, hash);
+		struct SWISS(group) *group = (struct SWISS(group) *)
+			matras_touch(&gen->mtable, slot / SWISS_GROUP_SIZE);
+		if (group == NULL) {
+			/*
+			 * The group is not moved, so the values
+			 * must not be found in both storages.
+			 */
+			while (dst_count-- > 0) {
+				uint32_t dst = dst_slot[dst_count];
+				group = (struct SWISS(group) *)
+					matras_get(&gen->mtable,
+						   dst / SWISS_GROUP_SIZE);
+				group->ctrl[dst % SWISS_GROUP_SIZE] =
+					dst_ctrl[dst_count];
+			}
+			return -1;
+		}
+		uint32_t j = slot % SWISS_GROUP_SIZE;
+		dst_slot[dst_count] = slot;
+		dst_ctrl[dst_count++] = group->ctrl[j];
+		group->ctrl[j] = old_group->ctrl[i];
+		group->hash[j] = hash;
+		group->slot[j].value = old_group->slot[i].value;
+	}
+	if (++ht->moved == old->group_count) {
+		ht->old = NULL;
+		ht->moved = 0;
+		SWISS(gen_retire)(ht, old);
+	}
+	return 0;
+}
+
+/**
+ * Start moving all values into a new storage, large enough to
+ * insert one more value. The values are moved by move_group(),
+ * which is called on every insert. Since the new storage has
+ * at least as many free slots left before the next rehash as
+ * the old one has groups, the move is normally over before the
+ * next rehash is due. Allocating the new storage still takes
+ * time linear in its size, but it only fills control bytes.
+ * @return 0 on success, -1 on memory error
+ */
+static inline int
+SWISS(rehash)(struct SWISS(core) *ht)
+{
+	/* Only reachable if inserts failed to move groups. */
+	while (ht->old != NULL) {
+		if (SWISS(move_group)(ht) != 0)
+			return -1;
+	}
+	struct SWISS(gen) *old_gen = ht->gen;
+	uint32_t group_count = old_gen == NULL ? 1 : old_gen->group_count;
+	/*
+	 * Grow unless the table is filled with DELETED slots
+	 * rather than with values.
+	 */
+	if ((ht->count + 1) * 16 > group_count * SWISS_GROUP_SIZE * 7)
+		group_count *= 2;
+	if (group_count > SWISS(end) / SWISS_GROUP_SIZE / 2)
+		return -1;
+	struct SWISS(gen) *gen = SWISS(gen_new)(ht, group_count);
+	if (gen == NULL)
+		return -1;
+	ht->gen = gen;
+	ht->old = old_gen;
+	ht->moved = 0;
+	/* Values which are not moved yet are accounted too. */
+	ht->growth_left = group_count * SWISS_GROUP_SIZE / 8 * 7 - ht->count;
+	return 0;
+}
+
+/**
+ * Find the storage of a slot and the slot in it. Slots of the
+ * storage being moved follow the slots of the current one.
+ */
+static inline struct SWISS(gen) *
+SWISS(slot_gen)(const struct SWISS(core) *ht, uint32_t *slotpos)
+{
+	uint32_t capacity = ht->gen->group_count * SWISS_GROUP_SIZE;
+	if (*slotpos < capacity)
+		return ht->gen;
+	assert(ht->old != NULL);
+	*slotpos -= capacity;
+	return ht->old;
+}
+
+/**
+ * Find a record with given hash and key in the current storage
+ * or, if @a in_old is set, in the storage being moved, skipping
+ * its groups that are already moved.
+ */
+static inline uint32_t
+SWISS(gen_find_key)(const struct SWISS(core) *ht, bool in_old,
+		    uint32_t hash, SWISS_KEY_TYPE key)
+{
+	const struct SWISS(gen) *gen = in_old ? ht->old : ht->gen;
+	uint32_t moved = in_old ? ht->moved : 0;
+	uint32_t mixed = SWISS(mix)(hash);
+	uint8_t h2 = mixed & 0x7f;
+	uint32_t mask = gen->group_count - 1;
+	uint32_t g = (mixed >> 7) & mask;
+	for (uint32_t step = 1; ; step++) {
+		const struct SWISS(group) *group = (const struct SWISS(group) *)
+			matras_get(&gen->mtable, g);
+		uint32_t match = g >= moved ? SWISS(match)(group, h2) : 0;
+		for (; match != 0; match &= match - 1) {
+			uint32_t i = __builtin_ctz(match);
+			if (group->hash[i] == hash &&
+			    SWISS_EQUAL_KEY((group->slot[i].value), (key),
+					    (ht->arg)))
+				return g * SWISS_GROUP_SIZE + i;
+		}
+		if (SWISS(match)(group, SWISS_CTRL_EMPTY) != 0)
+			return SWISS(end);
+		g = (g + step) & mask;
+	}
+}
+
+/**
+ * Find a record with given hash and value in a storage, see
+ * gen_find_key().
+ */
+static inline uint32_t
+SWISS(gen_find)(const struct SWISS(core) *ht, bool in_old,
+		uint32_t hash, SWISS_DATA_TYPE value)
+{
+	const struct SWISS(gen) *gen = in_old ? ht->old : ht->gen;
+	uint32_t moved = in_old ? ht->moved : 0;
+	uint32_t mixed = SWISS(mix)(hash);
+	uint8_t h2 = mixed & 0x7f;
+	uint32_t mask = gen->group_count - 1;
+	uint32_t g = (mixed >> 7) & mask;
+	for (uint32_t step = 1; ; step++) {
+		const struct SWISS(group) *group = (const struct SWISS(group) *)
+			matras_get(&gen->mtable, g);
+		uint32_t match = g >= moved ? SWISS(match)(group, h2) : 0;
+		for (; match != 0; match &= match - 1) {
+			uint32_t i = __builtin_ctz(match);
+			if (group->hash[i] == hash &&
+			    SWISS_EQUAL((group->slot[i].value), (value),
+					(ht->arg)))
+				return g * SWISS_GROUP_SIZE + i;
+		}
+		if (SWISS(match)(group, SWISS_CTRL_EMPTY) != 0)
+			return SWISS(end);
+		g = (g + step) & mask;
+	}
+}
+
+/**
+ * Find the first value at or after a slot of a storage version.
+ * @return pointer to the value, with @a slotpos set to its slot,
+ * or NULL
+ */
+static inline SWISS_DATA_TYPE *
+SWISS(gen_next)(const struct SWISS(gen) *gen, const struct matras_view *view,
+		uint32_t *slotpos)
+{
+	uint32_t g = *slotpos / SWISS_GROUP_SIZE;
+	uint32_t i = *slotpos % SWISS_GROUP_SIZE;
+	for (; g < gen->group_count; g++, i = 0) {
+		struct SWISS(group) *group = (struct SWISS(group) *)
+			matras_view_get(&gen->mtable, view, g);
+		uint32_t full_mask = SWISS(match_full)(group) &
+				     ~((1U << i) - 1);
+		if (full_mask != 0) {
+			i = __builtin_ctz(full_mask);
+			*slotpos = g * SWISS_GROUP_SIZE + i;
+			return &group->slot[i].value;
+		}
+	}
+	return NULL;
+}
+
+/**
+ * Release a read view of a storage and delete the storage if
+ * it was the last view of a retired one.
+ */
+static inline void
+SWISS(gen_release)(struct SWISS(core) *ht, struct SWISS(gen) *gen,
+		   struct matras_view *view)
+{
+	matras_destroy_read_view(&gen->mtable, view);
+	if (--gen->view_count > 0 || gen == ht->gen || gen == ht->old)
+		return;
+	struct SWISS(gen) **prev = &ht->retired;
+	while (*prev != gen)
+		prev = &(*prev)->next;
+	*prev = gen->next;
+	SWISS(gen_delete)(gen);
+}
+
+/* }}} */
+
+/* {{{ API */
+
+/**
+ * @brief Hash table construction. Fills struct swiss members.
+ * @param ht - pointer to a hash table struct
+ * @param extent_size - size of allocating memory blocks
+ * @param extent_alloc_func - memory blocks allocation function
+ * @param extent_free_func - memory blocks allocation function
+ * @param arg - optional parameter to save for comparing function
+ */
+inline void
+SWISS(create)(struct SWISS(core) *ht, size_t extent_size,
+	      SWISS(extent_alloc_t) extent_alloc_func,
+	      SWISS(extent_free_t) extent_free_func,
+	      SWISS_CMP_ARG_TYPE arg)
+{
+	assert(sizeof(SWISS_DATA_TYPE) <= sizeof(uint64_t));
+	assert(sizeof(struct SWISS(group)) <= SWISS_BLOCK_SIZE);
+	ht->count = 0;
+	ht->growth_left = 0;
+	ht->gen = NULL;
+	ht->old = NULL;
+	ht->moved = 0;
+	ht->retired = NULL;
+	ht->extent_size = extent_size;
+	ht->extent_alloc_func = extent_alloc_func;
+	ht->extent_free_func = extent_free_func;
+	ht->arg = arg;
+}
+
+/**
+ * @brief Hash table destruction. Frees all allocated memory
+ * @param ht - pointer to a hash table struct
+ */
+inline void
+SWISS(destroy)(struct SWISS(core) *ht)
+{
+	if (ht->gen != NULL)
+		SWISS(gen_delete)(ht->gen);
+	if (ht->old != NULL)
+		SWISS(gen_delete)(ht->old);
+	while (ht->retired != NULL) {
+		struct SWISS(gen) *gen = ht->retired;
+		ht->retired = gen->next;
+		SWISS(gen_delete)(gen);
+	}
+}
+
+/**
+ * @brief Number of slots in the hash table. Any slot below
+ * the capacity can be checked with swiss_pos_valid.
+ * @param ht - pointer to a hash table struct
+ */
+inline uint32_t
+SWISS(capacity)(const struct SWISS(core) *ht)
+{
+	uint32_t group_count = 0;
+	if (ht->gen != NULL)
+		group_count += ht->gen->group_count;
+	if (ht->old != NULL)
+		group_count += ht->old->group_count;
+	return group_count * SWISS_GROUP_SIZE;
+}
+
+/**
+ * @brief Number of memory extents used by the hash table,
+ * including storages kept for read views.
+ * @param ht - pointer to a hash table struct
+ */
+inline size_t
+SWISS(extent_count)(const struct SWISS(core) *ht)
+{
+	size_t count = 0;
+	if (ht->gen != NULL)
+		count += matras_extent_count(&ht->gen->mtable);
+	if (ht->old != NULL)
+		count += matras_extent_count(&ht->old->mtable);
+	for (struct SWISS(gen) *gen = ht->retired; gen != NULL;
+	     gen = gen->next)
+		count += matras_extent_count(&gen->mtable);
+	return count;
+}
+
+/**
+ * @brief Prefetch the group where a record with given hash is
+ * looked up first, so that a following find_key() with the
+ * same hash doesn't stall on a cache miss
+ * @param ht - pointer to a hash table struct
+ * @param hash - hash to be found later
+ */
+inline void
+SWISS(prefetch)(const struct SWISS(core) *ht, uint32_t hash)
+{
+	const struct SWISS(gen) *gen = ht->gen;
+	if (gen == NULL)
+		return;
+	uint32_t mixed = SWISS(mix)(hash);
+	uint32_t g = (mixed >> 7) & (gen->group_count - 1);
+	__builtin_prefetch(matras_get(&gen->mtable, g));
+	gen = ht->old;
+	if (gen == NULL)
+		return;
+	g = (mixed >> 7) & (gen->group_count - 1);
+	__builtin_prefetch(matras_get(&gen->mtable, g));
+}
+
+/**
+ * @brief Find a record with given hash and key
+ * @param ht - pointer to a hash table struct
+ * @param hash - hash to find
+ * @param key - key to find
+ * @return integer ID of found record or swiss_end if nothing found
+ */
+inline uint32_t
+SWISS(find_key)(const struct SWISS(core) *ht, uint32_t hash,
+		SWISS_KEY_TYPE key)
+{
+	const struct SWISS(gen) *gen = ht->gen;
+	if (gen == NULL)
+		return SWISS(end);
+	uint32_t slot = SWISS(gen_find_key)(ht, false, hash, key);
+	if (slot != SWISS(end) || ht->old == NULL)
+		return slot;
+	slot = SWISS(gen_find_key)(ht, true, hash, key);
+	if (slot == SWISS(end))
+		return slot;
+	return gen->group_count * SWISS_GROUP_SIZE + slot;
+}
+
+/**
+ * @brief Find a record with given hash and value
+ * @param ht - pointer to a hash table struct
+ * @param hash - hash to find
+ * @param value - value to find
+ * @return integer ID of found record or swiss_end if nothing found
+ */
+inline uint32_t
+SWISS(find)(const struct SWISS(core) *ht, uint32_t hash,
+	    SWISS_DATA_TYPE value)
+{
+	const struct SWISS(gen) *gen = ht->gen;
+	if (gen == NULL)
+		return SWISS(end);
+	uint32_t slot = SWISS(gen_find)(ht, false, hash, value);
+	if (slot != SWISS(end) || ht->old == NULL)
+		return slot;
+	slot = SWISS(gen_find)(ht, true, hash, value);
+	if (slot == SWISS(end))
+		return slot;
+	return gen->group_count * SWISS_GROUP_SIZE + slot;
+}
+
+/**
+ * @brief Insert a record with given hash and value.
+ * The value must not be in the table.
+ * @param ht - pointer to a hash table struct
+ * @param hash - hash to insert
+ * @param value - value to insert
+ * @return integer ID of inserted record or swiss_end if failed
+ */
+inline uint32_t
+SWISS(insert)(struct SWISS(core) *ht, uint32_t hash, SWISS_DATA_TYPE value)
+{
+	if (ht->gen == NULL && SWISS(rehash)(ht) != 0)
+		return SWISS(end);
+	if (ht->old != NULL && SWISS(move_group)(ht) != 0)
+		return SWISS(end);
+	uint32_t slot = SWISS(find_free)(ht->gen, hash);
+	const struct SWISS(group) *group = (const struct SWISS(group) *)
+		matras_get(&ht->gen->mtable, slot / SWISS_GROUP_SIZE);
+	bool is_empty = group->ctrl[slot % SWISS_GROUP_SIZE] ==
+			SWISS_CTRL_EMPTY;
+	/* Reusing a DELETED slot does not bring the rehash closer. */
+	if (is_empty && ht->growth_left == 0) {
+		if (SWISS(rehash)(ht) != 0)
+			return SWISS(end);
+		slot = SWISS(find_free)(ht->gen, hash);
+	}
+	struct SWISS(group) *touched = (struct SWISS(group) *)
+		matras_touch(&ht->gen->mtable, slot / SWISS_GROUP_SIZE);
+	if (touched == NULL)
+		return SWISS(end);
+	uint32_t i = slot % SWISS_GROUP_SIZE;
+	if (touched->ctrl[i] == SWISS_CTRL_EMPTY)
+		ht->growth_left--;
+	touched->ctrl[i] = SWISS(mix)(hash) & 0x7f;
+	touched->hash[i] = hash;
+	touched->slot[i].value = value;
+	ht->count++;
+	return slot;
+}
+
+/**
+ * @brief Replace a record with given hash and value
+ * @param ht - pointer to a hash table struct
+ * @param hash - hash to find
+ * @param value - value to find and replace
+ * @param replaced - pointer to a value that was stored in table before replace
+ * @return integer ID of found record or swiss_end if nothing found
+ */
+inline uint32_t
+SWISS(replace)(struct SWISS(core) *ht, uint32_t hash,
+	       SWISS_DATA_TYPE value, SWISS_DATA_TYPE *replaced)
+{
+	uint32_t slot = SWISS(find)(ht, hash, value);
+	if (slot == SWISS(end))
+		return SWISS(end);
+	uint32_t pos = slot;
+	struct SWISS(gen) *gen = SWISS(slot_gen)(ht, &pos);
+	struct SWISS(group) *group = (struct SWISS(group) *)
+		matras_touch(&gen->mtable, pos / SWISS_GROUP_SIZE);
+	if (group == NULL)
+		return SWISS(end);
+	uint32_t i = pos % SWISS_GROUP_SIZE;
+	*replaced = group->slot[i].value;
+	group->slot[i].value = value;
+	return slot;
+}
+
+/**
+ * @brief Delete a record from a hash table by given record ID
+ * @param ht - pointer to a hash table struct
+ * @param slotpos - ID of an record. See SWISS(find) for details.
+ * @return 0 if ok, -1 on memory error (only with freezed iterators)
+ */
+inline int
+SWISS(delete)(struct SWISS(core) *ht, uint32_t slotpos)
+{
+	assert(slotpos < SWISS(capacity)(ht));
+	struct SWISS(gen) *gen = SWISS(slot_gen)(ht, &slotpos);
+	assert(gen == ht->gen || slotpos / SWISS_GROUP_SIZE >= ht->moved);
+	struct SWISS(group) *group = (struct SWISS(group) *)
+		matras_touch(&gen->mtable, slotpos / SWISS_GROUP_SIZE);
+	if (group == NULL)
+		return -1;
+	uint32_t i = slotpos % SWISS_GROUP_SIZE;
+	assert((group->ctrl[i] & 0x80) == 0);
+	/*
+	 * A group is searched further only if it has no EMPTY
+	 * slots, and such a group has never had one. So if there
+	 * is an EMPTY slot, no probe sequence goes through the
+	 * group and the slot can be made EMPTY too.
+	 */
+	bool is_empty = SWISS(match)(group, SWISS_CTRL_EMPTY) != 0;
+	group->ctrl[i] = is_empty ? SWISS_CTRL_EMPTY : SWISS_CTRL_DELETED;
+	/* A value not moved yet has a free slot reserved in gen. */
+	if (is_empty || gen != ht->gen)
+		ht->growth_left++;
+	ht->count--;
+	return 0;
+}
+
+/**
+ * @brief Delete a record from a hash table by that value and its hash.
+ * @param ht - pointer to a hash table struct
+ * @param hash - hash of the value
+ * @param value - value to delete
+ * @return 0 if ok, 1 if not found or -1 on memory error
+ * (only with freezed iterators)
+ */
+inline int
+SWISS(delete_value)(struct SWISS(core) *ht,
+		    uint32_t hash, SWISS_DATA_TYPE value)
+{
+	uint32_t slot = SWISS(find)(ht, hash, value);
+	if (slot == SWISS(end))
+		return 1;
+	return SWISS(delete)(ht, slot);
+}
+
+/**
+ * @brief Determine if posision holds a value
+ * @param ht - pointer to a hash table struct
+ * @param slotpos - ID of an record
+ *  ID must be in valid range [0, capacity) (asserted).
+ */
+inline bool
+SWISS(pos_valid)(struct SWISS(core) *ht, uint32_t slotpos)
+{
+	assert(slotpos < SWISS(capacity)(ht));
+	struct SWISS(gen) *gen = SWISS(slot_gen)(ht, &slotpos);
+	uint32_t g = slotpos / SWISS_GROUP_SIZE;
+	/* Values of moved groups are found in the current storage. */
+	if (gen == ht->old && g < ht->moved)
+		return false;
+	const struct SWISS(group) *group = (const struct SWISS(group) *)
+		matras_get(&gen->mtable, g);
+	return (group->ctrl[slotpos % SWISS_GROUP_SIZE] & 0x80) == 0;
+}
+
+/**
+ * @brief Get a value from a desired position
+ * @param ht - pointer to a hash table struct
+ * @param slotpos - ID of an record
+ *  ID must be vaild, check it by swiss_pos_valid (asserted).
+ */
+inline SWISS_DATA_TYPE
+SWISS(get)(struct SWISS(core) *ht, uint32_t slotpos)
+{
+	assert(SWISS(pos_valid)(ht, slotpos));
+	const struct SWISS(gen) *gen = SWISS(slot_gen)(ht, &slotpos);
+	const struct SWISS(group) *group = (const struct SWISS(group) *)
+		matras_get(&gen->mtable, slotpos / SWISS_GROUP_SIZE);
+	return group->slot[slotpos % SWISS_GROUP_SIZE].value;
+}
+
+/**
+ * @brief Set iterator to the beginning of hash table
+ * @param ht - pointer to a hash table struct
+ * @param itr - iterator to set
+ */
+inline void
+SWISS(iterator_begin)(const struct SWISS(core) *ht,
+		      struct SWISS(iterator) *itr)
+{
+	(void)ht;
+	itr->slotpos = 0;
+	itr->is_frozen = false;
+	itr->gen = NULL;
+	itr->old = NULL;
+	itr->moved = 0;
+	matras_head_read_view(&itr->view);
+	matras_head_read_view(&itr->old_view);
+}
+
+/**
+ * @brief Set iterator to position determined by key
+ * @param ht - pointer to a hash table struct
+ * @param itr - iterator to set
+ * @param hash - hash to find
+ * @param key - key to find
+ */
+inline void
+SWISS(iterator_key)(const struct SWISS(core) *ht,
+		    struct SWISS(iterator) *itr,
+		    uint32_t hash, SWISS_KEY_TYPE key)
+{
+	SWISS(iterator_begin)(ht, itr);
+	itr->slotpos = SWISS(find_key)(ht, hash, key);
+}
+
+/**
+ * @brief Get the value that iterator currently points to
+ * @param ht - pointer to a hash table struct
+ * @param itr - iterator to set
+ * @return poiner to the value or NULL if iteration is complete
+ */
+inline SWISS_DATA_TYPE *
+SWISS(iterator_get_and_next)(const struct SWISS(core) *ht,
+			     struct SWISS(iterator) *itr)
+{
+	const struct SWISS(gen) *gen = itr->is_frozen ? itr->gen : ht->gen;
+	if (gen == NULL)
+		return NULL;
+	const struct SWISS(gen) *old = itr->is_frozen ? itr->old : ht->old;
+	uint32_t moved = itr->is_frozen ? itr->moved : ht->moved;
+	uint32_t capacity = gen->group_count * SWISS_GROUP_SIZE;
+	uint32_t pos = itr->slotpos;
+	if (pos < capacity) {
+		const struct matras_view *view = itr->is_frozen ?
+						  &itr->view :
+						  &gen->mtable.head;
+		SWISS_DATA_TYPE *value = SWISS(gen_next)(gen, view, &pos);
+		if (value != NULL) {
+			itr->slotpos = pos + 1;
+			return value;
+		}
+		pos = capacity;
+	}
+	if (old != NULL) {
+		const struct matras_view *view = itr->is_frozen ?
+						  &itr->old_view :
+						  &old->mtable.head;
+		/* Values of moved groups have been visited in gen. */
+		pos -= capacity;
+		if (pos < moved * SWISS_GROUP_SIZE)
+			pos = moved * SWISS_GROUP_SIZE;
+		SWISS_DATA_TYPE *value = SWISS(gen_next)(old, view, &pos);
+		if (value != NULL) {
+			itr->slotpos = capacity + pos + 1;
+			return value;
+		}
+	}
+	itr->slotpos = SWISS(end);
+	return NULL;
+}
+
+/**
+ * @brief Freezes state for given iterator. All following hash table
+ * modification will not apply to that iterator iteration. That
+ * iterator should be destroyed with a swiss_iterator_destroy call
+ * after usage.
+ * @param ht - pointer to a hash table struct
+ * @param itr - iterator to freeze
+ */
+inline void
+SWISS(iterator_freeze)(struct SWISS(core) *ht, struct SWISS(iterator) *itr)
+{
+	assert(!itr->is_frozen);
+	itr->is_frozen = true;
+	itr->gen = ht->gen;
+	itr->old = ht->old;
+	itr->moved = ht->moved;
+	if (itr->gen == NULL)
+		return;
+	matras_create_read_view(&itr->gen->mtable, &itr->view);
+	itr->gen->view_count++;
+	if (itr->old == NULL)
+		return;
+	matras_create_read_view(&itr->old->mtable, &itr->old_view);
+	itr->old->view_count++;
+}
+
+/**
+ * @brief Destroy an iterator that was frozen before. Useless for not
+ * frozen iterators.
+ * @param ht - pointer to a hash table struct
+ * @param itr - iterator to destroy
+ */
+inline void
+SWISS(iterator_destroy)(struct SWISS(core) *ht, struct SWISS(iterator) *itr)
+{
+	struct SWISS(gen) *gen = itr->gen;
+	struct SWISS(gen) *old = itr->old;
+	itr->is_frozen = false;
+	itr->gen = NULL;
+	itr->old = NULL;
+	if (gen != NULL)
+		SWISS(gen_release)(ht, gen, &itr->view);
+	if (old != NULL)
+		SWISS(gen_release)(ht, old, &itr->old_view);
+}
+
+/*
+ * Selfcheck of the internal state of hash table. Used only for debugging.
+ * That means that you should not use this function.
+ * If return not zero, something went terribly wrong.
+ */
+inline int
+SWISS(selfcheck)(const struct SWISS(core) *ht)
+{
+	int res = 0;
+	const struct SWISS(gen) *gen = ht->gen;
+	if (gen == NULL)
+		return ht->count == 0 && ht->old == NULL ? 0 : 1;
+	if ((gen->group_count & (gen->group_count - 1)) != 0)
+		res |= 2; /* group count is not a power of two */
+	if (ht->old != NULL && ht->moved >= ht->old->group_count)
+		res |= 64; /* a drained storage is still searched */
+	uint32_t count = 0;
+	uint32_t empty = 0;
+	uint32_t group_count = SWISS(capacity)(ht) / SWISS_GROUP_SIZE;
+	for (uint32_t g = 0; g < group_count; g++) {
+		uint32_t slot = g * SWISS_GROUP_SIZE;
+		const struct SWISS(gen) *slot_gen = SWISS(slot_gen)(ht, &slot);
+		uint32_t local = slot / SWISS_GROUP_SIZE;
+		if (slot_gen == ht->old && local < ht->moved)
+			continue;
+		const struct SWISS(group) *group = (const struct SWISS(group) *)
+			matras_get(&slot_gen->mtable, local);
+		if (slot_gen == gen)
+			empty += __builtin_popcount(
+				SWISS(match)(group, SWISS_CTRL_EMPTY));
+		uint32_t full_mask = SWISS(match_full)(group);
+		for (; full_mask != 0; full_mask &= full_mask - 1) {
+			uint32_t i = __builtin_ctz(full_mask);
+			count++;
+			if (group->ctrl[i] != (SWISS(mix)(group->hash[i]) & 0x7f))
+				res |= 4; /* wrong control byte */
+			if (SWISS(find)(ht, group->hash[i],
+					group->slot[i].value) !=
+			    g * SWISS_GROUP_SIZE + i)
+				res |= 8; /* value is not reachable */
+		}
+	}
+	if (count != ht->count)
+		res |= 16; /* wrong count */
+	if (empty == 0)
+		res |= 32; /* no EMPTY slot to stop a probe */
+	return res;
+}
+
+/* }}} API */
@@ -0,0 +1,48 @@
+-- index:get_many()
+s = box.schema.space.create('test')
+pk = s:create_index('pk', {type = 'hash'})
+tree = s:create_index('tree', {type = 'tree', parts = {2, 'string'}})
+swiss = s:create_index('swiss', {type = 'hash', parts = {3, 'unsigned'}, layout = 'swiss'})
+nu = s:create_index('nu', {type = 'tree', parts = {3, 'unsigned'}, unique = false})
+for i = 1, 100 do s:insert{i, 'key' .. i, i * 10} end
+r = pk:get_many{1, 2, 200, {100}}
+r[1], r[2], r[3], r[4]
+r = s:get_many{{50}, 7}
+r[1], r[2]
+r = tree:get_many{'key3', 'key20', 'nokey', 'key3', 'key1'}
+r[1], r[2], r[3], r[4], r[5]
+r = swiss:get_many{10, 15, 1000}
+r[1], r[2], r[3]
+#pk:get_many{}
+-- more keys than are prefetched at once
+keys = {} for i = 1, 150 do keys[i] = 151 - i end
+r = pk:get_many(keys)
+bad = 0 for i = 1, 150 do if (r[i] == nil) ~= (keys[i] > 100) or (r[i] ~= nil and r[i][1] ~= keys[i]) then bad = bad + 1 end end
+bad
+r = swiss:get_many(keys)
+bad = 0 for i = 1, 150 do if (r[i] == nil) ~= (keys[i] % 10 ~= 0) or (r[i] ~= nil and r[i][3] ~= keys[i]) then bad = bad + 1 end end
+bad
+keys = {} for i = 1, 150 do keys[i] = 'key' .. (151 - i) end
+r = tree:get_many(keys)
+bad = 0 for i = 1, 150 do if (r[i] == nil) ~= (i <= 50) or (r[i] ~= nil and r[i][2] ~= keys[i]) then bad = bad + 1 end end
+bad
+-- errors
+nu:get_many{{10}}
+pk:get_many{{1, 2}}
+pk:get_many{{'abc'}}
+pk:get_many(1)
+pk:get_many{1, 2, function() end}
+#pk:get_many{1, 2}
+-- net.box
+box.schema.user.grant('guest', 'read,write,execute', 'universe')
+LISTEN = require('uri').parse(box.cfg.listen)
+cn = require('net.box').connect(LISTEN.host, LISTEN.service)
+r = cn.space.test:get_many{1, 200, {3}}
+r[1], r[2], r[3]
+r = cn.space.test.index.tree:get_many{'key5', 'nokey'}
+r[1], r[2]
+#cn.space.test:get_many{}
+cn.space.test.index.nu:get_many{{10}}
+cn:close()
+box.schema.user.revoke('guest', 'read,write,execute', 'universe')
+s:drop()
@@ -0,0 +1,58 @@
+-- HASH index with the swiss layout
+s = box.schema.space.create('test')
+pk = s:create_index('pk', {type = 'hash', layout = 'swiss'})
+str = s:create_index('str', {type = 'hash', parts = {2, 'string'}, layout = 'swiss'})
+for i = 1, 1000 do s:insert{i, 'key' .. i} end
+pk:count()
+str:count()
+pk:get{500}
+str:get{'key777'}
+str:get{'key1001'}
+s:insert{1001, 'key1'}
+s:replace{1, 'key2'}
+pk:get{1001}
+s:replace{1, 'key1001'}
+str:get{'key1001'}
+str:get{'key1'}
+for i = 2, 1000, 2 do s:delete{i} end
+pk:count()
+#pk:select()
+#str:select()
+pk:get{2}
+str:get{'key999'}
+box.snapshot()
+for i = 2, 1000, 2 do s:insert{i, 'key' .. i} end
+pk:count()
+pk:random(7) ~= nil
+-- an index built on existing data
+h = s:create_index('h', {type = 'hash', parts = {2, 'string', 1, 'unsigned'}, layout = 'swiss'})
+h:count()
+h:get{'key10', 10}
+-- switching the layout rebuilds the index
+str:alter({layout = 'chain'})
+str:get{'key10'}
+str:count()
+
+ok, err = pcall(s.create_index, s, 'bad', {type = 'hash', layout = 'flat'})
+ok, string.match(tostring(err), "layout must be either 'chain' or 'swiss'") ~= nil
+ok, err = pcall(s.create_index, s, 'bad', {type = 'tree', layout = 'swiss'})
+ok, string.match(tostring(err), 'only HASH index supports layouts') ~= nil
+s:drop()
+
+-- the table grows while a snapshot holds a frozen iterator
+fiber = require('fiber')
+s = box.schema.space.create('test')
+pk = s:create_index('pk', {type = 'hash', layout = 'swiss'})
+for i = 1, 100 do s:insert{i} end
+ch = fiber.channel(1)
+_ = fiber.create(function() ch:put(box.snapshot()) end) box.begin() for i = 101, 10000 do s:insert{i} end box.commit()
+ch:get()
+pk:count()
+#pk:select()
+cnt = 0
+for i = 1, 10000 do if pk:get{i} ~= nil then cnt = cnt + 1 end end
+cnt
+for i = 1, 10000, 2 do s:delete{i} end
+pk:count()
+#pk:select()
+s:drop()
@@ -0,0 +1,44 @@
+-- index iterators and select() fetch tuples in batches,
+-- check results crossing batch boundaries
+s = box.schema.space.create('test')
+pk = s:create_index('pk')
+sk = s:create_index('sk', {unique = false, parts = {2, 'unsigned'}})
+h = s:create_index('h', {type = 'hash', parts = {1, 'unsigned'}})
+for i = 1, 100 do s:insert{i, i % 3} end
+
+#s:select{}
+#s:select({}, {limit = 33})
+s:select({}, {offset = 31, limit = 3})
+s:select({}, {offset = 98})
+s:select({}, {offset = 100})
+s:select({}, {limit = 0})
+s:select({50}, {iterator = 'LT', offset = 40})
+#sk:select{1}
+sk:select({2}, {iterator = 'REQ', offset = 32})
+#h:select()
+h:select{70}
+
+function count(...) local n = 0 for _ in ... do n = n + 1 end return n end
+count(pk:pairs())
+count(pk:pairs({}, {iterator = 'REQ'}))
+count(sk:pairs({0}))
+count(h:pairs())
+count(h:pairs({10}))
+
+-- tuples prefetched by pairs() are not returned after index drop
+gen, param, state = sk:pairs({1})
+gen(param, state)
+sk:drop()
+gen(param, state)
+
+-- iteration continues after an unrelated schema change
+result = {}
+for _, t in pk:pairs({96}, {iterator = 'GE'}) do table.insert(result, t[1]) if t[1] == 97 then box.schema.space.create('test2'):drop() end end
+result
+
+-- a loop which changes tuples ahead of the cursor sees the changes
+result = {}
+for _, t in pk:pairs() do if t[1] > 10 then break end table.insert(result, t[2]) pk:update(t[1] + 1, {{'=', 2, 100}}) end
+result
+
+s:drop()
@@ -405,6 +405,39 @@ c.space.test:upsert({2, 4, 'nothing'}, {{'+', 3, 100500}}) -- wrong operation
 c.space.test:select{}
 box.space.test:drop()
 
+-- SELECT responses streamed in chunks
+_ = box.schema.space.create('test')
+_ = box.space.test:create_index('primary', {type = 'TREE', parts = {1,'unsigned'}})
+_ = box.space.test:create_index('secondary', {type = 'TREE', unique = false, parts = {2,'unsigned'}})
+for i = 1, 100 do box.space.test:insert{i, i % 10} end
+c = net:connect(box.cfg.listen)
+#c.space.test:select({}, {chunk_size = 7})
+#c.space.test:select({}, {chunk_size = 10, limit = 30})
+#c.space.test:select({}, {chunk_size = 1, offset = 95})
+c.space.test:select({50}, {chunk_size = 3, limit = 5, iterator = 'GT'})
+c.space.test:select({50}, {chunk_size = 2, limit = 5, iterator = 'LE'})
+c.space.test:select({50}, {chunk_size = 2, iterator = 'EQ'})
+-- not streamed, a non-unique index
+#c.space.test.index.secondary:select({5}, {chunk_size = 2})
+-- large tuples are sent without copying
+_ = box.space.test:replace{1, 1, string.rep('a', 10000)}
+_ = box.space.test:replace{3, 3, string.rep('b', 5000)}
+t = c.space.test:select({}, {limit = 3})
+#t, #t[1][3], t[2][3], #t[3][3]
+t = c.space.test:select({}, {limit = 3, chunk_size = 1})
+#t, #t[1][3], t[2][3], #t[3][3]
+c.space.test:get{1}[3] == string.rep('a', 10000)
+-- DML requests pipelined over one connection
+ch = fiber.channel(200)
+function insert(k) ch:put((pcall(c.space.test.insert, c.space.test, {k, 0}))) end
+for i = 101, 200 do fiber.create(insert, i) end
+for i = 151, 250 do fiber.create(insert, i) end
+ok = 0
+for i = 1, 200 do if ch:get() then ok = ok + 1 end end
+ok
+box.space.test:count()
+box.space.test:drop()
+
 box.schema.user.revoke('guest', 'read,write,execute', 'universe')
 
 -- Tarantool < 1.7.1 compatibility (gh-1533)
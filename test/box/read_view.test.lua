@@ -0,0 +1,52 @@
+fiber = require('fiber')
+net_box = require('net.box')
+
+box.cfg.read_view_period
+box.cfg{read_view_period = -1}
+box.cfg.read_view_period
+
+-- only memtx spaces support read views
+s = box.schema.space.create('test_vinyl', {engine = 'vinyl', read_view = true})
+
+s = box.schema.space.create('test', {read_view = true})
+s.id == box.space._space.index.name:get{'test'}[1]
+box.space._space.index.name:get{'test'}[6].read_view
+pk = s:create_index('pk')
+sk = s:create_index('sk', {unique = false, parts = {2, 'unsigned'}})
+h = s:create_index('h', {type = 'hash', parts = {1, 'unsigned'}})
+for i = 1, 10 do s:insert{i, i % 3} end
+box.schema.user.grant('guest', 'read', 'space', 'test')
+
+LISTEN = require('uri').parse(box.cfg.listen)
+c = net_box.connect(LISTEN.host, LISTEN.service)
+fiber.sleep(0.1)
+
+c.space.test:select{}
+c.space.test:select({5}, {iterator = 'LE', limit = 3})
+c.space.test:select({5}, {iterator = 'GT', offset = 2})
+#c.space.test.index.sk:select{1}
+#c.space.test.index.sk:select({2}, {iterator = 'REQ'})
+#c.space.test.index.sk:select({}, {iterator = 'LT', limit = 2})
+c.space.test.index.h:select{3}
+c.space.test:get{7}
+c.space.test:get{11}
+
+-- changes are visible after a refresh
+s:replace{7, 100}
+s:delete{8}
+fiber.sleep(0.1)
+c.space.test:select({6}, {iterator = 'GE', limit = 3})
+
+-- access is checked
+box.schema.user.revoke('guest', 'read', 'space', 'test')
+fiber.sleep(0.1)
+c.space.test:select{1}
+box.schema.user.grant('guest', 'read', 'space', 'test')
+
+-- read views are dropped with the index
+sk:drop()
+fiber.sleep(0.1)
+c.space.test:select{1}
+
+c:close()
+s:drop()
@@ -26,6 +26,14 @@ box.stat.SELECT.total
 space:get('Impossible value')
 box.stat.ERROR.total
 
+-- WAL statistics
+batches = 0
+for _, count in pairs(box.stat.wal.batch_rows) do batches = batches + count end
+batches > 0
+-- nothing is synced in wal_mode = 'write'
+next(box.stat.wal.fsync_usec)
+type(box.stat.wal().batch_rows)
+
 test_run:cmd('restart server default')
 
 -- statistics must be zero
@@ -21,6 +21,11 @@ box.stat.net.RECEIVED.total > 0
 box.stat.net.EVENTS.total > 0
 -- box.stat.net.LOCKS.total > 0
 
+-- per-thread statistics
+#box.stat.net.threads == box.cfg.iproto_threads
+box.stat.net.threads[1].CONNECTIONS > 0
+box.stat.net.threads[1].RECEIVED.total == box.stat.net.RECEIVED.total
+
 space:drop()
 cn:close()
 box.schema.user.revoke('guest','read,write,execute','universe')
@@ -0,0 +1,55 @@
+-- TREE indexes with hints order tuples the same way as without
+s = box.schema.space.create('test')
+pk = s:create_index('pk', {hint = true})
+str = s:create_index('str', {parts = {2, 'string'}, hint = true})
+num = s:create_index('num', {unique = false, parts = {3, 'number'}, hint = true})
+int = s:create_index('int', {parts = {4, 'integer', 1, 'unsigned'}, hint = true})
+_ = s:insert{1, 'abcdefghij', 1.5, -10}
+_ = s:insert{2, 'abcdefgh', -0.5, 5}
+_ = s:insert{3, 'abcdefghi', 2, -10}
+_ = s:insert{4, 'b', -3, tonumber64('18446744073709551615')}
+_ = s:insert{5, '', 0, tonumber64('9223372036854775807')}
+_ = s:insert{6, 'abc', 1e20, 0}
+function ids(t) local r = {} for _, v in ipairs(t) do table.insert(r, v[1]) end return r end
+
+ids(pk:select({3}, {iterator = 'GE'}))
+ids(str:select())
+ids(str:select({'abcdefgh'}, {iterator = 'GT'}))
+ids(str:select({'abcdefghi'}, {iterator = 'LE'}))
+str:get{'abcdefghij'}[1]
+str:get{'abcdefghijk'}
+ids(num:select())
+ids(num:select({0}, {iterator = 'GE'}))
+ids(num:select({1}, {iterator = 'LT'}))
+ids(num:select({2}))
+ids(num:select({1.5}))
+ids(int:select())
+ids(int:select({-10}))
+ids(int:select({0}, {iterator = 'GT'}))
+ids(int:select({tonumber64('9223372036854775807')}, {iterator = 'GE'}))
+
+-- updates keep the order
+_ = s:delete{3}
+ids(str:select())
+_ = s:replace{2, 'zz', 7, 1}
+ids(str:select())
+ids(num:select())
+-- an index built on existing data
+str2 = s:create_index('str2', {parts = {2, 'string'}, hint = true})
+ids(str2:select())
+ids(str2:select({'abd'}, {iterator = 'LT'}))
+
+-- only TREE indexes support hints
+ok, err = pcall(s.create_index, s, 'h', {type = 'hash', hint = true})
+ok, string.match(tostring(err), 'only TREE index supports hints') ~= nil
+s:drop()
+
+-- hints take memory only in indexes that have them
+s = box.schema.space.create('test')
+pk = s:create_index('pk')
+sk = s:create_index('sk', {parts = {1, 'unsigned'}, hint = true})
+for i = 1, 10000 do s:insert{i} end
+sk:bsize() > pk:bsize()
+ids(pk:select({9998}, {iterator = 'GE'}))
+ids(sk:select({9998}, {iterator = 'GE'}))
+s:drop()
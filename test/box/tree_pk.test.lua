@@ -191,3 +191,27 @@ utils.sort(s0.index['i2']:select(0))
 s0:drop()
 s0 = nil
 
+
+-- index:count() is calculated from subtree counts
+s = box.schema.space.create('count_test')
+i1 = s:create_index('primary', { type = 'tree', parts = {1, 'unsigned'} })
+i2 = s:create_index('i2', { type = 'tree', unique = false, parts = {2, 'unsigned', 1, 'unsigned'} })
+for i = 1, 1000 do s:replace{i, i % 17} end
+for i = 1, 1000, 3 do s:delete{i} end
+test_run:cmd("setopt delimiter ';'")
+function check_count(index, keys)
+    local types = {'EQ', 'REQ', 'ALL', 'GE', 'GT', 'LE', 'LT'}
+    for _, key in pairs(keys) do
+        for _, type in pairs(types) do
+            local opts = {iterator = type}
+            if index:count(key, opts) ~= #index:select(key, opts) then
+                return {key, type}
+            end
+        end
+    end
+    return true
+end;
+test_run:cmd("setopt delimiter ''");
+check_count(i1, {{}, {0}, {1}, {2}, {500}, {999}, {1000}, {1001}})
+check_count(i2, {{}, {0}, {5}, {16}, {17}, {5, 500}, {5, 498}, {16, 0}})
+s:drop()
@@ -0,0 +1,25 @@
+-- keys on arbitrary fields and of any type get typed comparators
+s = box.schema.space.create('test')
+pk = s:create_index('pk')
+i = s:create_index('i', {parts = {3, 'integer', 5, 'number', 2, 'scalar', 4, 'string'}})
+j = s:create_index('j', {unique = false, parts = {4, 'string', 3, 'integer'}})
+_ = s:insert{1, 'x', 5, 'b', 1.5}
+_ = s:insert{2, 1, -3, 'a', 2}
+_ = s:insert{3, 'x', 5, 'a', 1.5}
+_ = s:insert{4, true, 5, 'a', 1.5}
+_ = s:insert{5, 'y', 10, 'c', -1}
+_ = s:insert{6, 2.5, -3, 'z', 2}
+function ids(t) local r = {} for _, v in ipairs(t) do table.insert(r, v[1]) end return r end
+
+ids(i:select())
+ids(i:select({5}))
+ids(i:select({5, 1.5, 'x'}))
+ids(i:select({5, 1.5, 'x'}, {iterator = 'LT'}))
+ids(i:select({-3}, {iterator = 'GT'}))
+i:get{5, 1.5, 'x', 'b'}[1]
+i:get{5, 1.5, 'x', 'c'}
+ids(j:select())
+ids(j:select({'a'}))
+ids(j:select({'a', 5}))
+ids(j:select({'b'}, {iterator = 'LE'}))
+s:drop()
@@ -0,0 +1,36 @@
+env = require('test_run')
+test_run = env.new()
+test_run:cmd('switch default')
+box.schema.user.grant('guest', 'replication')
+space = box.schema.space.create('test')
+index = space:create_index('primary')
+test_run:cmd("create server replica with rpl_master=default, script='replication/replica.lua'")
+test_run:cmd("start server replica")
+test_run:cmd('switch replica')
+fiber = require('fiber')
+while box.space.test == nil or box.space.test.index.primary == nil do fiber.sleep(0.001) end
+-- A row failing in the middle of a batch stops the applier
+box.space.test:insert({50})
+test_run:cmd('switch default')
+fiber = require('fiber')
+for i = 1, 100 do fiber.create(function() space:insert({i}) end) end
+while space:count() < 100 do fiber.sleep(0.001) end
+test_run:cmd('switch replica')
+while box.info.replication[1].status ~= "stopped" do fiber.sleep(0.001) end
+box.info.replication[1].message:match('Duplicate') ~= nil
+-- Rows before the failing one are applied, the rest are not
+box.space.test:count()
+box.space.test:select({49}, {iterator = 'LE', limit = 1})
+box.space.test:select({50}, {iterator = 'GT', limit = 1})
+-- The replica catches up once the conflict is resolved
+box.space.test:delete({50})
+source = box.cfg.replication_source
+box.cfg { replication_source = "" }
+box.cfg { replication_source = source }
+while box.space.test:count() < 100 do fiber.sleep(0.001) end
+box.info.replication[1].status
+test_run:cmd('switch default')
+space:drop()
+box.schema.user.revoke('guest', 'replication')
+test_run:cmd("stop server replica")
+test_run:cmd("cleanup server replica")
@@ -0,0 +1,40 @@
+env = require('test_run')
+test_run = env.new()
+test_run:cmd('switch default')
+box.schema.user.grant('guest', 'replication')
+space = box.schema.space.create('test')
+index = space:create_index('primary')
+test_run:cmd("create server replica with rpl_master=default, script='replication/replica.lua'")
+test_run:cmd("start server replica")
+test_run:cmd('switch replica')
+fiber = require('fiber')
+while box.space.test == nil or box.space.test.index.primary == nil do fiber.sleep(0.001) end
+test_run:cmd('switch default')
+fiber = require('fiber')
+-- The replica follows from the WAL tail buffer across blocks
+pad = string.rep('x', 1024)
+for i = 1, 1000 do space:insert({i, pad}) if i % 100 == 0 then fiber.sleep(0.01) end end
+test_run:cmd('switch replica')
+while box.space.test:count() < 1000 do fiber.sleep(0.001) end
+box.info.replication[1].status
+box.space.test:get({1000})[1]
+-- Rows written while the replica is down are sent on reconnect
+test_run:cmd('switch default')
+test_run:cmd("stop server replica")
+for i = 1001, 2000 do space:insert({i, pad}) end
+test_run:cmd("start server replica")
+test_run:cmd('switch replica')
+while box.space.test:count() < 2000 do fiber.sleep(0.001) end
+test_run:cmd('switch default')
+for i = 2001, 3000 do space:insert({i, pad}) end
+test_run:cmd('switch replica')
+while box.space.test:count() < 3000 do fiber.sleep(0.001) end
+box.info.replication[1].status
+s = 0
+for _, t in box.space.test:pairs() do s = s + t[1] end
+s
+test_run:cmd('switch default')
+space:drop()
+box.schema.user.revoke('guest', 'replication')
+test_run:cmd("stop server replica")
+test_run:cmd("cleanup server replica")
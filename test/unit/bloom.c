@@ -0,0 +1,90 @@
+#include <stdlib.h>
+#include <stdio.h>
+
+#include "unit.h"
+#include "salad/bloom.h"
+
+/* A simple integer hash (murmur3 finalizer). */
+static bloom_hash_t
+test_hash(uint32_t value)
+{
+	value ^= value >> 16;
+	value *= 0x85ebca6bU;
+	value ^= value >> 13;
+	value *= 0xc2b2ae35U;
+	value ^= value >> 16;
+	return value;
+}
+
+static void
+no_false_negatives_check()
+{
+	header();
+	const uint32_t count = 10000;
+	struct bloom bloom;
+	fail_if(bloom_create(&bloom, count, 0.01) != 0);
+	for (uint32_t i = 0; i < count; i++)
+		bloom_add(&bloom, test_hash(i));
+	for (uint32_t i = 0; i < count; i++)
+		fail_unless(bloom_possible_has(&bloom, test_hash(i)));
+	bloom_destroy(&bloom);
+	footer();
+}
+
+static void
+false_positive_rate_check()
+{
+	header();
+	const uint32_t count = 10000;
+	double rates[] = {0.5, 0.1, 0.05, 0.01, 0.001};
+	for (size_t r = 0; r < sizeof(rates) / sizeof(rates[0]); r++) {
+		struct bloom bloom;
+		fail_if(bloom_create(&bloom, count, rates[r]) != 0);
+		for (uint32_t i = 0; i < count; i++)
+			bloom_add(&bloom, test_hash(i));
+		uint32_t false_positives = 0;
+		const uint32_t checks = 100000;
+		for (uint32_t i = count; i < count + checks; i++)
+			false_positives += bloom_possible_has(&bloom,
+							      test_hash(i));
+		/* Allow 50% deviation from the requested rate. */
+		fail_if(false_positives > checks * rates[r] * 1.5);
+		bloom_destroy(&bloom);
+	}
+	footer();
+}
+
+static void
+store_load_check()
+{
+	header();
+	const uint32_t count = 1000;
+	struct bloom bloom;
+	fail_if(bloom_create(&bloom, count, 0.05) != 0);
+	for (uint32_t i = 0; i < count; i++)
+		bloom_add(&bloom, test_hash(i * 2));
+
+	char *buf = malloc(bloom_store_size(&bloom));
+	fail_if(buf == NULL);
+	fail_unless(bloom_store(&bloom, buf) ==
+		    buf + bloom_store_size(&bloom));
+
+	struct bloom copy;
+	fail_if(bloom_load_table(&copy, bloom.hash_count,
+				 bloom.table_size, buf) != 0);
+	free(buf);
+	for (uint32_t i = 0; i < count * 2; i++)
+		fail_unless(bloom_possible_has(&bloom, test_hash(i)) ==
+			    bloom_possible_has(&copy, test_hash(i)));
+	bloom_destroy(&copy);
+	bloom_destroy(&bloom);
+	footer();
+}
+
+int
+main(void)
+{
+	no_false_negatives_check();
+	false_positive_rate_check();
+	store_load_check();
+}
@@ -39,6 +39,27 @@ compare(type_t a, type_t b);
 #undef bps_tree_key_t
 #undef bps_tree_arg_t
 
+/* tree with subtree counts */
+#define BPS_TREE_NAME counted
+#define BPS_TREE_BLOCK_SIZE 128 /* value is to low specially for tests */
+#define BPS_TREE_EXTENT_SIZE 2048 /* value is to low specially for tests */
+#define BPS_TREE_COMPARE(a, b, arg) compare(a, b)
+#define BPS_TREE_COMPARE_KEY(a, b, arg) compare(a, b)
+#define bps_tree_elem_t type_t
+#define bps_tree_key_t type_t
+#define bps_tree_arg_t int
+#define BPS_TREE_SUBTREE_COUNT
+#include "salad/bps_tree.h"
+#undef BPS_TREE_NAME
+#undef BPS_TREE_BLOCK_SIZE
+#undef BPS_TREE_EXTENT_SIZE
+#undef BPS_TREE_COMPARE
+#undef BPS_TREE_COMPARE_KEY
+#undef bps_tree_elem_t
+#undef bps_tree_key_t
+#undef bps_tree_arg_t
+#undef BPS_TREE_SUBTREE_COUNT
+
 /* true tree with true settings */
 #define BPS_TREE_NAME test
 #define BPS_TREE_BLOCK_SIZE 128 /* value is to low specially for tests */
@@ -629,6 +650,76 @@ white_box_test()
 	footer();
 }
 
+static void
+rank_check()
+{
+	header();
+
+	const type_t range = 1000;
+	const unsigned int rounds = 20000;
+	bool present[range];
+	for (type_t i = 0; i < range; i++)
+		present[i] = false;
+
+	counted tree;
+	counted_create(&tree, 0, extent_alloc, extent_free);
+	for (unsigned int i = 0; i < rounds; i++) {
+		type_t v = rand() % range;
+		if (rand() % 3 != 0) {
+			counted_insert(&tree, v, 0);
+			present[v] = true;
+		} else {
+			counted_delete(&tree, v);
+			present[v] = false;
+		}
+		if (i % 100 != 0)
+			continue;
+		if (counted_debug_check(&tree)) {
+			counted_print(&tree, TYPE_F);
+			fail("debug check nonzero", "true");
+		}
+		size_t less = 0;
+		for (type_t k = 0; k < range; k++) {
+			if (counted_lower_bound_rank(&tree, k) != less)
+				fail("lower bound rank mismatch", "true");
+			if (present[k])
+				less++;
+			if (counted_upper_bound_rank(&tree, k) != less)
+				fail("upper bound rank mismatch", "true");
+		}
+		if (less != counted_size(&tree))
+			fail("tree size mismatch", "true");
+		type_t a = rand() % range, b = rand() % range;
+		size_t between = 0;
+		for (type_t k = a; k <= b; k++)
+			between += present[k];
+		if (counted_count_between(&tree, a, b) != between)
+			fail("count between mismatch", "true");
+	}
+	counted_destroy(&tree);
+
+	type_t arr[range];
+	for (type_t i = 0; i < range; i++)
+		arr[i] = i * 2;
+	for (type_t n = 0; n < range; n += 37) {
+		counted_create(&tree, 0, extent_alloc, extent_free);
+		if (counted_build(&tree, arr, n))
+			fail("building failed", "true");
+		if (counted_debug_check(&tree))
+			fail("debug check nonzero", "true");
+		for (type_t k = 0; k < n; k++) {
+			if (counted_lower_bound_rank(&tree, k * 2) != (size_t)k)
+				fail("lower bound rank mismatch", "true");
+			if (counted_upper_bound_rank(&tree, k * 2) !=
+			    (size_t)k + 1)
+				fail("upper bound rank mismatch", "true");
+		}
+		counted_destroy(&tree);
+	}
+
+	footer();
+}
+
 int
 main(void)
 {
@@ -639,6 +730,7 @@ main(void)
 	loading_test();
 	printing_test();
 	white_box_test();
+	rank_check();
 	if (extents_count != 0)
 		fail("memory leak!", "true");
 }
@@ -479,6 +479,84 @@ iterator_freeze_check()
 	footer();
 }
 
+static void
+view_check()
+{
+	header();
+
+	const long count = 2000;
+	elem_t comp_buf[count];
+	srand(0);
+	struct test tree;
+	test_create(&tree, 0, extent_alloc, extent_free);
+	for (long i = 0; i < count; i++) {
+		elem_t e;
+		e.first = i * 2;
+		e.second = 0;
+		test_insert(&tree, e, 0);
+		comp_buf[i] = e;
+	}
+	struct test_view view;
+	test_view_create(&tree, &view);
+	/* Change the tree a lot, the view must not see it. */
+	for (long i = 0; i < count; i++) {
+		elem_t e;
+		e.first = i * 2 + 1;
+		e.second = 0;
+		test_insert(&tree, e, 0);
+		e.first = (rand() % count) * 2;
+		test_delete(&tree, e);
+		int check = test_debug_check(&tree);
+		fail_if(check);
+	}
+	if (view.size != (size_t) count)
+		fail("view size", "true");
+
+	for (long key = -1; key <= count * 2; key++) {
+		/* The first element >= key and > key in comp_buf. */
+		long lower = key < 0 ? 0 : (key + 1) / 2;
+		long upper = key < 0 ? 0 : key / 2 + 1;
+		if (lower > count)
+			lower = count;
+		if (upper > count)
+			upper = count;
+		bool exact;
+		struct test_iterator itr =
+			test_view_lower_bound(&tree, &view, key, &exact);
+		if (exact != (key >= 0 && key % 2 == 0 && key < count * 2))
+			fail("view lower bound exact", "true");
+		for (long i = lower; i < lower + 3 && i < count; i++) {
+			elem_t *e = test_iterator_get_elem(&tree, &itr);
+			if (e == NULL || *e != comp_buf[i])
+				fail("view lower bound", "true");
+			test_iterator_next(&tree, &itr);
+		}
+		itr = test_view_upper_bound(&tree, &view, key, &exact);
+		if (test_iterator_is_invalid(&itr) != (upper == count))
+			fail("view upper bound end", "true");
+		for (long i = upper; i < upper + 3 && i < count; i++) {
+			elem_t *e = test_iterator_get_elem(&tree, &itr);
+			if (e == NULL || *e != comp_buf[i])
+				fail("view upper bound", "true");
+			test_iterator_next(&tree, &itr);
+		}
+	}
+
+	struct test_iterator itr = test_view_last(&tree, &view);
+	for (long i = count - 1; i >= 0; i--) {
+		elem_t *e = test_iterator_get_elem(&tree, &itr);
+		if (e == NULL || *e != comp_buf[i])
+			fail("view backward iteration", "true");
+		test_iterator_prev(&tree, &itr);
+	}
+	if (test_iterator_get_elem(&tree, &itr) != NULL)
+		fail("view backward iteration end", "true");
+
+	test_view_destroy(&tree, &view);
+	test_destroy(&tree);
+
+	footer();
+}
 
 int
 main(void)
@@ -487,6 +565,7 @@ main(void)
 	iterator_check();
 	iterator_invalidate_check();
 	iterator_freeze_check();
+	view_check();
 	if (total_extents_allocated) {
 		fail("memory leak", "true");
 	}
@@ -0,0 +1,38 @@
+test_run = require('test_run').new()
+
+s = box.schema.space.create('test', {engine = 'vinyl'})
+_ = s:create_index('pk', {bloom_fpr = 0.001})
+
+function vyinfo() return box.info.vinyl().db[s.id..'/0'] end
+function page_reads() return vyinfo().read_disk + vyinfo().read_cache end
+
+test_run:cmd("setopt delimiter ';'")
+for i = 1, 1000 do
+    s:replace{i * 2}
+end;
+test_run:cmd("setopt delimiter ''");
+box.snapshot()
+
+-- all existing keys are found
+found = 0
+for i = 1, 1000 do found = found + (s:get{i * 2} ~= nil and 1 or 0) end
+found
+
+-- lookups of missing keys skip the run
+reads = page_reads()
+missing = 0
+for i = 1, 1000 do missing = missing + (s:get{i * 2 + 1} == nil and 1 or 0) end
+missing
+page_reads() - reads < 100
+
+-- range lookups don't use bloom filters
+#s:select({1}, {iterator = 'GE'})
+
+-- bloom_fpr must be in (0, 1], 1 disables bloom filters
+s2 = box.schema.space.create('test2', {engine = 'vinyl'})
+ok = pcall(s2.create_index, s2, 'pk', {bloom_fpr = 1.5})
+ok
+_ = s2:create_index('pk', {bloom_fpr = 1})
+s2:drop()
+
+s:drop()
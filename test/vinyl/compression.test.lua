@@ -0,0 +1,49 @@
+test_run = require('test_run').new()
+
+function vyinfo(s) return box.info.vinyl().db[s.id..'/0'] end
+
+-- pages are compressed on dump and decompressed on load
+test_run:cmd("setopt delimiter ';'")
+for _, codec in ipairs({'none', 'lz4', 'zstd'}) do
+    local s = box.schema.space.create('test', {engine = 'vinyl'})
+    s:create_index('pk', {compression = codec, page_size = 4096})
+    for i = 1, 1000 do
+        s:replace{i, string.rep('x', 100)}
+    end
+    box.snapshot()
+    local count = 0
+    for _, t in s:pairs() do
+        if t[2] == string.rep('x', 100) then
+            count = count + 1
+        end
+    end
+    assert(count == 1000)
+    assert(s:get{500}[2] == string.rep('x', 100))
+    local info = vyinfo(s)
+    if codec == 'none' then
+        assert(info.size_uncompressed - info.size < 4096 * 4)
+    else
+        assert(info.size * 3 < info.size_uncompressed)
+    end
+    s:drop()
+end;
+test_run:cmd("setopt delimiter ''");
+
+-- invalid codec
+s = box.schema.space.create('test', {engine = 'vinyl'})
+ok = pcall(s.create_index, s, 'pk', {compression = 'gzip'})
+ok
+_ = s:create_index('pk', {compression = 'zstd', compression_level = 9})
+s:replace{1, 'abc'}
+box.snapshot()
+s:get{1}
+s:drop()
+
+-- compression level is checked against the codec
+s = box.schema.space.create('test', {engine = 'vinyl'})
+s:create_index('pk', {compression = 'none', compression_level = 1})
+ok = pcall(s.create_index, s, 'pk', {compression = 'lz4', compression_level = 100})
+ok
+ok = pcall(s.create_index, s, 'pk', {compression = 'zstd', compression_level = 100})
+ok
+s:drop()
@@ -0,0 +1,12 @@
+#!/usr/bin/env tarantool
+os = require('os')
+
+box.cfg{
+    listen                  = os.getenv("LISTEN"),
+    slab_alloc_arena        = 0.1,
+    pid_file                = "tarantool.pid",
+    wal_group_commit_bytes  = 4096,
+    wal_group_commit_usec   = 500000
+}
+
+require('console').listen(os.getenv('ADMIN'))
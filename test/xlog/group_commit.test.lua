@@ -0,0 +1,42 @@
+--
+-- Requests are written to the WAL in groups, a group is
+-- written when it is big enough or its timeout expires.
+--
+env = require('test_run')
+test_run = env.new()
+test_run:cmd("create server group_commit with script='xlog/group_commit.lua'")
+test_run:cmd("start server group_commit")
+test_run:cmd("switch group_commit")
+fiber = require('fiber')
+errinj = box.error.injection
+s = box.schema.space.create('test')
+_ = s:create_index('pk')
+pad = string.rep('x', 1000)
+ch = fiber.channel(10)
+function insert(i) local ok = pcall(s.insert, s, {i, pad}) ch:put(ok) end
+-- Groups are written by a member which is not the first one
+for i = 1, 10 do fiber.create(insert, i) fiber.sleep(0.001) end
+ok = 0
+for i = 1, 10 do if ch:get() then ok = ok + 1 end end
+ok
+s:count()
+-- A WAL error while a group is open rolls back all its members
+errinj.set('ERRINJ_WAL_WRITE', true)
+for i = 11, 20 do fiber.create(insert, i) fiber.sleep(0.001) end
+ok = 0
+for i = 1, 10 do if ch:get() then ok = ok + 1 end end
+ok
+s:count()
+errinj.set('ERRINJ_WAL_WRITE', false)
+for i = 11, 20 do fiber.create(insert, i) fiber.sleep(0.001) end
+ok = 0
+for i = 1, 10 do if ch:get() then ok = ok + 1 end end
+ok
+s:count()
+test_run:cmd("restart server group_commit")
+s = box.space.test
+s:count()
+s:get{20}[1]
+test_run:cmd("switch default")
+test_run:cmd("stop server group_commit")
+test_run:cmd("cleanup server group_commit")
@@ -0,0 +1,27 @@
+--
+-- Disk space for a new WAL file is reserved in advance,
+-- the file size visible to readers is not changed.
+--
+env = require('test_run')
+test_run = env.new()
+test_run:cmd("create server prealloc with script='xlog/prealloc.lua'")
+test_run:cmd("start server prealloc")
+test_run:cmd("switch prealloc")
+fio = require('fio')
+box.cfg.wal_prealloc_size
+s = box.schema.space.create('test')
+_ = s:create_index('pk')
+for i = 1, 100 do s:insert{i, string.rep('x', 100)} end
+xlogs = fio.glob(fio.pathjoin(box.cfg.wal_dir, '*.xlog'))
+table.sort(xlogs)
+stat = fio.stat(xlogs[#xlogs])
+stat.size < box.cfg.wal_prealloc_size
+-- fallocate() is available on Linux only
+jit.os ~= 'Linux' or stat.blocks * 512 >= box.cfg.wal_prealloc_size
+test_run:cmd("restart server prealloc")
+s = box.space.test
+s:count()
+s:get{100}[2] == string.rep('x', 100)
+test_run:cmd("switch default")
+test_run:cmd("stop server prealloc")
+test_run:cmd("cleanup server prealloc")
@@ -0,0 +1,31 @@
+--
+-- Snapshots are written with blocks of rows, which
+-- can be compressed.
+--
+env = require('test_run')
+test_run = env.new()
+test_run:cmd("create server compressed with script='xlog/snap_compression.lua'")
+test_run:cmd("start server compressed")
+test_run:cmd("switch compressed")
+box.cfg.snap_compression
+fio = require('fio')
+s = box.schema.space.create('test')
+_ = s:create_index('pk')
+for i = 1, 10000 do s:insert{i, string.rep('x', 100)} end
+box.snapshot()
+snaps = fio.glob(fio.pathjoin(box.cfg.snap_dir, '*.snap'))
+table.sort(snaps)
+snap = snaps[#snaps]
+f = fio.open(snap)
+f:read(10) == 'SNAP\n0.13\n'
+f:close()
+-- 10000 * 100 bytes of tuple data
+fio.stat(snap).size < 100000
+test_run:cmd("restart server compressed")
+s = box.space.test
+s:count()
+s:get{5000}[1]
+s:get{5000}[2] == string.rep('x', 100)
+test_run:cmd("switch default")
+test_run:cmd("stop server compressed")
+test_run:cmd("cleanup server compressed")